@@ -1743,6 +1743,57 @@ static void test_string_termination(void)
     RegCloseKey(subkey);
 }
 
+static void test_reg_notify(void)
+{
+    HKEY subkey;
+    HANDLE event;
+    DWORD dw;
+    LONG ret;
+
+    ret = RegCreateKeyA(hkey_main, "notify", &subkey);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    ok(event != NULL, "CreateEvent failed, error %u\n", GetLastError());
+
+    /* value changes in subkeys are reported to subtree watchers */
+    ret = RegNotifyChangeKeyValue(hkey_main, TRUE, REG_NOTIFY_CHANGE_LAST_SET, event, TRUE);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    dw = WaitForSingleObject(event, 0);
+    ok(dw == WAIT_TIMEOUT, "got %u\n", dw);
+    ret = RegSetValueExA(subkey, "value", 0, REG_SZ, (const BYTE *)"data", 5);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    dw = WaitForSingleObject(event, 0);
+    ok(dw == WAIT_OBJECT_0, "got %u\n", dw);
+
+    /* but not to watchers of the parent key only */
+    ret = RegNotifyChangeKeyValue(hkey_main, FALSE, REG_NOTIFY_CHANGE_LAST_SET, event, TRUE);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    ret = RegSetValueExA(subkey, "value", 0, REG_SZ, (const BYTE *)"data2", 6);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    dw = WaitForSingleObject(event, 0);
+    ok(dw == WAIT_TIMEOUT, "got %u\n", dw);
+    ret = RegSetValueExA(hkey_main, "notify", 0, REG_SZ, (const BYTE *)"data", 5);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    dw = WaitForSingleObject(event, 0);
+    ok(dw == WAIT_OBJECT_0, "got %u\n", dw);
+
+    /* nor to subtree watchers that don't ask for value changes */
+    ret = RegNotifyChangeKeyValue(hkey_main, TRUE, REG_NOTIFY_CHANGE_NAME, event, TRUE);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    ret = RegSetValueExA(subkey, "value", 0, REG_SZ, (const BYTE *)"data3", 6);
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    dw = WaitForSingleObject(event, 0);
+    ok(dw == WAIT_TIMEOUT, "got %u\n", dw);
+    ret = RegDeleteKeyA(subkey, "");
+    ok(ret == ERROR_SUCCESS, "Expected ERROR_SUCCESS, got %d\n", ret);
+    dw = WaitForSingleObject(event, 0);
+    ok(dw == WAIT_OBJECT_0, "got %u\n", dw);
+
+    RegDeleteValueA(hkey_main, "notify");
+    RegCloseKey(subkey);
+    CloseHandle(event);
+}
+
 static void test_reg_delete_tree(void)
 {
     CHAR buffer[MAX_PATH];
@@ -2978,6 +3029,7 @@ START_TEST(registry)
         set_privileges(SE_RESTORE_NAME, FALSE);
     }
 
+    test_reg_notify();
     test_reg_delete_tree();
     test_rw_order();
     test_deleted_key();
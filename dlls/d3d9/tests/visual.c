@@ -17116,6 +17116,284 @@ static void test_negative_fixedfunction_fog(void)
     DestroyWindow(window);
 }
 
+static void test_command_stream_replay(void)
+{
+    enum
+    {
+        CMD_VIEWPORT,
+        CMD_TFACTOR,
+        CMD_TRANSFORM,
+        CMD_DRAW,
+    };
+    struct command
+    {
+        unsigned int type;
+        unsigned int arg;
+    } commands[4096];
+    static const struct vec3 quad[] =
+    {
+        {-1.0f, -1.0f, 0.0f},
+        {-1.0f,  1.0f, 0.0f},
+        { 1.0f, -1.0f, 0.0f},
+        { 1.0f,  1.0f, 0.0f},
+    };
+    static const D3DCOLOR expected[] = {0x00ff0000, 0x0000ff00, 0x000000ff, 0x00ffff00};
+    unsigned int i, frame, count = 0, frame_count = 100;
+    IDirect3DDevice9 *device;
+    D3DVIEWPORT9 viewport;
+    IDirect3D9 *d3d;
+    D3DMATRIX mat;
+    D3DCOLOR color;
+    ULONG refcount;
+    DWORD start;
+    HWND window;
+    HRESULT hr;
+
+    window = CreateWindowA("static", "d3d9_test", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+            0, 0, 640, 480, NULL, NULL, NULL, NULL);
+    d3d = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d, "Failed to create a D3D object.\n");
+    if (!(device = create_device(d3d, window, window, TRUE)))
+    {
+        skip("Failed to create a D3D device, skipping tests.\n");
+        IDirect3D9_Release(d3d);
+        DestroyWindow(window);
+        return;
+    }
+
+    hr = IDirect3DDevice9_SetFVF(device, D3DFVF_XYZ);
+    ok(SUCCEEDED(hr), "Failed to set fvf, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_LIGHTING, FALSE);
+    ok(SUCCEEDED(hr), "Failed to set render state, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_ZENABLE, FALSE);
+    ok(SUCCEEDED(hr), "Failed to set render state, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetTextureStageState(device, 0, D3DTSS_COLOROP, D3DTOP_SELECTARG1);
+    ok(SUCCEEDED(hr), "Failed to set texture stage state, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetTextureStageState(device, 0, D3DTSS_COLORARG1, D3DTA_TFACTOR);
+    ok(SUCCEEDED(hr), "Failed to set texture stage state, hr %#x.\n", hr);
+
+    /* Record a stream of many small state changes and draws, each quadrant of
+     * the render target is overdrawn several times and ends up with the color
+     * from the last draw. */
+    for (i = 0; count < sizeof(commands) / sizeof(*commands) - 12; ++i)
+    {
+        commands[count].type = CMD_VIEWPORT;
+        commands[count++].arg = i % 4;
+        commands[count].type = CMD_TRANSFORM;
+        commands[count++].arg = i;
+        commands[count].type = CMD_TFACTOR;
+        commands[count++].arg = i * 0x10203;
+        commands[count].type = CMD_DRAW;
+        commands[count++].arg = 0;
+    }
+    for (i = 0; i < 4; ++i)
+    {
+        commands[count].type = CMD_VIEWPORT;
+        commands[count++].arg = i;
+        commands[count].type = CMD_TFACTOR;
+        commands[count++].arg = expected[i];
+        commands[count].type = CMD_DRAW;
+        commands[count++].arg = 0;
+    }
+
+    viewport.Width = 320;
+    viewport.Height = 240;
+    viewport.MinZ = 0.0f;
+    viewport.MaxZ = 1.0f;
+
+    start = GetTickCount();
+    for (frame = 0; frame < frame_count; ++frame)
+    {
+        hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0x00808080, 0.0f, 0);
+        ok(SUCCEEDED(hr), "Failed to clear, hr %#x.\n", hr);
+        hr = IDirect3DDevice9_BeginScene(device);
+        ok(SUCCEEDED(hr), "Failed to begin scene, hr %#x.\n", hr);
+        for (i = 0; i < count; ++i)
+        {
+            switch (commands[i].type)
+            {
+                case CMD_VIEWPORT:
+                    viewport.X = (commands[i].arg & 1) * 320;
+                    viewport.Y = (commands[i].arg >> 1) * 240;
+                    hr = IDirect3DDevice9_SetViewport(device, &viewport);
+                    break;
+
+                case CMD_TRANSFORM:
+                    /* The matrix is modified right after the call. */
+                    memset(&mat, 0, sizeof(mat));
+                    U(mat).m[0][0] = U(mat).m[1][1] = U(mat).m[2][2] = U(mat).m[3][3] = 1.0f;
+                    hr = IDirect3DDevice9_SetTransform(device, D3DTS_WORLD, &mat);
+                    U(mat).m[0][0] = U(mat).m[1][1] = 0.0f;
+                    break;
+
+                case CMD_TFACTOR:
+                    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_TEXTUREFACTOR, commands[i].arg);
+                    break;
+
+                case CMD_DRAW:
+                    hr = IDirect3DDevice9_DrawPrimitiveUP(device, D3DPT_TRIANGLESTRIP, 2, quad, sizeof(*quad));
+                    break;
+            }
+            if (FAILED(hr))
+                break;
+        }
+        ok(SUCCEEDED(hr), "Command %u (type %u) failed, hr %#x.\n", i, commands[i].type, hr);
+        hr = IDirect3DDevice9_EndScene(device);
+        ok(SUCCEEDED(hr), "Failed to end scene, hr %#x.\n", hr);
+
+        if (frame == frame_count - 1)
+        {
+            color = getPixelColor(device, 160, 120);
+            ok(color_match(color, expected[0], 1), "Got unexpected color 0x%08x.\n", color);
+            color = getPixelColor(device, 480, 120);
+            ok(color_match(color, expected[1], 1), "Got unexpected color 0x%08x.\n", color);
+            color = getPixelColor(device, 160, 360);
+            ok(color_match(color, expected[2], 1), "Got unexpected color 0x%08x.\n", color);
+            color = getPixelColor(device, 480, 360);
+            ok(color_match(color, expected[3], 1), "Got unexpected color 0x%08x.\n", color);
+        }
+
+        hr = IDirect3DDevice9_Present(device, NULL, NULL, NULL, NULL);
+        ok(SUCCEEDED(hr), "Failed to present, hr %#x.\n", hr);
+    }
+    trace("Replayed %u frames of %u commands in %u ms.\n", frame_count, count, GetTickCount() - start);
+
+    refcount = IDirect3DDevice9_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    IDirect3D9_Release(d3d);
+    DestroyWindow(window);
+}
+
+static void test_dynamic_buffer_locks(void)
+{
+    struct vertex
+    {
+        struct vec3 position;
+        DWORD diffuse;
+    } *vertices;
+    IDirect3DVertexBuffer9 *vb;
+    IDirect3DIndexBuffer9 *ib;
+    unsigned int i, j, frame, frame_count = 10, quad_count = 5000, ring_quads = 256;
+    unsigned int cell_count = 64 * 48, cell, x, y;
+    IDirect3DDevice9 *device;
+    IDirect3D9 *d3d;
+    D3DCOLOR color, expected;
+    ULONG refcount;
+    DWORD start, flags;
+    HWND window;
+    HRESULT hr;
+    WORD *indices;
+
+    window = CreateWindowA("static", "d3d9_test", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+            0, 0, 640, 480, NULL, NULL, NULL, NULL);
+    d3d = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d, "Failed to create a D3D object.\n");
+    if (!(device = create_device(d3d, window, window, TRUE)))
+    {
+        skip("Failed to create a D3D device, skipping tests.\n");
+        IDirect3D9_Release(d3d);
+        DestroyWindow(window);
+        return;
+    }
+
+    hr = IDirect3DDevice9_CreateVertexBuffer(device, ring_quads * 4 * sizeof(*vertices),
+            D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, &vb, NULL);
+    ok(SUCCEEDED(hr), "Failed to create vertex buffer, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_CreateIndexBuffer(device, ring_quads * 6 * sizeof(*indices),
+            D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFMT_INDEX16, D3DPOOL_DEFAULT, &ib, NULL);
+    ok(SUCCEEDED(hr), "Failed to create index buffer, hr %#x.\n", hr);
+
+    hr = IDirect3DDevice9_SetFVF(device, D3DFVF_XYZ | D3DFVF_DIFFUSE);
+    ok(SUCCEEDED(hr), "Failed to set fvf, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetStreamSource(device, 0, vb, 0, sizeof(*vertices));
+    ok(SUCCEEDED(hr), "Failed to set stream source, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetIndices(device, ib);
+    ok(SUCCEEDED(hr), "Failed to set index buffer, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_LIGHTING, FALSE);
+    ok(SUCCEEDED(hr), "Failed to set render state, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_SetRenderState(device, D3DRS_ZENABLE, FALSE);
+    ok(SUCCEEDED(hr), "Failed to set render state, hr %#x.\n", hr);
+
+    /* Particle system style updates: every quad is written with a small
+     * NOOVERWRITE lock of both buffers right before it is drawn, and the
+     * buffers are discarded when they are full. The quads go to a 64x48 grid
+     * of 10x10 pixel cells, later quads overwrite earlier ones. */
+    start = GetTickCount();
+    for (frame = 0; frame < frame_count; ++frame)
+    {
+        hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0x00000000, 0.0f, 0);
+        ok(SUCCEEDED(hr), "Failed to clear, hr %#x.\n", hr);
+        hr = IDirect3DDevice9_BeginScene(device);
+        ok(SUCCEEDED(hr), "Failed to begin scene, hr %#x.\n", hr);
+        for (i = 0; i < quad_count; ++i)
+        {
+            j = i % ring_quads;
+            flags = j ? D3DLOCK_NOOVERWRITE : D3DLOCK_DISCARD;
+            cell = i % cell_count;
+            x = (cell % 64) * 10;
+            y = (cell / 64) * 10;
+
+            hr = IDirect3DVertexBuffer9_Lock(vb, j * 4 * sizeof(*vertices), 4 * sizeof(*vertices),
+                    (void **)&vertices, flags);
+            if (FAILED(hr))
+                break;
+            vertices[0].position.x = vertices[1].position.x = x / 320.0f - 1.0f;
+            vertices[2].position.x = vertices[3].position.x = (x + 10) / 320.0f - 1.0f;
+            vertices[0].position.y = vertices[2].position.y = 1.0f - (y + 10) / 240.0f;
+            vertices[1].position.y = vertices[3].position.y = 1.0f - y / 240.0f;
+            vertices[0].position.z = vertices[1].position.z = vertices[2].position.z = vertices[3].position.z = 0.0f;
+            vertices[0].diffuse = vertices[1].diffuse = vertices[2].diffuse = vertices[3].diffuse
+                    = 0xff000000 | (i * 0x9e3779b1);
+            hr = IDirect3DVertexBuffer9_Unlock(vb);
+            if (FAILED(hr))
+                break;
+
+            hr = IDirect3DIndexBuffer9_Lock(ib, j * 6 * sizeof(*indices), 6 * sizeof(*indices),
+                    (void **)&indices, flags);
+            if (FAILED(hr))
+                break;
+            indices[0] = j * 4;
+            indices[1] = indices[4] = j * 4 + 1;
+            indices[2] = indices[3] = j * 4 + 2;
+            indices[5] = j * 4 + 3;
+            hr = IDirect3DIndexBuffer9_Unlock(ib);
+            if (FAILED(hr))
+                break;
+
+            hr = IDirect3DDevice9_DrawIndexedPrimitive(device, D3DPT_TRIANGLELIST, 0, j * 4, 4, j * 6, 2);
+            if (FAILED(hr))
+                break;
+        }
+        ok(SUCCEEDED(hr), "Quad %u failed, hr %#x.\n", i, hr);
+        hr = IDirect3DDevice9_EndScene(device);
+        ok(SUCCEEDED(hr), "Failed to end scene, hr %#x.\n", hr);
+
+        if (frame == frame_count - 1)
+        {
+            for (cell = 0; cell < cell_count; cell += 97)
+            {
+                i = cell + (quad_count - 1 - cell) / cell_count * cell_count;
+                expected = (i * 0x9e3779b1) & 0x00ffffff;
+                color = getPixelColor(device, (cell % 64) * 10 + 5, (cell / 64) * 10 + 5);
+                ok(color_match(color, expected, 1), "Cell %u: got unexpected color 0x%08x, expected 0x%08x.\n",
+                        cell, color, expected);
+            }
+        }
+
+        hr = IDirect3DDevice9_Present(device, NULL, NULL, NULL, NULL);
+        ok(SUCCEEDED(hr), "Failed to present, hr %#x.\n", hr);
+    }
+    trace("Drew %u frames with %u dynamic buffer locks each in %u ms.\n",
+            frame_count, quad_count * 2, GetTickCount() - start);
+
+    IDirect3DVertexBuffer9_Release(vb);
+    IDirect3DIndexBuffer9_Release(ib);
+    refcount = IDirect3DDevice9_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    IDirect3D9_Release(d3d);
+    DestroyWindow(window);
+}
+
 START_TEST(visual)
 {
     D3DADAPTER_IDENTIFIER9 identifier;
@@ -17226,4 +17504,6 @@ START_TEST(visual)
     test_3dc_formats();
     test_fog_interpolation();
     test_negative_fixedfunction_fog();
+    test_command_stream_replay();
+    test_dynamic_buffer_locks();
 }
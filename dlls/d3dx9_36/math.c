@@ -31,6 +31,10 @@
 #include "wingdi.h"
 #include "d3dx9_36_private.h"
 
+#ifdef D3DX_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3dx);
@@ -396,6 +400,37 @@ D3DXMATRIX * WINAPI D3DXMatrixLookAtRH(D3DXMATRIX *out, const D3DXVECTOR3 *eye,
     return out;
 }
 
+#ifdef D3DX_SSE
+/* The SSE versions evaluate the sums in the same order as the C versions,
+ * so that the results are identical. */
+static void D3DX_SSE_FUNC matrix_multiply_sse(D3DXMATRIX *out, const D3DXMATRIX *m1,
+        const D3DXMATRIX *m2, BOOL transpose)
+{
+    __m128 r0 = _mm_loadu_ps(m2->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(m2->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(m2->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(m2->u.m[3]);
+    __m128 row[4];
+    unsigned int i;
+
+    for (i = 0; i < 4; ++i)
+    {
+        row[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(m1->u.m[i][0]), r0),
+                _mm_mul_ps(_mm_set1_ps(m1->u.m[i][1]), r1)),
+                _mm_mul_ps(_mm_set1_ps(m1->u.m[i][2]), r2)),
+                _mm_mul_ps(_mm_set1_ps(m1->u.m[i][3]), r3));
+    }
+    if (transpose)
+        _MM_TRANSPOSE4_PS(row[0], row[1], row[2], row[3]);
+
+    _mm_storeu_ps(out->u.m[0], row[0]);
+    _mm_storeu_ps(out->u.m[1], row[1]);
+    _mm_storeu_ps(out->u.m[2], row[2]);
+    _mm_storeu_ps(out->u.m[3], row[3]);
+}
+#endif
+
 D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, const D3DXMATRIX *pm2)
 {
     D3DXMATRIX out;
@@ -403,6 +438,14 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiply(D3DXMATRIX *pout, const D3DXMATRIX *pm1, c
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+    {
+        matrix_multiply_sse(pout, pm1, pm2, FALSE);
+        return pout;
+    }
+#endif
+
     for (i=0; i<4; i++)
     {
         for (j=0; j<4; j++)
@@ -422,6 +465,14 @@ D3DXMATRIX* WINAPI D3DXMatrixMultiplyTranspose(D3DXMATRIX *pout, const D3DXMATRI
 
     TRACE("pout %p, pm1 %p, pm2 %p\n", pout, pm1, pm2);
 
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+    {
+        matrix_multiply_sse(pout, pm1, pm2, TRUE);
+        return pout;
+    }
+#endif
+
     for (i = 0; i < 4; i++)
         for (j = 0; j < 4; j++)
             temp.u.m[j][i] = pm1->u.m[i][0] * pm2->u.m[0][j] + pm1->u.m[i][1] * pm2->u.m[1][j] + pm1->u.m[i][2] * pm2->u.m[2][j] + pm1->u.m[i][3] * pm2->u.m[3][j];
@@ -1909,12 +1960,92 @@ D3DXVECTOR4* WINAPI D3DXVec3Transform(D3DXVECTOR4 *pout, const D3DXVECTOR3 *pv,
     return pout;
 }
 
+#ifdef D3DX_SSE
+static inline __m128 D3DX_SSE_FUNC vec3_transform_sse(const D3DXVECTOR3 *v,
+        __m128 r0, __m128 r1, __m128 r2, __m128 r3)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(v->x), r0),
+            _mm_mul_ps(_mm_set1_ps(v->y), r1)),
+            _mm_mul_ps(_mm_set1_ps(v->z), r2)), r3);
+}
+
+static inline void D3DX_SSE_FUNC vec3_store_sse(D3DXVECTOR3 *out, __m128 v)
+{
+    _mm_storel_pi((__m64 *)out, v);
+    _mm_store_ss(&out->z, _mm_movehl_ps(v, v));
+}
+
+static void D3DX_SSE_FUNC vec3_transform_array_sse(D3DXVECTOR4 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(matrix->u.m[3]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        _mm_storeu_ps(&out->x, vec3_transform_sse(in, r0, r1, r2, r3));
+        out = (D3DXVECTOR4 *)((char *)out + outstride);
+        in = (const D3DXVECTOR3 *)((const char *)in + instride);
+    }
+}
+
+static void D3DX_SSE_FUNC vec3_transform_coord_array_sse(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(matrix->u.m[3]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        __m128 v = vec3_transform_sse(in, r0, r1, r2, r3);
+
+        vec3_store_sse(out, _mm_div_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+        out = (D3DXVECTOR3 *)((char *)out + outstride);
+        in = (const D3DXVECTOR3 *)((const char *)in + instride);
+    }
+}
+
+static void D3DX_SSE_FUNC vec3_transform_normal_array_sse(D3DXVECTOR3 *out, UINT outstride,
+        const D3DXVECTOR3 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        vec3_store_sse(out, _mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(in->x), r0),
+                _mm_mul_ps(_mm_set1_ps(in->y), r1)),
+                _mm_mul_ps(_mm_set1_ps(in->z), r2)));
+        out = (D3DXVECTOR3 *)((char *)out + outstride);
+        in = (const D3DXVECTOR3 *)((const char *)in + instride);
+    }
+}
+#endif
+
 D3DXVECTOR4* WINAPI D3DXVec3TransformArray(D3DXVECTOR4* out, UINT outstride, const D3DXVECTOR3* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+    {
+        vec3_transform_array_sse(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1948,6 +2079,14 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformCoordArray(D3DXVECTOR3* out, UINT outstride
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+    {
+        vec3_transform_coord_array_sse(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformCoord(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -1976,6 +2115,14 @@ D3DXVECTOR3* WINAPI D3DXVec3TransformNormalArray(D3DXVECTOR3* out, UINT outstrid
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+    {
+        vec3_transform_normal_array_sse(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec3TransformNormal(
             (D3DXVECTOR3*)((char*)out + outstride * i),
@@ -2110,12 +2257,43 @@ D3DXVECTOR4* WINAPI D3DXVec4Transform(D3DXVECTOR4 *pout, const D3DXVECTOR4 *pv,
     return pout;
 }
 
+#ifdef D3DX_SSE
+static void D3DX_SSE_FUNC vec4_transform_array_sse(D3DXVECTOR4 *out, UINT outstride,
+        const D3DXVECTOR4 *in, UINT instride, const D3DXMATRIX *matrix, UINT elements)
+{
+    __m128 r0 = _mm_loadu_ps(matrix->u.m[0]);
+    __m128 r1 = _mm_loadu_ps(matrix->u.m[1]);
+    __m128 r2 = _mm_loadu_ps(matrix->u.m[2]);
+    __m128 r3 = _mm_loadu_ps(matrix->u.m[3]);
+    UINT i;
+
+    for (i = 0; i < elements; ++i)
+    {
+        _mm_storeu_ps(&out->x, _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(in->x), r0),
+                _mm_mul_ps(_mm_set1_ps(in->y), r1)),
+                _mm_mul_ps(_mm_set1_ps(in->z), r2)),
+                _mm_mul_ps(_mm_set1_ps(in->w), r3)));
+        out = (D3DXVECTOR4 *)((char *)out + outstride);
+        in = (const D3DXVECTOR4 *)((const char *)in + instride);
+    }
+}
+#endif
+
 D3DXVECTOR4* WINAPI D3DXVec4TransformArray(D3DXVECTOR4* out, UINT outstride, const D3DXVECTOR4* in, UINT instride, const D3DXMATRIX* matrix, UINT elements)
 {
     UINT i;
 
     TRACE("out %p, outstride %u, in %p, instride %u, matrix %p, elements %u\n", out, outstride, in, instride, matrix, elements);
 
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+    {
+        vec4_transform_array_sse(out, outstride, in, instride, matrix, elements);
+        return out;
+    }
+#endif
+
     for (i = 0; i < elements; ++i) {
         D3DXVec4Transform(
             (D3DXVECTOR4*)((char*)out + outstride * i),
@@ -1211,19 +1211,44 @@ cleanup:
     return hr;
 }
 
-struct vertex_metadata {
-  float key;
-  DWORD vertex_index;
-  DWORD first_shared_index;
+/* Vertices are bucketed on a grid of epsilon sized cells, so that coincident
+ * vertices can be found by only looking at the neighbouring cells. */
+struct vertex_metadata
+{
+    int cell[3];
+    DWORD next;
+    DWORD first_shared_index;
 };
 
-static int compare_vertex_keys(const void *a, const void *b)
+static int get_vertex_cell(float value, float epsilon)
 {
-    const struct vertex_metadata *left = a;
-    const struct vertex_metadata *right = b;
-    if (left->key == right->key)
-        return 0;
-    return left->key < right->key ? -1 : 1;
+    double cell;
+
+    if (epsilon == 0.0f)
+    {
+        union
+        {
+            float f;
+            int i;
+        } u;
+
+        /* only identical coordinates are coincident, -0.0f == 0.0f */
+        u.f = value == 0.0f ? 0.0f : value;
+        return u.i;
+    }
+
+    cell = floor((double)value / epsilon);
+    if (cell < -0x3fffffff)
+        return -0x3fffffff;
+    if (cell > 0x3fffffff)
+        return 0x3fffffff;
+    return cell;
+}
+
+static DWORD hash_vertex_cell(const int *cell, DWORD mask)
+{
+    return ((unsigned int)cell[0] * 73856093u ^ (unsigned int)cell[1] * 19349663u
+            ^ (unsigned int)cell[2] * 83492791u) & mask;
 }
 
 static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsilon, DWORD *adjacency)
@@ -1234,12 +1259,15 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
     const DWORD *indices = NULL;
     DWORD vertex_size;
     DWORD buffer_size;
-    /* sort the vertices by (x + y + z) to quickly find coincident vertices */
-    struct vertex_metadata *sorted_vertices;
+    /* hash the vertices by position to quickly find coincident vertices */
+    struct vertex_metadata *vertex_data;
+    DWORD *hash_table, hash_mask;
+    DWORD *coincident_vertices;
     /* shared_indices links together identical indices in the index buffer so
      * that adjacency checks can be limited to faces sharing a vertex */
     DWORD *shared_indices = NULL;
     const FLOAT epsilon_sq = epsilon * epsilon;
+    int cell_radius = epsilon > 0.0f ? 1 : 0;
     DWORD i;
 
     TRACE("iface %p, epsilon %.8e, adjacency %p.\n", iface, epsilon, adjacency);
@@ -1247,13 +1275,21 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
     if (!adjacency)
         return D3DERR_INVALIDCALL;
 
-    buffer_size = This->numfaces * 3 * sizeof(*shared_indices) + This->numvertices * sizeof(*sorted_vertices);
+    hash_mask = 1;
+    while (hash_mask < This->numvertices)
+        hash_mask <<= 1;
+
+    buffer_size = This->numfaces * 3 * sizeof(*shared_indices) + This->numvertices * sizeof(*vertex_data)
+            + hash_mask * sizeof(*hash_table) + This->numvertices * sizeof(*coincident_vertices);
     if (!(This->options & D3DXMESH_32BIT))
         buffer_size += This->numfaces * 3 * sizeof(*indices);
     shared_indices = HeapAlloc(GetProcessHeap(), 0, buffer_size);
     if (!shared_indices)
         return E_OUTOFMEMORY;
-    sorted_vertices = (struct vertex_metadata*)(shared_indices + This->numfaces * 3);
+    vertex_data = (struct vertex_metadata *)(shared_indices + This->numfaces * 3);
+    hash_table = (DWORD *)(vertex_data + This->numvertices);
+    coincident_vertices = hash_table + hash_mask;
+    hash_mask -= 1;
 
     hr = iface->lpVtbl->LockVertexBuffer(iface, D3DLOCK_READONLY, (void**)&vertices);
     if (FAILED(hr)) goto cleanup;
@@ -1262,36 +1298,80 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
 
     if (!(This->options & D3DXMESH_32BIT)) {
         const WORD *word_indices = (const WORD*)indices;
-        DWORD *dword_indices = (DWORD*)(sorted_vertices + This->numvertices);
+        DWORD *dword_indices = coincident_vertices + This->numvertices;
         indices = dword_indices;
         for (i = 0; i < This->numfaces * 3; i++)
             *dword_indices++ = *word_indices++;
     }
 
     vertex_size = iface->lpVtbl->GetNumBytesPerVertex(iface);
+    memset(hash_table, 0xff, (hash_mask + 1) * sizeof(*hash_table));
     for (i = 0; i < This->numvertices; i++) {
         D3DXVECTOR3 *vertex = (D3DXVECTOR3*)(vertices + vertex_size * i);
-        sorted_vertices[i].first_shared_index = -1;
-        sorted_vertices[i].key = vertex->x + vertex->y + vertex->z;
-        sorted_vertices[i].vertex_index = i;
+        struct vertex_metadata *data = &vertex_data[i];
+
+        data->first_shared_index = -1;
+        if (epsilon < 0.0f)
+            continue;
+        data->cell[0] = get_vertex_cell(vertex->x, epsilon);
+        data->cell[1] = get_vertex_cell(vertex->y, epsilon);
+        data->cell[2] = get_vertex_cell(vertex->z, epsilon);
+        data->next = hash_table[hash_vertex_cell(data->cell, hash_mask)];
+        hash_table[hash_vertex_cell(data->cell, hash_mask)] = i;
     }
     for (i = 0; i < This->numfaces * 3; i++) {
-        DWORD *first_shared_index = &sorted_vertices[indices[i]].first_shared_index;
+        DWORD *first_shared_index = &vertex_data[indices[i]].first_shared_index;
         shared_indices[i] = *first_shared_index;
         *first_shared_index = i;
         adjacency[i] = -1;
     }
-    qsort(sorted_vertices, This->numvertices, sizeof(*sorted_vertices), compare_vertex_keys);
 
     for (i = 0; i < This->numvertices; i++) {
-        struct vertex_metadata *sorted_vertex_a = &sorted_vertices[i];
-        D3DXVECTOR3 *vertex_a = (D3DXVECTOR3*)(vertices + sorted_vertex_a->vertex_index * vertex_size);
-        DWORD shared_index_a = sorted_vertex_a->first_shared_index;
+        struct vertex_metadata *vertex_data_a = &vertex_data[i];
+        D3DXVECTOR3 *vertex_a = (D3DXVECTOR3*)(vertices + i * vertex_size);
+        DWORD shared_index_a = vertex_data_a->first_shared_index;
+        DWORD coincident_count = 0;
+
+        if (shared_index_a == -1)
+            continue;
+
+        /* Collect the coincident vertices that haven't been processed yet.
+         * Pairs with lower vertex indices were already handled when the
+         * other vertex was processed. */
+        if (epsilon >= 0.0f) {
+            int x, y, z;
+
+            for (x = -cell_radius; x <= cell_radius; x++)
+            for (y = -cell_radius; y <= cell_radius; y++)
+            for (z = -cell_radius; z <= cell_radius; z++)
+            {
+                int cell[3];
+                DWORD j;
+
+                cell[0] = vertex_data_a->cell[0] + x;
+                cell[1] = vertex_data_a->cell[1] + y;
+                cell[2] = vertex_data_a->cell[2] + z;
+                for (j = hash_table[hash_vertex_cell(cell, hash_mask)]; j != -1; j = vertex_data[j].next) {
+                    D3DXVECTOR3 *vertex_b;
+
+                    if (j <= i || vertex_data[j].cell[0] != cell[0]
+                            || vertex_data[j].cell[1] != cell[1] || vertex_data[j].cell[2] != cell[2])
+                        continue;
+                    /* check for coincidence */
+                    vertex_b = (D3DXVECTOR3*)(vertices + j * vertex_size);
+                    if (fabsf(vertex_a->x - vertex_b->x) <= epsilon &&
+                        fabsf(vertex_a->y - vertex_b->y) <= epsilon &&
+                        fabsf(vertex_a->z - vertex_b->z) <= epsilon)
+                    {
+                        coincident_vertices[coincident_count++] = j;
+                    }
+                }
+            }
+        }
 
         while (shared_index_a != -1) {
-            DWORD j = i;
+            DWORD j = 0;
             DWORD shared_index_b = shared_indices[shared_index_a];
-            struct vertex_metadata *sorted_vertex_b = sorted_vertex_a;
 
             while (TRUE) {
                 while (shared_index_b != -1) {
@@ -1336,31 +1416,13 @@ static HRESULT WINAPI d3dx9_mesh_GenerateAdjacency(ID3DXMesh *iface, float epsil
 
                     shared_index_b = shared_indices[shared_index_b];
                 }
-                while (++j < This->numvertices) {
-                    D3DXVECTOR3 *vertex_b;
-
-                    sorted_vertex_b++;
-                    if (sorted_vertex_b->key - sorted_vertex_a->key > epsilon * 3.0f) {
-                        /* no more coincident vertices to try */
-                        j = This->numvertices;
-                        break;
-                    }
-                    /* check for coincidence */
-                    vertex_b = (D3DXVECTOR3*)(vertices + sorted_vertex_b->vertex_index * vertex_size);
-                    if (fabsf(vertex_a->x - vertex_b->x) <= epsilon &&
-                        fabsf(vertex_a->y - vertex_b->y) <= epsilon &&
-                        fabsf(vertex_a->z - vertex_b->z) <= epsilon)
-                    {
-                        break;
-                    }
-                }
-                if (j >= This->numvertices)
+                if (j >= coincident_count)
                     break;
-                shared_index_b = sorted_vertex_b->first_shared_index;
+                shared_index_b = vertex_data[coincident_vertices[j++]].first_shared_index;
             }
 
-            sorted_vertex_a->first_shared_index = shared_indices[sorted_vertex_a->first_shared_index];
-            shared_index_a = sorted_vertex_a->first_shared_index;
+            vertex_data_a->first_shared_index = shared_indices[vertex_data_a->first_shared_index];
+            shared_index_a = vertex_data_a->first_shared_index;
         }
     }
 
@@ -1645,6 +1707,266 @@ static HRESULT remap_faces_for_attrsort(struct d3dx9_mesh *This, const DWORD *in
     return D3D_OK;
 }
 
+/* Vertex cache optimization, based on Tom Forsyth's "Linear-Speed Vertex
+ * Cache Optimisation". Faces are greedily emitted by picking the face whose
+ * vertices score best, where the score favours vertices that are in the
+ * simulated LRU cache and vertices with few remaining faces. */
+#define VERTEX_CACHE_SIZE 32
+
+struct vertex_cache_vertex
+{
+    float score;
+    int cache_position;
+    DWORD live_faces;
+    DWORD first_face;
+    DWORD face_count;
+};
+
+static float vertex_cache_score(const struct vertex_cache_vertex *vertex)
+{
+    float score = 0.0f;
+
+    if (!vertex->live_faces)
+        return -1.0f;
+
+    if (vertex->cache_position >= 0)
+    {
+        /* The last face's vertices get a fixed score, so that the optimizer
+         * doesn't prefer faces using them over faces using older vertices. */
+        if (vertex->cache_position < 3)
+            score = 0.75f;
+        else
+            score = powf(1.0f - (vertex->cache_position - 3) * (1.0f / (VERTEX_CACHE_SIZE - 3)), 1.5f);
+    }
+
+    /* Boost vertices with few faces left, to get rid of lone faces early. */
+    return score + 2.0f / sqrtf(vertex->live_faces);
+}
+
+/* Reorders the faces of each attribute range of face_order (new -> old
+ * mapping) for the post-transform vertex cache. */
+static HRESULT optimize_faces_for_vertex_cache(const DWORD *indices, DWORD num_vertices,
+        const DWORD *sorted_attrib_buffer, DWORD *face_order, DWORD num_faces)
+{
+    struct vertex_cache_vertex *vertex_data;
+    DWORD *faces, *vertex_faces;
+    float *face_scores;
+    BYTE *face_added;
+    DWORD start, end;
+    DWORD i, j, k;
+
+    vertex_data = HeapAlloc(GetProcessHeap(), 0, num_vertices * sizeof(*vertex_data));
+    faces = HeapAlloc(GetProcessHeap(), 0, num_faces * 4 * sizeof(*faces) + num_faces * sizeof(*face_scores)
+            + num_faces * sizeof(*face_added));
+    if (!vertex_data || !faces)
+    {
+        HeapFree(GetProcessHeap(), 0, vertex_data);
+        HeapFree(GetProcessHeap(), 0, faces);
+        return E_OUTOFMEMORY;
+    }
+    vertex_faces = faces + num_faces;
+    face_scores = (float *)(vertex_faces + num_faces * 3);
+    face_added = (BYTE *)(face_scores + num_faces);
+
+    memcpy(faces, face_order, num_faces * sizeof(*faces));
+
+    for (start = 0; start < num_faces; start = end)
+    {
+        DWORD cache[VERTEX_CACHE_SIZE + 3], new_cache[VERTEX_CACHE_SIZE + 3];
+        DWORD cache_size = 0, next_face = start;
+        DWORD best_face;
+        float best_score;
+
+        for (end = start + 1; end < num_faces && sorted_attrib_buffer[end] == sorted_attrib_buffer[start]; end++)
+            ;
+
+        /* build the list of faces using each vertex of the range */
+        for (i = start * 3; i < end * 3; i++)
+        {
+            struct vertex_cache_vertex *vertex = &vertex_data[indices[faces[i / 3] * 3 + i % 3]];
+
+            vertex->live_faces = 0;
+            vertex->face_count = 0;
+            vertex->first_face = ~0u;
+            vertex->cache_position = -1;
+        }
+        for (i = start * 3; i < end * 3; i++)
+            vertex_data[indices[faces[i / 3] * 3 + i % 3]].live_faces++;
+        for (i = start * 3, j = start * 3; i < end * 3; i++)
+        {
+            struct vertex_cache_vertex *vertex = &vertex_data[indices[faces[i / 3] * 3 + i % 3]];
+
+            if (vertex->first_face == ~0u)
+            {
+                vertex->first_face = j;
+                vertex->score = vertex_cache_score(vertex);
+                j += vertex->live_faces;
+            }
+            vertex_faces[vertex->first_face + vertex->face_count++] = i / 3;
+        }
+
+        best_face = start;
+        best_score = -1.0f;
+        for (i = start; i < end; i++)
+        {
+            const DWORD *face = &indices[faces[i] * 3];
+
+            face_scores[i] = vertex_data[face[0]].score + vertex_data[face[1]].score + vertex_data[face[2]].score;
+            face_added[i] = FALSE;
+            if (face_scores[i] > best_score)
+            {
+                best_score = face_scores[i];
+                best_face = i;
+            }
+        }
+
+        for (i = start; i < end; i++)
+        {
+            const DWORD *face;
+            DWORD new_cache_size;
+
+            if (best_face == ~0u)
+            {
+                /* nothing in the cache can be used, take the next face in the original order */
+                while (face_added[next_face])
+                    next_face++;
+                best_face = next_face;
+            }
+
+            face_order[i] = faces[best_face];
+            face_added[best_face] = TRUE;
+            face = &indices[faces[best_face] * 3];
+
+            /* remove the face from its vertices, and put them at the front of the cache */
+            new_cache_size = 3;
+            for (j = 0; j < 3; j++)
+            {
+                struct vertex_cache_vertex *vertex = &vertex_data[face[j]];
+                DWORD *list = &vertex_faces[vertex->first_face];
+
+                for (k = 0; list[k] != best_face; k++)
+                    ;
+                list[k] = list[--vertex->live_faces];
+                if (vertex->cache_position < 0)
+                    vertex->cache_position = 0;
+            }
+            for (j = 0; j < cache_size; j++)
+            {
+                DWORD vertex_index = cache[j];
+
+                if (vertex_index == face[0] || vertex_index == face[1] || vertex_index == face[2])
+                    continue;
+                new_cache[new_cache_size++] = vertex_index;
+            }
+            new_cache[0] = face[0];
+            new_cache[1] = face[1];
+            new_cache[2] = face[2];
+            memcpy(cache, new_cache, new_cache_size * sizeof(*cache));
+            cache_size = new_cache_size;
+
+            /* update the scores of the cached vertices and their faces */
+            best_face = ~0u;
+            best_score = -1.0f;
+            for (j = 0; j < cache_size; j++)
+            {
+                struct vertex_cache_vertex *vertex = &vertex_data[cache[j]];
+
+                vertex->cache_position = j < VERTEX_CACHE_SIZE ? j : -1;
+                vertex->score = vertex_cache_score(vertex);
+            }
+            for (j = 0; j < cache_size; j++)
+            {
+                const struct vertex_cache_vertex *vertex = &vertex_data[cache[j]];
+
+                for (k = 0; k < vertex->live_faces; k++)
+                {
+                    DWORD face_index = vertex_faces[vertex->first_face + k];
+                    const DWORD *cached_face = &indices[faces[face_index] * 3];
+
+                    face_scores[face_index] = vertex_data[cached_face[0]].score
+                            + vertex_data[cached_face[1]].score + vertex_data[cached_face[2]].score;
+                    if (face_scores[face_index] > best_score)
+                    {
+                        best_score = face_scores[face_index];
+                        best_face = face_index;
+                    }
+                }
+            }
+            if (cache_size > VERTEX_CACHE_SIZE)
+                cache_size = VERTEX_CACHE_SIZE;
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, faces);
+    HeapFree(GetProcessHeap(), 0, vertex_data);
+    return D3D_OK;
+}
+
+/* Creates a vertex_remap that orders the vertices by their first use in
+ * face_order, so that vertex fetches follow the face order. Unused vertices
+ * are removed if compact is set, and moved to the end otherwise.
+ * Indices are updated according to the vertex_remap. */
+static HRESULT remap_vertices_for_vertex_cache(struct d3dx9_mesh *This, DWORD *indices,
+        const DWORD *face_order, BOOL compact, DWORD *new_num_vertices, ID3DXBuffer **vertex_remap)
+{
+    DWORD *vertex_remap_ptr;
+    DWORD *old_to_new;
+    DWORD num_used_vertices;
+    HRESULT hr;
+    DWORD i, j;
+
+    old_to_new = HeapAlloc(GetProcessHeap(), 0, This->numvertices * sizeof(*old_to_new));
+    if (!old_to_new)
+        return E_OUTOFMEMORY;
+
+    hr = D3DXCreateBuffer(This->numvertices * sizeof(DWORD), vertex_remap);
+    if (FAILED(hr))
+    {
+        HeapFree(GetProcessHeap(), 0, old_to_new);
+        return hr;
+    }
+    vertex_remap_ptr = ID3DXBuffer_GetBufferPointer(*vertex_remap);
+
+    memset(old_to_new, 0xff, This->numvertices * sizeof(*old_to_new));
+    num_used_vertices = 0;
+    for (i = 0; i < This->numfaces; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            DWORD vertex_index = indices[face_order[i] * 3 + j];
+
+            if (old_to_new[vertex_index] == -1)
+                old_to_new[vertex_index] = num_used_vertices++;
+        }
+    }
+    if (!compact)
+    {
+        for (i = 0; i < This->numvertices; i++)
+        {
+            if (old_to_new[i] == -1)
+                old_to_new[i] = num_used_vertices++;
+        }
+    }
+
+    /* convert indices */
+    for (i = 0; i < This->numfaces * 3; i++)
+        indices[i] = old_to_new[indices[i]];
+
+    /* create new->old vertex mapping */
+    for (i = num_used_vertices; i < This->numvertices; i++)
+        vertex_remap_ptr[i] = -1;
+    for (i = 0; i < This->numvertices; i++)
+    {
+        if (old_to_new[i] != -1)
+            vertex_remap_ptr[old_to_new[i]] = i;
+    }
+
+    *new_num_vertices = num_used_vertices;
+
+    HeapFree(GetProcessHeap(), 0, old_to_new);
+    return D3D_OK;
+}
+
 static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags, const DWORD *adjacency_in,
         DWORD *adjacency_out, DWORD *face_remap_out, ID3DXBuffer **vertex_remap_out)
 {
@@ -1659,6 +1981,7 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
     DWORD new_num_alloc_vertices = 0;
     IDirect3DVertexBuffer9 *vertex_buffer = NULL;
     DWORD *sorted_attrib_buffer = NULL;
+    DWORD *face_order = NULL; /* new -> old mapping */
     DWORD i;
 
     TRACE("iface %p, flags %#x, adjacency_in %p, adjacency_out %p, face_remap_out %p, vertex_remap_out %p.\n",
@@ -1671,14 +1994,14 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
     if ((flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER)) == (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
         return D3DERR_INVALIDCALL;
 
-    if (flags & (D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_STRIPREORDER))
+    if (flags & D3DXMESHOPT_STRIPREORDER)
     {
-        if (flags & D3DXMESHOPT_VERTEXCACHE)
-            FIXME("D3DXMESHOPT_VERTEXCACHE not implemented.\n");
-        if (flags & D3DXMESHOPT_STRIPREORDER)
-            FIXME("D3DXMESHOPT_STRIPREORDER not implemented.\n");
+        FIXME("D3DXMESHOPT_STRIPREORDER not implemented.\n");
         return E_NOTIMPL;
     }
+    /* vertex cache optimization is done per attribute range */
+    if (flags & D3DXMESHOPT_VERTEXCACHE)
+        flags |= D3DXMESHOPT_ATTRSORT;
 
     hr = iface->lpVtbl->LockIndexBuffer(iface, 0, &indices);
     if (FAILED(hr)) goto cleanup;
@@ -1699,7 +2022,7 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
         hr = compact_mesh(This, dword_indices, &new_num_vertices, &vertex_remap);
         if (FAILED(hr)) goto cleanup;
     } else if (flags & D3DXMESHOPT_ATTRSORT) {
-        if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+        if (!(flags & (D3DXMESHOPT_IGNOREVERTS | D3DXMESHOPT_VERTEXCACHE)))
         {
             FIXME("D3DXMESHOPT_ATTRSORT vertex reordering not implemented.\n");
             hr = E_NOTIMPL;
@@ -1711,6 +2034,32 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
 
         hr = remap_faces_for_attrsort(This, dword_indices, attrib_buffer, &sorted_attrib_buffer, &face_remap);
         if (FAILED(hr)) goto cleanup;
+
+        if (flags & D3DXMESHOPT_VERTEXCACHE)
+        {
+            face_order = HeapAlloc(GetProcessHeap(), 0, This->numfaces * sizeof(*face_order));
+            if (!face_order)
+            {
+                hr = E_OUTOFMEMORY;
+                goto cleanup;
+            }
+            for (i = 0; i < This->numfaces; i++)
+                face_order[face_remap[i]] = i;
+
+            hr = optimize_faces_for_vertex_cache(dword_indices, This->numvertices,
+                    sorted_attrib_buffer, face_order, This->numfaces);
+            if (FAILED(hr)) goto cleanup;
+            for (i = 0; i < This->numfaces; i++)
+                face_remap[face_order[i]] = i;
+
+            if (!(flags & D3DXMESHOPT_IGNOREVERTS))
+            {
+                new_num_alloc_vertices = This->numvertices;
+                hr = remap_vertices_for_vertex_cache(This, dword_indices, face_order,
+                        !!(flags & D3DXMESHOPT_COMPACT), &new_num_vertices, &vertex_remap);
+                if (FAILED(hr)) goto cleanup;
+            }
+        }
     }
 
     if (vertex_remap)
@@ -1803,9 +2152,10 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
             for (i = 0; i < This->numfaces; i++) {
                 DWORD old_pos = i * 3;
                 DWORD new_pos = face_remap[i] * 3;
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
-                adjacency_out[new_pos++] = face_remap[adjacency_in[old_pos++]];
+                DWORD j;
+
+                for (j = 0; j < 3; j++, old_pos++)
+                    adjacency_out[new_pos++] = adjacency_in[old_pos] == -1 ? -1 : face_remap[adjacency_in[old_pos]];
             }
         } else {
             memcpy(adjacency_out, adjacency_in, This->numfaces * 3 * sizeof(*adjacency_out));
@@ -1833,6 +2183,7 @@ static HRESULT WINAPI d3dx9_mesh_OptimizeInplace(ID3DXMesh *iface, DWORD flags,
 
     hr = D3D_OK;
 cleanup:
+    HeapFree(GetProcessHeap(), 0, face_order);
     HeapFree(GetProcessHeap(), 0, sorted_attrib_buffer);
     HeapFree(GetProcessHeap(), 0, face_remap);
     HeapFree(GetProcessHeap(), 0, dword_indices);
@@ -18,10 +18,17 @@
  *
  */
 
+#include "config.h"
+#include "wine/port.h"
+
 #include "wine/debug.h"
 #include "wine/unicode.h"
 #include "d3dx9_36_private.h"
 
+#ifdef D3DX_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "initguid.h"
 #include "ole2.h"
 #include "wincodec.h"
@@ -1519,6 +1526,23 @@ void copy_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch,
     }
 }
 
+/* Pixels can be copied with a mask when both formats are the same integer
+ * ARGB format. The mask clears unused bits, like a conversion would. */
+static BOOL get_pixel_copy_mask(const struct pixel_format_desc *src_format,
+        const struct pixel_format_desc *dst_format, D3DCOLOR color_key, DWORD *mask)
+{
+    unsigned int c;
+
+    if (src_format != dst_format || color_key || src_format->type != FORMAT_ARGB
+            || src_format->to_rgba || src_format->from_rgba || src_format->bytes_per_pixel > 4)
+        return FALSE;
+
+    *mask = 0;
+    for (c = 0; c < 4; ++c)
+        *mask |= ((1u << src_format->bits[c]) - 1) << src_format->shift[c];
+    return TRUE;
+}
+
 /************************************************************
  * convert_argb_pixels
  *
@@ -1534,12 +1558,14 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
 {
     struct argb_conversion_info conv_info, ck_conv_info;
     const struct pixel_format_desc *ck_format = NULL;
-    DWORD channels[4];
+    DWORD channels[4], copy_mask;
     UINT min_width, min_height, min_depth;
     UINT x, y, z;
+    BOOL copy;
 
     ZeroMemory(channels, sizeof(channels));
     init_argb_conversion_info(src_format, dst_format, &conv_info);
+    copy = get_pixel_copy_mask(src_format, dst_format, color_key, &copy_mask);
 
     min_width = min(src_size->width, dst_size->width);
     min_height = min(src_size->height, dst_size->height);
@@ -1561,7 +1587,15 @@ void convert_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pit
             BYTE *dst_ptr = dst_slice_ptr + y * dst_row_pitch;
 
             for (x = 0; x < min_width; x++) {
-                if (!src_format->to_rgba && !dst_format->from_rgba
+                if (copy)
+                {
+                    DWORD val = 0;
+
+                    memcpy(&val, src_ptr, src_format->bytes_per_pixel);
+                    val &= copy_mask;
+                    memcpy(dst_ptr, &val, dst_format->bytes_per_pixel);
+                }
+                else if (!src_format->to_rgba && !dst_format->from_rgba
                         && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
                 {
                     DWORD val;
@@ -1637,11 +1671,13 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
 {
     struct argb_conversion_info conv_info, ck_conv_info;
     const struct pixel_format_desc *ck_format = NULL;
-    DWORD channels[4];
+    DWORD channels[4], copy_mask;
     UINT x, y, z;
+    BOOL copy;
 
     ZeroMemory(channels, sizeof(channels));
     init_argb_conversion_info(src_format, dst_format, &conv_info);
+    copy = get_pixel_copy_mask(src_format, dst_format, color_key, &copy_mask);
 
     if (color_key)
     {
@@ -1664,7 +1700,15 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
             {
                 const BYTE *src_ptr = src_row_ptr + (x * src_size->width / dst_size->width) * src_format->bytes_per_pixel;
 
-                if (!src_format->to_rgba && !dst_format->from_rgba
+                if (copy)
+                {
+                    DWORD val = 0;
+
+                    memcpy(&val, src_ptr, src_format->bytes_per_pixel);
+                    val &= copy_mask;
+                    memcpy(dst_ptr, &val, dst_format->bytes_per_pixel);
+                }
+                else if (!src_format->to_rgba && !dst_format->from_rgba
                         && src_format->bytes_per_pixel <= 4 && dst_format->bytes_per_pixel <= 4)
                 {
                     DWORD val;
@@ -1716,6 +1760,482 @@ void point_filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slic
     }
 }
 
+/* D3DX_FILTER_LINEAR, D3DX_FILTER_TRIANGLE and D3DX_FILTER_BOX are separable.
+ * Each axis has a list of contiguous source taps and their weights for every
+ * destination pixel. */
+struct filter_tap
+{
+    unsigned int first;
+    unsigned int count;
+};
+
+struct filter_axis
+{
+    struct filter_tap *taps;
+    float *weights;
+    unsigned int max_taps;
+};
+
+static float filter_weight(DWORD filter, float offset, float radius)
+{
+    switch (filter & 0xf)
+    {
+        case D3DX_FILTER_BOX:
+            /* Coverage of the source pixel by the destination pixel footprint. */
+            return min(offset + 0.5f, radius) - max(offset - 0.5f, -radius);
+
+        case D3DX_FILTER_LINEAR:
+        case D3DX_FILTER_TRIANGLE:
+        default:
+            return 1.0f - fabsf(offset) / radius;
+    }
+}
+
+static BOOL init_filter_axis(struct filter_axis *axis, unsigned int src_count, unsigned int dst_count, DWORD filter)
+{
+    float scale = (float)src_count / dst_count, radius, center, sum, w;
+    struct filter_tap *tap;
+    unsigned int x, i;
+    float *weights;
+    int start, end;
+
+    switch (filter & 0xf)
+    {
+        case D3DX_FILTER_LINEAR:
+            radius = 1.0f;
+            break;
+
+        case D3DX_FILTER_TRIANGLE:
+            radius = max(scale, 1.0f);
+            break;
+
+        case D3DX_FILTER_BOX:
+        default:
+            radius = scale / 2.0f;
+            break;
+    }
+
+    axis->max_taps = (unsigned int)ceilf(2.0f * radius) + 2;
+    axis->taps = HeapAlloc(GetProcessHeap(), 0, dst_count * sizeof(*axis->taps));
+    axis->weights = HeapAlloc(GetProcessHeap(), 0, dst_count * axis->max_taps * sizeof(*axis->weights));
+    if (!axis->taps || !axis->weights)
+    {
+        HeapFree(GetProcessHeap(), 0, axis->taps);
+        HeapFree(GetProcessHeap(), 0, axis->weights);
+        return FALSE;
+    }
+
+    for (x = 0; x < dst_count; ++x)
+    {
+        tap = &axis->taps[x];
+        weights = &axis->weights[x * axis->max_taps];
+        center = (x + 0.5f) * scale - 0.5f;
+        start = max((int)floorf(center - radius), 0);
+        end = min((int)ceilf(center + radius), (int)src_count - 1);
+
+        /* Source pixels outside the image are dropped and the remaining
+         * weights renormalized, which clamps to the edge. */
+        tap->first = start;
+        tap->count = 0;
+        sum = 0.0f;
+        for (; start <= end && tap->count < axis->max_taps; ++start)
+        {
+            if ((w = filter_weight(filter, start - center, radius)) <= 0.0f)
+            {
+                if (tap->count)
+                    break;
+                ++tap->first;
+                continue;
+            }
+            weights[tap->count++] = w;
+            sum += w;
+        }
+
+        if (!tap->count)
+        {
+            tap->first = min((unsigned int)max(center + 0.5f, 0.0f), src_count - 1);
+            tap->count = 1;
+            weights[0] = 1.0f;
+            continue;
+        }
+        for (i = 0; i < tap->count; ++i)
+            weights[i] /= sum;
+    }
+
+    return TRUE;
+}
+
+static void cleanup_filter_axis(struct filter_axis *axis)
+{
+    HeapFree(GetProcessHeap(), 0, axis->taps);
+    HeapFree(GetProcessHeap(), 0, axis->weights);
+}
+
+/* Formats with only byte sized and byte aligned channels are decoded and
+ * encoded directly instead of going through format_to_vec4(). */
+static BOOL is_byte_argb_format(const struct pixel_format_desc *format)
+{
+    unsigned int c;
+
+    if (format->type != FORMAT_ARGB || format->to_rgba || format->from_rgba || format->bytes_per_pixel > 4)
+        return FALSE;
+
+    for (c = 0; c < 4; ++c)
+    {
+        if (format->bits[c] && (format->bits[c] != 8 || format->shift[c] % 8))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+struct filter_context
+{
+    const BYTE *src;
+    UINT src_row_pitch, src_slice_pitch;
+    const struct volume *src_size;
+    const struct pixel_format_desc *src_format;
+    BYTE *dst;
+    UINT dst_row_pitch, dst_slice_pitch;
+    const struct volume *dst_size;
+    const struct pixel_format_desc *dst_format;
+    const struct pixel_format_desc *ck_format;
+    D3DCOLOR color_key;
+    const PALETTEENTRY *palette;
+    BOOL byte_src, byte_dst;
+    struct filter_axis x, y, z;
+};
+
+static void decode_row(const struct filter_context *ctx, const BYTE *src, struct vec4 *dst)
+{
+    static const unsigned int component_offsets[4] = {3, 0, 1, 2};
+    const struct pixel_format_desc *format = ctx->src_format;
+    unsigned int x, c;
+
+    if (ctx->byte_src)
+    {
+        for (x = 0; x < ctx->src_size->width; ++x, src += format->bytes_per_pixel)
+        {
+            float *component = (float *)&dst[x];
+            DWORD argb = 0;
+            BYTE v;
+
+            for (c = 0; c < 4; ++c)
+            {
+                v = format->bits[c] ? src[format->shift[c] / 8] : 0xff;
+                component[component_offsets[c]] = v / 255.0f;
+                argb |= v << (24 - c * 8);
+            }
+            if (ctx->color_key && argb == ctx->color_key)
+                dst[x].w = 0.0f;
+        }
+        return;
+    }
+
+    for (x = 0; x < ctx->src_size->width; ++x, src += format->bytes_per_pixel)
+    {
+        struct vec4 color;
+
+        format_to_vec4(format, src, &color);
+        if (format->to_rgba)
+            format->to_rgba(&color, &dst[x], ctx->palette);
+        else
+            dst[x] = color;
+
+        if (ctx->ck_format)
+        {
+            DWORD ck_pixel;
+
+            format_from_vec4(ctx->ck_format, &dst[x], (BYTE *)&ck_pixel);
+            if (ck_pixel == ctx->color_key)
+                dst[x].w = 0.0f;
+        }
+    }
+}
+
+static void encode_row(const struct filter_context *ctx, const struct vec4 *src, BYTE *dst)
+{
+    static const unsigned int component_offsets[4] = {3, 0, 1, 2};
+    const struct pixel_format_desc *format = ctx->dst_format;
+    unsigned int x, c;
+
+    if (ctx->byte_dst)
+    {
+        for (x = 0; x < ctx->dst_size->width; ++x, dst += format->bytes_per_pixel)
+        {
+            const float *component = (const float *)&src[x];
+            float v;
+
+            memset(dst, 0, format->bytes_per_pixel);
+            for (c = 0; c < 4; ++c)
+            {
+                if (!format->bits[c])
+                    continue;
+                v = component[component_offsets[c]];
+                dst[format->shift[c] / 8] = v <= 0.0f ? 0 : v >= 1.0f ? 0xff : (BYTE)(v * 255.0f + 0.5f);
+            }
+        }
+        return;
+    }
+
+    for (x = 0; x < ctx->dst_size->width; ++x, dst += format->bytes_per_pixel)
+    {
+        struct vec4 color;
+
+        if (format->from_rgba)
+        {
+            format->from_rgba(&src[x], &color);
+            format_from_vec4(format, &color, dst);
+        }
+        else
+        {
+            format_from_vec4(format, &src[x], dst);
+        }
+    }
+}
+
+static void filter_row_horizontal(const struct filter_axis *axis, const struct vec4 *src,
+        struct vec4 *dst, unsigned int width)
+{
+    const struct filter_tap *tap;
+    const float *weights;
+    unsigned int x, i;
+
+    for (x = 0; x < width; ++x)
+    {
+        tap = &axis->taps[x];
+        weights = &axis->weights[x * axis->max_taps];
+        dst[x].x = dst[x].y = dst[x].z = dst[x].w = 0.0f;
+        for (i = 0; i < tap->count; ++i)
+        {
+            const struct vec4 *s = &src[tap->first + i];
+
+            dst[x].x += weights[i] * s->x;
+            dst[x].y += weights[i] * s->y;
+            dst[x].z += weights[i] * s->z;
+            dst[x].w += weights[i] * s->w;
+        }
+    }
+}
+
+static void accumulate_row(struct vec4 *dst, const struct vec4 *src, float weight, unsigned int width)
+{
+    unsigned int x;
+
+    for (x = 0; x < width; ++x)
+    {
+        dst[x].x += weight * src[x].x;
+        dst[x].y += weight * src[x].y;
+        dst[x].z += weight * src[x].z;
+        dst[x].w += weight * src[x].w;
+    }
+}
+
+#ifdef D3DX_SSE
+static void D3DX_SSE_FUNC filter_row_horizontal_sse(const struct filter_axis *axis, const struct vec4 *src,
+        struct vec4 *dst, unsigned int width)
+{
+    const struct filter_tap *tap;
+    const float *weights;
+    unsigned int x, i;
+    __m128 sum;
+
+    for (x = 0; x < width; ++x)
+    {
+        tap = &axis->taps[x];
+        weights = &axis->weights[x * axis->max_taps];
+        sum = _mm_setzero_ps();
+        for (i = 0; i < tap->count; ++i)
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]),
+                    _mm_loadu_ps(&src[tap->first + i].x)));
+        _mm_storeu_ps(&dst[x].x, sum);
+    }
+}
+
+static void D3DX_SSE_FUNC accumulate_row_sse(struct vec4 *dst, const struct vec4 *src,
+        float weight, unsigned int width)
+{
+    const __m128 w = _mm_set1_ps(weight);
+    unsigned int x;
+
+    for (x = 0; x < width; ++x)
+        _mm_storeu_ps(&dst[x].x, _mm_add_ps(_mm_loadu_ps(&dst[x].x),
+                _mm_mul_ps(w, _mm_loadu_ps(&src[x].x))));
+}
+#endif
+
+/* Horizontally filtered source rows, indexed by their position in the
+ * source image modulo the number of taps. Consecutive destination rows
+ * mostly share their source rows. */
+struct filter_row_cache
+{
+    struct vec4 *line;
+    struct vec4 *accum;
+    struct vec4 *rows;
+    int *tags;
+};
+
+static const struct vec4 *get_filtered_row(const struct filter_context *ctx,
+        struct filter_row_cache *cache, unsigned int sz, unsigned int sy)
+{
+    unsigned int slot = (sz % ctx->z.max_taps) * ctx->y.max_taps + sy % ctx->y.max_taps;
+    int tag = sz * ctx->src_size->height + sy;
+    struct vec4 *row = &cache->rows[slot * ctx->dst_size->width];
+
+    if (cache->tags[slot] == tag)
+        return row;
+
+    decode_row(ctx, ctx->src + sz * ctx->src_slice_pitch + sy * ctx->src_row_pitch, cache->line);
+#ifdef D3DX_SSE
+    if (d3dx_cpu_has_sse())
+        filter_row_horizontal_sse(&ctx->x, cache->line, row, ctx->dst_size->width);
+    else
+#endif
+        filter_row_horizontal(&ctx->x, cache->line, row, ctx->dst_size->width);
+    cache->tags[slot] = tag;
+
+    return row;
+}
+
+static void filter_rows(void *context, unsigned int row, unsigned int row_count)
+{
+    const struct filter_context *ctx = context;
+    unsigned int width = ctx->dst_size->width, height = ctx->dst_size->height;
+    unsigned int slot_count = ctx->y.max_taps * ctx->z.max_taps;
+    const struct filter_tap *y_tap, *z_tap;
+    const float *y_weights, *z_weights;
+    struct filter_row_cache cache;
+    unsigned int i, j, y, z;
+
+    cache.line = HeapAlloc(GetProcessHeap(), 0, ctx->src_size->width * sizeof(*cache.line));
+    cache.accum = HeapAlloc(GetProcessHeap(), 0, width * sizeof(*cache.accum));
+    cache.rows = HeapAlloc(GetProcessHeap(), 0, slot_count * width * sizeof(*cache.rows));
+    cache.tags = HeapAlloc(GetProcessHeap(), 0, slot_count * sizeof(*cache.tags));
+    if (!cache.line || !cache.accum || !cache.rows || !cache.tags)
+    {
+        ERR("Failed to allocate filter buffers.\n");
+        goto done;
+    }
+    memset(cache.tags, 0xff, slot_count * sizeof(*cache.tags));
+
+    for (; row_count--; ++row)
+    {
+        z = row / height;
+        y = row % height;
+        z_tap = &ctx->z.taps[z];
+        z_weights = &ctx->z.weights[z * ctx->z.max_taps];
+        y_tap = &ctx->y.taps[y];
+        y_weights = &ctx->y.weights[y * ctx->y.max_taps];
+
+        memset(cache.accum, 0, width * sizeof(*cache.accum));
+        for (i = 0; i < z_tap->count; ++i)
+        {
+            for (j = 0; j < y_tap->count; ++j)
+            {
+                const struct vec4 *src_row = get_filtered_row(ctx, &cache, z_tap->first + i, y_tap->first + j);
+                float weight = z_weights[i] * y_weights[j];
+
+#ifdef D3DX_SSE
+                if (d3dx_cpu_has_sse())
+                    accumulate_row_sse(cache.accum, src_row, weight, width);
+                else
+#endif
+                    accumulate_row(cache.accum, src_row, weight, width);
+            }
+        }
+
+        encode_row(ctx, cache.accum, ctx->dst + z * ctx->dst_slice_pitch + y * ctx->dst_row_pitch);
+    }
+
+done:
+    HeapFree(GetProcessHeap(), 0, cache.line);
+    HeapFree(GetProcessHeap(), 0, cache.accum);
+    HeapFree(GetProcessHeap(), 0, cache.rows);
+    HeapFree(GetProcessHeap(), 0, cache.tags);
+}
+
+/************************************************************
+ * filter_argb_pixels
+ *
+ * Copies the source buffer to the destination buffer, performing
+ * any necessary format conversion, color keying and stretching
+ * using a box, linear or triangle filter.
+ * The rows of large images are filtered on several threads.
+ * Works only for ARGB formats.
+ */
+void filter_argb_pixels(const BYTE *src, UINT src_row_pitch, UINT src_slice_pitch, const struct volume *src_size,
+        const struct pixel_format_desc *src_format, BYTE *dst, UINT dst_row_pitch, UINT dst_slice_pitch,
+        const struct volume *dst_size, const struct pixel_format_desc *dst_format, D3DCOLOR color_key,
+        const PALETTEENTRY *palette, DWORD filter)
+{
+    struct filter_context ctx;
+
+    if ((filter & 0xf) != D3DX_FILTER_LINEAR && (filter & 0xf) != D3DX_FILTER_TRIANGLE
+            && (filter & 0xf) != D3DX_FILTER_BOX)
+    {
+        FIXME("Unhandled filter %#x.\n", filter);
+        point_filter_argb_pixels(src, src_row_pitch, src_slice_pitch, src_size, src_format,
+                dst, dst_row_pitch, dst_slice_pitch, dst_size, dst_format, color_key, palette);
+        return;
+    }
+
+    /* Nothing to filter, a point filter gives an exact conversion. */
+    if (src_size->width == dst_size->width && src_size->height == dst_size->height
+            && src_size->depth == dst_size->depth)
+    {
+        point_filter_argb_pixels(src, src_row_pitch, src_slice_pitch, src_size, src_format,
+                dst, dst_row_pitch, dst_slice_pitch, dst_size, dst_format, color_key, palette);
+        return;
+    }
+
+    ctx.src = src;
+    ctx.src_row_pitch = src_row_pitch;
+    ctx.src_slice_pitch = src_slice_pitch;
+    ctx.src_size = src_size;
+    ctx.src_format = src_format;
+    ctx.dst = dst;
+    ctx.dst_row_pitch = dst_row_pitch;
+    ctx.dst_slice_pitch = dst_slice_pitch;
+    ctx.dst_size = dst_size;
+    ctx.dst_format = dst_format;
+    /* Color keys are always represented in D3DFMT_A8R8G8B8 format. */
+    ctx.ck_format = color_key ? get_format_info(D3DFMT_A8R8G8B8) : NULL;
+    ctx.color_key = color_key;
+    ctx.palette = palette;
+    ctx.byte_src = is_byte_argb_format(src_format);
+    ctx.byte_dst = is_byte_argb_format(dst_format);
+
+    if (!init_filter_axis(&ctx.x, src_size->width, dst_size->width, filter))
+        goto fail;
+    if (!init_filter_axis(&ctx.y, src_size->height, dst_size->height, filter))
+    {
+        cleanup_filter_axis(&ctx.x);
+        goto fail;
+    }
+    if (!init_filter_axis(&ctx.z, src_size->depth, dst_size->depth, filter))
+    {
+        cleanup_filter_axis(&ctx.y);
+        cleanup_filter_axis(&ctx.x);
+        goto fail;
+    }
+
+    TRACE("Filtering %ux%ux%u -> %ux%ux%u, %u/%u/%u taps.\n", src_size->width, src_size->height,
+            src_size->depth, dst_size->width, dst_size->height, dst_size->depth,
+            ctx.x.max_taps, ctx.y.max_taps, ctx.z.max_taps);
+
+    run_rows_parallel(filter_rows, &ctx, dst_size->height * dst_size->depth,
+            dst_size->width * sizeof(struct vec4) * ctx.y.max_taps * ctx.z.max_taps);
+
+    cleanup_filter_axis(&ctx.z);
+    cleanup_filter_axis(&ctx.y);
+    cleanup_filter_axis(&ctx.x);
+    return;
+
+fail:
+    ERR("Failed to allocate filter weights, falling back to a point filter.\n");
+    point_filter_argb_pixels(src, src_row_pitch, src_slice_pitch, src_size, src_format,
+            dst, dst_row_pitch, dst_slice_pitch, dst_size, dst_format, color_key, palette);
+}
+
 /************************************************************
  * D3DXLoadSurfaceFromMemory
  *
@@ -1853,16 +2373,17 @@ HRESULT WINAPI D3DXLoadSurfaceFromMemory(IDirect3DSurface9 *dst_surface,
             convert_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
                     lockrect.pBits, lockrect.Pitch, 0, &dst_size, destformatdesc, color_key, src_palette);
         }
-        else /* if ((filter & 0xf) == D3DX_FILTER_POINT) */
+        else if ((filter & 0xf) == D3DX_FILTER_POINT)
         {
-            if ((filter & 0xf) != D3DX_FILTER_POINT)
-                FIXME("Unhandled filter %#x.\n", filter);
-
-            /* Always apply a point filter until D3DX_FILTER_LINEAR,
-             * D3DX_FILTER_TRIANGLE and D3DX_FILTER_BOX are implemented. */
             point_filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
                     lockrect.pBits, lockrect.Pitch, 0, &dst_size, destformatdesc, color_key, src_palette);
         }
+        else
+        {
+            filter_argb_pixels(src_memory, src_pitch, 0, &src_size, srcformatdesc,
+                    lockrect.pBits, lockrect.Pitch, 0, &dst_size, destformatdesc, color_key, src_palette,
+                    filter);
+        }
 
         IDirect3DSurface9_UnlockRect(dst_surface);
     }
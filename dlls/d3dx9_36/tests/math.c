@@ -2337,6 +2337,139 @@ static void test_D3DXVec_Array(void)
     compare_planes(exp_plane, out_plane);
 }
 
+/* Results can be computed in a different order or precision than by the
+ * single vector functions, so use an absolute error for small values. */
+static BOOL compare_vec4_batch(const D3DXVECTOR4 *expected, const D3DXVECTOR4 *got, unsigned int components)
+{
+    const float *e = &expected->x, *g = &got->x;
+    unsigned int i;
+
+    for (i = 0; i < components; ++i)
+    {
+        if (fabsf(e[i] - g[i]) > admitted_error * max(1.0f, fabsf(e[i])))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void test_D3DXVec_Array_batch(void)
+{
+    static const unsigned int count = 65536, iterations = 16;
+    D3DXVECTOR4 *inp_vec, *out_vec, exp_vec;
+    D3DXMATRIX mat, mat2, exp_mat, out_mat;
+    unsigned int i, j, seed = 1;
+    DWORD start, time;
+    BOOL equal;
+
+    inp_vec = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*inp_vec));
+    out_vec = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*out_vec));
+
+    for (i = 0; i < count; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        inp_vec[i].x = ((int)(seed >> 16) - 32768) / 32768.0f;
+        seed = seed * 1103515245 + 12345;
+        inp_vec[i].y = ((int)(seed >> 16) - 32768) / 32768.0f;
+        seed = seed * 1103515245 + 12345;
+        inp_vec[i].z = ((int)(seed >> 16) - 32768) / 32768.0f;
+        inp_vec[i].w = 1.0f;
+    }
+
+    D3DXMatrixRotationYawPitchRoll(&mat, 0.3f, 1.1f, -0.7f);
+    U(mat).m[0][3] = 0.01f; U(mat).m[1][3] = -0.02f; U(mat).m[2][3] = 0.005f;
+    U(mat).m[3][0] = 10.0f; U(mat).m[3][1] = -20.0f; U(mat).m[3][2] = 30.0f; U(mat).m[3][3] = 2.0f;
+
+    /* D3DXVec3TransformArray */
+    start = GetTickCount();
+    for (j = 0; j < iterations; ++j)
+        D3DXVec3TransformArray(out_vec, sizeof(*out_vec), (D3DXVECTOR3 *)inp_vec, sizeof(*inp_vec), &mat, count);
+    time = GetTickCount() - start;
+    for (i = 0, equal = TRUE; i < count && equal; ++i)
+    {
+        D3DXVec3Transform(&exp_vec, (D3DXVECTOR3 *)&inp_vec[i], &mat);
+        equal = compare_vec4_batch(&exp_vec, &out_vec[i], 4);
+    }
+    ok(equal, "Got unexpected vector %u.\n", i - 1);
+    trace("D3DXVec3TransformArray: %u vectors in %u ms.\n", count * iterations, time);
+
+    /* D3DXVec3TransformCoordArray */
+    for (i = 0; i < count; ++i)
+        out_vec[i].w = 5.0f;
+    start = GetTickCount();
+    for (j = 0; j < iterations; ++j)
+        D3DXVec3TransformCoordArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec),
+                (D3DXVECTOR3 *)inp_vec, sizeof(*inp_vec), &mat, count);
+    time = GetTickCount() - start;
+    for (i = 0, equal = TRUE; i < count && equal; ++i)
+    {
+        D3DXVec3TransformCoord((D3DXVECTOR3 *)&exp_vec, (D3DXVECTOR3 *)&inp_vec[i], &mat);
+        equal = compare_vec4_batch(&exp_vec, &out_vec[i], 3) && out_vec[i].w == 5.0f;
+    }
+    ok(equal, "Got unexpected vector %u.\n", i - 1);
+    trace("D3DXVec3TransformCoordArray: %u vectors in %u ms.\n", count * iterations, time);
+
+    /* D3DXVec3TransformNormalArray */
+    start = GetTickCount();
+    for (j = 0; j < iterations; ++j)
+        D3DXVec3TransformNormalArray((D3DXVECTOR3 *)out_vec, sizeof(*out_vec),
+                (D3DXVECTOR3 *)inp_vec, sizeof(*inp_vec), &mat, count);
+    time = GetTickCount() - start;
+    for (i = 0, equal = TRUE; i < count && equal; ++i)
+    {
+        D3DXVec3TransformNormal((D3DXVECTOR3 *)&exp_vec, (D3DXVECTOR3 *)&inp_vec[i], &mat);
+        equal = compare_vec4_batch(&exp_vec, &out_vec[i], 3) && out_vec[i].w == 5.0f;
+    }
+    ok(equal, "Got unexpected vector %u.\n", i - 1);
+    trace("D3DXVec3TransformNormalArray: %u vectors in %u ms.\n", count * iterations, time);
+
+    /* D3DXVec4TransformArray, in place */
+    memcpy(out_vec, inp_vec, count * sizeof(*out_vec));
+    start = GetTickCount();
+    D3DXVec4TransformArray(out_vec, sizeof(*out_vec), out_vec, sizeof(*out_vec), &mat, count);
+    time = GetTickCount() - start;
+    for (i = 0, equal = TRUE; i < count && equal; ++i)
+    {
+        D3DXVec4Transform(&exp_vec, &inp_vec[i], &mat);
+        equal = compare_vec4_batch(&exp_vec, &out_vec[i], 4);
+    }
+    ok(equal, "Got unexpected vector %u.\n", i - 1);
+    start = GetTickCount();
+    for (j = 0; j < iterations; ++j)
+        D3DXVec4TransformArray(out_vec, sizeof(*out_vec), inp_vec, sizeof(*inp_vec), &mat, count);
+    time = GetTickCount() - start;
+    trace("D3DXVec4TransformArray: %u vectors in %u ms.\n", count * iterations, time);
+
+    /* D3DXMatrixMultiply, with the output aliasing the inputs */
+    D3DXMatrixRotationAxis(&mat2, (D3DXVECTOR3 *)&inp_vec[1], 0.5f);
+    U(mat2).m[3][0] = -3.0f; U(mat2).m[3][1] = 4.0f; U(mat2).m[3][2] = 0.5f;
+    for (i = 0; i < 4; ++i)
+    {
+        for (j = 0; j < 4; ++j)
+            U(exp_mat).m[i][j] = U(mat).m[i][0] * U(mat2).m[0][j] + U(mat).m[i][1] * U(mat2).m[1][j]
+                    + U(mat).m[i][2] * U(mat2).m[2][j] + U(mat).m[i][3] * U(mat2).m[3][j];
+    }
+    out_mat = mat;
+    D3DXMatrixMultiply(&out_mat, &out_mat, &mat2);
+    expect_mat(&exp_mat, &out_mat);
+    out_mat = mat2;
+    D3DXMatrixMultiply(&out_mat, &mat, &out_mat);
+    expect_mat(&exp_mat, &out_mat);
+    D3DXMatrixTranspose(&exp_mat, &exp_mat);
+    out_mat = mat;
+    D3DXMatrixMultiplyTranspose(&out_mat, &out_mat, &mat2);
+    expect_mat(&exp_mat, &out_mat);
+
+    out_mat = mat;
+    start = GetTickCount();
+    for (j = 0; j < count * iterations; ++j)
+        D3DXMatrixMultiply(&out_mat, &mat2, &mat);
+    time = GetTickCount() - start;
+    trace("D3DXMatrixMultiply: %u matrices in %u ms.\n", count * iterations, time);
+
+    HeapFree(GetProcessHeap(), 0, out_vec);
+    HeapFree(GetProcessHeap(), 0, inp_vec);
+}
+
 static void test_D3DXFloat_Array(void)
 {
     static const float z = 0.0f;
@@ -3391,6 +3524,7 @@ START_TEST(math)
     test_Matrix_Decompose();
     test_Matrix_Transformation2D();
     test_D3DXVec_Array();
+    test_D3DXVec_Array_batch();
     test_D3DXFloat_Array();
     test_D3DXSHAdd();
     test_D3DXSHDot();
@@ -10603,6 +10603,189 @@ static void test_optimize_faces(void)
     "faces when using 16-bit indices. Got %x\n, expected D3DERR_INVALIDCALL\n", hr);
 }
 
+/* Average number of post-transform vertex cache misses per face, for a FIFO
+ * cache of 16 entries. */
+static float compute_acmr(const DWORD *indices, DWORD num_faces)
+{
+    DWORD cache[16], misses = 0, cache_size = 0;
+    DWORD i, j;
+
+    for (i = 0; i < num_faces * 3; i++)
+    {
+        for (j = 0; j < cache_size; j++)
+        {
+            if (cache[j] == indices[i])
+                break;
+        }
+        if (j < cache_size)
+            continue;
+
+        misses++;
+        if (cache_size < ARRAY_SIZE(cache))
+            cache_size++;
+        memmove(&cache[1], &cache[0], (cache_size - 1) * sizeof(*cache));
+        cache[0] = indices[i];
+    }
+
+    return (float)misses / num_faces;
+}
+
+static void test_optimize_vertex_cache(void)
+{
+    static const unsigned int grid_size = 64;
+    const DWORD num_vertices = (grid_size + 1) * (grid_size + 1);
+    const DWORD num_faces = grid_size * grid_size * 2;
+    DWORD *adjacency, *adjacency_out, *face_remap, *vertex_remap_ptr;
+    ID3DXMesh *mesh, *split_mesh;
+    struct test_context *test_context;
+    D3DXVECTOR3 *vertices, *split_vertices, *old_positions;
+    ID3DXBuffer *vertex_remap;
+    DWORD *indices, *split_indices, *attributes;
+    DWORD i, j, x, y, start, count;
+    unsigned int seed = 1;
+    float acmr_before, acmr_after;
+    HRESULT hr;
+
+    test_context = new_test_context();
+    if (!test_context)
+    {
+        skip("Couldn't create test context\n");
+        return;
+    }
+
+    hr = D3DXCreateMeshFVF(num_faces, num_vertices, D3DXMESH_32BIT | D3DXMESH_SYSTEMMEM,
+            D3DFVF_XYZ, test_context->device, &mesh);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    hr = D3DXCreateMeshFVF(num_faces, num_faces * 3, D3DXMESH_32BIT | D3DXMESH_SYSTEMMEM,
+            D3DFVF_XYZ, test_context->device, &split_mesh);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+
+    adjacency = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*adjacency));
+    adjacency_out = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*adjacency_out));
+    face_remap = HeapAlloc(GetProcessHeap(), 0, num_faces * sizeof(*face_remap));
+    old_positions = HeapAlloc(GetProcessHeap(), 0, num_faces * 3 * sizeof(*old_positions));
+
+    /* A grid, with the faces shuffled and split in two attribute ranges. */
+    mesh->lpVtbl->LockVertexBuffer(mesh, 0, (void **)&vertices);
+    for (y = 0; y <= grid_size; y++)
+    {
+        for (x = 0; x <= grid_size; x++)
+        {
+            vertices[y * (grid_size + 1) + x].x = x;
+            vertices[y * (grid_size + 1) + x].y = y;
+            vertices[y * (grid_size + 1) + x].z = 0.0f;
+        }
+    }
+    mesh->lpVtbl->LockIndexBuffer(mesh, 0, (void **)&indices);
+    for (y = 0; y < grid_size; y++)
+    {
+        for (x = 0; x < grid_size; x++)
+        {
+            DWORD *face = &indices[(y * grid_size + x) * 6];
+            DWORD corner = y * (grid_size + 1) + x;
+
+            face[0] = corner;
+            face[1] = corner + 1;
+            face[2] = corner + grid_size + 1;
+            face[3] = corner + 1;
+            face[4] = corner + grid_size + 2;
+            face[5] = corner + grid_size + 1;
+        }
+    }
+    for (i = num_faces - 1; i > 0; i--)
+    {
+        DWORD tmp[3];
+
+        seed = seed * 1103515245 + 12345;
+        j = (seed >> 8) % (i + 1);
+        memcpy(tmp, &indices[i * 3], sizeof(tmp));
+        memcpy(&indices[i * 3], &indices[j * 3], sizeof(tmp));
+        memcpy(&indices[j * 3], tmp, sizeof(tmp));
+    }
+    mesh->lpVtbl->LockAttributeBuffer(mesh, 0, &attributes);
+    for (i = 0; i < num_faces; i++)
+        attributes[i] = vertices[indices[i * 3]].x < grid_size / 2;
+    mesh->lpVtbl->UnlockAttributeBuffer(mesh);
+
+    /* The same grid without shared vertices. */
+    split_mesh->lpVtbl->LockVertexBuffer(split_mesh, 0, (void **)&split_vertices);
+    for (i = 0; i < num_faces * 3; i++)
+        old_positions[i] = split_vertices[i] = vertices[indices[i]];
+    split_mesh->lpVtbl->UnlockVertexBuffer(split_mesh);
+    split_mesh->lpVtbl->LockIndexBuffer(split_mesh, 0, (void **)&split_indices);
+    for (i = 0; i < num_faces * 3; i++)
+        split_indices[i] = i;
+    split_mesh->lpVtbl->UnlockIndexBuffer(split_mesh);
+
+    acmr_before = compute_acmr(indices, num_faces);
+    mesh->lpVtbl->UnlockIndexBuffer(mesh);
+    mesh->lpVtbl->UnlockVertexBuffer(mesh);
+
+    start = GetTickCount();
+    hr = split_mesh->lpVtbl->GenerateAdjacency(split_mesh, 1e-3f, adjacency_out);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    trace("Generated adjacency for %u faces in %u ms.\n", num_faces, GetTickCount() - start);
+    hr = mesh->lpVtbl->GenerateAdjacency(mesh, 0.0f, adjacency);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    ok(!memcmp(adjacency, adjacency_out, num_faces * 3 * sizeof(*adjacency)),
+            "Got different adjacency for shared and split vertices.\n");
+    for (i = 0, count = 0; i < num_faces * 3; i++)
+    {
+        if (adjacency[i] != -1)
+            count++;
+    }
+    ok(count == 2 * (2 * grid_size * (grid_size - 1) + grid_size * grid_size),
+            "Got unexpected number of adjacent edges %u.\n", count);
+
+    start = GetTickCount();
+    hr = mesh->lpVtbl->OptimizeInplace(mesh, D3DXMESHOPT_VERTEXCACHE | D3DXMESHOPT_COMPACT,
+            adjacency, adjacency_out, face_remap, &vertex_remap);
+    ok(hr == D3D_OK, "Got unexpected hr %#x.\n", hr);
+    trace("Optimized %u faces for the vertex cache in %u ms.\n", num_faces, GetTickCount() - start);
+    if (FAILED(hr))
+        goto cleanup;
+
+    mesh->lpVtbl->LockVertexBuffer(mesh, D3DLOCK_READONLY, (void **)&vertices);
+    mesh->lpVtbl->LockIndexBuffer(mesh, D3DLOCK_READONLY, (void **)&indices);
+    mesh->lpVtbl->LockAttributeBuffer(mesh, D3DLOCK_READONLY, &attributes);
+    vertex_remap_ptr = ID3DXBuffer_GetBufferPointer(vertex_remap);
+
+    acmr_after = compute_acmr(indices, num_faces);
+    trace("ACMR %.3f before, %.3f after optimization.\n", acmr_before, acmr_after);
+    ok(acmr_after < 1.0f, "Got unexpected ACMR %.3f.\n", acmr_after);
+    ok(acmr_after < acmr_before, "Got ACMR %.3f, before %.3f.\n", acmr_after, acmr_before);
+
+    for (i = 0; i < num_faces; i++)
+    {
+        ok(face_remap[i] < num_faces, "Got unexpected face remap %u for face %u.\n", face_remap[i], i);
+        if (face_remap[i] >= num_faces)
+            break;
+        if (i)
+            ok(attributes[i] >= attributes[i - 1], "Attributes of face %u are not sorted.\n", i);
+        for (j = 0; j < 3; j++)
+        {
+            ok(vertex_remap_ptr[indices[i * 3 + j]] < num_vertices, "Got unexpected vertex remap.\n");
+            if (memcmp(&vertices[indices[i * 3 + j]], &old_positions[face_remap[i] * 3 + j], sizeof(*vertices)))
+                break;
+        }
+        ok(j == 3, "Face %u (old %u) doesn't match.\n", i, face_remap[i]);
+    }
+
+    ID3DXBuffer_Release(vertex_remap);
+    mesh->lpVtbl->UnlockAttributeBuffer(mesh);
+    mesh->lpVtbl->UnlockIndexBuffer(mesh);
+    mesh->lpVtbl->UnlockVertexBuffer(mesh);
+
+cleanup:
+    HeapFree(GetProcessHeap(), 0, old_positions);
+    HeapFree(GetProcessHeap(), 0, face_remap);
+    HeapFree(GetProcessHeap(), 0, adjacency_out);
+    HeapFree(GetProcessHeap(), 0, adjacency);
+    split_mesh->lpVtbl->Release(split_mesh);
+    mesh->lpVtbl->Release(mesh);
+    free_test_context(test_context);
+}
+
 START_TEST(mesh)
 {
     D3DXBoundProbeTest();
@@ -10631,4 +10814,5 @@ START_TEST(mesh)
     test_clone_mesh();
     test_valid_mesh();
     test_optimize_faces();
+    test_optimize_vertex_cache();
 }
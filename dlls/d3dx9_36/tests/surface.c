@@ -1159,6 +1159,81 @@ static void test_D3DXLoadSurface(IDirect3DDevice9 *device)
     if(testbitmap_ok) DeleteFileA("testbitmap.bmp");
 }
 
+static DWORD filter_test_color(unsigned int x, unsigned int y)
+{
+    return 0xff000000 | ((y * 13) & 0xff) << 16 | ((x * 7) & 0xff) << 8 | ((x + y) & 0x1f);
+}
+
+/* Halves images with 2x2 blocks of one color, except for the blue channel
+ * that alternates between 0x20 and 0x60 within the blocks. Tall images are
+ * filtered on several threads and, where available, with SSE, so check
+ * every pixel against the color computed here. */
+static void test_D3DXLoadSurface_filters(IDirect3DDevice9 *device)
+{
+    static const DWORD filters[] = {D3DX_FILTER_POINT, D3DX_FILTER_LINEAR, D3DX_FILTER_BOX};
+    static const unsigned int heights[] = {7, 301};
+    unsigned int i, j, x, y, width = 256, src_width = 2 * width;
+    D3DLOCKED_RECT lockrect;
+    IDirect3DSurface9 *surf;
+    DWORD *src, color, expected;
+    RECT rect;
+    HRESULT hr;
+
+    src = HeapAlloc(GetProcessHeap(), 0, src_width * 2 * heights[1] * sizeof(*src));
+    for (y = 0; y < 2 * heights[1]; ++y)
+    {
+        for (x = 0; x < src_width; ++x)
+            src[y * src_width + x] = filter_test_color(x / 2, y / 2) | ((x ^ y) & 1 ? 0x60 : 0x20);
+    }
+
+    for (i = 0; i < sizeof(heights) / sizeof(heights[0]); ++i)
+    {
+        hr = IDirect3DDevice9_CreateOffscreenPlainSurface(device, width, heights[i], D3DFMT_A8R8G8B8,
+                D3DPOOL_SCRATCH, &surf, NULL);
+        if (FAILED(hr))
+        {
+            skip("Failed to create a surface, hr %#x.\n", hr);
+            continue;
+        }
+        SetRect(&rect, 0, 0, src_width, 2 * heights[i]);
+
+        for (j = 0; j < sizeof(filters) / sizeof(filters[0]); ++j)
+        {
+            hr = D3DXLoadSurfaceFromMemory(surf, NULL, NULL, src, D3DFMT_A8R8G8B8, src_width * sizeof(*src),
+                    NULL, &rect, filters[j], 0);
+            ok(hr == D3D_OK, "Filter %#x, height %u: got hr %#x.\n", filters[j], heights[i], hr);
+
+            hr = IDirect3DSurface9_LockRect(surf, &lockrect, NULL, D3DLOCK_READONLY);
+            ok(hr == D3D_OK, "Failed to lock surface, hr %#x.\n", hr);
+            for (y = 0; y < heights[i]; ++y)
+            {
+                for (x = 0; x < width; ++x)
+                {
+                    color = ((DWORD *)((BYTE *)lockrect.pBits + y * lockrect.Pitch))[x];
+                    expected = filter_test_color(x, y);
+                    /* a point filter picks one of the source pixels */
+                    if (filters[j] == D3DX_FILTER_POINT)
+                        expected |= color & 0x40 ? 0x60 : 0x20;
+                    else
+                        expected |= 0x40;
+                    if (color != expected)
+                        break;
+                }
+                if (x < width)
+                    break;
+            }
+            ok(y == heights[i], "Filter %#x, height %u: got 0x%08x at (%u, %u), expected 0x%08x.\n",
+                    filters[j], heights[i], color, x, y, expected);
+            hr = IDirect3DSurface9_UnlockRect(surf);
+            ok(hr == D3D_OK, "Failed to unlock surface, hr %#x.\n", hr);
+        }
+
+        check_release((IUnknown *)surf, 0);
+    }
+
+    HeapFree(GetProcessHeap(), 0, src);
+}
+
 static void test_D3DXSaveSurfaceToFileInMemory(IDirect3DDevice9 *device)
 {
     HRESULT hr;
@@ -1322,6 +1397,7 @@ START_TEST(surface)
 
     test_D3DXGetImageInfo();
     test_D3DXLoadSurface(device);
+    test_D3DXLoadSurface_filters(device);
     test_D3DXSaveSurfaceToFileInMemory(device);
     test_D3DXSaveSurfaceToFile(device);
 
@@ -922,6 +922,58 @@ static void test_D3DXFilterTexture(IDirect3DDevice9 *device)
     else
         skip("Failed to create texture\n");
 
+    /* The box filter averages the checkerboard to a single color, which stays
+     * the same in all the following levels. Large enough to be filtered in
+     * parallel. */
+    hr = IDirect3DDevice9_CreateTexture(device, 1024, 1024, 0, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &tex, NULL);
+    if (SUCCEEDED(hr))
+    {
+        DWORD level_count = IDirect3DTexture9_GetLevelCount(tex), level, start, *data;
+        D3DLOCKED_RECT lock_rect;
+        D3DSURFACE_DESC desc;
+        unsigned int x, y;
+
+        hr = IDirect3DTexture9_LockRect(tex, 0, &lock_rect, NULL, 0);
+        ok(hr == D3D_OK, "Failed to lock texture, hr %#x.\n", hr);
+        for (y = 0; y < 1024; ++y)
+        {
+            data = (DWORD *)((BYTE *)lock_rect.pBits + y * lock_rect.Pitch);
+            for (x = 0; x < 1024; ++x)
+                data[x] = (x ^ y) & 1 ? 0xff406080 : 0xff204060;
+        }
+        hr = IDirect3DTexture9_UnlockRect(tex, 0);
+        ok(hr == D3D_OK, "Failed to unlock texture, hr %#x.\n", hr);
+
+        start = GetTickCount();
+        hr = D3DXFilterTexture((IDirect3DBaseTexture9 *)tex, NULL, 0, D3DX_FILTER_BOX);
+        ok(hr == D3D_OK, "D3DXFilterTexture returned %#x, expected %#x\n", hr, D3D_OK);
+        trace("Filtered %u levels in %u ms.\n", level_count, GetTickCount() - start);
+
+        for (level = 1; level < level_count; ++level)
+        {
+            IDirect3DTexture9_GetLevelDesc(tex, level, &desc);
+            hr = IDirect3DTexture9_LockRect(tex, level, &lock_rect, NULL, D3DLOCK_READONLY);
+            ok(hr == D3D_OK, "Failed to lock level %u, hr %#x.\n", level, hr);
+            for (y = 0; y < desc.Height; ++y)
+            {
+                data = (DWORD *)((BYTE *)lock_rect.pBits + y * lock_rect.Pitch);
+                for (x = 0; x < desc.Width; ++x)
+                {
+                    if (data[x] != 0xff305070)
+                        break;
+                }
+                if (x < desc.Width)
+                    break;
+            }
+            ok(y == desc.Height, "Level %u: got unexpected color 0x%08x at (%u, %u).\n",
+                    level, y == desc.Height ? 0 : data[x], x, y);
+            IDirect3DTexture9_UnlockRect(tex, level);
+        }
+        IDirect3DTexture9_Release(tex);
+    }
+    else
+        skip("Failed to create texture\n");
+
     /* Volume texture test */
     hr = IDirect3DDevice9_CreateVolumeTexture(device, 256, 256, 4, 0, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &voltex, NULL);
     if (SUCCEEDED(hr))
@@ -227,6 +227,103 @@ const struct pixel_format_desc *get_format_info_idx(int idx)
 
 #define WINE_D3DX_TO_STR(x) case x: return #x
 
+BOOL d3dx_cpu_has_sse(void)
+{
+    static int sse = -1;
+
+    if (sse == -1)
+        sse = IsProcessorFeaturePresent(PF_XMMI_INSTRUCTIONS_AVAILABLE);
+    return sse;
+}
+
+/* Rows are handed out in chunks of about ROW_JOB_CHUNK_SIZE bytes of work,
+ * large enough that the source rows shared by neighbouring chunks are only
+ * a small part of it. Below ROW_JOB_MIN_PARALLEL_SIZE the calling thread
+ * does everything, waking up workers would take longer. */
+#define ROW_JOB_CHUNK_SIZE          (256 * 1024)
+#define ROW_JOB_MIN_PARALLEL_SIZE   (1024 * 1024)
+#define ROW_JOB_MAX_WORKERS         7
+
+struct row_job
+{
+    void (*func)(void *ctx, unsigned int row, unsigned int row_count);
+    void *ctx;
+    unsigned int row_count;
+    unsigned int chunk_rows;
+    LONG next_row;
+    LONG active;
+    HANDLE finished;
+};
+
+static void run_row_job(struct row_job *job)
+{
+    unsigned int row;
+
+    while ((row = InterlockedExchangeAdd(&job->next_row, job->chunk_rows)) < job->row_count)
+        job->func(job->ctx, row, min(job->chunk_rows, job->row_count - row));
+
+    if (!InterlockedDecrement(&job->active))
+        SetEvent(job->finished);
+}
+
+static DWORD WINAPI row_job_worker(void *arg)
+{
+    run_row_job(arg);
+    return 0;
+}
+
+/************************************************************
+ * run_rows_parallel
+ *
+ * Calls func for all the rows in [0, row_count), in chunks of consecutive
+ * rows. The chunks are taken by the calling thread and by thread pool
+ * workers as they become free, so func must only write the rows it is
+ * given. row_size is the amount of work per row, in bytes touched.
+ */
+void run_rows_parallel(void (*func)(void *ctx, unsigned int row, unsigned int row_count),
+        void *ctx, unsigned int row_count, SIZE_T row_size)
+{
+    static unsigned int cpu_count;
+    unsigned int chunk_count, worker_count, i;
+    struct row_job job;
+
+    if (!cpu_count)
+    {
+        SYSTEM_INFO info;
+
+        GetSystemInfo(&info);
+        cpu_count = max(info.dwNumberOfProcessors, 1);
+    }
+
+    job.chunk_rows = max(ROW_JOB_CHUNK_SIZE / max(row_size, 1), 1);
+    chunk_count = (row_count + job.chunk_rows - 1) / job.chunk_rows;
+    worker_count = min(min(cpu_count - 1, ROW_JOB_MAX_WORKERS), chunk_count - 1);
+    if (!worker_count || (SIZE_T)row_count * row_size < ROW_JOB_MIN_PARALLEL_SIZE
+            || !(job.finished = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        func(ctx, 0, row_count);
+        return;
+    }
+
+    TRACE("%u rows in chunks of %u, %u workers.\n", row_count, job.chunk_rows, worker_count);
+
+    job.func = func;
+    job.ctx = ctx;
+    job.row_count = row_count;
+    job.next_row = 0;
+    job.active = worker_count + 1;
+    for (i = 0; i < worker_count; ++i)
+    {
+        /* a worker that couldn't be queued has nothing to do */
+        if (!QueueUserWorkItem(row_job_worker, &job, WT_EXECUTEDEFAULT))
+            InterlockedDecrement(&job.active);
+    }
+    run_row_job(&job);
+
+    WaitForSingleObject(job.finished, INFINITE);
+    CloseHandle(job.finished);
+}
+
 const char *debug_d3dxparameter_class(D3DXPARAMETER_CLASS c)
 {
     switch (c)
@@ -7058,6 +7058,178 @@ static void test_p8_rgb_blit(void)
     DestroyWindow(window);
 }
 
+static BYTE clamp_yuv(int x)
+{
+    return x < 0 ? 0 : x > 255 ? 255 : x;
+}
+
+static D3DCOLOR yuy2_to_rgb(const BYTE *macro_pixel, unsigned int x)
+{
+    int c = macro_pixel[(x & 1) * 2] - 16, d = macro_pixel[1] - 128, e = macro_pixel[3] - 128;
+
+    return clamp_yuv((298 * c + 409 * e + 128) >> 8) << 16
+            | clamp_yuv((298 * c - 100 * d - 208 * e + 128) >> 8) << 8
+            | clamp_yuv((298 * c + 516 * d + 128) >> 8);
+}
+
+static void test_sysmem_conversion_blit(void)
+{
+    static const DDPIXELFORMAT r5g6b5 =
+    {
+        sizeof(DDPIXELFORMAT), DDPF_RGB, 0,
+        {16}, {0xf800}, {0x07e0}, {0x001f}, {0x0000}
+    };
+    static const DDPIXELFORMAT a8r8g8b8 =
+    {
+        sizeof(DDPIXELFORMAT), DDPF_RGB | DDPF_ALPHAPIXELS, 0,
+        {32}, {0x00ff0000}, {0x0000ff00}, {0x000000ff}, {0xff000000}
+    };
+    static const DDPIXELFORMAT x8r8g8b8 =
+    {
+        sizeof(DDPIXELFORMAT), DDPF_RGB, 0,
+        {32}, {0x00ff0000}, {0x0000ff00}, {0x000000ff}, {0x00000000}
+    };
+    static const DDPIXELFORMAT yuy2 =
+    {
+        sizeof(DDPIXELFORMAT), DDPF_FOURCC, MAKEFOURCC('Y','U','Y','2'),
+        {0}, {0}, {0}, {0}, {0}
+    };
+    static const struct
+    {
+        const char *name;
+        const DDPIXELFORMAT *src_format, *dst_format;
+        DWORD src_caps;
+        BYTE max_diff;
+    }
+    tests[] =
+    {
+        {"R5G6B5 -> X8R8G8B8",   &r5g6b5,   &x8r8g8b8, DDSCAPS_OFFSCREENPLAIN, 1},
+        {"A8R8G8B8 -> X8R8G8B8", &a8r8g8b8, &x8r8g8b8, DDSCAPS_OFFSCREENPLAIN, 0},
+        /* Windows refuses fourcc off-screen plain surfaces in system memory. */
+        {"YUY2 -> X8R8G8B8",     &yuy2,     &x8r8g8b8, DDSCAPS_TEXTURE,        2},
+        {"YUY2 -> R5G6B5",       &yuy2,     &r5g6b5,   DDSCAPS_TEXTURE,        8},
+    };
+    unsigned int i, x, y, src_bpp, dst_bpp, mismatches;
+    IDirectDrawSurface7 *src, *dst;
+    DDSURFACEDESC2 src_desc, dst_desc;
+    D3DCOLOR color, expected;
+    IDirectDraw7 *ddraw;
+    DWORD start, time;
+    ULONG refcount;
+    HWND window;
+    HRESULT hr;
+    BYTE *row;
+    WORD c;
+
+    window = CreateWindowA("static", "ddraw_test", WS_OVERLAPPEDWINDOW,
+            0, 0, 640, 480, 0, 0, 0, 0);
+    ddraw = create_ddraw();
+    ok(!!ddraw, "Failed to create a ddraw object.\n");
+    hr = IDirectDraw7_SetCooperativeLevel(ddraw, window, DDSCL_NORMAL);
+    ok(SUCCEEDED(hr), "Failed to set cooperative level, hr %#x.\n", hr);
+
+    for (i = 0; i < sizeof(tests) / sizeof(*tests); ++i)
+    {
+        memset(&src_desc, 0, sizeof(src_desc));
+        src_desc.dwSize = sizeof(src_desc);
+        src_desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PIXELFORMAT;
+        src_desc.dwWidth = 1024;
+        src_desc.dwHeight = 768;
+        src_desc.ddsCaps.dwCaps = tests[i].src_caps | DDSCAPS_SYSTEMMEMORY;
+        U4(src_desc).ddpfPixelFormat = *tests[i].src_format;
+        if (FAILED(IDirectDraw7_CreateSurface(ddraw, &src_desc, &src, NULL)))
+        {
+            skip("Failed to create a %s source surface.\n", tests[i].name);
+            continue;
+        }
+
+        dst_desc = src_desc;
+        dst_desc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN | DDSCAPS_SYSTEMMEMORY;
+        U4(dst_desc).ddpfPixelFormat = *tests[i].dst_format;
+        hr = IDirectDraw7_CreateSurface(ddraw, &dst_desc, &dst, NULL);
+        ok(SUCCEEDED(hr), "Failed to create surface, hr %#x.\n", hr);
+
+        hr = IDirectDrawSurface7_Lock(src, NULL, &src_desc, 0, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock source surface, hr %#x.\n", hr);
+        src_bpp = tests[i].src_format->dwFlags & DDPF_FOURCC ? 16 : U1(*tests[i].src_format).dwRGBBitCount;
+        for (y = 0; y < src_desc.dwHeight; ++y)
+        {
+            row = (BYTE *)src_desc.lpSurface + y * U1(src_desc).lPitch;
+            for (x = 0; x < src_desc.dwWidth * src_bpp / 8; ++x)
+                row[x] = (x * 7 + y * 13 + (x * y >> 5)) & 0xff;
+        }
+        hr = IDirectDrawSurface7_Unlock(src, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock source surface, hr %#x.\n", hr);
+
+        start = GetTickCount();
+        hr = IDirectDrawSurface7_Blt(dst, NULL, src, NULL, DDBLT_WAIT, NULL);
+        time = GetTickCount() - start;
+        if (FAILED(hr))
+        {
+            skip("Failed to blit %s, hr %#x.\n", tests[i].name, hr);
+            IDirectDrawSurface7_Release(dst);
+            IDirectDrawSurface7_Release(src);
+            continue;
+        }
+        trace("%s: %ux%u in %u ms.\n", tests[i].name, src_desc.dwWidth, src_desc.dwHeight, time);
+
+        hr = IDirectDrawSurface7_Lock(src, NULL, &src_desc, DDLOCK_READONLY, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock source surface, hr %#x.\n", hr);
+        hr = IDirectDrawSurface7_Lock(dst, NULL, &dst_desc, DDLOCK_READONLY, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock destination surface, hr %#x.\n", hr);
+        dst_bpp = U1(*tests[i].dst_format).dwRGBBitCount;
+        mismatches = 0;
+        for (y = 0; y < src_desc.dwHeight; ++y)
+        {
+            row = (BYTE *)src_desc.lpSurface + y * U1(src_desc).lPitch;
+            for (x = 0; x < src_desc.dwWidth; ++x)
+            {
+                if (tests[i].src_format->dwFlags & DDPF_FOURCC)
+                {
+                    expected = yuy2_to_rgb(row + (x & ~1) * 2, x);
+                }
+                else if (src_bpp == 16)
+                {
+                    c = ((WORD *)row)[x];
+                    expected = ((c >> 11) * 255 / 31) << 16 | (((c >> 5) & 0x3f) * 255 / 63) << 8
+                            | ((c & 0x1f) * 255 / 31);
+                }
+                else
+                {
+                    expected = ((DWORD *)row)[x] & 0x00ffffff;
+                }
+
+                if (dst_bpp == 16)
+                {
+                    c = ((WORD *)((BYTE *)dst_desc.lpSurface + y * U1(dst_desc).lPitch))[x];
+                    color = ((c >> 11) * 255 / 31) << 16 | (((c >> 5) & 0x3f) * 255 / 63) << 8
+                            | ((c & 0x1f) * 255 / 31);
+                }
+                else
+                {
+                    color = ((DWORD *)((BYTE *)dst_desc.lpSurface + y * U1(dst_desc).lPitch))[x] & 0x00ffffff;
+                }
+
+                if (!compare_color(color, expected, tests[i].max_diff) && !mismatches++)
+                    trace("%s: pixel %u,%u: got color %#x, expected %#x.\n",
+                            tests[i].name, x, y, color, expected);
+            }
+        }
+        ok(!mismatches, "%s: got %u mismatching pixels.\n", tests[i].name, mismatches);
+        hr = IDirectDrawSurface7_Unlock(dst, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock destination surface, hr %#x.\n", hr);
+        hr = IDirectDrawSurface7_Unlock(src, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock source surface, hr %#x.\n", hr);
+
+        IDirectDrawSurface7_Release(dst);
+        IDirectDrawSurface7_Release(src);
+    }
+
+    refcount = IDirectDraw7_Release(ddraw);
+    ok(!refcount, "Got unexpected refcount %u.\n", refcount);
+    DestroyWindow(window);
+}
+
 static void test_material(void)
 {
     static const D3DCOLORVALUE null_color;
@@ -8259,6 +8431,7 @@ START_TEST(ddraw7)
     test_mipmap_lock();
     test_palette_complex();
     test_p8_rgb_blit();
+    test_sysmem_conversion_blit();
     test_material();
     test_palette_gdi();
     test_palette_alpha();
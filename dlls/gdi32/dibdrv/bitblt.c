@@ -552,20 +552,45 @@ static void copy_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
-static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
-                         HRGN clip, BLENDFUNCTION blend )
+struct blend_rect_op
 {
+    struct tile_op  op;
+    const dib_info *dst;
+    const dib_info *src;
+    const RECT     *dst_rect;
+    const RECT     *src_rect;
+    BLENDFUNCTION   blend;
+};
+
+static BOOL blend_rect_tile( struct tile_op *op, int num, const RECT *rects )
+{
+    struct blend_rect_op *blend = CONTAINING_RECORD( op, struct blend_rect_op, op );
     POINT origin;
-    struct clipped_rects clipped_rects;
     int i;
 
-    if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
-    for (i = 0; i < clipped_rects.count; i++)
+    for (i = 0; i < num; i++)
     {
-        origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
-        origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
-        dst->funcs->blend_rect( dst, &clipped_rects.rects[i], src, &origin, blend );
+        origin.x = blend->src_rect->left + rects[i].left - blend->dst_rect->left;
+        origin.y = blend->src_rect->top  + rects[i].top  - blend->dst_rect->top;
+        blend->dst->funcs->blend_rect( blend->dst, &rects[i], blend->src, &origin, blend->blend );
     }
+    return TRUE;
+}
+
+static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
+                         HRGN clip, BLENDFUNCTION blend )
+{
+    struct blend_rect_op op;
+    struct clipped_rects clipped_rects;
+
+    if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
+    op.op.func  = blend_rect_tile;
+    op.dst      = dst;
+    op.src      = src;
+    op.dst_rect = dst_rect;
+    op.src_rect = src_rect;
+    op.blend    = blend;
+    run_tiled_op( &op.op, clipped_rects.count, clipped_rects.rects );
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
 }
@@ -649,17 +674,37 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
-static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
+struct gradient_rect_op
 {
+    struct tile_op   op;
+    const dib_info  *dib;
+    const TRIVERTEX *v;
+    int              mode;
+};
+
+static BOOL gradient_rect_tile( struct tile_op *op, int num, const RECT *rects )
+{
+    struct gradient_rect_op *gradient = CONTAINING_RECORD( op, struct gradient_rect_op, op );
     int i;
+
+    for (i = 0; i < num; i++)
+        if (!gradient->dib->funcs->gradient_rect( gradient->dib, &rects[i], gradient->v, gradient->mode ))
+            return FALSE;
+    return TRUE;
+}
+
+static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
+{
+    struct gradient_rect_op op;
     struct clipped_rects clipped_rects;
-    BOOL ret = TRUE;
+    BOOL ret;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
-    for (i = 0; i < clipped_rects.count; i++)
-    {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
-    }
+    op.op.func = gradient_rect_tile;
+    op.dib     = dib;
+    op.v       = v;
+    op.mode    = mode;
+    ret = run_tiled_op( &op.op, clipped_rects.count, clipped_rects.rects );
     free_clipped_rects( &clipped_rects );
     return ret;
 }
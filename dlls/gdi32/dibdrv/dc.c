@@ -21,6 +21,7 @@
 #include <assert.h>
 
 #include "gdi_private.h"
+#include "winreg.h"
 #include "dibdrv.h"
 
 #include "wine/exception.h"
@@ -279,7 +280,7 @@ int get_clipped_rects( const dib_info *dib, const RECT *rc, HRGN clip, struct cl
 
     if (!(region = get_wine_region( clip ))) return 0;
 
-    for (i = 0; i < region->numRects; i++)
+    for (i = find_band( region->rects, region->numRects, rect.top ); i < region->numRects; i++)
     {
         if (region->rects[i].top >= rect.bottom) break;
         if (!intersect_rect( out, &rect, &region->rects[i] )) continue;
@@ -317,6 +318,116 @@ void add_clipped_bounds( dibdrv_physdev *dev, const RECT *rect, HRGN clip )
     add_bounds_rect( dev->bounds, &rc );
 }
 
+/* Tiled rendering: large operations are split into horizontal bands that are
+ * processed in parallel by the thread pool. Every pixel of the primitives that
+ * use it only depends on its own coordinates, so the output is the same as
+ * with a single band. */
+
+#define MAX_RENDER_THREADS 16
+
+static INIT_ONCE render_init_once = INIT_ONCE_STATIC_INIT;
+static int render_threads;              /* number of bands, 0 or 1 to disable */
+static DWORD render_tile_threshold;     /* minimum number of pixels of a tiled rect */
+
+struct tile
+{
+    struct tile_op *op;
+    RECT            rect;
+};
+
+static BOOL CALLBACK init_tiled_rendering( INIT_ONCE *once, void *param, void **context )
+{
+    char buffer[16];
+    DWORD type, count, size;
+    HKEY hkey;
+
+    count = 0;
+    render_tile_threshold = 1024 * 1024;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Gdi */
+    if (!RegOpenKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Gdi", &hkey ))
+    {
+        size = sizeof(buffer);
+        if (!RegQueryValueExA( hkey, "RenderThreads", 0, &type, (BYTE *)buffer, &size ) && type == REG_SZ)
+            count = min( atoi( buffer ), MAX_RENDER_THREADS );
+        size = sizeof(buffer);
+        if (!RegQueryValueExA( hkey, "RenderTileThreshold", 0, &type, (BYTE *)buffer, &size ) && type == REG_SZ)
+            render_tile_threshold = max( atoi( buffer ), 1 );
+        RegCloseKey( hkey );
+    }
+    if (count > 1) TRACE( "using %u render threads above %u pixels\n", count, render_tile_threshold );
+    render_threads = count;
+    return TRUE;
+}
+
+static int get_tile_count( const RECT *rc )
+{
+    int height = rc->bottom - rc->top;
+
+    InitOnceExecuteOnce( &render_init_once, init_tiled_rendering, NULL, NULL );
+    if (render_threads <= 1) return 1;
+    if ((DWORD)(rc->right - rc->left) * height < render_tile_threshold) return 1;
+    return min( render_threads, height );
+}
+
+static DWORD CALLBACK tile_proc( void *arg )
+{
+    struct tile *tile = arg;
+    struct tile_op *op = tile->op;
+
+    if (!op->func( op, 1, &tile->rect )) op->ret = FALSE;
+    if (!InterlockedDecrement( &op->pending )) SetEvent( op->done );
+    return 0;
+}
+
+static BOOL run_tiles( struct tile_op *op, const RECT *rc, int count )
+{
+    struct tile tiles[MAX_RENDER_THREADS];
+    int i, height = rc->bottom - rc->top;
+
+    if (!(op->done = CreateEventW( NULL, TRUE, FALSE, NULL ))) return op->func( op, 1, rc );
+
+    op->ret = TRUE;
+    op->pending = count;
+    for (i = 0; i < count; i++)
+    {
+        tiles[i].op = op;
+        tiles[i].rect.left   = rc->left;
+        tiles[i].rect.right  = rc->right;
+        tiles[i].rect.top    = rc->top + height * i / count;
+        tiles[i].rect.bottom = rc->top + height * (i + 1) / count;
+    }
+    for (i = 1; i < count; i++)
+        if (!QueueUserWorkItem( tile_proc, &tiles[i], WT_EXECUTEDEFAULT )) tile_proc( &tiles[i] );
+    tile_proc( &tiles[0] );
+
+    WaitForSingleObject( op->done, INFINITE );
+    CloseHandle( op->done );
+    return op->ret;
+}
+
+/***********************************************************************
+ *           run_tiled_op
+ *
+ * Apply op to the rectangles. When tiled rendering is enabled, the large
+ * ones are split in bands run in parallel, the others are passed as is.
+ */
+BOOL run_tiled_op( struct tile_op *op, int num, const RECT *rects )
+{
+    int i, count, start = 0;
+    BOOL ret = TRUE;
+
+    for (i = 0; i < num; i++)
+    {
+        if ((count = get_tile_count( &rects[i] )) <= 1) continue;
+        if (i > start && !op->func( op, i - start, rects + start )) ret = FALSE;
+        if (!run_tiles( op, &rects[i], count )) ret = FALSE;
+        start = i + 1;
+    }
+    if (num > start && !op->func( op, num - start, rects + start )) ret = FALSE;
+    return ret;
+}
+
 /**********************************************************************
  *	     dibdrv_CreateDC
  */
@@ -253,6 +253,16 @@ extern int clip_line(const POINT *start, const POINT *end, const RECT *clip,
                      const bres_params *params, POINT *pt1, POINT *pt2) DECLSPEC_HIDDEN;
 extern void release_cached_font( struct cached_font *font ) DECLSPEC_HIDDEN;
 
+struct tile_op
+{
+    BOOL  (*func)( struct tile_op *op, int num, const RECT *rc );  /* render some rects or bands */
+    LONG    pending;
+    HANDLE  done;
+    BOOL    ret;
+};
+
+extern BOOL run_tiled_op( struct tile_op *op, int num, const RECT *rects ) DECLSPEC_HIDDEN;
+
 static inline void init_clipped_rects( struct clipped_rects *clip_rects )
 {
     clip_rects->count = 0;
@@ -26,6 +26,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(dib);
+WINE_DECLARE_DEBUG_CHANNEL(glyphcache);
 
 struct cached_glyph
 {
@@ -43,18 +44,48 @@ enum glyph_type
 #define GLYPH_CACHE_PAGE_SIZE  0x100
 #define GLYPH_CACHE_PAGES      (0x10000 / GLYPH_CACHE_PAGE_SIZE)
 
+struct cached_font;
+
+struct glyph_page
+{
+    struct list           entry;       /* entry in the glyph_pages clock list */
+    struct cached_font   *font;
+    enum glyph_type       type;
+    UINT                  index;       /* index of the page in the font */
+    BOOL                  used;        /* looked up since the clock hand last passed */
+    LONG                  size;        /* memory used by the page and its glyphs */
+    struct cached_glyph  *glyphs[GLYPH_CACHE_PAGE_SIZE];
+};
+
 struct cached_font
 {
-    struct list           entry;
+    struct list           entry;       /* entry in the font_cache lru list */
+    struct list           hash_entry;  /* entry in the font_cache_buckets hash */
     LONG                  ref;
     DWORD                 hash;
     LOGFONTW              lf;
     XFORM                 xform;
     UINT                  aa_flags;
-    struct cached_glyph **glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
+    SRWLOCK               lock;        /* held shared while glyphs are used, exclusive to free pages */
+    struct glyph_page    *glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
 };
 
+#define FONT_CACHE_HASH_SIZE   64
+#define FONT_CACHE_MIN_UNUSED  5                   /* unused fonts kept regardless of the budget */
+#define FONT_CACHE_MAX_UNUSED  32                  /* unused fonts kept while within the budget */
+#define GLYPH_CACHE_MAX_SIZE   (4 * 1024 * 1024)   /* glyph memory that triggers trimming */
+#define GLYPH_CACHE_TRIM_SIZE  (3 * 1024 * 1024)   /* glyph memory left after trimming */
+
+/* fonts in most-recently used order; shared between all the DCs of the process */
 static struct list font_cache = LIST_INIT( font_cache );
+static struct list font_cache_buckets[FONT_CACHE_HASH_SIZE];
+/* glyph pages of all the fonts, in the order the clock hand visits them */
+static struct list glyph_pages = LIST_INIT( glyph_pages );
+static LONG glyph_cache_size;
+
+/* statistics, only maintained when the glyphcache channel is enabled */
+static LONG font_cache_hits, font_cache_misses, glyph_cache_hits, glyph_cache_misses;
+static LONG font_cache_evictions, glyph_page_evictions;
 
 static CRITICAL_SECTION font_cache_cs;
 static CRITICAL_SECTION_DEBUG critsect_debug =
@@ -482,10 +513,114 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+static void dump_font_cache_stats(void)
+{
+    TRACE_(glyphcache)( "fonts: %u hits %u misses %u evictions, glyphs: %u hits %u misses, "
+                        "%u bytes, %u page evictions\n",
+                        font_cache_hits, font_cache_misses, font_cache_evictions,
+                        glyph_cache_hits, glyph_cache_misses, glyph_cache_size, glyph_page_evictions );
+}
+
+/* Must be called with font_cache_cs held, and with the font lock held
+ * exclusively unless the font is unused. */
+static void free_glyph_page( struct glyph_page *page )
+{
+    UINT i;
+
+    page->font->glyphs[page->type][page->index] = NULL;
+    for (i = 0; i < GLYPH_CACHE_PAGE_SIZE; i++)
+        HeapFree( GetProcessHeap(), 0, page->glyphs[i] );
+    InterlockedExchangeAdd( &glyph_cache_size, -page->size );
+    list_remove( &page->entry );
+    HeapFree( GetProcessHeap(), 0, page );
+}
+
+static void free_cached_font( struct cached_font *font )
+{
+    UINT i, j;
+
+    for (i = 0; i < GLYPH_NBTYPES; i++)
+        for (j = 0; j < GLYPH_CACHE_PAGES; j++)
+            if (font->glyphs[i][j]) free_glyph_page( font->glyphs[i][j] );
+    list_remove( &font->entry );
+    list_remove( &font->hash_entry );
+    HeapFree( GetProcessHeap(), 0, font );
+    if (TRACE_ON(glyphcache)) InterlockedIncrement( &font_cache_evictions );
+}
+
+/***********************************************************************
+ *         trim_font_cache
+ *
+ * Evict the least recently used fonts that are not selected in any DC,
+ * while there are more than FONT_CACHE_MAX_UNUSED of them or the glyph
+ * memory exceeds the budget. The FONT_CACHE_MIN_UNUSED most recently
+ * used ones are never evicted. Must be called with font_cache_cs held;
+ * the reference count of an unused font can only be raised under it.
+ * Glyphs of fonts in use are trimmed by trim_glyph_cache.
+ */
+static void trim_font_cache( void )
+{
+    struct cached_font *font, *prev;
+    UINT unused = 0;
+
+    LIST_FOR_EACH_ENTRY( font, &font_cache, struct cached_font, entry )
+        if (!font->ref) unused++;
+
+    LIST_FOR_EACH_ENTRY_SAFE_REV( font, prev, &font_cache, struct cached_font, entry )
+    {
+        if (unused <= FONT_CACHE_MIN_UNUSED) break;
+        if (unused <= FONT_CACHE_MAX_UNUSED && glyph_cache_size <= GLYPH_CACHE_MAX_SIZE) break;
+        if (font->ref) continue;
+        free_cached_font( font );
+        unused--;
+    }
+}
+
+/***********************************************************************
+ *         trim_glyph_cache
+ *
+ * Bring the glyph memory back down to GLYPH_CACHE_TRIM_SIZE once it went
+ * over the budget, first by evicting unused fonts, then by evicting glyph
+ * pages that haven't been looked up since the clock hand last passed them.
+ * Pages of fonts that are being rendered are skipped. Must be called
+ * without holding any font lock.
+ */
+static void trim_glyph_cache( void )
+{
+    struct glyph_page *page;
+    UINT visits;
+
+    EnterCriticalSection( &font_cache_cs );
+    trim_font_cache();
+
+    /* every page gets visited at most twice: once to clear the used flag, once to evict it */
+    visits = 2 * list_count( &glyph_pages );
+    while (glyph_cache_size > GLYPH_CACHE_TRIM_SIZE && visits--)
+    {
+        struct list *ptr = list_head( &glyph_pages );
+        struct cached_font *font;
+
+        page = LIST_ENTRY( ptr, struct glyph_page, entry );
+        font = page->font;
+        if (page->used || !TryAcquireSRWLockExclusive( &font->lock ))
+        {
+            page->used = FALSE;
+            list_remove( &page->entry );
+            list_add_tail( &glyph_pages, &page->entry );
+            continue;
+        }
+        free_glyph_page( page );
+        ReleaseSRWLockExclusive( &font->lock );
+        if (TRACE_ON(glyphcache)) glyph_page_evictions++;
+    }
+    LeaveCriticalSection( &font_cache_cs );
+}
+
 static struct cached_font *add_cached_font( HDC hdc, HFONT hfont, UINT aa_flags )
 {
-    struct cached_font font, *ptr, *last_unused = NULL;
-    UINT i = 0, j, k;
+    struct cached_font font, *ptr;
+    struct list *bucket;
+    UINT i;
 
     GetObjectW( hfont, sizeof(font.lf), &font.lf );
     GetTransform( hdc, 0x204, &font.xform );
@@ -501,37 +636,30 @@ static struct cached_font *add_cached_font( HDC hdc, HFONT hfont, UINT aa_flags
     font.hash = font_cache_hash( &font );
 
     EnterCriticalSection( &font_cache_cs );
-    LIST_FOR_EACH_ENTRY( ptr, &font_cache, struct cached_font, entry )
+    if (!font_cache_buckets[0].next)
+        for (i = 0; i < FONT_CACHE_HASH_SIZE; i++) list_init( &font_cache_buckets[i] );
+
+    bucket = &font_cache_buckets[font.hash % FONT_CACHE_HASH_SIZE];
+    LIST_FOR_EACH_ENTRY( ptr, bucket, struct cached_font, hash_entry )
     {
         if (!font_cache_cmp( &font, ptr ))
         {
             InterlockedIncrement( &ptr->ref );
             list_remove( &ptr->entry );
+            list_add_head( &font_cache, &ptr->entry );
+            if (TRACE_ON(glyphcache)) font_cache_hits++;
             goto done;
         }
-        if (!ptr->ref)
-        {
-            i++;
-            last_unused = ptr;
-        }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
+    if (TRACE_ON(glyphcache))
     {
-        ptr = last_unused;
-        for (i = 0; i < GLYPH_NBTYPES; i++)
-        {
-            for (j = 0; j < GLYPH_CACHE_PAGES; j++)
-            {
-                if (!ptr->glyphs[i][j]) continue;
-                for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
-                    HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j][k] );
-                HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j] );
-            }
-        }
-        list_remove( &ptr->entry );
+        font_cache_misses++;
+        dump_font_cache_stats();
     }
-    else if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
+    trim_font_cache();
+
+    if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
     {
         LeaveCriticalSection( &font_cache_cs );
         return NULL;
@@ -539,9 +667,11 @@ static struct cached_font *add_cached_font( HDC hdc, HFONT hfont, UINT aa_flags
 
     *ptr = font;
     ptr->ref = 1;
+    InitializeSRWLock( &ptr->lock );
     memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
-done:
     list_add_head( &font_cache, &ptr->entry );
+    list_add_head( bucket, &ptr->hash_entry );
+done:
     LeaveCriticalSection( &font_cache_cs );
     TRACE( "%d %s -> %p\n", ptr->lf.lfHeight, debugstr_w(ptr->lf.lfFaceName), ptr );
     return ptr;
@@ -552,40 +682,58 @@ void release_cached_font( struct cached_font *font )
     if (font) InterlockedDecrement( &font->ref );
 }
 
+/* Must be called with the font lock held shared. */
 static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
-                                              struct cached_glyph *glyph )
+                                              struct cached_glyph *glyph, DWORD size )
 {
     struct cached_glyph *ret;
+    struct glyph_page *page;
     enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
-    UINT page = index / GLYPH_CACHE_PAGE_SIZE;
-    UINT entry = index % GLYPH_CACHE_PAGE_SIZE;
+    UINT page_index = index / GLYPH_CACHE_PAGE_SIZE;
 
-    if (!font->glyphs[type][page])
+    if (!(page = font->glyphs[type][page_index]))
     {
-        struct cached_glyph **ptr;
-
-        ptr = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, GLYPH_CACHE_PAGE_SIZE * sizeof(*ptr) );
-        if (!ptr)
+        EnterCriticalSection( &font_cache_cs );
+        if (!(page = font->glyphs[type][page_index]) &&
+            (page = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*page) )))
+        {
+            page->font  = font;
+            page->type  = type;
+            page->index = page_index;
+            page->used  = TRUE;
+            page->size  = sizeof(*page);
+            InterlockedExchangeAdd( &glyph_cache_size, page->size );
+            list_add_tail( &glyph_pages, &page->entry );
+            font->glyphs[type][page_index] = page;
+        }
+        LeaveCriticalSection( &font_cache_cs );
+        if (!page)
         {
             HeapFree( GetProcessHeap(), 0, glyph );
             return NULL;
         }
-        if (InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page], ptr, NULL ))
-            HeapFree( GetProcessHeap(), 0, ptr );
     }
-    ret = InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page][entry], glyph, NULL );
-    if (!ret) ret = glyph;
+    ret = InterlockedCompareExchangePointer( (void **)&page->glyphs[index % GLYPH_CACHE_PAGE_SIZE], glyph, NULL );
+    if (!ret)
+    {
+        ret = glyph;
+        size += FIELD_OFFSET( struct cached_glyph, bits );
+        InterlockedExchangeAdd( &page->size, size );
+        InterlockedExchangeAdd( &glyph_cache_size, size );
+    }
     else HeapFree( GetProcessHeap(), 0, glyph );
     return ret;
 }
 
+/* Must be called with the font lock held shared. */
 static struct cached_glyph *get_cached_glyph( struct cached_font *font, UINT index, UINT flags )
 {
     enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
-    UINT page = index / GLYPH_CACHE_PAGE_SIZE;
+    struct glyph_page *page = font->glyphs[type][index / GLYPH_CACHE_PAGE_SIZE];
 
-    if (!font->glyphs[type][page]) return NULL;
-    return font->glyphs[type][page][index % GLYPH_CACHE_PAGE_SIZE];
+    if (!page) return NULL;
+    if (!page->used) page->used = TRUE;
+    return page->glyphs[index % GLYPH_CACHE_PAGE_SIZE];
 }
 
 /**********************************************************************
@@ -624,8 +772,10 @@ static void draw_glyph( dib_info *dib, int x, int y, const GLYPHMETRICS *metrics
     rect.bottom = rect.top   + metrics->gmBlackBoxY;
     if (bounds) add_bounds_rect( bounds, &rect );
 
-    for (i = 0; i < clipped_rects->count; i++)
+    /* clipped rects are a subset of the clip region, so they are still banded */
+    for (i = find_band( clipped_rects->rects, clipped_rects->count, rect.top ); i < clipped_rects->count; i++)
     {
+        if (clipped_rects->rects[i].top >= rect.bottom) break;
         if (intersect_rect( &clipped_rect, &rect, clipped_rects->rects + i ))
         {
             src_origin.x = clipped_rect.left - rect.left;
@@ -733,14 +883,14 @@ static struct cached_glyph *cache_glyph_bitmap( HDC hdc, struct cached_font *fon
 
 done:
     glyph->metrics = metrics;
-    return add_cached_glyph( font, index, flags, glyph );
+    return add_cached_glyph( font, index, flags, glyph, size );
 }
 
 static void render_string( HDC hdc, dib_info *dib, struct cached_font *font, INT x, INT y,
                            UINT flags, const WCHAR *str, UINT count, const INT *dx,
                            const struct clipped_rects *clipped_rects, RECT *bounds )
 {
-    UINT i;
+    UINT i, misses = 0;
     struct cached_glyph *glyph;
     dib_info glyph_dib;
     DWORD text_color;
@@ -757,10 +907,14 @@ static void render_string( HDC hdc, dib_info *dib, struct cached_font *font, INT
     if (glyph_dib.bit_count == 8)
         get_aa_ranges( dib->funcs->pixel_to_colorref( dib, text_color ), ranges );
 
+    AcquireSRWLockShared( &font->lock );
     for (i = 0; i < count; i++)
     {
-        if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
-            !(glyph = cache_glyph_bitmap( hdc, font, str[i], flags ))) continue;
+        if (!(glyph = get_cached_glyph( font, str[i], flags )))
+        {
+            misses++;
+            if (!(glyph = cache_glyph_bitmap( hdc, font, str[i], flags ))) continue;
+        }
 
         glyph_dib.width       = glyph->metrics.gmBlackBoxX;
         glyph_dib.height      = glyph->metrics.gmBlackBoxY;
@@ -787,6 +941,15 @@ static void render_string( HDC hdc, dib_info *dib, struct cached_font *font, INT
             y += glyph->metrics.gmCellIncY;
         }
     }
+    ReleaseSRWLockShared( &font->lock );
+
+    if (glyph_cache_size > GLYPH_CACHE_MAX_SIZE) trim_glyph_cache();
+
+    if (TRACE_ON(glyphcache))
+    {
+        InterlockedExchangeAdd( &glyph_cache_hits, count - misses );
+        InterlockedExchangeAdd( &glyph_cache_misses, misses );
+    }
 }
 
 BOOL render_aa_text_bitmapinfo( HDC hdc, BITMAPINFO *info, struct gdi_image_bits *bits,
@@ -1144,6 +1307,21 @@ BOOL dibdrv_PaintRgn( PHYSDEV dev, HRGN rgn )
     return TRUE;
 }
 
+/* fill polygons with the brush straight from their scan conversion, without creating a region */
+static BOOL fill_polygons( dibdrv_physdev *pdev, const POINT *points, const INT *counts, DWORD polygons )
+{
+    WINEREGION interior;
+    BOOL ret = TRUE;
+    int i;
+
+    if (!init_polypolygon_region( &interior, points, counts, polygons, GetPolyFillMode( pdev->dev.hdc )))
+        return FALSE;
+    for (i = 0; ret && i < interior.numRects; i++)
+        ret = brush_rect( pdev, &pdev->brush, &interior.rects[i], pdev->clip );
+    destroy_region( &interior );
+    return ret;
+}
+
 /***********************************************************************
  *           dibdrv_PolyPolygon
  */
@@ -1166,21 +1344,18 @@ BOOL dibdrv_PolyPolygon( PHYSDEV dev, const POINT *pt, const INT *counts, DWORD
     memcpy( points, pt, total * sizeof(*pt) );
     LPtoDP( dev->hdc, points, total );
 
-    if (pdev->brush.style != BS_NULL &&
-        !(interior = CreatePolyPolygonRgn( points, counts, polygons, GetPolyFillMode( dev->hdc ))))
-    {
-        HeapFree( GetProcessHeap(), 0, points );
-        return FALSE;
-    }
-
     if (pdev->pen_uses_region) outline = CreateRectRgn( 0, 0, 0, 0 );
 
-    /* if not using a region, paint the interior first so the outline can overlap it */
-    if (interior && !outline)
+    if (pdev->brush.style != BS_NULL)
     {
-        ret = brush_region( pdev, interior );
-        DeleteObject( interior );
-        interior = 0;
+        /* if not using a region, paint the interior first so the outline can overlap it */
+        if (!outline) ret = fill_polygons( pdev, points, counts, polygons );
+        else if (!(interior = CreatePolyPolygonRgn( points, counts, polygons, GetPolyFillMode( dev->hdc ))))
+        {
+            DeleteObject( outline );
+            HeapFree( GetProcessHeap(), 0, points );
+            return FALSE;
+        }
     }
 
     for (i = pos = 0; i < polygons; i++)
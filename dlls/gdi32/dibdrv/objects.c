@@ -1756,15 +1756,31 @@ COLORREF dibdrv_SetDCPenColor( PHYSDEV dev, COLORREF color )
  *
  * Fill a number of rectangles with the solid brush
  */
+struct solid_rects_op
+{
+    struct tile_op  op;
+    const dib_info *dib;
+    rop_mask        color;
+};
+
+static BOOL solid_rects_tile( struct tile_op *op, int num, const RECT *rects )
+{
+    struct solid_rects_op *solid = CONTAINING_RECORD( op, struct solid_rects_op, op );
+
+    solid->dib->funcs->solid_rects( solid->dib, num, rects, solid->color.and, solid->color.xor );
+    return TRUE;
+}
+
 static BOOL solid_brush(dibdrv_physdev *pdev, dib_brush *brush, dib_info *dib,
                         int num, const RECT *rects, INT rop)
 {
-    rop_mask brush_color;
+    struct solid_rects_op solid;
     DWORD color = get_pixel_color( pdev->dev.hdc, &pdev->dib, brush->colorref, TRUE );
 
-    calc_rop_masks( rop, color, &brush_color );
-    dib->funcs->solid_rects( dib, num, rects, brush_color.and, brush_color.xor );
-    return TRUE;
+    calc_rop_masks( rop, color, &solid.color );
+    solid.op.func = solid_rects_tile;
+    solid.dib = dib;
+    return run_tiled_op( &solid.op, num, rects );
 }
 
 static BOOL alloc_brush_mask_bits( dib_brush *brush )
@@ -1989,10 +2005,27 @@ static BOOL select_pattern_brush( dibdrv_physdev *pdev, dib_brush *brush, BOOL *
  * Fill a number of rectangles with the pattern brush
  * FIXME: Should we insist l < r && t < b?  Currently we assume this.
  */
+struct pattern_rects_op
+{
+    struct tile_op  op;
+    const dib_info *dib;
+    dib_brush      *brush;
+    POINT           origin;
+};
+
+static BOOL pattern_rects_tile( struct tile_op *op, int num, const RECT *rects )
+{
+    struct pattern_rects_op *pattern = CONTAINING_RECORD( op, struct pattern_rects_op, op );
+
+    pattern->dib->funcs->pattern_rects( pattern->dib, num, rects, &pattern->origin,
+                                        &pattern->brush->dib, &pattern->brush->masks );
+    return TRUE;
+}
+
 static BOOL pattern_brush(dibdrv_physdev *pdev, dib_brush *brush, dib_info *dib,
                           int num, const RECT *rects, INT rop)
 {
-    POINT origin;
+    struct pattern_rects_op pattern;
     BOOL needs_reselect = FALSE;
 
     if (rop != brush->rop)
@@ -2028,9 +2061,12 @@ static BOOL pattern_brush(dibdrv_physdev *pdev, dib_brush *brush, dib_info *dib,
         }
     }
 
-    GetBrushOrgEx(pdev->dev.hdc, &origin);
+    GetBrushOrgEx(pdev->dev.hdc, &pattern.origin);
 
-    dib->funcs->pattern_rects( dib, num, rects, &origin, &brush->dib, &brush->masks );
+    pattern.op.func = pattern_rects_tile;
+    pattern.dib = dib;
+    pattern.brush = brush;
+    run_tiled_op( &pattern.op, num, rects );
 
     if (needs_reselect) free_pattern_brush( brush );
     return TRUE;
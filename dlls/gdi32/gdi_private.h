@@ -336,6 +336,10 @@ typedef struct
     RECT extents;
 } WINEREGION;
 
+extern BOOL init_polypolygon_region( WINEREGION *reg, const POINT *pts, const INT *count,
+                                     INT polygons, INT mode ) DECLSPEC_HIDDEN;
+extern void destroy_region( WINEREGION *reg ) DECLSPEC_HIDDEN;
+
 /* return the region data without making a copy */
 static inline const WINEREGION *get_wine_region(HRGN rgn)
 {
@@ -346,6 +350,21 @@ static inline void release_wine_region(HRGN rgn)
     GDI_ReleaseObj(rgn);
 }
 
+/* Region rectangles are stored in y-x banded order, so their bottom coordinates are
+ * sorted. Return the index of the first rectangle of the first band below y. */
+static inline int find_band( const RECT *rects, int count, int y )
+{
+    int min = 0, max = count;
+
+    while (min < max)
+    {
+        int pos = (min + max) / 2;
+        if (rects[pos].bottom <= y) min = pos + 1;
+        else max = pos;
+    }
+    return min;
+}
+
 /* null driver entry points */
 extern BOOL nulldrv_AbortPath( PHYSDEV dev ) DECLSPEC_HIDDEN;
 extern BOOL nulldrv_AlphaBlend( PHYSDEV dst_dev, struct bitblt_coords *dst,
@@ -310,19 +310,85 @@ static void PATH_CheckCorners( HDC hdc, POINT corners[], INT x1, INT y1, INT x2,
     }
 }
 
+#define BEZIER_MAX_DEPTH  16   /* maximum subdivision depth */
+#define BEZIER_TOLERANCE  1.0  /* maximum device space distance between the curve and its lines */
+
+/* check whether a Bezier segment can be replaced by its chord, using the
+ * bound on their distance derived from the control points */
+static BOOL bezier_is_flat( const FLOAT_POINT *pt )
+{
+    double ux = 3.0 * pt[1].x - 2.0 * pt[0].x - pt[3].x;
+    double uy = 3.0 * pt[1].y - 2.0 * pt[0].y - pt[3].y;
+    double vx = 3.0 * pt[2].x - pt[0].x - 2.0 * pt[3].x;
+    double vy = 3.0 * pt[2].y - pt[0].y - 2.0 * pt[3].y;
+
+    ux *= ux;
+    uy *= uy;
+    vx *= vx;
+    vy *= vy;
+    return max( ux, vx ) + max( uy, vy ) <= 16.0 * BEZIER_TOLERANCE * BEZIER_TOLERANCE;
+}
+
 /* PATH_AddFlatBezier
+ *
+ * Adds line segments approximating the Bezier curve starting at pt[0] to the
+ * path. The curve is split at its midpoint until each part is flat enough,
+ * so the number of lines adapts to the curvature and the device size.
  */
 static BOOL PATH_AddFlatBezier(struct gdi_path *pPath, POINT *pt, BOOL closed)
 {
-    POINT *pts;
-    INT no, i;
+    FLOAT_POINT stack[BEZIER_MAX_DEPTH + 1][4], *cur, *next;
+    int depth[BEZIER_MAX_DEPTH + 1];
+    int i, top = 0;
+    POINT point, last = pt[0];
 
-    pts = GDI_Bezier( pt, 4, &no );
-    if(!pts) return FALSE;
+    for (i = 0; i < 4; i++)
+    {
+        stack[0][i].x = pt[i].x;
+        stack[0][i].y = pt[i].y;
+    }
+    depth[0] = 0;
 
-    for(i = 1; i < no; i++)
-        PATH_AddEntry(pPath, &pts[i], (i == no-1 && closed) ? PT_LINETO | PT_CLOSEFIGURE : PT_LINETO);
-    HeapFree( GetProcessHeap(), 0, pts );
+    /* the parts are kept on the stack from right to left, so the
+     * top one always starts at the last point that was added */
+    while (top >= 0)
+    {
+        cur = stack[top];
+        if (depth[top] == BEZIER_MAX_DEPTH || bezier_is_flat( cur ))
+        {
+            point.x = GDI_ROUND( cur[3].x );
+            point.y = GDI_ROUND( cur[3].y );
+            if (!top)
+            {
+                if (!PATH_AddEntry( pPath, &point, closed ? PT_LINETO | PT_CLOSEFIGURE : PT_LINETO ))
+                    return FALSE;
+            }
+            else if (point.x != last.x || point.y != last.y)
+            {
+                if (!PATH_AddEntry( pPath, &point, PT_LINETO )) return FALSE;
+                last = point;
+            }
+            top--;
+            continue;
+        }
+
+        /* de Casteljau split, the right half stays in place */
+        next = stack[top + 1];
+        next[0] = cur[0];
+        next[1].x = (cur[0].x + cur[1].x) / 2;
+        next[1].y = (cur[0].y + cur[1].y) / 2;
+        next[2].x = (cur[0].x + 2 * cur[1].x + cur[2].x) / 4;
+        next[2].y = (cur[0].y + 2 * cur[1].y + cur[2].y) / 4;
+        next[3].x = (cur[0].x + 3 * cur[1].x + 3 * cur[2].x + cur[3].x) / 8;
+        next[3].y = (cur[0].y + 3 * cur[1].y + 3 * cur[2].y + cur[3].y) / 8;
+        cur[1].x = (cur[1].x + 2 * cur[2].x + cur[3].x) / 4;
+        cur[1].y = (cur[1].y + 2 * cur[2].y + cur[3].y) / 4;
+        cur[2].x = (cur[2].x + cur[3].x) / 2;
+        cur[2].y = (cur[2].y + cur[3].y) / 2;
+        cur[0] = next[3];
+        depth[top + 1] = ++depth[top];
+        top++;
+    }
     return TRUE;
 }
 
@@ -362,44 +428,36 @@ static struct gdi_path *PATH_FlattenPath(const struct gdi_path *pPath)
     return new_path;
 }
 
-/* PATH_PathToRegion
+/* PATH_GetStrokes
  *
- * Creates a region from the specified path using the specified polygon
- * filling mode. The path is left unchanged.
+ * Returns the number of points in each stroke of a flattened path.
  */
-static HRGN PATH_PathToRegion(const struct gdi_path *pPath, INT nPolyFillMode)
+static INT *PATH_GetStrokes(const struct gdi_path *pPath, INT *pNumStrokes)
 {
-    struct gdi_path *rgn_path;
     int    numStrokes, iStroke, i;
     INT  *pNumPointsInStroke;
-    HRGN hrgn;
-
-    if (!(rgn_path = PATH_FlattenPath( pPath ))) return 0;
-
-    /* FIXME: What happens when number of points is zero? */
 
     /* First pass: Find out how many strokes there are in the path */
     /* FIXME: We could eliminate this with some bookkeeping in GdiPath */
     numStrokes=0;
-    for(i=0; i<rgn_path->count; i++)
-        if((rgn_path->flags[i] & ~PT_CLOSEFIGURE) == PT_MOVETO)
+    for(i=0; i<pPath->count; i++)
+        if((pPath->flags[i] & ~PT_CLOSEFIGURE) == PT_MOVETO)
             numStrokes++;
 
     /* Allocate memory for number-of-points-in-stroke array */
     pNumPointsInStroke=HeapAlloc( GetProcessHeap(), 0, sizeof(int) * numStrokes );
     if(!pNumPointsInStroke)
     {
-        free_gdi_path( rgn_path );
         SetLastError(ERROR_NOT_ENOUGH_MEMORY);
-        return 0;
+        return NULL;
     }
 
     /* Second pass: remember number of points in each polygon */
     iStroke=-1;  /* Will get incremented to 0 at beginning of first stroke */
-    for(i=0; i<rgn_path->count; i++)
+    for(i=0; i<pPath->count; i++)
     {
         /* Is this the beginning of a new stroke? */
-        if((rgn_path->flags[i] & ~PT_CLOSEFIGURE) == PT_MOVETO)
+        if((pPath->flags[i] & ~PT_CLOSEFIGURE) == PT_MOVETO)
         {
             iStroke++;
             pNumPointsInStroke[iStroke]=0;
@@ -408,6 +466,32 @@ static HRGN PATH_PathToRegion(const struct gdi_path *pPath, INT nPolyFillMode)
         pNumPointsInStroke[iStroke]++;
     }
 
+    *pNumStrokes = numStrokes;
+    return pNumPointsInStroke;
+}
+
+/* PATH_PathToRegion
+ *
+ * Creates a region from the specified path using the specified polygon
+ * filling mode. The path is left unchanged.
+ */
+static HRGN PATH_PathToRegion(const struct gdi_path *pPath, INT nPolyFillMode)
+{
+    struct gdi_path *rgn_path;
+    int    numStrokes;
+    INT  *pNumPointsInStroke;
+    HRGN hrgn;
+
+    if (!(rgn_path = PATH_FlattenPath( pPath ))) return 0;
+
+    /* FIXME: What happens when number of points is zero? */
+
+    if (!(pNumPointsInStroke = PATH_GetStrokes( rgn_path, &numStrokes )))
+    {
+        free_gdi_path( rgn_path );
+        return 0;
+    }
+
     /* Create a region from the strokes */
     hrgn=CreatePolyPolygonRgn(rgn_path->points, pNumPointsInStroke,
                               numStrokes, nPolyFillMode);
@@ -665,19 +749,46 @@ HRGN WINAPI PathToRegion(HDC hdc)
    return hrgnRval;
 }
 
-static BOOL PATH_FillPath( HDC hdc, const struct gdi_path *pPath )
+static BOOL PATH_FillPath( DC *dc, const struct gdi_path *pPath )
 {
+   HDC   hdc = dc->hSelf;
    INT   mapMode, graphicsMode;
    SIZE  ptViewportExt, ptWindowExt;
-   POINT ptViewportOrg, ptWindowOrg;
+   POINT ptViewportOrg, ptWindowOrg, *src, *dst;
    XFORM xform;
-   HRGN  hrgn;
+   HPEN  hpen;
+   HRGN  hrgn = 0;
+   struct gdi_path *flat_path = NULL;
+   INT   *counts = NULL, numStrokes, numPolygons = 0, i;
+   BOOL  ret = TRUE;
+
+   /* The DIB engine fills the flattened path as polygons with a null pen,
+    * rasterizing it directly instead of painting an intermediate region.
+    * Other drivers, such as printer drivers, keep getting the region.
+    * Strokes of less than two points don't cover anything and aren't valid
+    * polygons, so drop them. */
+   if (find_dc_driver( dc, &dib_driver ))
+   {
+      if (!(flat_path = PATH_FlattenPath( pPath ))) return FALSE;
+      if (!(counts = PATH_GetStrokes( flat_path, &numStrokes )))
+      {
+         free_gdi_path( flat_path );
+         return FALSE;
+      }
+      for (i = 0, src = dst = flat_path->points; i < numStrokes; src += counts[i++])
+      {
+         if (counts[i] < 2) continue;
+         memmove( dst, src, counts[i] * sizeof(*dst) );
+         dst += counts[i];
+         counts[numPolygons++] = counts[i];
+      }
+   }
+   else if (!(hrgn = PATH_PathToRegion( pPath, GetPolyFillMode(hdc) ))) return FALSE;
 
-   /* Construct a region from the path and fill it */
-   if ((hrgn = PATH_PathToRegion(pPath, GetPolyFillMode(hdc))))
+   if (numPolygons || hrgn)
    {
-      /* Since PaintRgn interprets the region as being in logical coordinates
-       * but the points we store for the path are already in device
+      /* Since PolyPolygon and PaintRgn interpret their input as being in logical
+       * coordinates but the points we store for the path are already in device
        * coordinates, we have to set the mapping mode to MM_TEXT temporarily.
        * Using SaveDC to save information about the mapping mode / world
        * transform would be easier but would require more overhead, especially
@@ -708,9 +819,20 @@ static BOOL PATH_FillPath( HDC hdc, const struct gdi_path *pPath )
       ModifyWorldTransform(hdc, &xform, MWT_IDENTITY);
       SetGraphicsMode(hdc, graphicsMode);
 
-      /* Paint the region */
-      PaintRgn(hdc, hrgn);
-      DeleteObject(hrgn);
+      if (hrgn)
+      {
+         /* Paint the region */
+         PaintRgn(hdc, hrgn);
+         DeleteObject(hrgn);
+      }
+      else
+      {
+         /* Fill the polygons */
+         hpen = SelectObject(hdc, GetStockObject(NULL_PEN));
+         ret = PolyPolygon(hdc, flat_path->points, counts, numPolygons);
+         SelectObject(hdc, hpen);
+      }
+
       /* Restore the old mapping mode */
       SetMapMode(hdc, mapMode);
       SetViewportExtEx(hdc, ptViewportExt.cx, ptViewportExt.cy, NULL);
@@ -723,9 +845,11 @@ static BOOL PATH_FillPath( HDC hdc, const struct gdi_path *pPath )
       SetGraphicsMode(hdc, GM_ADVANCED);
       SetWorldTransform(hdc, &xform);
       SetGraphicsMode(hdc, graphicsMode);
-      return TRUE;
    }
-   return FALSE;
+
+   HeapFree( GetProcessHeap(), 0, counts );
+   if (flat_path) free_gdi_path( flat_path );
+   return ret;
 }
 
 
@@ -2146,7 +2270,7 @@ BOOL nulldrv_FillPath( PHYSDEV dev )
         SetLastError( ERROR_CAN_NOT_COMPLETE );
         return FALSE;
     }
-    if (!PATH_FillPath( dev->hdc, dc->path )) return FALSE;
+    if (!PATH_FillPath( dc, dc->path )) return FALSE;
     /* FIXME: Should the path be emptied even if conversion failed? */
     free_gdi_path( dc->path );
     dc->path = NULL;
@@ -2162,7 +2286,7 @@ BOOL nulldrv_StrokeAndFillPath( PHYSDEV dev )
         SetLastError( ERROR_CAN_NOT_COMPLETE );
         return FALSE;
     }
-    if (!PATH_FillPath( dev->hdc, dc->path )) return FALSE;
+    if (!PATH_FillPath( dc, dc->path )) return FALSE;
     if (!PATH_StrokePath( dev->hdc, dc->path )) return FALSE;
     free_gdi_path( dc->path );
     dc->path = NULL;
@@ -448,7 +448,7 @@ static BOOL init_region( WINEREGION *pReg, INT n )
 /***********************************************************************
  *           destroy_region
  */
-static void destroy_region( WINEREGION *pReg )
+void destroy_region( WINEREGION *pReg )
 {
     HeapFree( GetProcessHeap(), 0, pReg->rects );
 }
@@ -1045,12 +1045,15 @@ BOOL WINAPI PtInRegion( HRGN hrgn, INT x, INT y )
 	int i;
 
 	if (obj->numRects > 0 && is_in_rect(&obj->extents, x, y))
-	    for (i = 0; i < obj->numRects; i++)
+	    for (i = find_band( obj->rects, obj->numRects, y ); i < obj->numRects; i++)
+            {
+                if (obj->rects[i].top > y) break;
 		if (is_in_rect(&obj->rects[i], x, y))
                 {
 		    ret = TRUE;
                     break;
                 }
+            }
 	GDI_ReleaseObj( hrgn );
     }
     return ret;
@@ -1088,8 +1091,8 @@ BOOL WINAPI RectInRegion( HRGN hrgn, const RECT *rect )
     /* this is (just) a useful optimization */
 	if ((obj->numRects > 0) && overlapping(&obj->extents, &rc))
 	{
-	    for (pCurRect = obj->rects, pRectEnd = pCurRect +
-	     obj->numRects; pCurRect < pRectEnd; pCurRect++)
+	    for (pCurRect = obj->rects + find_band( obj->rects, obj->numRects, rc.top ),
+	     pRectEnd = obj->rects + obj->numRects; pCurRect < pRectEnd; pCurRect++)
 	    {
 	        if (pCurRect->bottom <= rc.top)
 		    continue;             /* not far enough down yet */
@@ -2650,13 +2653,15 @@ static BOOL REGION_PtsToRegion( struct point_block *FirstPtBlock, WINEREGION *re
 }
 
 /***********************************************************************
- *           CreatePolyPolygonRgn    (GDI32.@)
+ *           init_polypolygon_region
+ *
+ * Scan convert polygons into region data, without creating a region object.
+ * The rectangles must be freed with destroy_region.
  */
-HRGN WINAPI CreatePolyPolygonRgn(const POINT *Pts, const INT *Count,
-		      INT nbpolygons, INT mode)
+BOOL init_polypolygon_region( WINEREGION *obj, const POINT *Pts, const INT *Count,
+                              INT nbpolygons, INT mode )
 {
-    HRGN hrgn = 0;
-    WINEREGION *obj;
+    BOOL ret = FALSE;
     INT y;                           /* current scanline        */
     struct list WETE, *pWETE;        /* Winding Edge Table */
     ScanLineList *pSLL;              /* current scanLineList    */
@@ -2669,8 +2674,6 @@ HRGN WINAPI CreatePolyPolygonRgn(const POINT *Pts, const INT *Count,
     struct edge_table_entry *active, *next;
     INT poly, total;
 
-    TRACE("%p, count %d, polygons %d, mode %d\n", Pts, *Count, nbpolygons, mode);
-
     /* special case a rectangle */
 
     if (((nbpolygons == 1) && ((*Count == 4) ||
@@ -2683,13 +2686,24 @@ HRGN WINAPI CreatePolyPolygonRgn(const POINT *Pts, const INT *Count,
 	  (Pts[1].y == Pts[2].y) &&
 	  (Pts[2].x == Pts[3].x) &&
 	  (Pts[3].y == Pts[0].y))))
-        return CreateRectRgn( min(Pts[0].x, Pts[2].x), min(Pts[0].y, Pts[2].y),
-                              max(Pts[0].x, Pts[2].x), max(Pts[0].y, Pts[2].y) );
+    {
+        if (!init_region( obj, 1 )) return FALSE;
+        if (Pts[0].x != Pts[2].x && Pts[0].y != Pts[2].y)
+        {
+            obj->extents.left   = min(Pts[0].x, Pts[2].x);
+            obj->extents.top    = min(Pts[0].y, Pts[2].y);
+            obj->extents.right  = max(Pts[0].x, Pts[2].x);
+            obj->extents.bottom = max(Pts[0].y, Pts[2].y);
+            obj->rects[0] = obj->extents;
+            obj->numRects = 1;
+        }
+        return TRUE;
+    }
 
     for(poly = total = 0; poly < nbpolygons; poly++)
         total += Count[poly];
     if (! (pETEs = HeapAlloc( GetProcessHeap(), 0, sizeof(EdgeTableEntry) * total )))
-	return 0;
+	return FALSE;
 
     REGION_CreateEdgeTable(Count, nbpolygons, Pts, &ET, pETEs, &SLLBlock);
     list_init( &AET );
@@ -2775,23 +2789,38 @@ HRGN WINAPI CreatePolyPolygonRgn(const POINT *Pts, const INT *Count,
         }
     }
 
-    if (!(obj = HeapAlloc( GetProcessHeap(), 0, sizeof(*obj) ))) goto done;
+    ret = REGION_PtsToRegion(&FirstPtBlock, obj);
+
+done:
+    REGION_FreeStorage(SLLBlock.next);
+    free_point_blocks( FirstPtBlock.next );
+    HeapFree( GetProcessHeap(), 0, pETEs );
+    return ret;
+}
+
+/***********************************************************************
+ *           CreatePolyPolygonRgn    (GDI32.@)
+ */
+HRGN WINAPI CreatePolyPolygonRgn(const POINT *Pts, const INT *Count,
+		      INT nbpolygons, INT mode)
+{
+    HRGN hrgn;
+    WINEREGION *obj;
 
-    if (!REGION_PtsToRegion(&FirstPtBlock, obj))
+    TRACE("%p, count %d, polygons %d, mode %d\n", Pts, *Count, nbpolygons, mode);
+
+    if (!(obj = HeapAlloc( GetProcessHeap(), 0, sizeof(*obj) ))) return 0;
+
+    if (!init_polypolygon_region( obj, Pts, Count, nbpolygons, mode ))
     {
         HeapFree( GetProcessHeap(), 0, obj );
-        goto done;
+        return 0;
     }
     if (!(hrgn = alloc_gdi_handle( obj, OBJ_REGION, &region_funcs )))
     {
-        HeapFree( GetProcessHeap(), 0, obj->rects );
+        destroy_region( obj );
         HeapFree( GetProcessHeap(), 0, obj );
     }
-
-done:
-    REGION_FreeStorage(SLLBlock.next);
-    free_point_blocks( FirstPtBlock.next );
-    HeapFree( GetProcessHeap(), 0, pETEs );
     return hrgn;
 }
 
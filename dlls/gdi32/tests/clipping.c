@@ -548,6 +548,75 @@ static void test_window_dc_clipping(void)
 }
 
 
+static void test_complex_clip_text(void)
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog";
+    BITMAPINFO bmi;
+    DWORD *bits, start, time;
+    HBITMAP hbmp;
+    HRGN hrgn, sibling;
+    HDC hdc;
+    RECT rc;
+    int i, x, y, drawn = 0, clipped = 0;
+
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = 500;
+    bmi.bmiHeader.biHeight = -400;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    hbmp = CreateDIBSection(0, &bmi, DIB_RGB_COLORS, (void **)&bits, NULL, 0);
+    ok(hbmp != NULL, "CreateDIBSection failed\n");
+    memset(bits, 0xff, 500 * 400 * 4);
+
+    hdc = CreateCompatibleDC(0);
+    SelectObject(hdc, hbmp);
+    SelectObject(hdc, GetStockObject(SYSTEM_FONT));
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, RGB(0, 0, 0));
+
+    /* a window clipped by a grid of 500 siblings */
+    hrgn = CreateRectRgn(0, 0, 500, 400);
+    sibling = CreateRectRgn(0, 0, 0, 0);
+    for (i = 0; i < 500; i++)
+    {
+        x = (i % 25) * 20 + 2;
+        y = (i / 25) * 20 + 2;
+        SetRectRgn(sibling, x, y, x + 16, y + 12);
+        CombineRgn(hrgn, hrgn, sibling, RGN_DIFF);
+    }
+    ok(!PtInRegion(hrgn, 10, 10), "point inside a sibling should be clipped\n");
+    ok(PtInRegion(hrgn, 19, 10), "point between siblings should be visible\n");
+    SetRect(&rc, 4, 4, 10, 10);
+    ok(!RectInRegion(hrgn, &rc), "rect inside a sibling should be clipped\n");
+    SetRect(&rc, 4, 384, 22, 390);
+    ok(RectInRegion(hrgn, &rc), "rect overlapping two siblings should be visible\n");
+    SelectClipRgn(hdc, hrgn);
+
+    start = GetTickCount();
+    for (i = 0; i < 100; i++)
+        for (y = 0; y < 400; y += 10)
+            ExtTextOutA(hdc, (i % 5) - 5, y, 0, NULL, text, sizeof(text) - 1, NULL);
+    time = GetTickCount() - start;
+    trace("%u ExtTextOut calls with 500 clip holes took %u ms\n", 100 * 40, time);
+
+    for (y = 0; y < 400; y++)
+        for (x = 0; x < 500; x++)
+        {
+            if ((bits[y * 500 + x] & 0xffffff) == 0xffffff) continue;
+            if (x % 20 >= 2 && x % 20 < 18 && y % 20 >= 2 && y % 20 < 14) clipped++;
+            else drawn++;
+        }
+    ok(!clipped, "%d pixels drawn inside the siblings\n", clipped);
+    ok(drawn > 0, "no text drawn\n");
+
+    DeleteDC(hdc);
+    DeleteObject(hbmp);
+    DeleteObject(hrgn);
+    DeleteObject(sibling);
+}
+
 START_TEST(clipping)
 {
     test_GetRandomRgn();
@@ -555,4 +624,5 @@ START_TEST(clipping)
     test_GetClipRgn();
     test_memory_dc_clipping();
     test_window_dc_clipping();
+    test_complex_clip_text();
 }
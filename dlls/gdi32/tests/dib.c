@@ -26,6 +26,7 @@
 #include "winbase.h"
 #include "wingdi.h"
 #include "winuser.h"
+#include "winreg.h"
 #include "wincrypt.h"
 #include "mmsystem.h" /* DIBINDEX */
 
@@ -3330,16 +3331,145 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+static void draw_large_ops( HDC hdc, HDC src_dc, int size, int strip )
+{
+    static const BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0xc0, AC_SRC_ALPHA };
+    TRIVERTEX vert[3];
+    GRADIENT_RECT rect = { 0, 1 };
+    GRADIENT_TRIANGLE tri = { 0, 1, 2 };
+    HBRUSH brush, orig_brush;
+    int y;
+
+    vert[0].x = 0;    vert[0].y = 0;    vert[0].Red = 0xff00; vert[0].Green = 0x0000; vert[0].Blue = 0x8000;
+    vert[1].x = size; vert[1].y = size; vert[1].Red = 0x0000; vert[1].Green = 0xff00; vert[1].Blue = 0x4000;
+    vert[2].x = 0;    vert[2].y = size; vert[2].Red = 0x2000; vert[2].Green = 0x8000; vert[2].Blue = 0xff00;
+    vert[0].Alpha = vert[1].Alpha = vert[2].Alpha = 0;
+
+    brush = CreateHatchBrush( HS_DIAGCROSS, RGB( 0x20, 0x40, 0x60 ));
+    orig_brush = SelectObject( hdc, brush );
+
+    /* draw in one call, or in strips that are too small to be split further */
+    for (y = 0; y < size; y += strip)
+    {
+        SaveDC( hdc );
+        IntersectClipRect( hdc, 0, y, size, y + strip );
+        pGdiGradientFill( hdc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+        pGdiGradientFill( hdc, vert, 3, &tri, 1, GRADIENT_FILL_TRIANGLE );
+        PatBlt( hdc, 0, 0, size, size, PATINVERT );
+        pGdiAlphaBlend( hdc, 0, 0, size, size, src_dc, 0, 0, size, size, blend );
+        RestoreDC( hdc, -1 );
+    }
+
+    SelectObject( hdc, orig_brush );
+    DeleteObject( brush );
+}
+
+static void test_large_ops( const char *threads )
+{
+    static const int size = 2048;
+    BITMAPINFO bmi;
+    DWORD *bits[3], start, time;
+    HBITMAP dib[3];
+    HDC hdc[3];
+    int i;
+
+    if (!pGdiAlphaBlend || !pGdiGradientFill)
+    {
+        win_skip( "GdiAlphaBlend or GdiGradientFill not supported\n" );
+        return;
+    }
+
+    memset( &bmi, 0, sizeof(bmi) );
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = size;
+    bmi.bmiHeader.biHeight = -size;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    for (i = 0; i < 3; i++)
+    {
+        hdc[i] = CreateCompatibleDC( 0 );
+        dib[i] = CreateDIBSection( 0, &bmi, DIB_RGB_COLORS, (void **)&bits[i], NULL, 0 );
+        ok( dib[i] != NULL, "CreateDIBSection failed\n" );
+        SelectObject( hdc[i], dib[i] );
+    }
+    for (i = 0; i < size * size; i++) bits[2][i] = ((i * 0x01030507) & 0x00ffffff) | (i % 0xff) << 24;
+
+    start = GetTickCount();
+    draw_large_ops( hdc[0], hdc[2], size, size );
+    time = GetTickCount() - start;
+    trace( "large ops on %ux%u with %s render threads took %u ms\n", size, size, threads, time );
+
+    draw_large_ops( hdc[1], hdc[2], size, 64 );
+    ok( !memcmp( bits[0], bits[1], size * size * 4 ), "large ops don't match the ops done in strips\n" );
+
+    for (i = 0; i < 3; i++)
+    {
+        DeleteDC( hdc[i] );
+        DeleteObject( dib[i] );
+    }
+}
+
+static void test_render_threads(void)
+{
+    static const DWORD counts[] = { 1, 2, 4, 8, 16 };
+    char **argv, cmdline[MAX_PATH + 32], buffer[16], orig[16];
+    DWORD i, type, size = sizeof(orig);
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si;
+    BOOL has_orig;
+    HKEY hkey;
+    LONG ret;
+
+    /* the setting is read once per process, so each count runs in a child */
+    ret = RegCreateKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Gdi", &hkey );
+    ok( !ret, "RegCreateKey failed: %d\n", ret );
+    if (ret) return;
+    has_orig = !RegQueryValueExA( hkey, "RenderThreads", 0, &type, (BYTE *)orig, &size ) && type == REG_SZ;
+
+    winetest_get_mainargs( &argv );
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        sprintf( buffer, "%u", counts[i] );
+        RegSetValueExA( hkey, "RenderThreads", 0, REG_SZ, (BYTE *)buffer, strlen( buffer ) + 1 );
+
+        sprintf( cmdline, "\"%s\" dib large_ops %s", argv[0], buffer );
+        memset( &si, 0, sizeof(si) );
+        si.cb = sizeof(si);
+        ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+        ok( ret, "CreateProcess failed: %u\n", GetLastError() );
+        if (!ret) break;
+        winetest_wait_child_process( pi.hProcess );
+        CloseHandle( pi.hProcess );
+        CloseHandle( pi.hThread );
+    }
+
+    if (has_orig) RegSetValueExA( hkey, "RenderThreads", 0, REG_SZ, (BYTE *)orig, size );
+    else RegDeleteValueA( hkey, "RenderThreads" );
+    RegCloseKey( hkey );
+}
+
 START_TEST(dib)
 {
     HMODULE mod = GetModuleHandleA("gdi32.dll");
+    char **argv;
+
     pSetLayout = (void *)GetProcAddress( mod, "SetLayout" );
     pGdiAlphaBlend = (void *)GetProcAddress( mod, "GdiAlphaBlend" );
     pGdiGradientFill = (void *)GetProcAddress( mod, "GdiGradientFill" );
 
+    if (winetest_get_mainargs( &argv ) >= 4 && !strcmp( argv[2], "large_ops" ))
+    {
+        /* nothing must be drawn before, the render threads setting is read on first use */
+        test_large_ops( argv[3] );
+        return;
+    }
+
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_render_threads();
 
     CryptReleaseContext(crypt_prov, 0);
 }
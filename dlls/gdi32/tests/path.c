@@ -22,6 +22,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <assert.h>
+#include <math.h>
 #include "windef.h"
 #include "winbase.h"
 #include "wingdi.h"
@@ -735,6 +736,115 @@ static void test_linedda(void)
     ok(pt->x == -1 && pt->y == -1, "didn't find terminator\n");
 }
 
+static void test_flatten_bezier(void)
+{
+    /* a quarter circle of radius 1000 around (0,0) */
+    static const POINT curve[] = {{1000, 0}, {1000, 552}, {552, 1000}, {0, 1000}};
+    POINT *points;
+    BYTE *types;
+    HDC hdc = CreateCompatibleDC(0);
+    int i, count;
+    double dist;
+
+    BeginPath(hdc);
+    MoveToEx(hdc, curve[0].x, curve[0].y, NULL);
+    PolyBezierTo(hdc, curve + 1, 3);
+    EndPath(hdc);
+    ok(FlattenPath(hdc), "FlattenPath failed\n");
+
+    count = GetPath(hdc, NULL, NULL, 0);
+    ok(count > 2 && count < 200, "got %d points\n", count);
+    points = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*points));
+    types = HeapAlloc(GetProcessHeap(), 0, count);
+    GetPath(hdc, points, types, count);
+    ok(points[count - 1].x == 0 && points[count - 1].y == 1000, "wrong end point %d,%d\n",
+       points[count - 1].x, points[count - 1].y);
+    for (i = 0; i < count; i++)
+    {
+        ok(types[i] == (i ? PT_LINETO : PT_MOVETO), "%d: wrong type %02x\n", i, types[i]);
+        dist = sqrt((double)points[i].x * points[i].x + (double)points[i].y * points[i].y);
+        ok(dist > 997.0 && dist < 1003.0, "%d: point %d,%d too far from the curve\n", i, points[i].x, points[i].y);
+    }
+    HeapFree(GetProcessHeap(), 0, points);
+    HeapFree(GetProcessHeap(), 0, types);
+    DeleteDC(hdc);
+}
+
+static void draw_bezier_shapes(HDC hdc, int shapes)
+{
+    POINT pts[9];
+    unsigned int seed = 12345;
+    int i, j;
+
+    BeginPath(hdc);
+    for (i = 0; i < shapes; i++)
+    {
+        for (j = 0; j < 9; j++)
+        {
+            seed = seed * 1103515245 + 12345;
+            pts[j].x = (seed >> 8) % 1024;
+            seed = seed * 1103515245 + 12345;
+            pts[j].y = (seed >> 8) % 1024;
+        }
+        MoveToEx(hdc, pts[0].x, pts[0].y, NULL);
+        PolyBezierTo(hdc, pts + 1, 6);
+        LineTo(hdc, pts[8].x, pts[8].y);
+        CloseFigure(hdc);
+    }
+    EndPath(hdc);
+}
+
+static void test_fill_bezier_paths(void)
+{
+    BITMAPINFO bmi;
+    DWORD *bits[2], start, time;
+    HBITMAP dib[2];
+    HBRUSH brush = CreateSolidBrush(RGB(0x40, 0x80, 0xc0));
+    HRGN rgn;
+    HDC hdc[2];
+    int i;
+
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = 1024;
+    bmi.bmiHeader.biHeight = -1024;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    for (i = 0; i < 2; i++)
+    {
+        hdc[i] = CreateCompatibleDC(0);
+        dib[i] = CreateDIBSection(0, &bmi, DIB_RGB_COLORS, (void **)&bits[i], NULL, 0);
+        ok(dib[i] != NULL, "CreateDIBSection failed\n");
+        SelectObject(hdc[i], dib[i]);
+        SelectObject(hdc[i], brush);
+        SetPolyFillMode(hdc[i], WINDING);
+    }
+
+    /* a vector map-like set of shapes, filled directly or through a region */
+    start = GetTickCount();
+    draw_bezier_shapes(hdc[0], 2000);
+    ok(FillPath(hdc[0]), "FillPath failed\n");
+    time = GetTickCount() - start;
+    trace("filling 2000 bezier shapes took %u ms\n", time);
+
+    draw_bezier_shapes(hdc[1], 2000);
+    rgn = PathToRegion(hdc[1]);
+    ok(rgn != 0, "PathToRegion failed\n");
+    FillRgn(hdc[1], rgn, brush);
+    DeleteObject(rgn);
+
+    ok(!memcmp(bits[0], bits[1], 1024 * 1024 * 4), "FillPath doesn't match the path region\n");
+
+    for (i = 0; i < 2; i++)
+    {
+        DeleteDC(hdc[i]);
+        DeleteObject(dib[i]);
+    }
+    DeleteObject(brush);
+}
+
 START_TEST(path)
 {
     test_path_state();
@@ -744,4 +854,6 @@ START_TEST(path)
     test_polydraw();
     test_closefigure();
     test_linedda();
+    test_flatten_bezier();
+    test_fill_bezier_paths();
 }
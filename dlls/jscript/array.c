@@ -143,8 +143,9 @@ static HRESULT Array_set_length(script_ctx_t *ctx, jsdisp_t *jsthis, jsval_t val
     if(len!=(DWORD)len)
         return throw_range_error(ctx, JS_E_INVALID_LENGTH, NULL);
 
-    for(i=len; i < This->length; i++) {
-        hres = jsdisp_delete_idx(&This->dispex, i);
+    /* Delete from the end so that dense storage is truncated in place. */
+    for(i=This->length; i > len; i--) {
+        hres = jsdisp_delete_idx(&This->dispex, i-1);
         if(FAILED(hres))
             return hres;
     }
@@ -956,6 +957,13 @@ static HRESULT Array_unshift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsi
         return hres;
 
     if(argc) {
+        /* Extend the array first, so that dense arrays stay dense while elements are moved. */
+        for(i=0; i<argc; i++) {
+            hres = jsdisp_propput_idx(jsthis, length+i, jsval_undefined());
+            if(FAILED(hres))
+                return hres;
+        }
+
         buf_end = buf + sizeof(buf)/sizeof(WCHAR)-1;
         *buf_end-- = 0;
         i = length;
@@ -972,7 +980,7 @@ static HRESULT Array_unshift(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsi
                 hres = jsdisp_propput_idx(jsthis, i+argc, val);
                 jsval_release(val);
             }else if(hres == DISP_E_UNKNOWNNAME) {
-                hres = IDispatchEx_DeleteMemberByDispID(vthis->u.dispex, id);
+                hres = jsdisp_delete_idx(jsthis, i+argc);
             }
         }
 
@@ -1033,6 +1041,14 @@ static void Array_on_put(jsdisp_t *dispex, const WCHAR *name)
         array->length = id+1;
 }
 
+static void Array_on_put_elem(jsdisp_t *dispex, unsigned idx)
+{
+    ArrayInstance *array = array_from_jsdisp(dispex);
+
+    if(idx >= array->length)
+        array->length = idx+1;
+}
+
 static const builtin_prop_t Array_props[] = {
     {concatW,                Array_concat,               PROPF_METHOD|1},
     {joinW,                  Array_join,                 PROPF_METHOD|1},
@@ -1055,7 +1071,11 @@ static const builtin_info_t Array_info = {
     sizeof(Array_props)/sizeof(*Array_props),
     Array_props,
     Array_destructor,
-    Array_on_put
+    Array_on_put,
+    NULL,
+    NULL,
+    NULL,
+    Array_on_put_elem
 };
 
 static const builtin_prop_t ArrayInst_props[] = {
@@ -1068,7 +1088,11 @@ static const builtin_info_t ArrayInst_info = {
     sizeof(ArrayInst_props)/sizeof(*ArrayInst_props),
     ArrayInst_props,
     Array_destructor,
-    Array_on_put
+    Array_on_put,
+    NULL,
+    NULL,
+    NULL,
+    Array_on_put_elem
 };
 
 static HRESULT ArrayConstr_value(script_ctx_t *ctx, vdisp_t *vthis, WORD flags, unsigned argc, jsval_t *argv,
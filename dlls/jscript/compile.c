@@ -54,6 +54,10 @@ typedef struct {
     unsigned labels_size;
     unsigned labels_cnt;
 
+    unsigned *local_refs;
+    unsigned local_refs_size;
+    unsigned local_refs_cnt;
+
     statement_ctx_t *stat_ctx;
     function_code_t *func;
 
@@ -215,6 +219,7 @@ static unsigned push_instr(compiler_ctx_t *ctx, jsop_t op)
     }
 
     ctx->code->instrs[ctx->code_off].op = op;
+    memset(&ctx->code->instrs[ctx->code_off].u, 0, sizeof(ctx->code->instrs[ctx->code_off].u));
     return ctx->code_off++;
 }
 
@@ -361,6 +366,47 @@ static HRESULT compile_unary_expression(compiler_ctx_t *ctx, unary_expression_t
     return push_instr(ctx, op) ? S_OK : E_OUTOFMEMORY;
 }
 
+/*
+ * Identifier references in function code that are not shadowed by a with or catch scope are
+ * candidates for local variable slots. They are resolved at the end of compile_function.
+ */
+static HRESULT push_instr_ident(compiler_ctx_t *ctx, jsop_t op, const WCHAR *identifier, unsigned flags)
+{
+    statement_ctx_t *iter;
+    HRESULT hres;
+
+    if(op == OP_identid)
+        hres = push_instr_bstr_uint(ctx, op, identifier, flags);
+    else
+        hres = push_instr_bstr(ctx, op, identifier);
+    if(FAILED(hres))
+        return hres;
+
+    for(iter = ctx->stat_ctx; iter; iter = iter->next) {
+        if(iter->using_scope)
+            return S_OK;
+    }
+
+    if(!ctx->local_refs_size) {
+        ctx->local_refs = heap_alloc(16 * sizeof(*ctx->local_refs));
+        if(!ctx->local_refs)
+            return E_OUTOFMEMORY;
+        ctx->local_refs_size = 16;
+    }else if(ctx->local_refs_size == ctx->local_refs_cnt) {
+        unsigned *new_refs;
+
+        new_refs = heap_realloc(ctx->local_refs, 2*ctx->local_refs_size*sizeof(*ctx->local_refs));
+        if(!new_refs)
+            return E_OUTOFMEMORY;
+
+        ctx->local_refs = new_refs;
+        ctx->local_refs_size *= 2;
+    }
+
+    ctx->local_refs[ctx->local_refs_cnt++] = ctx->code_off-1;
+    return S_OK;
+}
+
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT compile_member_expression(compiler_ctx_t *ctx, member_expression_t *expr)
 {
@@ -415,7 +461,7 @@ static HRESULT compile_memberid_expression(compiler_ctx_t *ctx, expression_t *ex
     case EXPR_IDENT: {
         identifier_expression_t *ident_expr = (identifier_expression_t*)expr;
 
-        hres = push_instr_bstr_uint(ctx, OP_identid, ident_expr->identifier, flags);
+        hres = push_instr_ident(ctx, OP_identid, ident_expr->identifier, flags);
         break;
     }
     case EXPR_ARRAY: {
@@ -864,7 +910,7 @@ static HRESULT compile_function_expression(compiler_ctx_t *ctx, function_express
     /* FIXME: not exactly right */
     if(expr->identifier) {
         ctx->func->func_cnt++;
-        return push_instr_bstr(ctx, OP_ident, expr->identifier);
+        return push_instr_ident(ctx, OP_ident, expr->identifier, 0);
     }
 
     return push_instr_uint(ctx, OP_func, ctx->func->func_cnt++);
@@ -961,7 +1007,7 @@ static HRESULT compile_expression(compiler_ctx_t *ctx, expression_t *expr, BOOL
         hres = compile_binary_expression(ctx, (binary_expression_t*)expr, OP_gteq);
         break;
     case EXPR_IDENT:
-        hres = push_instr_bstr(ctx, OP_ident, ((identifier_expression_t*)expr)->identifier);
+        hres = push_instr_ident(ctx, OP_ident, ((identifier_expression_t*)expr)->identifier, 0);
         break;
     case EXPR_IN:
         hres = compile_binary_expression(ctx, (binary_expression_t*)expr, OP_in);
@@ -1102,7 +1148,7 @@ static HRESULT compile_variable_list(compiler_ctx_t *ctx, variable_declaration_t
         if(FAILED(hres))
             return hres;
 
-        hres = push_instr_bstr(ctx, OP_var_set, iter->identifier);
+        hres = push_instr_ident(ctx, OP_var_set, iter->identifier, 0);
         if(FAILED(hres))
             return hres;
     }
@@ -1300,7 +1346,7 @@ static HRESULT compile_forin_statement(compiler_ctx_t *ctx, forin_statement_t *s
         return hres;
 
     if(stat->variable) {
-        hres = push_instr_bstr_uint(ctx, OP_identid, stat->variable->identifier, fdexNameEnsure);
+        hres = push_instr_ident(ctx, OP_identid, stat->variable->identifier, fdexNameEnsure);
         if(FAILED(hres))
             return hres;
     }else if(is_memberid_expr(stat->expr->type)) {
@@ -1789,6 +1835,84 @@ static void resolve_labels(compiler_ctx_t *ctx, unsigned off)
     ctx->labels_cnt = 0;
 }
 
+static BOOL is_local_name(compiler_ctx_t *ctx, function_expression_t *func_expr, const WCHAR *name)
+{
+    variable_declaration_t *var_iter;
+    function_expression_t *func_iter;
+    parameter_t *param_iter;
+
+    static const WCHAR argumentsW[] = {'a','r','g','u','m','e','n','t','s',0};
+
+    if(!strcmpW(name, argumentsW))
+        return TRUE;
+
+    for(param_iter = func_expr->parameter_list; param_iter; param_iter = param_iter->next) {
+        if(!strcmpW(name, param_iter->identifier))
+            return TRUE;
+    }
+
+    for(var_iter = ctx->var_head; var_iter; var_iter = var_iter->global_next) {
+        if(!strcmpW(name, var_iter->identifier))
+            return TRUE;
+    }
+
+    for(func_iter = ctx->func_head; func_iter; func_iter = func_iter->next) {
+        if(func_iter->identifier && !strcmpW(name, func_iter->identifier))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Rewrites references to the function's own variables, parameters and nested functions into
+ * local slot instructions. Each slot is bound to a DISPID of the variable object on function entry.
+ */
+static HRESULT resolve_locals(compiler_ctx_t *ctx, function_expression_t *func_expr)
+{
+    function_code_t *func = ctx->func;
+    instr_t *instr;
+    unsigned i, j;
+
+    if(!ctx->local_refs_cnt)
+        return S_OK;
+
+    func->locals = compiler_alloc(ctx->code, ctx->local_refs_cnt * sizeof(*func->locals));
+    if(!func->locals)
+        return E_OUTOFMEMORY;
+
+    for(i = 0; i < ctx->local_refs_cnt; i++) {
+        instr = instr_ptr(ctx, ctx->local_refs[i]);
+
+        for(j = 0; j < func->local_cnt; j++) {
+            if(!strcmpW(func->locals[j], instr->u.arg[0].bstr))
+                break;
+        }
+        if(j == func->local_cnt) {
+            if(!is_local_name(ctx, func_expr, instr->u.arg[0].bstr))
+                continue;
+            func->locals[func->local_cnt++] = instr->u.arg[0].bstr;
+        }
+
+        switch(instr->op) {
+        case OP_ident:
+            instr->op = OP_local;
+            break;
+        case OP_identid:
+            instr->op = OP_local_ref;
+            break;
+        case OP_var_set:
+            instr->op = OP_local_set;
+            break;
+        DEFAULT_UNREACHABLE;
+        }
+        instr->u.arg[0].uint = j;
+    }
+
+    ctx->local_refs_cnt = 0;
+    return S_OK;
+}
+
 void release_bytecode(bytecode_t *code)
 {
     unsigned i;
@@ -1847,6 +1971,7 @@ static HRESULT compile_function(compiler_ctx_t *ctx, source_elements_t *source,
 
     ctx->var_head = ctx->var_tail = NULL;
     ctx->func_head = ctx->func_tail = NULL;
+    ctx->local_refs_cnt = 0;
     ctx->from_eval = from_eval;
 
     off = ctx->code_off;
@@ -1857,6 +1982,12 @@ static HRESULT compile_function(compiler_ctx_t *ctx, source_elements_t *source,
 
     resolve_labels(ctx, off);
 
+    if(func_expr) {
+        hres = resolve_locals(ctx, func_expr);
+        if(FAILED(hres))
+            return hres;
+    }
+
     if(!push_instr(ctx, OP_ret))
         return E_OUTOFMEMORY;
 
@@ -2021,6 +2152,7 @@ HRESULT compile_script(script_ctx_t *ctx, const WCHAR *code, const WCHAR *args,
 
     hres = compile_function(&compiler, compiler.parser->source, NULL, from_eval, &compiler.code->global_code);
     parser_release(compiler.parser);
+    heap_free(compiler.local_refs);
     if(FAILED(hres)) {
         release_bytecode(compiler.code);
         return hres;
@@ -19,6 +19,7 @@
 #include <assert.h>
 
 #include "jscript.h"
+#include "engine.h"
 
 #include "wine/unicode.h"
 #include "wine/debug.h"
@@ -35,6 +36,16 @@ static const IID IID_IDispatchJS =
 #define FDEX_VERSION_MASK 0xf0000000
 #define GOLDEN_RATIO 0x9E3779B9U
 
+/*
+ * Objects with on_put_elem callback (arrays) store index properties in a dense
+ * jsval_t array as long as they are set contiguously from index 0. Such elements
+ * don't have dispex_prop_t entries and use DISPIDs starting at ELEM_DISPID_BASE.
+ * All other index properties are stored as regular named properties and
+ * elems_sparse flag is set once any of them is created.
+ */
+#define ELEM_DISPID_BASE 0x40000000
+#define ELEMS_MAX        0x10000000
+
 typedef enum {
     PROP_JSVAL,
     PROP_BUILTIN,
@@ -60,6 +71,10 @@ struct _dispex_prop_t {
     int bucket_next;
 };
 
+static const WCHAR idx_formatW[] = {'%','d',0};
+
+static dispex_prop_t *get_elem_prop(jsdisp_t*,unsigned);
+
 static inline DISPID prop_to_id(jsdisp_t *This, dispex_prop_t *prop)
 {
     return prop - This->props;
@@ -67,12 +82,58 @@ static inline DISPID prop_to_id(jsdisp_t *This, dispex_prop_t *prop)
 
 static inline dispex_prop_t *get_prop(jsdisp_t *This, DISPID id)
 {
+    if(id >= ELEM_DISPID_BASE)
+        return get_elem_prop(This, id - ELEM_DISPID_BASE);
+
     if(id < 0 || id >= This->prop_cnt || This->props[id].type == PROP_DELETED)
         return NULL;
 
     return This->props+id;
 }
 
+static inline BOOL has_elems(jsdisp_t *This)
+{
+    return This->builtin_info->on_put_elem && !This->elems_disabled;
+}
+
+static inline DISPID elem_to_id(unsigned idx)
+{
+    return ELEM_DISPID_BASE + idx;
+}
+
+static inline BOOL get_elem_idx(jsdisp_t *This, DISPID id, unsigned *idx)
+{
+    if(id < ELEM_DISPID_BASE || id - ELEM_DISPID_BASE >= This->elems_cnt)
+        return FALSE;
+
+    *idx = id - ELEM_DISPID_BASE;
+    return TRUE;
+}
+
+static BOOL parse_elem_idx(const WCHAR *name, unsigned *ret)
+{
+    const WCHAR *ptr;
+    unsigned idx = 0;
+
+    if(*name == '0') {
+        if(name[1])
+            return FALSE;
+        *ret = 0;
+        return TRUE;
+    }
+
+    for(ptr = name; isdigitW(*ptr); ptr++) {
+        idx = idx*10 + (*ptr-'0');
+        if(idx >= ELEMS_MAX)
+            return FALSE;
+    }
+    if(ptr == name || *ptr)
+        return FALSE;
+
+    *ret = idx;
+    return TRUE;
+}
+
 static DWORD get_flags(jsdisp_t *This, dispex_prop_t *prop)
 {
     if(prop->type == PROP_PROTREF) {
@@ -168,6 +229,9 @@ static inline dispex_prop_t* alloc_prop(jsdisp_t *This, const WCHAR *name, prop_
     prop->flags = flags;
     prop->hash = string_hash(name);
 
+    if(!This->elems_sparse && has_elems(This) && isdigitW(*name))
+        This->elems_sparse = TRUE;
+
     bucket = get_props_idx(This, prop->hash);
     prop->bucket_next = This->props[bucket].bucket_head;
     This->props[bucket].bucket_head = This->prop_cnt++;
@@ -311,6 +375,190 @@ static HRESULT ensure_prop_name(jsdisp_t *This, const WCHAR *name, BOOL search_p
     return hres;
 }
 
+static dispex_prop_t *find_elem_prop(jsdisp_t *This, unsigned idx)
+{
+    dispex_prop_t *prop;
+    WCHAR name[12];
+    HRESULT hres;
+
+    sprintfW(name, idx_formatW, idx);
+
+    hres = find_prop_name(This, string_hash(name), name, &prop);
+    if(FAILED(hres) || !prop || prop->type == PROP_DELETED)
+        return NULL;
+    return prop;
+}
+
+/* Elements moved out of dense storage keep their DISPIDs valid. */
+static dispex_prop_t *get_elem_prop(jsdisp_t *This, unsigned idx)
+{
+    return This->elems_sparse ? find_elem_prop(This, idx) : NULL;
+}
+
+static BOOL use_elem_storage(jsdisp_t *This, unsigned idx)
+{
+    if(idx < This->elems_cnt)
+        return TRUE;
+
+    if(idx != This->elems_cnt || idx >= ELEMS_MAX || !has_elems(This))
+        return FALSE;
+
+    return !This->elems_sparse || !find_elem_prop(This, idx);
+}
+
+static HRESULT grow_elems(jsdisp_t *This)
+{
+    jsval_t *elems;
+    DWORD size;
+
+    if(This->elems_cnt < This->elems_size)
+        return S_OK;
+
+    if(This->elems) {
+        size = min(This->elems_size*2, ELEMS_MAX);
+        elems = heap_realloc(This->elems, size*sizeof(*elems));
+    }else {
+        size = 8;
+        elems = heap_alloc(size*sizeof(*elems));
+    }
+    if(!elems)
+        return E_OUTOFMEMORY;
+
+    This->elems = elems;
+    This->elems_size = size;
+    return S_OK;
+}
+
+static HRESULT elem_get(jsdisp_t *This, unsigned idx, jsval_t *r)
+{
+    TRACE("%p[%u] ret %s\n", This, idx, debugstr_jsval(This->elems[idx]));
+    return jsval_copy(This->elems[idx], r);
+}
+
+/* idx must be either in dense storage or directly following it. */
+static HRESULT elem_put(jsdisp_t *This, unsigned idx, jsval_t val)
+{
+    jsval_t copy;
+    HRESULT hres;
+
+    TRACE("%p[%u] = %s\n", This, idx, debugstr_jsval(val));
+
+    if(idx == This->elems_cnt) {
+        hres = grow_elems(This);
+        if(FAILED(hres))
+            return hres;
+    }
+
+    hres = jsval_copy(val, &copy);
+    if(FAILED(hres))
+        return hres;
+
+    if(idx < This->elems_cnt)
+        jsval_release(This->elems[idx]);
+    else
+        This->elems_cnt++;
+    This->elems[idx] = copy;
+
+    This->builtin_info->on_put_elem(This, idx);
+    return S_OK;
+}
+
+/* Moves elements starting from idx to named properties. */
+static HRESULT spill_elems(jsdisp_t *This, unsigned idx)
+{
+    dispex_prop_t *prop;
+    WCHAR name[12];
+    unsigned i;
+    HRESULT hres;
+
+    if(idx >= This->elems_cnt)
+        return S_OK;
+
+    /* Allocate all properties first, so that we don't fail in the middle of moving values. */
+    for(i = idx; i < This->elems_cnt; i++) {
+        sprintfW(name, idx_formatW, i);
+
+        hres = find_prop_name(This, string_hash(name), name, &prop);
+        if(FAILED(hres))
+            return hres;
+        if(!prop && !alloc_prop(This, name, PROP_DELETED, 0))
+            return E_OUTOFMEMORY;
+    }
+
+    for(i = idx; i < This->elems_cnt; i++) {
+        sprintfW(name, idx_formatW, i);
+        find_prop_name(This, string_hash(name), name, &prop);
+        if(prop->type == PROP_JSVAL)
+            jsval_release(prop->u.val);
+
+        prop->type = PROP_JSVAL;
+        prop->flags = PROPF_ENUM;
+        prop->u.val = This->elems[i];
+    }
+
+    This->elems_cnt = idx;
+    This->elems_sparse = TRUE;
+    return S_OK;
+}
+
+static HRESULT elem_delete(jsdisp_t *This, unsigned idx)
+{
+    HRESULT hres;
+
+    TRACE("%p[%u]\n", This, idx);
+
+    /* Only the last element may be removed without leaving a hole. */
+    if(idx+1 < This->elems_cnt) {
+        hres = spill_elems(This, idx+1);
+        if(FAILED(hres))
+            return hres;
+    }
+
+    jsval_release(This->elems[idx]);
+    This->elems_cnt = idx;
+    return S_OK;
+}
+
+static HRESULT invoke_elem(jsdisp_t *This, IDispatch *jsthis, unsigned idx, WORD flags,
+        unsigned argc, jsval_t *argv, jsval_t *r)
+{
+    IDispatch *disp;
+    HRESULT hres;
+
+    if(!is_object_instance(This->elems[idx]) || !get_object(This->elems[idx])) {
+        FIXME("invoke %s\n", debugstr_jsval(This->elems[idx]));
+        return E_FAIL;
+    }
+
+    disp = get_object(This->elems[idx]);
+    TRACE("call %p[%u] %p\n", This, idx, disp);
+
+    IDispatch_AddRef(disp);
+    hres = disp_call_value(This->ctx, disp, jsthis, flags, argc, argv, r);
+    IDispatch_Release(disp);
+    return hres;
+}
+
+/* Returns S_FALSE if the element is not (and may not be) stored in dense storage. */
+static HRESULT find_elem(jsdisp_t *This, unsigned idx, DWORD flags, DISPID *id)
+{
+    HRESULT hres;
+
+    if(idx >= This->elems_cnt) {
+        if(!(flags & fdexNameEnsure) || !use_elem_storage(This, idx))
+            return S_FALSE;
+
+        /* Like ensure_prop_name, don't notify the object until the value is set. */
+        hres = grow_elems(This);
+        if(FAILED(hres))
+            return hres;
+        This->elems[This->elems_cnt++] = jsval_undefined();
+    }
+
+    *id = elem_to_id(idx);
+    return S_OK;
+}
+
 static IDispatch *get_this(DISPPARAMS *dp)
 {
     DWORD i;
@@ -516,6 +764,7 @@ HRESULT builtin_set_const(script_ctx_t *ctx, jsdisp_t *jsthis, jsval_t value)
 static HRESULT fill_protrefs(jsdisp_t *This)
 {
     dispex_prop_t *iter, *prop;
+    unsigned idx;
     HRESULT hres;
 
     if(!This->prototype)
@@ -526,6 +775,8 @@ static HRESULT fill_protrefs(jsdisp_t *This)
     for(iter = This->prototype->props; iter < This->prototype->props+This->prototype->prop_cnt; iter++) {
         if(!iter->name)
             continue;
+        if(This->elems_cnt && parse_elem_idx(iter->name, &idx) && idx < This->elems_cnt)
+            continue;
         hres = find_prop_name(This, iter->hash, iter->name, &prop);
         if(FAILED(hres))
             return hres;
@@ -663,7 +914,8 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
         VARIANT *pvarRes, EXCEPINFO *pei, IServiceProvider *pspCaller)
 {
     jsdisp_t *This = impl_from_IDispatchEx(iface);
-    dispex_prop_t *prop;
+    dispex_prop_t *prop = NULL;
+    unsigned idx;
     HRESULT hres;
 
     TRACE("(%p)->(%x %x %x %p %p %p %p)\n", This, id, lcid, wFlags, pdp, pvarRes, pei, pspCaller);
@@ -671,10 +923,12 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
     if(pvarRes)
         V_VT(pvarRes) = VT_EMPTY;
 
-    prop = get_prop(This, id);
-    if(!prop || prop->type == PROP_DELETED) {
-        TRACE("invalid id\n");
-        return DISP_E_MEMBERNOTFOUND;
+    if(!get_elem_idx(This, id, &idx)) {
+        prop = get_prop(This, id);
+        if(!prop || prop->type == PROP_DELETED) {
+            TRACE("invalid id\n");
+            return DISP_E_MEMBERNOTFOUND;
+        }
     }
 
     clear_ei(This->ctx);
@@ -692,7 +946,10 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
         if(FAILED(hres))
             return hres;
 
-        hres = invoke_prop_func(This, get_this(pdp), prop, wFlags, argc, argv, pvarRes ? &r : NULL, pspCaller);
+        if(prop)
+            hres = invoke_prop_func(This, get_this(pdp), prop, wFlags, argc, argv, pvarRes ? &r : NULL, pspCaller);
+        else
+            hres = invoke_elem(This, get_this(pdp), idx, wFlags, argc, argv, pvarRes ? &r : NULL);
         if(argv != buf)
             heap_free(argv);
         if(SUCCEEDED(hres) && pvarRes) {
@@ -704,7 +961,10 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
     case DISPATCH_PROPERTYGET: {
         jsval_t r;
 
-        hres = prop_get(This, prop, pdp, &r, pspCaller);
+        if(prop)
+            hres = prop_get(This, prop, pdp, &r, pspCaller);
+        else
+            hres = elem_get(This, idx, &r);
         if(SUCCEEDED(hres)) {
             hres = jsval_to_variant(r, pvarRes);
             jsval_release(r);
@@ -729,7 +989,10 @@ static HRESULT WINAPI DispatchEx_InvokeEx(IDispatchEx *iface, DISPID id, LCID lc
         if(FAILED(hres))
             return hres;
 
-        hres = prop_put(This, prop, val, pspCaller);
+        if(prop)
+            hres = prop_put(This, prop, val, pspCaller);
+        else
+            hres = elem_put(This, idx, val);
         jsval_release(val);
         break;
     }
@@ -763,6 +1026,7 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByName(IDispatchEx *iface, BSTR bst
 {
     jsdisp_t *This = impl_from_IDispatchEx(iface);
     dispex_prop_t *prop;
+    unsigned idx;
     BOOL b;
     HRESULT hres;
 
@@ -771,6 +1035,9 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByName(IDispatchEx *iface, BSTR bst
     if(grfdex & ~(fdexNameCaseSensitive|fdexNameEnsure|fdexNameImplicit|FDEX_VERSION_MASK))
         FIXME("Unsupported grfdex %x\n", grfdex);
 
+    if(This->elems_cnt && parse_elem_idx(bstrName, &idx) && idx < This->elems_cnt)
+        return elem_delete(This, idx);
+
     hres = find_prop_name(This, string_hash(bstrName), bstrName, &prop);
     if(FAILED(hres))
         return hres;
@@ -786,10 +1053,14 @@ static HRESULT WINAPI DispatchEx_DeleteMemberByDispID(IDispatchEx *iface, DISPID
 {
     jsdisp_t *This = impl_from_IDispatchEx(iface);
     dispex_prop_t *prop;
+    unsigned idx;
     BOOL b;
 
     TRACE("(%p)->(%x)\n", This, id);
 
+    if(get_elem_idx(This, id, &idx))
+        return elem_delete(This, idx);
+
     prop = get_prop(This, id);
     if(!prop) {
         WARN("invalid id\n");
@@ -810,9 +1081,18 @@ static HRESULT WINAPI DispatchEx_GetMemberName(IDispatchEx *iface, DISPID id, BS
 {
     jsdisp_t *This = impl_from_IDispatchEx(iface);
     dispex_prop_t *prop;
+    unsigned idx;
 
     TRACE("(%p)->(%x %p)\n", This, id, pbstrName);
 
+    if(get_elem_idx(This, id, &idx)) {
+        WCHAR name[12];
+
+        sprintfW(name, idx_formatW, idx);
+        *pbstrName = SysAllocString(name);
+        return *pbstrName ? S_OK : E_OUTOFMEMORY;
+    }
+
     prop = get_prop(This, id);
     if(!prop || !prop->name || prop->type == PROP_DELETED)
         return DISP_E_MEMBERNOTFOUND;
@@ -838,6 +1118,18 @@ static HRESULT WINAPI DispatchEx_GetNextDispID(IDispatchEx *iface, DWORD grfdex,
             return hres;
     }
 
+    /* Elements in dense storage are enumerated first, followed by named properties. */
+    if(id == DISPID_STARTENUM || id >= ELEM_DISPID_BASE) {
+        unsigned idx = id == DISPID_STARTENUM ? 0 : id-ELEM_DISPID_BASE+1;
+
+        if(idx < This->elems_cnt) {
+            *pid = elem_to_id(idx);
+            return S_OK;
+        }
+
+        id = DISPID_STARTENUM;
+    }
+
     if(id+1>=0 && id+1<This->prop_cnt) {
         iter = &This->props[id+1];
     }else {
@@ -893,13 +1185,278 @@ jsdisp_t *to_jsdisp(IDispatch *disp)
     return disp->lpVtbl == (IDispatchVtbl*)&DispatchExVtbl ? impl_from_IDispatchEx((IDispatchEx*)disp) : NULL;
 }
 
+/*
+ * Cycle collector
+ *
+ * Reference counting can't free objects referencing each other, like a closure stored in its own
+ * variable object. gc_run finds such cycles by trial deletion: references held by the script's
+ * objects and scope chains are subtracted from the reference counts of their targets. Objects
+ * and scopes that still have references left are referenced from outside (the host, interpreter
+ * stack or C code), so they are kept alive together with everything reachable from them. All
+ * other objects are only referenced by each other; their references are dropped to break cycles.
+ */
+
+#define GC_MIN_ALLOCS 4096
+
+typedef enum {
+    GC_COUNT,
+    GC_MARK,
+    GC_UNLINK
+} gc_op_t;
+
+struct _gc_ctx_t {
+    script_ctx_t *script;
+    gc_op_t op;
+    LONG gen;
+    BOOL failed;
+
+    void **objs;
+    unsigned objs_cnt;
+    unsigned objs_size;
+
+    void **scopes;
+    unsigned scopes_cnt;
+    unsigned scopes_size;
+
+    void **scope_stack;
+    unsigned scope_stack_cnt;
+    unsigned scope_stack_size;
+};
+
+static BOOL gc_push(gc_ctx_t *gc, void ***stack, unsigned *cnt, unsigned *size, void *ptr)
+{
+    if(*cnt == *size) {
+        void **new_stack;
+
+        if(*stack)
+            new_stack = heap_realloc(*stack, *size*2*sizeof(**stack));
+        else
+            new_stack = heap_alloc(64*sizeof(**stack));
+        if(!new_stack) {
+            gc->failed = TRUE;
+            return FALSE;
+        }
+
+        *stack = new_stack;
+        *size = *size ? *size*2 : 64;
+    }
+
+    (*stack)[(*cnt)++] = ptr;
+    return TRUE;
+}
+
+void gc_traverse_jsdisp(gc_ctx_t *gc, jsdisp_t **jsdisp)
+{
+    jsdisp_t *obj = *jsdisp;
+
+    if(!obj)
+        return;
+
+    switch(gc->op) {
+    case GC_COUNT:
+        if(obj->ctx == gc->script)
+            obj->gc_ref--;
+        break;
+    case GC_MARK:
+        if(obj->ctx == gc->script && !obj->gc_marked) {
+            obj->gc_marked = TRUE;
+            gc_push(gc, &gc->objs, &gc->objs_cnt, &gc->objs_size, obj);
+        }
+        break;
+    case GC_UNLINK:
+        *jsdisp = NULL;
+        jsdisp_release(obj);
+        break;
+    }
+}
+
+void gc_traverse_jsval(gc_ctx_t *gc, jsval_t *val)
+{
+    jsdisp_t *obj;
+
+    if(gc->op == GC_UNLINK) {
+        jsval_t tmp = *val;
+
+        *val = jsval_undefined();
+        jsval_release(tmp);
+        return;
+    }
+
+    if(is_object_instance(*val) && get_object(*val) && (obj = to_jsdisp(get_object(*val))))
+        gc_traverse_jsdisp(gc, &obj);
+}
+
+void gc_traverse_scope(gc_ctx_t *gc, scope_chain_t **scope_ptr)
+{
+    scope_chain_t *scope = *scope_ptr;
+
+    if(!scope)
+        return;
+
+    switch(gc->op) {
+    case GC_COUNT:
+        if(scope->gc_gen != gc->gen) {
+            if(!gc_push(gc, &gc->scopes, &gc->scopes_cnt, &gc->scopes_size, scope))
+                return;
+            scope->gc_gen = gc->gen;
+            scope->gc_ref = scope->ref;
+            scope->gc_marked = FALSE;
+        }
+        scope->gc_ref--;
+        break;
+    case GC_MARK:
+        if(!scope->gc_marked) {
+            scope->gc_marked = TRUE;
+            gc_push(gc, &gc->scope_stack, &gc->scope_stack_cnt, &gc->scope_stack_size, scope);
+        }
+        break;
+    case GC_UNLINK:
+        *scope_ptr = NULL;
+        scope_release(scope);
+        break;
+    }
+}
+
+static void gc_traverse_scope_refs(gc_ctx_t *gc, scope_chain_t *scope)
+{
+    jsdisp_t *jsobj = scope->jsobj;
+
+    /* scope->obj holds the reference to jsobj */
+    gc_traverse_jsdisp(gc, &jsobj);
+    gc_traverse_scope(gc, &scope->next);
+}
+
+static void gc_traverse_obj(gc_ctx_t *gc, jsdisp_t *obj)
+{
+    dispex_prop_t *prop;
+    unsigned i;
+
+    for(prop = obj->props; prop < obj->props+obj->prop_cnt; prop++) {
+        if(prop->type == PROP_JSVAL)
+            gc_traverse_jsval(gc, &prop->u.val);
+    }
+
+    for(i = 0; i < obj->elems_cnt; i++)
+        gc_traverse_jsval(gc, obj->elems+i);
+
+    gc_traverse_jsdisp(gc, &obj->prototype);
+
+    if(obj->builtin_info->gc_traverse)
+        obj->builtin_info->gc_traverse(gc, obj);
+}
+
+static void gc_mark(gc_ctx_t *gc)
+{
+    while(!gc->failed && (gc->objs_cnt || gc->scope_stack_cnt)) {
+        if(gc->objs_cnt)
+            gc_traverse_obj(gc, gc->objs[--gc->objs_cnt]);
+        else
+            gc_traverse_scope_refs(gc, gc->scope_stack[--gc->scope_stack_cnt]);
+    }
+}
+
+void gc_run(script_ctx_t *ctx)
+{
+    static LONG gc_gen;
+
+    gc_ctx_t gc = {ctx};
+    scope_chain_t *scope;
+    jsdisp_t *obj;
+    unsigned i;
+
+    TRACE("(%p) %u objects\n", ctx, ctx->obj_cnt);
+
+    ctx->gc_alloc_cnt = 0;
+
+    gc.gen = InterlockedIncrement(&gc_gen);
+    if(!gc.gen)
+        gc.gen = InterlockedIncrement(&gc_gen);
+
+    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+        obj->gc_ref = obj->ref;
+        obj->gc_marked = FALSE;
+    }
+
+    /* Subtract references held by objects and scope chains from their targets. */
+    gc.op = GC_COUNT;
+    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry)
+        gc_traverse_obj(&gc, obj);
+    for(i = 0; i < gc.scopes_cnt; i++)
+        gc_traverse_scope_refs(&gc, gc.scopes[i]);
+
+    /* Mark everything reachable from objects and scopes referenced from elsewhere. */
+    gc.op = GC_MARK;
+    LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+        if(gc.failed)
+            break;
+        if(obj->gc_ref && !obj->gc_marked) {
+            obj->gc_marked = TRUE;
+            gc_push(&gc, &gc.objs, &gc.objs_cnt, &gc.objs_size, obj);
+            gc_mark(&gc);
+        }
+    }
+    for(i = 0; i < gc.scopes_cnt && !gc.failed; i++) {
+        scope = gc.scopes[i];
+        if(scope->gc_ref && !scope->gc_marked) {
+            scope->gc_marked = TRUE;
+            gc_push(&gc, &gc.scope_stack, &gc.scope_stack_cnt, &gc.scope_stack_size, scope);
+            gc_mark(&gc);
+        }
+    }
+
+    /* Unmarked objects are garbage. Keep them alive until all of them are unlinked. */
+    if(!gc.failed) {
+        gc.objs_cnt = 0;
+        LIST_FOR_EACH_ENTRY(obj, &ctx->objects, jsdisp_t, entry) {
+            if(!obj->gc_marked && !gc_push(&gc, &gc.objs, &gc.objs_cnt, &gc.objs_size, obj))
+                break;
+        }
+    }
+
+    if(gc.failed) {
+        WARN("out of memory\n");
+    }else if(gc.objs_cnt) {
+        TRACE("freeing %u objects\n", gc.objs_cnt);
+
+        for(i = 0; i < gc.objs_cnt; i++)
+            jsdisp_addref(gc.objs[i]);
+
+        gc.op = GC_UNLINK;
+        for(i = 0; i < gc.objs_cnt; i++)
+            gc_traverse_obj(&gc, gc.objs[i]);
+
+        for(i = 0; i < gc.objs_cnt; i++)
+            jsdisp_release(gc.objs[i]);
+    }
+
+    heap_free(gc.objs);
+    heap_free(gc.scopes);
+    heap_free(gc.scope_stack);
+}
+
 HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *builtin_info, jsdisp_t *prototype)
 {
     TRACE("%p (%p)\n", dispex, prototype);
 
+    if(++ctx->gc_alloc_cnt >= GC_MIN_ALLOCS && ctx->gc_alloc_cnt >= ctx->obj_cnt)
+        gc_run(ctx);
+
+    /* Prototype lookups work on named properties only. */
+    if(prototype && has_elems(prototype)) {
+        HRESULT hres;
+
+        hres = spill_elems(prototype, 0);
+        if(FAILED(hres))
+            return hres;
+        prototype->elems_disabled = TRUE;
+    }
+
     dispex->IDispatchEx_iface.lpVtbl = &DispatchExVtbl;
     dispex->ref = 1;
     dispex->builtin_info = builtin_info;
+    dispex->elems = NULL;
+    dispex->elems_cnt = dispex->elems_size = 0;
+    dispex->elems_sparse = dispex->elems_disabled = FALSE;
 
     dispex->props = heap_alloc_zero(sizeof(dispex_prop_t)*(dispex->buf_size=4));
     if(!dispex->props)
@@ -920,6 +1477,8 @@ HRESULT init_dispex(jsdisp_t *dispex, script_ctx_t *ctx, const builtin_info_t *b
     script_addref(ctx);
     dispex->ctx = ctx;
 
+    list_add_tail(&ctx->objects, &dispex->entry);
+    ctx->obj_cnt++;
     return S_OK;
 }
 
@@ -956,12 +1515,18 @@ void jsdisp_free(jsdisp_t *obj)
 
     TRACE("(%p)\n", obj);
 
+    list_remove(&obj->entry);
+    obj->ctx->obj_cnt--;
+
     for(prop = obj->props; prop < obj->props+obj->prop_cnt; prop++) {
         if(prop->type == PROP_JSVAL)
             jsval_release(prop->u.val);
         heap_free(prop->name);
     }
     heap_free(obj->props);
+    while(obj->elems_cnt)
+        jsval_release(obj->elems[--obj->elems_cnt]);
+    heap_free(obj->elems);
     script_release(obj->ctx);
     if(obj->prototype)
         jsdisp_release(obj->prototype);
@@ -1038,8 +1603,15 @@ jsdisp_t *iface_to_jsdisp(IUnknown *iface)
 HRESULT jsdisp_get_id(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *id)
 {
     dispex_prop_t *prop;
+    unsigned idx;
     HRESULT hres;
 
+    if(has_elems(jsdisp) && parse_elem_idx(name, &idx)) {
+        hres = find_elem(jsdisp, idx, flags, id);
+        if(hres != S_FALSE)
+            return hres;
+    }
+
     if(flags & fdexNameEnsure)
         hres = ensure_prop_name(jsdisp, name, TRUE, PROPF_ENUM, &prop);
     else
@@ -1082,6 +1654,10 @@ HRESULT jsdisp_call_value(jsdisp_t *jsfunc, IDispatch *jsthis, WORD flags, unsig
 HRESULT jsdisp_call(jsdisp_t *disp, DISPID id, WORD flags, unsigned argc, jsval_t *argv, jsval_t *r)
 {
     dispex_prop_t *prop;
+    unsigned idx;
+
+    if(get_elem_idx(disp, id, &idx))
+        return invoke_elem(disp, to_disp(disp), idx, flags, argc, argv, r);
 
     prop = get_prop(disp, id);
     if(!prop)
@@ -1294,8 +1870,12 @@ HRESULT disp_call_value(script_ctx_t *ctx, IDispatch *disp, IDispatch *jsthis, W
 HRESULT jsdisp_propput(jsdisp_t *obj, const WCHAR *name, DWORD flags, jsval_t val)
 {
     dispex_prop_t *prop;
+    unsigned idx;
     HRESULT hres;
 
+    if(flags == PROPF_ENUM && has_elems(obj) && parse_elem_idx(name, &idx) && use_elem_storage(obj, idx))
+        return elem_put(obj, idx, val);
+
     hres = ensure_prop_name(obj, name, FALSE, flags, &prop);
     if(FAILED(hres))
         return hres;
@@ -1329,9 +1909,10 @@ HRESULT jsdisp_propput_idx(jsdisp_t *obj, DWORD idx, jsval_t val)
 {
     WCHAR buf[12];
 
-    static const WCHAR formatW[] = {'%','d',0};
+    if(use_elem_storage(obj, idx))
+        return elem_put(obj, idx, val);
 
-    sprintfW(buf, formatW, idx);
+    sprintfW(buf, idx_formatW, idx);
     return jsdisp_propput_name(obj, buf, val);
 }
 
@@ -1343,12 +1924,17 @@ HRESULT disp_propput(script_ctx_t *ctx, IDispatch *disp, DISPID id, jsval_t val)
     jsdisp = iface_to_jsdisp((IUnknown*)disp);
     if(jsdisp) {
         dispex_prop_t *prop;
+        unsigned idx;
 
-        prop = get_prop(jsdisp, id);
-        if(prop)
-            hres = prop_put(jsdisp, prop, val, NULL);
-        else
-            hres = DISP_E_MEMBERNOTFOUND;
+        if(get_elem_idx(jsdisp, id, &idx)) {
+            hres = elem_put(jsdisp, idx, val);
+        }else {
+            prop = get_prop(jsdisp, id);
+            if(prop)
+                hres = prop_put(jsdisp, prop, val, NULL);
+            else
+                hres = DISP_E_MEMBERNOTFOUND;
+        }
 
         jsdisp_release(jsdisp);
     }else {
@@ -1388,8 +1974,12 @@ HRESULT jsdisp_propget_name(jsdisp_t *obj, const WCHAR *name, jsval_t *val)
 {
     DISPPARAMS dp = {NULL, NULL, 0, 0};
     dispex_prop_t *prop;
+    unsigned idx;
     HRESULT hres;
 
+    if(obj->elems_cnt && parse_elem_idx(name, &idx) && idx < obj->elems_cnt)
+        return elem_get(obj, idx, val);
+
     hres = find_prop_name_prot(obj, string_hash(name), name, &prop);
     if(FAILED(hres))
         return hres;
@@ -1409,9 +1999,10 @@ HRESULT jsdisp_get_idx(jsdisp_t *obj, DWORD idx, jsval_t *r)
     dispex_prop_t *prop;
     HRESULT hres;
 
-    static const WCHAR formatW[] = {'%','d',0};
+    if(idx < obj->elems_cnt)
+        return elem_get(obj, idx, r);
 
-    sprintfW(name, formatW, idx);
+    sprintfW(name, idx_formatW, idx);
 
     hres = find_prop_name_prot(obj, string_hash(name), name, &prop);
     if(FAILED(hres))
@@ -1425,10 +2016,63 @@ HRESULT jsdisp_get_idx(jsdisp_t *obj, DWORD idx, jsval_t *r)
     return prop_get(obj, prop, &dp, r, NULL);
 }
 
+/*
+ * Same as jsdisp_get_id, but first tries the DISPID stored in *cache by an earlier lookup. The hit
+ * is validated by comparing property names, so a single cache may be shared by all objects looked
+ * up from the same place in the code.
+ */
+HRESULT jsdisp_get_id_cached(jsdisp_t *jsdisp, const WCHAR *name, DWORD flags, DISPID *cache, DISPID *id)
+{
+    dispex_prop_t *prop;
+    HRESULT hres;
+
+    if((unsigned)*cache < jsdisp->prop_cnt) {
+        prop = jsdisp->props + *cache;
+        if(prop->type != PROP_DELETED && prop->name && !strcmpW(prop->name, name)) {
+            *id = *cache;
+            return S_OK;
+        }
+    }
+
+    hres = jsdisp_get_id(jsdisp, name, flags, id);
+    if(SUCCEEDED(hres))
+        *cache = *id;
+    return hres;
+}
+
+BOOL jsdisp_is_valid_id(jsdisp_t *jsdisp, DISPID id)
+{
+    unsigned idx;
+
+    if(get_elem_idx(jsdisp, id, &idx))
+        return TRUE;
+
+    return get_prop(jsdisp, id) != NULL;
+}
+
+HRESULT jsdisp_get_idx_id(jsdisp_t *obj, DWORD idx, DWORD flags, DISPID *id)
+{
+    WCHAR name[12];
+    HRESULT hres;
+
+    if(idx < ELEMS_MAX && has_elems(obj)) {
+        hres = find_elem(obj, idx, flags, id);
+        if(hres != S_FALSE)
+            return hres;
+    }
+
+    sprintfW(name, idx_formatW, idx);
+    return jsdisp_get_id(obj, name, flags, id);
+}
+
 HRESULT jsdisp_propget(jsdisp_t *jsdisp, DISPID id, jsval_t *val)
 {
     DISPPARAMS dp  = {NULL,NULL,0,0};
     dispex_prop_t *prop;
+    unsigned idx;
+
+    if(get_elem_idx(jsdisp, id, &idx))
+        return elem_get(jsdisp, idx, val);
 
     prop = get_prop(jsdisp, id);
     if(!prop)
@@ -1475,13 +2119,15 @@ HRESULT disp_propget(script_ctx_t *ctx, IDispatch *disp, DISPID id, jsval_t *val
 
 HRESULT jsdisp_delete_idx(jsdisp_t *obj, DWORD idx)
 {
-    static const WCHAR formatW[] = {'%','d',0};
     WCHAR buf[12];
     dispex_prop_t *prop;
     BOOL b;
     HRESULT hres;
 
-    sprintfW(buf, formatW, idx);
+    if(idx < obj->elems_cnt)
+        return elem_delete(obj, idx);
+
+    sprintfW(buf, idx_formatW, idx);
 
     hres = find_prop_name(obj, string_hash(buf), buf, &prop);
     if(FAILED(hres) || !prop)
@@ -1499,12 +2145,18 @@ HRESULT disp_delete(IDispatch *disp, DISPID id, BOOL *ret)
     jsdisp = iface_to_jsdisp((IUnknown*)disp);
     if(jsdisp) {
         dispex_prop_t *prop;
+        unsigned idx;
 
-        prop = get_prop(jsdisp, id);
-        if(prop)
-            hres = delete_prop(prop, ret);
-        else
-            hres = DISP_E_MEMBERNOTFOUND;
+        if(get_elem_idx(jsdisp, id, &idx)) {
+            *ret = TRUE;
+            hres = elem_delete(jsdisp, idx);
+        }else {
+            prop = get_prop(jsdisp, id);
+            if(prop)
+                hres = delete_prop(prop, ret);
+            else
+                hres = DISP_E_MEMBERNOTFOUND;
+        }
 
         jsdisp_release(jsdisp);
         return hres;
@@ -1536,6 +2188,7 @@ HRESULT disp_delete_name(script_ctx_t *ctx, IDispatch *disp, jsstr_t *name, BOOL
     if(jsdisp) {
         dispex_prop_t *prop;
         const WCHAR *ptr;
+        unsigned idx;
 
         ptr = jsstr_flatten(name);
         if(!ptr) {
@@ -1543,6 +2196,13 @@ HRESULT disp_delete_name(script_ctx_t *ctx, IDispatch *disp, jsstr_t *name, BOOL
             return E_OUTOFMEMORY;
         }
 
+        if(jsdisp->elems_cnt && parse_elem_idx(ptr, &idx) && idx < jsdisp->elems_cnt) {
+            *ret = TRUE;
+            hres = elem_delete(jsdisp, idx);
+            jsdisp_release(jsdisp);
+            return hres;
+        }
+
         hres = find_prop_name(jsdisp, string_hash(ptr), ptr, &prop);
         if(prop) {
             hres = delete_prop(prop, ret);
@@ -1587,8 +2247,14 @@ HRESULT disp_delete_name(script_ctx_t *ctx, IDispatch *disp, jsstr_t *name, BOOL
 HRESULT jsdisp_is_own_prop(jsdisp_t *obj, const WCHAR *name, BOOL *ret)
 {
     dispex_prop_t *prop;
+    unsigned idx;
     HRESULT hres;
 
+    if(obj->elems_cnt && parse_elem_idx(name, &idx) && idx < obj->elems_cnt) {
+        *ret = TRUE;
+        return S_OK;
+    }
+
     hres = find_prop_name(obj, string_hash(name), name, &prop);
     if(FAILED(hres))
         return hres;
@@ -1600,8 +2266,14 @@ HRESULT jsdisp_is_own_prop(jsdisp_t *obj, const WCHAR *name, BOOL *ret)
 HRESULT jsdisp_is_enumerable(jsdisp_t *obj, const WCHAR *name, BOOL *ret)
 {
     dispex_prop_t *prop;
+    unsigned idx;
     HRESULT hres;
 
+    if(obj->elems_cnt && parse_elem_idx(name, &idx) && idx < obj->elems_cnt) {
+        *ret = TRUE;
+        return S_OK;
+    }
+
     hres = find_prop_name(obj, string_hash(name), name, &prop);
     if(FAILED(hres))
         return hres;
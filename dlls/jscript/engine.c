@@ -251,6 +251,7 @@ HRESULT scope_push(scope_chain_t *scope, jsdisp_t *jsobj, IDispatch *obj, scope_
         return E_OUTOFMEMORY;
 
     new_scope->ref = 1;
+    new_scope->gc_gen = 0;
 
     IDispatch_AddRef(obj);
     new_scope->jsobj = jsobj;
@@ -357,6 +358,7 @@ void exec_release(exec_ctx_t *ctx)
     if(ctx->script)
         script_release(ctx->script);
     jsval_release(ctx->ret);
+    heap_free(ctx->local_ids);
     heap_free(ctx->stack);
     heap_free(ctx);
 }
@@ -581,6 +583,10 @@ static inline jsstr_t *get_op_str(exec_ctx_t *ctx, int i){
     return ctx->code->instrs[ctx->ip].u.arg[i].str;
 }
 
+static inline DISPID *get_op_cache(exec_ctx_t *ctx, int i){
+    return &ctx->code->instrs[ctx->ip].u.arg[i].lng;
+}
+
 static inline double get_op_double(exec_ctx_t *ctx){
     return ctx->code->instrs[ctx->ip].u.dbl;
 }
@@ -600,6 +606,23 @@ static HRESULT interp_var_set(exec_ctx_t *ctx)
     return hres;
 }
 
+static HRESULT interp_local_set(exec_ctx_t *ctx)
+{
+    const unsigned arg = get_op_uint(ctx, 0);
+    jsval_t val;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(ctx->func_code->locals[arg]));
+
+    val = stack_pop(ctx);
+    if(jsdisp_is_valid_id(ctx->var_disp, ctx->local_ids[arg]))
+        hres = disp_propput(ctx->script, to_disp(ctx->var_disp), ctx->local_ids[arg], val);
+    else
+        hres = jsdisp_propput_name(ctx->var_disp, ctx->func_code->locals[arg], val);
+    jsval_release(val);
+    return hres;
+}
+
 /* ECMA-262 3rd Edition    12.6.4 */
 static HRESULT interp_forin(exec_ctx_t *ctx)
 {
@@ -836,6 +859,22 @@ static HRESULT interp_func(exec_ctx_t *ctx)
     return stack_push(ctx, jsval_obj(dispex));
 }
 
+/* Returns TRUE if v is a small non-negative integer, whose string form is its decimal representation. */
+static inline BOOL get_index_number(jsval_t v, DWORD *ret)
+{
+    double n;
+
+    if(!is_number(v))
+        return FALSE;
+
+    n = get_number(v);
+    if(!(n >= 0 && n <= 0x7fffffff) || n != (DWORD)n)
+        return FALSE;
+
+    *ret = n;
+    return TRUE;
+}
+
 /* ECMA-262 3rd Edition    11.2.1 */
 static HRESULT interp_array(exec_ctx_t *ctx)
 {
@@ -843,7 +882,9 @@ static HRESULT interp_array(exec_ctx_t *ctx)
     const WCHAR *name;
     jsval_t v, namev;
     IDispatch *obj;
+    jsdisp_t *jsdisp;
     DISPID id;
+    DWORD idx;
     HRESULT hres;
 
     TRACE("\n");
@@ -856,6 +897,17 @@ static HRESULT interp_array(exec_ctx_t *ctx)
         return hres;
     }
 
+    /* Integer index on script object, no need to convert it to string. */
+    if(get_index_number(namev, &idx) && (jsdisp = to_jsdisp(obj))) {
+        hres = jsdisp_get_idx(jsdisp, idx, &v);
+        IDispatch_Release(obj);
+        if(hres == DISP_E_UNKNOWNNAME)
+            v = jsval_undefined();
+        else if(FAILED(hres))
+            return hres;
+        return stack_push(ctx, v);
+    }
+
     hres = to_flat_string(ctx->script, namev, &name_str, &name);
     jsval_release(namev);
     if(FAILED(hres)) {
@@ -883,6 +935,7 @@ static HRESULT interp_member(exec_ctx_t *ctx)
 {
     const BSTR arg = get_op_bstr(ctx, 0);
     IDispatch *obj;
+    jsdisp_t *jsdisp;
     jsval_t v;
     DISPID id;
     HRESULT hres;
@@ -893,7 +946,10 @@ static HRESULT interp_member(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    hres = disp_get_id(ctx->script, obj, arg, arg, 0, &id);
+    if((jsdisp = to_jsdisp(obj)))
+        hres = jsdisp_get_id_cached(jsdisp, arg, 0, get_op_cache(ctx, 1), &id);
+    else
+        hres = disp_get_id(ctx->script, obj, arg, arg, 0, &id);
     if(SUCCEEDED(hres)) {
         hres = disp_propget(ctx->script, obj, id, &v);
     }else if(hres == DISP_E_UNKNOWNNAME) {
@@ -915,7 +971,9 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
     const WCHAR *name;
     jsstr_t *name_str;
     IDispatch *obj;
+    jsdisp_t *jsdisp;
     DISPID id;
+    DWORD idx;
     HRESULT hres;
 
     TRACE("%x\n", arg);
@@ -925,17 +983,24 @@ static HRESULT interp_memberid(exec_ctx_t *ctx)
 
     hres = to_object(ctx->script, objv, &obj);
     jsval_release(objv);
-    if(SUCCEEDED(hres)) {
-        hres = to_flat_string(ctx->script, namev, &name_str, &name);
+    if(SUCCEEDED(hres) && get_index_number(namev, &idx) && (jsdisp = to_jsdisp(obj))) {
+        hres = jsdisp_get_idx_id(jsdisp, idx, arg, &id);
+    }else {
+        if(SUCCEEDED(hres)) {
+            hres = to_flat_string(ctx->script, namev, &name_str, &name);
+            if(FAILED(hres))
+                IDispatch_Release(obj);
+        }
+        jsval_release(namev);
         if(FAILED(hres))
-            IDispatch_Release(obj);
-    }
-    jsval_release(namev);
-    if(FAILED(hres))
-        return hres;
+            return hres;
 
-    hres = disp_get_id(ctx->script, obj, name, NULL, arg, &id);
-    jsstr_release(name_str);
+        if((jsdisp = to_jsdisp(obj)))
+            hres = jsdisp_get_id_cached(jsdisp, name, arg, get_op_cache(ctx, 1), &id);
+        else
+            hres = disp_get_id(ctx->script, obj, name, NULL, arg, &id);
+        jsstr_release(name_str);
+    }
     if(FAILED(hres)) {
         IDispatch_Release(obj);
         if(hres == DISP_E_UNKNOWNNAME && !(arg & fdexNameEnsure)) {
@@ -1056,22 +1121,18 @@ static HRESULT interp_this(exec_ctx_t *ctx)
     return stack_push(ctx, jsval_disp(ctx->this_obj));
 }
 
-/* ECMA-262 3rd Edition    10.1.4 */
-static HRESULT interp_ident(exec_ctx_t *ctx)
+static HRESULT push_ident_value(exec_ctx_t *ctx, BSTR identifier)
 {
-    const BSTR arg = get_op_bstr(ctx, 0);
     exprval_t exprval;
     jsval_t v;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(arg));
-
-    hres = identifier_eval(ctx->script, arg, &exprval);
+    hres = identifier_eval(ctx->script, identifier, &exprval);
     if(FAILED(hres))
         return hres;
 
     if(exprval.type == EXPRVAL_INVALID)
-        return throw_type_error(ctx->script, JS_E_UNDEFINED_VARIABLE, arg);
+        return throw_type_error(ctx->script, JS_E_UNDEFINED_VARIABLE, identifier);
 
     hres = exprval_to_value(ctx->script, &exprval, &v);
     exprval_release(&exprval);
@@ -1081,24 +1142,19 @@ static HRESULT interp_ident(exec_ctx_t *ctx)
     return stack_push(ctx, v);
 }
 
-/* ECMA-262 3rd Edition    10.1.4 */
-static HRESULT interp_identid(exec_ctx_t *ctx)
+static HRESULT push_ident_ref(exec_ctx_t *ctx, BSTR identifier, unsigned flags)
 {
-    const BSTR arg = get_op_bstr(ctx, 0);
-    const unsigned flags = get_op_uint(ctx, 1);
     exprval_t exprval;
     HRESULT hres;
 
-    TRACE("%s %x\n", debugstr_w(arg), flags);
-
-    hres = identifier_eval(ctx->script, arg, &exprval);
+    hres = identifier_eval(ctx->script, identifier, &exprval);
     if(FAILED(hres))
         return hres;
 
     if(exprval.type == EXPRVAL_INVALID && (flags & fdexNameEnsure)) {
         DISPID id;
 
-        hres = jsdisp_get_id(ctx->script->global, arg, fdexNameEnsure, &id);
+        hres = jsdisp_get_id(ctx->script->global, identifier, fdexNameEnsure, &id);
         if(FAILED(hres))
             return hres;
 
@@ -1114,6 +1170,62 @@ static HRESULT interp_identid(exec_ctx_t *ctx)
     return stack_push_objid(ctx, exprval.u.idref.disp, exprval.u.idref.id);
 }
 
+/* ECMA-262 3rd Edition    10.1.4 */
+static HRESULT interp_ident(exec_ctx_t *ctx)
+{
+    const BSTR arg = get_op_bstr(ctx, 0);
+
+    TRACE("%s\n", debugstr_w(arg));
+
+    return push_ident_value(ctx, arg);
+}
+
+/* ECMA-262 3rd Edition    10.1.4 */
+static HRESULT interp_identid(exec_ctx_t *ctx)
+{
+    const BSTR arg = get_op_bstr(ctx, 0);
+    const unsigned flags = get_op_uint(ctx, 1);
+
+    TRACE("%s %x\n", debugstr_w(arg), flags);
+
+    return push_ident_ref(ctx, arg, flags);
+}
+
+/*
+ * Local slot instructions are emitted by the compiler for references to the function's own
+ * variables. If the variable was deleted in the meantime, they fall back to name lookup.
+ */
+static HRESULT interp_local(exec_ctx_t *ctx)
+{
+    const unsigned arg = get_op_uint(ctx, 0);
+    jsval_t v;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(ctx->func_code->locals[arg]));
+
+    hres = jsdisp_propget(ctx->var_disp, ctx->local_ids[arg], &v);
+    if(hres == DISP_E_MEMBERNOTFOUND)
+        return push_ident_value(ctx, ctx->func_code->locals[arg]);
+    if(FAILED(hres))
+        return hres;
+
+    return stack_push(ctx, v);
+}
+
+static HRESULT interp_local_ref(exec_ctx_t *ctx)
+{
+    const unsigned arg = get_op_uint(ctx, 0);
+    const unsigned flags = get_op_uint(ctx, 1);
+
+    TRACE("%s %x\n", debugstr_w(ctx->func_code->locals[arg]), flags);
+
+    if(!jsdisp_is_valid_id(ctx->var_disp, ctx->local_ids[arg]))
+        return push_ident_ref(ctx, ctx->func_code->locals[arg], flags);
+
+    jsdisp_addref(ctx->var_disp);
+    return stack_push_objid(ctx, to_disp(ctx->var_disp), ctx->local_ids[arg]);
+}
+
 /* ECMA-262 3rd Edition    7.8.1 */
 static HRESULT interp_null(exec_ctx_t *ctx)
 {
@@ -1184,7 +1296,6 @@ static HRESULT interp_carray(exec_ctx_t *ctx)
 {
     const unsigned arg = get_op_uint(ctx, 0);
     jsdisp_t *array;
-    jsval_t val;
     unsigned i;
     HRESULT hres;
 
@@ -1194,17 +1305,16 @@ static HRESULT interp_carray(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    i = arg;
-    while(i--) {
-        val = stack_pop(ctx);
-        hres = jsdisp_propput_idx(array, i, val);
-        jsval_release(val);
+    /* Fill elements in order, so that they are kept in dense storage. */
+    for(i=0; i < arg; i++) {
+        hres = jsdisp_propput_idx(array, i, stack_topn(ctx, arg-i-1));
         if(FAILED(hres)) {
             jsdisp_release(array);
             return hres;
         }
     }
 
+    stack_popn(ctx, arg);
     return stack_push(ctx, jsval_obj(array));
 }
 
@@ -2537,6 +2647,18 @@ HRESULT exec_source(exec_ctx_t *ctx, bytecode_t *code, function_code_t *func, BO
         }
     }
 
+    if(func->local_cnt && !ctx->local_ids) {
+        ctx->local_ids = heap_alloc(func->local_cnt * sizeof(*ctx->local_ids));
+        if(!ctx->local_ids)
+            return E_OUTOFMEMORY;
+
+        for(i=0; i < func->local_cnt; i++) {
+            hres = jsdisp_get_id(ctx->var_disp, func->locals[i], 0, ctx->local_ids+i);
+            if(FAILED(hres))
+                ctx->local_ids[i] = DISPID_UNKNOWN;
+        }
+    }
+
     prev_ctx = ctx->script->exec_ctx;
     ctx->script->exec_ctx = ctx;
 
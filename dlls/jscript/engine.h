@@ -48,6 +48,9 @@
     X(int,        1, ARG_INT,    0)        \
     X(jmp,        0, ARG_ADDR,   0)        \
     X(jmp_z,      0, ARG_ADDR,   0)        \
+    X(local,      1, ARG_UINT,   0)        \
+    X(local_ref,  1, ARG_UINT,   ARG_UINT) \
+    X(local_set,  1, ARG_UINT,   0)        \
     X(lshift,     1, 0,0)                  \
     X(lt,         1, 0,0)                  \
     X(lteq,       1, 0,0)                  \
@@ -140,6 +143,9 @@ typedef struct _function_code_t {
 
     unsigned param_cnt;
     BSTR *params;
+
+    unsigned local_cnt;
+    BSTR *locals;
 } function_code_t;
 
 typedef struct _bytecode_t {
@@ -176,10 +182,15 @@ typedef struct _scope_chain_t {
     jsdisp_t *jsobj;
     IDispatch *obj;
     struct _scope_chain_t *next;
+
+    LONG gc_ref;
+    LONG gc_gen;
+    BOOL gc_marked;
 } scope_chain_t;
 
 HRESULT scope_push(scope_chain_t*,jsdisp_t*,IDispatch*,scope_chain_t**) DECLSPEC_HIDDEN;
 void scope_release(scope_chain_t*) DECLSPEC_HIDDEN;
+void gc_traverse_scope(gc_ctx_t*,scope_chain_t**) DECLSPEC_HIDDEN;
 
 static inline void scope_addref(scope_chain_t *scope)
 {
@@ -199,6 +210,7 @@ struct _exec_ctx_t {
     jsdisp_t *var_disp;
     IDispatch *this_obj;
     function_code_t *func_code;
+    DISPID *local_ids;
     BOOL is_global;
 
     jsval_t *stack;
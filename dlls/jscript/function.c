@@ -92,11 +92,23 @@ static void Arguments_destructor(jsdisp_t *jsdisp)
 {
     ArgumentsInstance *arguments = (ArgumentsInstance*)jsdisp;
 
-    jsdisp_release(&arguments->function->dispex);
-    jsdisp_release(arguments->var_obj);
+    if(arguments->function)
+        jsdisp_release(&arguments->function->dispex);
+    if(arguments->var_obj)
+        jsdisp_release(arguments->var_obj);
     heap_free(arguments);
 }
 
+static void Arguments_gc_traverse(gc_ctx_t *gc, jsdisp_t *jsdisp)
+{
+    ArgumentsInstance *arguments = (ArgumentsInstance*)jsdisp;
+    jsdisp_t *function = arguments->function ? &arguments->function->dispex : NULL;
+
+    gc_traverse_jsdisp(gc, &function);
+    arguments->function = function ? function_from_jsdisp(function) : NULL;
+    gc_traverse_jsdisp(gc, &arguments->var_obj);
+}
+
 static unsigned Arguments_idx_length(jsdisp_t *jsdisp)
 {
     ArgumentsInstance *arguments = (ArgumentsInstance*)jsdisp;
@@ -131,7 +143,9 @@ static const builtin_info_t Arguments_info = {
     NULL,
     Arguments_idx_length,
     Arguments_idx_get,
-    Arguments_idx_put
+    Arguments_idx_put,
+    NULL,
+    Arguments_gc_traverse
 };
 
 static HRESULT create_arguments(script_ctx_t *ctx, FunctionInstance *calee, jsdisp_t *var_obj,
@@ -577,6 +591,13 @@ static void Function_destructor(jsdisp_t *dispex)
     heap_free(This);
 }
 
+static void Function_gc_traverse(gc_ctx_t *gc, jsdisp_t *dispex)
+{
+    FunctionInstance *function = function_from_jsdisp(dispex);
+
+    gc_traverse_scope(gc, &function->scope_chain);
+}
+
 static const builtin_prop_t Function_props[] = {
     {applyW,                 Function_apply,                 PROPF_METHOD|2},
     {argumentsW,             NULL, 0,                        Function_get_arguments, builtin_set_const},
@@ -591,7 +612,12 @@ static const builtin_info_t Function_info = {
     sizeof(Function_props)/sizeof(*Function_props),
     Function_props,
     Function_destructor,
-    NULL
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    Function_gc_traverse
 };
 
 static const builtin_prop_t FunctionInst_props[] = {
@@ -605,7 +631,12 @@ static const builtin_info_t FunctionInst_info = {
     sizeof(FunctionInst_props)/sizeof(*FunctionInst_props),
     FunctionInst_props,
     Function_destructor,
-    NULL
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    Function_gc_traverse
 };
 
 static HRESULT create_function(script_ctx_t *ctx, const builtin_info_t *builtin_info, DWORD flags,
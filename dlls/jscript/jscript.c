@@ -72,6 +72,7 @@ void script_release(script_ctx_t *ctx)
     if(ctx->cc)
         release_cc(ctx->cc);
     heap_pool_free(&ctx->tmp_heap);
+    release_regexp_cache(ctx);
     if(ctx->last_match)
         jsstr_release(ctx->last_match);
 
@@ -217,6 +218,9 @@ static void decrease_state(JScript *This, SCRIPTSTATE state)
                 jsdisp_release(This->ctx->global);
                 This->ctx->global = NULL;
             }
+
+            /* Collect cycles that are no longer reachable from the global object. */
+            gc_run(This->ctx);
             /* FALLTHROUGH */
         case SCRIPTSTATE_UNINITIALIZED:
             change_state(This, state);
@@ -718,6 +722,8 @@ static HRESULT WINAPI JScriptParse_InitNew(IActiveScriptParse *iface)
     ctx->version = This->version;
     ctx->ei.val = jsval_undefined();
     heap_pool_init(&ctx->tmp_heap);
+    list_init(&ctx->objects);
+    list_init(&ctx->regexp_cache);
 
     hres = create_jscaller(ctx);
     if(FAILED(hres)) {
@@ -38,6 +38,7 @@ typedef struct _jsstr_t jsstr_t;
 typedef struct _script_ctx_t script_ctx_t;
 typedef struct _exec_ctx_t exec_ctx_t;
 typedef struct _dispex_prop_t dispex_prop_t;
+typedef struct _gc_ctx_t gc_ctx_t;
 
 typedef struct {
     void **blocks;
@@ -210,6 +211,8 @@ typedef struct {
     unsigned (*idx_length)(jsdisp_t*);
     HRESULT (*idx_get)(jsdisp_t*,unsigned,jsval_t*);
     HRESULT (*idx_put)(jsdisp_t*,unsigned,jsval_t);
+    void (*on_put_elem)(jsdisp_t*,unsigned);
+    void (*gc_traverse)(gc_ctx_t*,jsdisp_t*);
 } builtin_info_t;
 
 struct jsdisp_t {
@@ -225,6 +228,18 @@ struct jsdisp_t {
     jsdisp_t *prototype;
 
     const builtin_info_t *builtin_info;
+
+    /* dense storage of index properties, used if builtin_info->on_put_elem is set */
+    jsval_t *elems;
+    DWORD elems_cnt;
+    DWORD elems_size;
+    BOOL elems_sparse;
+    BOOL elems_disabled;
+
+    /* cycle collector state, see gc_run */
+    struct list entry;
+    LONG gc_ref;
+    BOOL gc_marked;
 };
 
 static inline IDispatch *to_disp(jsdisp_t *jsdisp)
@@ -267,6 +282,10 @@ HRESULT create_dispex(script_ctx_t*,const builtin_info_t*,jsdisp_t*,jsdisp_t**)
 HRESULT init_dispex(jsdisp_t*,script_ctx_t*,const builtin_info_t*,jsdisp_t*) DECLSPEC_HIDDEN;
 HRESULT init_dispex_from_constr(jsdisp_t*,script_ctx_t*,const builtin_info_t*,jsdisp_t*) DECLSPEC_HIDDEN;
 
+void gc_run(script_ctx_t*) DECLSPEC_HIDDEN;
+void gc_traverse_jsdisp(gc_ctx_t*,jsdisp_t**) DECLSPEC_HIDDEN;
+void gc_traverse_jsval(gc_ctx_t*,jsval_t*) DECLSPEC_HIDDEN;
+
 HRESULT disp_call(script_ctx_t*,IDispatch*,DISPID,WORD,unsigned,jsval_t*,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT disp_call_value(script_ctx_t*,IDispatch*,IDispatch*,WORD,unsigned,jsval_t*,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_call_value(jsdisp_t*,IDispatch*,WORD,unsigned,jsval_t*,jsval_t*) DECLSPEC_HIDDEN;
@@ -282,7 +301,10 @@ HRESULT jsdisp_propput_dontenum(jsdisp_t*,const WCHAR*,jsval_t) DECLSPEC_HIDDEN;
 HRESULT jsdisp_propput_idx(jsdisp_t*,DWORD,jsval_t) DECLSPEC_HIDDEN;
 HRESULT jsdisp_propget_name(jsdisp_t*,LPCWSTR,jsval_t*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_idx(jsdisp_t*,DWORD,jsval_t*) DECLSPEC_HIDDEN;
+HRESULT jsdisp_get_idx_id(jsdisp_t*,DWORD,DWORD,DISPID*) DECLSPEC_HIDDEN;
 HRESULT jsdisp_get_id(jsdisp_t*,const WCHAR*,DWORD,DISPID*) DECLSPEC_HIDDEN;
+HRESULT jsdisp_get_id_cached(jsdisp_t*,const WCHAR*,DWORD,DISPID*,DISPID*) DECLSPEC_HIDDEN;
+BOOL jsdisp_is_valid_id(jsdisp_t*,DISPID) DECLSPEC_HIDDEN;
 HRESULT disp_delete(IDispatch*,DISPID,BOOL*) DECLSPEC_HIDDEN;
 HRESULT disp_delete_name(script_ctx_t*,IDispatch*,jsstr_t*,BOOL*);
 HRESULT jsdisp_delete_idx(jsdisp_t*,DWORD) DECLSPEC_HIDDEN;
@@ -395,8 +417,15 @@ struct _script_ctx_t {
 
     heap_pool_t tmp_heap;
 
+    struct list objects;
+    unsigned obj_cnt;
+    unsigned gc_alloc_cnt;
+
     IDispatch *host_global;
 
+    struct list regexp_cache;
+    unsigned regexp_cache_cnt;
+
     jsstr_t *last_match;
     match_result_t match_parens[9];
     DWORD last_match_index;
@@ -457,6 +486,7 @@ struct match_state_t;
 HRESULT regexp_match_next(script_ctx_t*,jsdisp_t*,DWORD,jsstr_t*,struct match_state_t**) DECLSPEC_HIDDEN;
 HRESULT parse_regexp_flags(const WCHAR*,DWORD,DWORD*) DECLSPEC_HIDDEN;
 HRESULT regexp_string_match(script_ctx_t*,jsdisp_t*,jsstr_t*,jsval_t*) DECLSPEC_HIDDEN;
+void release_regexp_cache(script_ctx_t*) DECLSPEC_HIDDEN;
 
 static inline BOOL is_class(jsdisp_t *jsdisp, jsclass_t class)
 {
@@ -58,6 +58,21 @@ static const WCHAR idx7W[] = {'$','7',0};
 static const WCHAR idx8W[] = {'$','8',0};
 static const WCHAR idx9W[] = {'$','9',0};
 
+/* Compiled programs are shared by all RegExp objects with the same source and flags. */
+#define REGEXP_CACHE_SIZE 32
+
+typedef struct {
+    struct list entry;
+    jsstr_t *src;
+    regexp_t *regexp;
+} regexp_cache_entry_t;
+
+static void regexp_release(regexp_t *regexp)
+{
+    if(!--regexp->ref)
+        regexp_destroy(regexp);
+}
+
 static inline RegExpInstance *regexp_from_jsdisp(jsdisp_t *jsdisp)
 {
     return CONTAINING_RECORD(jsdisp, RegExpInstance, dispex);
@@ -592,7 +607,7 @@ static void RegExp_destructor(jsdisp_t *dispex)
     RegExpInstance *This = (RegExpInstance*)dispex;
 
     if(This->jsregexp)
-        regexp_destroy(This->jsregexp);
+        regexp_release(This->jsregexp);
     jsval_release(This->last_index_val);
     jsstr_release(This->str);
     heap_free(This);
@@ -658,17 +673,75 @@ static HRESULT alloc_regexp(script_ctx_t *ctx, jsdisp_t *object_prototype, RegEx
     return S_OK;
 }
 
-HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **ret)
+static void free_regexp_cache_entry(regexp_cache_entry_t *entry)
 {
-    RegExpInstance *regexp;
+    list_remove(&entry->entry);
+    regexp_release(entry->regexp);
+    jsstr_release(entry->src);
+    heap_free(entry);
+}
+
+void release_regexp_cache(script_ctx_t *ctx)
+{
+    while(!list_empty(&ctx->regexp_cache))
+        free_regexp_cache_entry(LIST_ENTRY(list_head(&ctx->regexp_cache), regexp_cache_entry_t, entry));
+    ctx->regexp_cache_cnt = 0;
+}
+
+/*
+ * Returns a compiled program for *src and flags, taken from the script context's cache if possible.
+ * Since the program keeps pointers into its source string, *src is replaced by the (equal) string
+ * the cached program was compiled from.
+ */
+static regexp_t *compile_regexp(script_ctx_t *ctx, jsstr_t **src_ptr, DWORD flags)
+{
+    regexp_cache_entry_t *entry;
+    jsstr_t *src = *src_ptr;
     const WCHAR *str;
-    HRESULT hres;
+    regexp_t *regexp;
 
-    TRACE("%s %x\n", debugstr_jsstr(src), flags);
+    LIST_FOR_EACH_ENTRY(entry, &ctx->regexp_cache, regexp_cache_entry_t, entry) {
+        if(entry->regexp->flags == flags && (entry->src == src || jsstr_eq(entry->src, src))) {
+            list_remove(&entry->entry);
+            list_add_head(&ctx->regexp_cache, &entry->entry);
+
+            *src_ptr = jsstr_addref(entry->src);
+            jsstr_release(src);
+            entry->regexp->ref++;
+            return entry->regexp;
+        }
+    }
 
     str = jsstr_flatten(src);
     if(!str)
-        return E_OUTOFMEMORY;
+        return NULL;
+
+    regexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(src), flags, FALSE);
+    if(!regexp)
+        return NULL;
+
+    entry = heap_alloc(sizeof(*entry));
+    if(entry) {
+        if(ctx->regexp_cache_cnt == REGEXP_CACHE_SIZE)
+            free_regexp_cache_entry(LIST_ENTRY(list_tail(&ctx->regexp_cache), regexp_cache_entry_t, entry));
+        else
+            ctx->regexp_cache_cnt++;
+
+        entry->src = jsstr_addref(src);
+        entry->regexp = regexp;
+        regexp->ref++;
+        list_add_head(&ctx->regexp_cache, &entry->entry);
+    }
+
+    return regexp;
+}
+
+HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **ret)
+{
+    RegExpInstance *regexp;
+    HRESULT hres;
+
+    TRACE("%s %x\n", debugstr_jsstr(src), flags);
 
     hres = alloc_regexp(ctx, NULL, &regexp);
     if(FAILED(hres))
@@ -677,7 +750,7 @@ HRESULT create_regexp(script_ctx_t *ctx, jsstr_t *src, DWORD flags, jsdisp_t **r
     regexp->str = jsstr_addref(src);
     regexp->last_index_val = jsval_number(0);
 
-    regexp->jsregexp = regexp_new(ctx, &ctx->tmp_heap, str, jsstr_length(regexp->str), flags, FALSE);
+    regexp->jsregexp = compile_regexp(ctx, &regexp->str, flags);
     if(!regexp->jsregexp) {
         WARN("regexp_new failed\n");
         jsdisp_release(&regexp->dispex);
@@ -3070,6 +3070,89 @@ good:
     return x;
 }
 
+/*
+ * Returns the first position at or after cp where the character consumed by the first operator
+ * of the program can match, or NULL if there is none. A match can't start at any position before
+ * it, so those are skipped without entering the backtracking matcher. Programs starting with
+ * other operators are tried at every position.
+ */
+static const WCHAR *
+FindMatchCandidate(REGlobalData *gData, const WCHAR *cp)
+{
+    jsbytecode *pc = gData->regexp->program;
+    const WCHAR *cpend = gData->cpend;
+    size_t offset, length, index;
+    const WCHAR *source;
+    RECharSet *charSet;
+    REOp op;
+    WCHAR ch;
+
+    op = (REOp) *pc++;
+    while (op == REOP_LPAREN) {
+        pc = ReadCompactIndex(pc, &index);
+        op = (REOp) *pc++;
+    }
+
+    switch (op) {
+      case REOP_FLAT:
+        pc = ReadCompactIndex(pc, &offset);
+        pc = ReadCompactIndex(pc, &length);
+        source = gData->regexp->source + offset;
+        while (length <= (size_t)(cpend - cp)) {
+            cp = memchrW(cp, *source, cpend - cp - length + 1);
+            if (!cp)
+                return NULL;
+            if (!memcmp(cp, source, length * sizeof(WCHAR)))
+                return cp;
+            cp++;
+        }
+        return NULL;
+      case REOP_FLAT1:
+        ch = *pc;
+        break;
+      case REOP_UCFLAT1:
+        ch = GET_ARG(pc);
+        break;
+      case REOP_FLATi:
+        ReadCompactIndex(pc, &offset);
+        ch = toupperW(gData->regexp->source[offset]);
+        goto fold;
+      case REOP_FLAT1i:
+        ch = toupperW(*pc);
+        goto fold;
+      case REOP_UCFLAT1i:
+        ch = toupperW(GET_ARG(pc));
+      fold:
+        for (; cp < cpend; cp++) {
+            if (toupperW(*cp) == ch)
+                return cp;
+        }
+        return NULL;
+      case REOP_CLASS:
+        ReadCompactIndex(pc, &index);
+        charSet = &gData->regexp->classList[index];
+        assert(charSet->converted);
+        if (!charSet->length)
+            return NULL;
+        for (; cp < cpend; cp++) {
+            ch = *cp;
+            if (ch <= charSet->length && (charSet->u.bits[ch >> 3] & (1 << (ch & 0x7))))
+                return cp;
+        }
+        return NULL;
+      case REOP_DIGIT:
+        for (; cp < cpend; cp++) {
+            if (JS7_ISDEC(*cp))
+                return cp;
+        }
+        return NULL;
+      default:
+        return cp;
+    }
+
+    return memchrW(cp, ch, cpend - cp);
+}
+
 static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
 {
     match_state_t *result;
@@ -3082,6 +3165,11 @@ static match_state_t *MatchRegExp(REGlobalData *gData, match_state_t *x)
      * in order to detect end-of-input/line condition.
      */
     for (cp2 = cp; cp2 <= gData->cpend; cp2++) {
+        if (!(gData->regexp->flags & REG_STICKY)) {
+            cp2 = FindMatchCandidate(gData, cp2);
+            if (!cp2)
+                break;
+        }
         gData->skipped = cp2 - cp;
         x->cp = cp2;
         for (j = 0; j < gData->regexp->parenCount; j++)
@@ -3277,6 +3365,7 @@ regexp_t* regexp_new(void *cx, heap_pool_t *pool, const WCHAR *str,
             re = tmp;
     }
 
+    re->ref = 1;
     re->flags = flags;
     re->parenCount = state.parenCount;
     re->source = str;
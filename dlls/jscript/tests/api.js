@@ -969,6 +969,48 @@ arr.length = 3;
 ok(arr.length === 3, "arr.length = " + arr.length);
 ok(arr.toString() === "1,,", "arr.toString() = " + arr.toString());
 
+arr = [];
+for(i=0; i < 100; i++)
+    arr[i] = i;
+ok(arr.length === 100, "arr.length = " + arr.length);
+delete arr[50];
+ok(!(50 in arr), "arr[50] not deleted");
+ok(arr[49] === 49 && arr[51] === 51 && arr[99] === 99, "unexpected array");
+ok(arr.length === 100, "arr.length = " + arr.length);
+tmp = 0;
+for(i in arr)
+    tmp++;
+ok(tmp === 99, "enumerated " + tmp + " elements");
+arr[50] = "x";
+ok(arr[50] === "x", "arr[50] = " + arr[50]);
+arr.length = 10;
+ok(arr.length === 10, "arr.length = " + arr.length);
+ok(arr[9] === 9 && !(10 in arr) && arr[50] === undefined, "array not truncated");
+arr[20] = 20;
+ok(arr.length === 21, "arr.length = " + arr.length);
+ok(!(15 in arr), "arr[15] exists");
+arr[10] = 10;
+ok(arr.toString() === "0,1,2,3,4,5,6,7,8,9,10,,,,,,,,,,20", "arr.toString() = " + arr.toString());
+tmp = arr.pop();
+ok(tmp === 20, "arr.pop() = " + tmp);
+ok(arr.length === 20, "arr.length = " + arr.length);
+ok(arr["3"] === 3, "arr[\"3\"] = " + arr["3"]);
+ok(arr.hasOwnProperty("3"), "arr.hasOwnProperty(\"3\") = false");
+ok(!arr.hasOwnProperty("03"), "arr.hasOwnProperty(\"03\") = true");
+arr["03"] = "a";
+ok(arr[3] === 3 && arr["03"] === "a", "arr[3] = " + arr[3] + " arr[\"03\"] = " + arr["03"]);
+arr[arr.length] = arr.length;
+ok(arr[20] === 20, "arr[20] = " + arr[20]);
+ok(arr.length === 21, "arr.length = " + arr.length);
+
+function ArrayPrototypeTest() {}
+ArrayPrototypeTest.prototype = [1,2,3];
+obj = new ArrayPrototypeTest();
+ok(obj[1] === 2, "obj[1] = " + obj[1]);
+ArrayPrototypeTest.prototype.push(4);
+ok(obj[3] === 4, "obj[3] = " + obj[3]);
+ok(obj.length === 4, "obj.length = " + obj.length);
+
 arr = Array("a","b","c");
 ok(arr.toString() === "a,b,c", "arr.toString() = " + arr.toString());
 
@@ -1420,6 +1420,68 @@ tmp = (function() {
 })();
 ok(tmp, "tmp = " + tmp);
 
+tmp = (function(x) {
+    var y = 1, r = "";
+
+    function inner() { return x+y; }
+
+    r += inner();
+    x = 3;
+    y = 4;
+    r += "," + inner();
+    with({y: 5})
+        r += "," + (x+y);
+    try {
+        throw 6;
+    }catch(x) {
+        r += "," + x;
+    }
+    r += "," + x;
+    eval("y = 7");
+    r += "," + y;
+    return r;
+})(2);
+ok(tmp === "3,7,8,6,3,7", "tmp = " + tmp);
+
+tmp = (function() {
+    var i, sum = 0;
+
+    for(i in {a: 1, b: 2})
+        sum++;
+    var obj = {x: 1};
+    for(i = 0; i < 3; i++)
+        obj.x += obj["x"];
+    return sum + obj.x + typeof(nonexistent) + typeof(arguments);
+})();
+ok(tmp === "10undefinedobject", "tmp = " + tmp);
+
+function createCycles(cnt) {
+    var i, o, ret = null;
+
+    for(i = 0; i < cnt; i++) {
+        o = {prev: ret, func: function() { return o; }};
+        o.self = o;
+        ret = (function(x) { var self = function() { return self; }; x.closure = self; return x; })(o);
+    }
+    return ret;
+}
+
+tmp = createCycles(10);
+createCycles(5000);
+ok(tmp.self === tmp, "tmp.self !== tmp");
+ok(tmp.func() === tmp, "tmp.func() !== tmp");
+ok(tmp.closure() === tmp.closure, "tmp.closure() !== tmp.closure");
+ok(tmp.prev.prev.self === tmp.prev.prev, "tmp.prev.prev.self !== tmp.prev.prev");
+ok(tmp.prev.prev.prev.prev.prev.prev.prev.prev.prev.prev === null, "unexpected tmp.prev chain");
+tmp = (function() {
+    var cycle = {};
+
+    cycle.self = cycle;
+    createCycles(5000);
+    return cycle.self === cycle;
+})();
+ok(tmp, "cycle referenced by active function was collected");
+
 /* NoNewline rule parser tests */
 while(true) {
     if(true) break
@@ -0,0 +1,227 @@
+/*
+ * JScript micro-benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+var N = 100000;
+
+function bench(name, func) {
+    var start = new Date().getTime(), ret;
+
+    ret = func();
+    test.trace(name + ": " + (new Date().getTime() - start) + " ms");
+    return ret;
+}
+
+function fill_array() {
+    var arr = [], i;
+
+    for(i = 0; i < N; i++)
+        arr[i] = i;
+    return arr;
+}
+
+var arr = bench("array index store", fill_array);
+test.ok(arr.length === N, "arr.length = " + arr.length);
+
+var sum = bench("array index load", function() {
+    var i, j, ret = 0;
+
+    for(j = 0; j < 4; j++) {
+        for(i = 0; i < arr.length; i++)
+            ret += arr[i];
+    }
+    return ret;
+});
+test.ok(sum === 2*N*(N-1), "sum = " + sum);
+
+bench("array index update", function() {
+    var i;
+
+    for(i = 0; i < arr.length; i++)
+        arr[i] += 1;
+});
+test.ok(arr[0] === 1 && arr[N-1] === N, "arr[0] = " + arr[0] + " arr[N-1] = " + arr[N-1]);
+
+var tmp = bench("array push/pop", function() {
+    var a = [], i, ret = 0;
+
+    for(i = 0; i < N; i++)
+        a.push(i);
+    while(a.length)
+        ret += a.pop();
+    return ret;
+});
+test.ok(tmp === N*(N-1)/2, "push/pop sum = " + tmp);
+
+tmp = bench("array join", function() {
+    return arr.join(",").length;
+});
+test.ok(tmp > N, "join length = " + tmp);
+
+tmp = bench("array sort", function() {
+    var a = [], i;
+
+    for(i = 0; i < N/10; i++)
+        a[i] = (i * 7919) % (N/10);
+    a.sort(function(x, y) { return x - y; });
+    return a;
+});
+test.ok(tmp[0] === 0 && tmp[tmp.length-1] === N/10-1, "array not sorted");
+
+tmp = bench("array splice/shift", function() {
+    var a = [1,2,3,4,5,6,7,8,9,10], i, ret = 0;
+
+    for(i = 0; i < N/10; i++) {
+        a.splice(2, 1, i);
+        ret += a.shift();
+        a.push(i);
+    }
+    return ret;
+});
+test.ok(tmp > 0, "splice/shift returned " + tmp);
+
+tmp = bench("array for in", function() {
+    var i, ret = 0;
+
+    for(i in arr)
+        ret++;
+    return ret;
+});
+test.ok(tmp === N, "enumerated " + tmp + " elements");
+
+tmp = bench("array literal", function() {
+    var i, a, ret = 0;
+
+    for(i = 0; i < N/10; i++) {
+        a = [i, i+1, i+2, i+3, i+4, i+5, i+6, i+7];
+        ret += a[7];
+    }
+    return ret;
+});
+test.ok(tmp > 0, "array literal sum = " + tmp);
+
+tmp = bench("sparse array store", function() {
+    var a = [], i;
+
+    for(i = N/10; i > 0; i--)
+        a[i*3] = i;
+    return a;
+});
+test.ok(tmp.length === 3*N/10+1, "sparse length = " + tmp.length);
+
+tmp = bench("object index store", function() {
+    var o = new Object(), i;
+
+    for(i = 0; i < N/10; i++)
+        o[i] = i;
+    return o;
+});
+test.ok(tmp[N/10-1] === N/10-1, "o[N/10-1] = " + tmp[N/10-1]);
+
+tmp = bench("local variable loop", function() {
+    var i, ret = 0;
+
+    for(i = 0; i < 10*N; i++)
+        ret += i & 7;
+    return ret;
+});
+test.ok(tmp === 35*N*10/8, "local loop sum = " + tmp);
+
+var gi, gret;
+bench("global variable loop", function() {
+    for(gi = 0, gret = 0; gi < 10*N; gi++)
+        gret += gi & 7;
+});
+test.ok(gret === 35*N*10/8, "global loop sum = " + gret);
+
+tmp = bench("property access loop", function() {
+    var o = {x: 0, y: 1}, i;
+
+    for(i = 0; i < N; i++)
+        o.x += o.y;
+    return o.x;
+});
+test.ok(tmp === N, "o.x = " + tmp);
+
+tmp = bench("method call loop", function() {
+    var o = {v: 0, inc: function() { this.v++; }}, i;
+
+    for(i = 0; i < N; i++)
+        o.inc();
+    return o.v;
+});
+test.ok(tmp === N, "o.v = " + tmp);
+
+bench("cycle collection", function() {
+    var i, o;
+
+    for(i = 0; i < N; i++) {
+        o = {i: i};
+        o.self = o;
+        o.func = function() { return o; };
+    }
+});
+
+var text = "";
+for(tmp = 0; tmp < 100; tmp++)
+    text += "lorem ipsum dolor sit amet " + tmp + " ";
+
+tmp = bench("regexp literal replace", function() {
+    var i, ret;
+
+    for(i = 0; i < N/100; i++)
+        ret = text.replace(/amet/g, "x");
+    return ret;
+});
+test.ok(tmp.indexOf("amet") === -1, "amet found in " + tmp);
+
+tmp = bench("regexp constructor search", function() {
+    var i, ret = 0;
+
+    for(i = 0; i < N/10; i++)
+        ret += text.search(new RegExp("amet 99"));
+    return ret;
+});
+test.ok(tmp > 0, "search returned " + tmp);
+
+tmp = bench("regexp class search", function() {
+    var i, ret = 0;
+
+    for(i = 0; i < N/10; i++)
+        ret += text.search(/[0-9]+ lorem/i);
+    return ret;
+});
+test.ok(tmp > 0, "class search returned " + tmp);
+
+var dict = new ActiveXObject("Scripting.Dictionary");
+
+bench("dictionary add", function() {
+    var i;
+
+    for(i = 0; i < 10*N; i++)
+        dict.Add("key" + i, i);
+});
+test.ok(dict.Count === 10*N, "dict.Count = " + dict.Count);
+
+tmp = bench("dictionary lookup", function() {
+    var i, ret = 0;
+
+    for(i = 0; i < 10*N; i++)
+        ret += dict.Item("key" + i);
+    return ret;
+});
+test.ok(tmp === 5*N*(10*N-1), "dictionary lookup sum = " + tmp);
@@ -660,4 +660,33 @@ tmp = new RegExp("abc/", "mgi");
 ok(tmp.toString() === "/abc//igm", "(new RegExp(\"abc/\")).toString() = " + tmp.toString());
 ok(/abc/.toString(1, false, "3") === "/abc/", "/abc/.toString(1, false, \"3\") = " + /abc/.toString());
 
+var re1 = new RegExp("a.c", "g"), re2 = new RegExp("a.c", "g");
+ok(re1 !== re2, "re1 === re2");
+ok(re1.exec("xabcxadc").index === 1, "re1.exec failed");
+ok(re1.lastIndex === 4, "re1.lastIndex = " + re1.lastIndex);
+ok(re2.lastIndex === 0, "re2.lastIndex = " + re2.lastIndex);
+ok(re2.exec("adc").index === 0, "re2.exec failed");
+ok(re1.exec("xabcxadc").index === 5, "second re1.exec failed");
+ok(re1.source === "a.c", "re1.source = " + re1.source);
+re2 = new RegExp("a.c", "i");
+ok(!re2.global && re2.ignoreCase, "re2 flags are wrong");
+
+for(i = 0; i < 3; i++) {
+    tmp = "abcabc".replace(/b/g, "x");
+    ok(tmp === "axcaxc", "replace returned " + tmp);
+    tmp = "xxABxAb".search(/ab/i);
+    ok(tmp === 2, "search returned " + tmp);
+}
+
+ok("xxxabyab".search(/ab(?!y)/) === 6, "search(/ab(?!y)/) failed");
+ok("xxXx".search(/X/) === 2, "search(/X/) failed");
+ok("xxXx".search(/Xx/i) === 0, "search(/Xx/i) failed");
+ok("abc1d".search(/\d/) === 3, "search(/\\d/) failed");
+ok("abc1d".search(/[0-9]d/) === 3, "search(/[0-9]d/) failed");
+ok("ab\u0100d".search(/\u0100/) === 2, "search(/\\u0100/) failed");
+ok("abcd".search(/(cd)/) === 2, "search(/(cd)/) failed");
+ok("abcd".search(/e/) === -1, "search(/e/) failed");
+ok("abcd".search(/cde/) === -1, "search(/cde/) failed");
+ok("abcd".search(/d$/) === 3, "search(/d$/) failed");
+
 reportSuccess();
@@ -2660,6 +2660,7 @@ static void run_benchmarks(void)
     run_benchmark("dna.js");
     run_benchmark("base64.js");
     run_benchmark("validateinput.js");
+    run_benchmark("microbench.js");
 }
 
 static BOOL check_jscript(void)
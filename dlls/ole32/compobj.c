@@ -161,9 +161,14 @@ struct class_reg_data
             void *section;
             HANDLE hactctx;
         } actctx;
-        HKEY hkey;
+        struct
+        {
+            enum comclass_threadingmodel model;
+            DWORD path_ret;
+            WCHAR path[MAX_PATH+1];
+        } reg;
     } u;
-    BOOL hkey;
+    BOOL registry;
 };
 
 struct registered_psclsid
@@ -1382,36 +1387,20 @@ static HRESULT apartment_getclassobject(struct apartment *apt, LPCWSTR dllpath,
 /***********************************************************************
  *	COM_RegReadPath	[internal]
  *
- *	Reads a registry value and expands it when necessary
+ *	Returns the path of the dll implementing the class
  */
 static DWORD COM_RegReadPath(const struct class_reg_data *regdata, WCHAR *dst, DWORD dstlen)
 {
     DWORD ret;
 
-    if (regdata->hkey)
+    if (regdata->registry)
     {
-	DWORD keytype;
-	WCHAR src[MAX_PATH];
-	DWORD dwLength = dstlen * sizeof(WCHAR);
-
-        if( (ret = RegQueryValueExW(regdata->u.hkey, NULL, NULL, &keytype, (BYTE*)src, &dwLength)) == ERROR_SUCCESS ) {
-            if (keytype == REG_EXPAND_SZ) {
-              if (dstlen <= ExpandEnvironmentStringsW(src, dst, dstlen)) ret = ERROR_MORE_DATA;
-            } else {
-              const WCHAR *quote_start;
-              quote_start = strchrW(src, '\"');
-              if (quote_start) {
-                const WCHAR *quote_end = strchrW(quote_start + 1, '\"');
-                if (quote_end) {
-                  memmove(src, quote_start + 1,
-                          (quote_end - quote_start - 1) * sizeof(WCHAR));
-                  src[quote_end - quote_start - 1] = '\0';
-                }
-              }
-              lstrcpynW(dst, src, dstlen);
-            }
+        if ((ret = regdata->u.reg.path_ret) == ERROR_SUCCESS)
+        {
+            if (dstlen <= strlenW(regdata->u.reg.path)) return ERROR_MORE_DATA;
+            strcpyW(dst, regdata->u.reg.path);
         }
-	return ret;
+        return ret;
     }
     else
     {
@@ -2843,35 +2832,321 @@ HRESULT WINAPI CoRegisterClassObject(
   return S_OK;
 }
 
-static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
+/* reads the dll path from the default value of an InprocServer32/InprocHandler32 key,
+ * a REG_EXPAND_SZ path is returned unexpanded and has to go through expand_inproc_path */
+static DWORD read_inproc_path(HKEY hkey, WCHAR *dst, DWORD dstlen, BOOL *expand)
 {
-    if (data->hkey)
+    DWORD keytype;
+    WCHAR src[MAX_PATH+1];
+    DWORD dwLength = sizeof(src);
+    DWORD ret;
+
+    *dst = 0;
+    *expand = FALSE;
+    if ((ret = RegQueryValueExW(hkey, NULL, NULL, &keytype, (BYTE*)src, &dwLength)) == ERROR_SUCCESS)
     {
-        static const WCHAR wszThreadingModel[] = {'T','h','r','e','a','d','i','n','g','M','o','d','e','l',0};
-        static const WCHAR wszApartment[] = {'A','p','a','r','t','m','e','n','t',0};
-        static const WCHAR wszFree[] = {'F','r','e','e',0};
-        static const WCHAR wszBoth[] = {'B','o','t','h',0};
-        WCHAR threading_model[10 /* strlenW(L"apartment")+1 */];
-        DWORD dwLength = sizeof(threading_model);
-        DWORD keytype;
-        DWORD ret;
-
-        ret = RegQueryValueExW(data->u.hkey, wszThreadingModel, NULL, &keytype, (BYTE*)threading_model, &dwLength);
-        if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
-            threading_model[0] = '\0';
-
-        if (!strcmpiW(threading_model, wszApartment)) return ThreadingModel_Apartment;
-        if (!strcmpiW(threading_model, wszFree)) return ThreadingModel_Free;
-        if (!strcmpiW(threading_model, wszBoth)) return ThreadingModel_Both;
-
-        /* there's not specific handling for this case */
-        if (threading_model[0]) return ThreadingModel_Neutral;
-        return ThreadingModel_No;
+        if (keytype == REG_EXPAND_SZ)
+        {
+            lstrcpynW(dst, src, dstlen);
+            *expand = TRUE;
+        }
+        else
+        {
+            const WCHAR *quote_start;
+            quote_start = strchrW(src, '\"');
+            if (quote_start)
+            {
+                const WCHAR *quote_end = strchrW(quote_start + 1, '\"');
+                if (quote_end)
+                {
+                    memmove(src, quote_start + 1,
+                            (quote_end - quote_start - 1) * sizeof(WCHAR));
+                    src[quote_end - quote_start - 1] = '\0';
+                }
+            }
+            lstrcpynW(dst, src, dstlen);
+        }
     }
+    return ret;
+}
+
+/* the environment may have changed since the path was read, so this is done on every lookup */
+static void expand_inproc_path(struct class_reg_data *regdata)
+{
+    WCHAR src[MAX_PATH+1];
+
+    if (regdata->u.reg.path_ret != ERROR_SUCCESS) return;
+    strcpyW(src, regdata->u.reg.path);
+    if (ARRAYSIZE(regdata->u.reg.path) <= ExpandEnvironmentStringsW(src, regdata->u.reg.path,
+                                                                    ARRAYSIZE(regdata->u.reg.path)))
+        regdata->u.reg.path_ret = ERROR_MORE_DATA;
+}
+
+static enum comclass_threadingmodel read_threading_model(HKEY hkey)
+{
+    static const WCHAR wszThreadingModel[] = {'T','h','r','e','a','d','i','n','g','M','o','d','e','l',0};
+    static const WCHAR wszApartment[] = {'A','p','a','r','t','m','e','n','t',0};
+    static const WCHAR wszFree[] = {'F','r','e','e',0};
+    static const WCHAR wszBoth[] = {'B','o','t','h',0};
+    WCHAR threading_model[10 /* strlenW(L"apartment")+1 */];
+    DWORD dwLength = sizeof(threading_model);
+    DWORD keytype;
+    DWORD ret;
+
+    ret = RegQueryValueExW(hkey, wszThreadingModel, NULL, &keytype, (BYTE*)threading_model, &dwLength);
+    if ((ret != ERROR_SUCCESS) || (keytype != REG_SZ))
+        threading_model[0] = '\0';
+
+    if (!strcmpiW(threading_model, wszApartment)) return ThreadingModel_Apartment;
+    if (!strcmpiW(threading_model, wszFree)) return ThreadingModel_Free;
+    if (!strcmpiW(threading_model, wszBoth)) return ThreadingModel_Both;
+
+    /* there's not specific handling for this case */
+    if (threading_model[0]) return ThreadingModel_Neutral;
+    return ThreadingModel_No;
+}
+
+static enum comclass_threadingmodel get_threading_model(const struct class_reg_data *data)
+{
+    if (data->registry)
+        return data->u.reg.model;
     else
         return data->u.actctx.data->model;
 }
 
+/*****************************************************************************
+ * This section contains the class registration cache
+ *
+ * Looking up a class in the registry takes several server round trips, which
+ * dominates the cost of creating a small in-process object. The results are
+ * kept per CLSID and the whole cache is flushed whenever anything below
+ * HKCR changes, which we learn about through a registry change notification.
+ * Checking the notification event costs a single wait, so a cache hit is
+ * still far cheaper than reading the keys again.
+ */
+
+#define CLASS_REG_CACHE_MAX_ENTRIES 1024
+
+struct class_reg_cache_server
+{
+    BOOL valid;
+    HRESULT hr;
+    enum comclass_threadingmodel model;
+    DWORD path_ret;
+    WCHAR *path;    /* unexpanded if expand is set */
+    BOOL expand;
+};
+
+struct class_reg_cache_entry
+{
+    struct list entry;
+    CLSID clsid;
+    struct class_reg_cache_server server[2]; /* InprocServer32, InprocHandler32 */
+    BOOL treatas_valid;
+    HRESULT treatas_hr;
+    CLSID treatas;
+};
+
+static struct list class_reg_cache = LIST_INIT(class_reg_cache);
+static unsigned int class_reg_cache_count;
+static unsigned int class_reg_cache_generation;
+static HANDLE class_reg_cache_event;
+static HKEY class_reg_cache_hkey;
+
+static CRITICAL_SECTION csClassRegCache;
+static CRITICAL_SECTION_DEBUG class_reg_cache_cs_debug =
+{
+    0, 0, &csClassRegCache,
+    { &class_reg_cache_cs_debug.ProcessLocksList, &class_reg_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": csClassRegCache") }
+};
+static CRITICAL_SECTION csClassRegCache = { &class_reg_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static void class_reg_cache_free_entry(struct class_reg_cache_entry *entry)
+{
+    list_remove(&entry->entry);
+    HeapFree(GetProcessHeap(), 0, entry->server[0].path);
+    HeapFree(GetProcessHeap(), 0, entry->server[1].path);
+    HeapFree(GetProcessHeap(), 0, entry);
+    class_reg_cache_count--;
+}
+
+/* must be called with csClassRegCache held */
+static void class_reg_cache_flush(void)
+{
+    struct class_reg_cache_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &class_reg_cache, struct class_reg_cache_entry, entry)
+        class_reg_cache_free_entry(entry);
+    class_reg_cache_generation++;
+}
+
+/* flushes the cache if the registry changed since the last call and re-arms
+ * the notification; returns FALSE if the cache can't be used.
+ * must be called with csClassRegCache held */
+static BOOL class_reg_cache_validate(void)
+{
+    static const WCHAR emptyW[] = {0};
+
+    if (!class_reg_cache_event)
+    {
+        if (!class_reg_cache_hkey &&
+            open_classes_key(HKEY_CLASSES_ROOT, emptyW, KEY_NOTIFY, &class_reg_cache_hkey))
+            return FALSE;
+        if (!(class_reg_cache_event = CreateEventW(NULL, FALSE, TRUE, NULL)))
+            return FALSE;
+    }
+
+    if (WaitForSingleObject(class_reg_cache_event, 0) != WAIT_OBJECT_0)
+        return TRUE;
+
+    class_reg_cache_flush();
+    if (RegNotifyChangeKeyValue(class_reg_cache_hkey, TRUE,
+                                REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+                                class_reg_cache_event, TRUE))
+    {
+        WARN("couldn't watch the registry for class changes\n");
+        /* try again on the next lookup */
+        SetEvent(class_reg_cache_event);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/* must be called with csClassRegCache held */
+static struct class_reg_cache_entry *class_reg_cache_find(REFCLSID clsid)
+{
+    struct class_reg_cache_entry *entry;
+
+    LIST_FOR_EACH_ENTRY(entry, &class_reg_cache, struct class_reg_cache_entry, entry)
+    {
+        if (IsEqualCLSID(&entry->clsid, clsid))
+        {
+            /* keep the most recently used classes at the front */
+            list_remove(&entry->entry);
+            list_add_head(&class_reg_cache, &entry->entry);
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* must be called with csClassRegCache held */
+static struct class_reg_cache_entry *class_reg_cache_get(REFCLSID clsid)
+{
+    struct class_reg_cache_entry *entry;
+
+    if ((entry = class_reg_cache_find(clsid))) return entry;
+
+    if (class_reg_cache_count >= CLASS_REG_CACHE_MAX_ENTRIES)
+        class_reg_cache_free_entry(LIST_ENTRY(list_tail(&class_reg_cache), struct class_reg_cache_entry, entry));
+
+    if (!(entry = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*entry))))
+        return NULL;
+    entry->clsid = *clsid;
+    list_add_head(&class_reg_cache, &entry->entry);
+    class_reg_cache_count++;
+    return entry;
+}
+
+static void class_reg_cache_free(void)
+{
+    EnterCriticalSection(&csClassRegCache);
+    class_reg_cache_flush();
+    if (class_reg_cache_event) CloseHandle(class_reg_cache_event);
+    if (class_reg_cache_hkey) RegCloseKey(class_reg_cache_hkey);
+    class_reg_cache_event = NULL;
+    class_reg_cache_hkey = NULL;
+    LeaveCriticalSection(&csClassRegCache);
+    DeleteCriticalSection(&csClassRegCache);
+}
+
+/* leaves a REG_EXPAND_SZ path unexpanded and sets *expand */
+static HRESULT read_class_reg_data(REFCLSID clsid, BOOL handler, struct class_reg_data *regdata, BOOL *expand)
+{
+    static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
+    static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
+    HKEY hkey;
+    HRESULT hr;
+
+    hr = COM_OpenKeyForCLSID(clsid, handler ? wszInprocHandler32 : wszInprocServer32, KEY_READ, &hkey);
+    if (FAILED(hr)) return hr;
+
+    regdata->u.reg.path_ret = read_inproc_path(hkey, regdata->u.reg.path, ARRAYSIZE(regdata->u.reg.path), expand);
+    regdata->u.reg.model = read_threading_model(hkey);
+    regdata->registry = TRUE;
+    RegCloseKey(hkey);
+    return S_OK;
+}
+
+/* looks up the InprocServer32 or InprocHandler32 registration of a class */
+static HRESULT get_class_reg_data(REFCLSID clsid, BOOL handler, struct class_reg_data *regdata)
+{
+    struct class_reg_cache_entry *entry;
+    struct class_reg_cache_server *server;
+    unsigned int generation;
+    BOOL use_cache, expand;
+    HRESULT hr;
+
+    EnterCriticalSection(&csClassRegCache);
+    use_cache = class_reg_cache_validate();
+    if (use_cache && (entry = class_reg_cache_find(clsid)) && entry->server[handler].valid)
+    {
+        server = &entry->server[handler];
+        hr = server->hr;
+        if (SUCCEEDED(hr))
+        {
+            regdata->u.reg.model = server->model;
+            regdata->u.reg.path_ret = server->path_ret;
+            strcpyW(regdata->u.reg.path, server->path);
+            regdata->registry = TRUE;
+            expand = server->expand;
+        }
+        LeaveCriticalSection(&csClassRegCache);
+        TRACE("found %s in cache, hr %#x\n", debugstr_guid(clsid), hr);
+        if (SUCCEEDED(hr) && expand) expand_inproc_path(regdata);
+        return hr;
+    }
+    generation = class_reg_cache_generation;
+    LeaveCriticalSection(&csClassRegCache);
+
+    hr = read_class_reg_data(clsid, handler, regdata, &expand);
+
+    /* don't remember errors that may be transient */
+    if (!use_cache || (hr != S_OK && hr != REGDB_E_CLASSNOTREG && hr != REGDB_E_KEYMISSING))
+    {
+        if (SUCCEEDED(hr) && expand) expand_inproc_path(regdata);
+        return hr;
+    }
+
+    EnterCriticalSection(&csClassRegCache);
+    /* the registry may have changed while we were reading it */
+    if (generation == class_reg_cache_generation && (entry = class_reg_cache_get(clsid)) &&
+        !entry->server[handler].valid)
+    {
+        server = &entry->server[handler];
+        server->hr = hr;
+        if (SUCCEEDED(hr))
+        {
+            DWORD size = (strlenW(regdata->u.reg.path) + 1) * sizeof(WCHAR);
+
+            if ((server->path = HeapAlloc(GetProcessHeap(), 0, size)))
+            {
+                memcpy(server->path, regdata->u.reg.path, size);
+                server->model = regdata->u.reg.model;
+                server->path_ret = regdata->u.reg.path_ret;
+                server->expand = expand;
+                server->valid = TRUE;
+            }
+        }
+        else
+            server->valid = TRUE;
+    }
+    LeaveCriticalSection(&csClassRegCache);
+    if (SUCCEEDED(hr) && expand) expand_inproc_path(regdata);
+    return hr;
+}
+
 static HRESULT get_inproc_class_object(APARTMENT *apt, const struct class_reg_data *regdata,
                                        REFCLSID rclsid, REFIID riid,
                                        BOOL hostifnecessary, void **ppv)
@@ -3005,7 +3280,7 @@ HRESULT WINAPI DECLSPEC_HOTPATCH CoGetClassObject(
             clsreg.u.actctx.hactctx = data.hActCtx;
             clsreg.u.actctx.data = data.lpData;
             clsreg.u.actctx.section = data.lpSectionBase;
-            clsreg.hkey = FALSE;
+            clsreg.registry = FALSE;
 
             hres = get_inproc_class_object(apt, &clsreg, &comclass->clsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
             ReleaseActCtx(data.hActCtx);
@@ -3037,10 +3312,7 @@ HRESULT WINAPI DECLSPEC_HOTPATCH CoGetClassObject(
     /* First try in-process server */
     if (CLSCTX_INPROC_SERVER & dwClsContext)
     {
-        static const WCHAR wszInprocServer32[] = {'I','n','p','r','o','c','S','e','r','v','e','r','3','2',0};
-        HKEY hkey;
-
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocServer32, KEY_READ, &hkey);
+        hres = get_class_reg_data(rclsid, FALSE, &clsreg);
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -3053,13 +3325,7 @@ HRESULT WINAPI DECLSPEC_HOTPATCH CoGetClassObject(
         }
 
         if (SUCCEEDED(hres))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.hkey = TRUE;
-
             hres = get_inproc_class_object(apt, &clsreg, rclsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -3073,10 +3339,7 @@ HRESULT WINAPI DECLSPEC_HOTPATCH CoGetClassObject(
     /* Next try in-process handler */
     if (CLSCTX_INPROC_HANDLER & dwClsContext)
     {
-        static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
-        HKEY hkey;
-
-        hres = COM_OpenKeyForCLSID(rclsid, wszInprocHandler32, KEY_READ, &hkey);
+        hres = get_class_reg_data(rclsid, TRUE, &clsreg);
         if (FAILED(hres))
         {
             if (hres == REGDB_E_CLASSNOTREG)
@@ -3089,13 +3352,7 @@ HRESULT WINAPI DECLSPEC_HOTPATCH CoGetClassObject(
         }
 
         if (SUCCEEDED(hres))
-        {
-            clsreg.u.hkey = hkey;
-            clsreg.hkey = TRUE;
-
             hres = get_inproc_class_object(apt, &clsreg, rclsid, iid, !(dwClsContext & WINE_CLSCTX_DONT_HOST), ppv);
-            RegCloseKey(hkey);
-        }
 
         /* return if we got a class, otherwise fall through to one of the
          * other types */
@@ -3803,23 +4060,7 @@ done:
     return res;
 }
 
-/******************************************************************************
- *              CoGetTreatAsClass        [OLE32.@]
- *
- * Gets the TreatAs value of a class.
- *
- * PARAMS
- *  clsidOld [I] Class to get the TreatAs value of.
- *  clsidNew [I] The class the clsidOld should be treated as.
- *
- * RETURNS
- *  Success: S_OK.
- *  Failure: HRESULT code.
- *
- * SEE ALSO
- *  CoSetTreatAsClass
- */
-HRESULT WINAPI CoGetTreatAsClass(REFCLSID clsidOld, LPCLSID clsidNew)
+static HRESULT read_treat_as_class(REFCLSID clsidOld, LPCLSID clsidNew)
 {
     static const WCHAR wszTreatAs[] = {'T','r','e','a','t','A','s',0};
     HKEY hkey = NULL;
@@ -3827,7 +4068,6 @@ HRESULT WINAPI CoGetTreatAsClass(REFCLSID clsidOld, LPCLSID clsidNew)
     HRESULT res = S_OK;
     LONG len = sizeof(szClsidNew);
 
-    TRACE("(%s,%p)\n", debugstr_guid(clsidOld), clsidNew);
     *clsidNew = *clsidOld; /* copy over old value */
 
     res = COM_OpenKeyForCLSID(clsidOld, wszTreatAs, KEY_READ, &hkey);
@@ -3849,6 +4089,57 @@ done:
     return res;
 }
 
+/******************************************************************************
+ *              CoGetTreatAsClass        [OLE32.@]
+ *
+ * Gets the TreatAs value of a class.
+ *
+ * PARAMS
+ *  clsidOld [I] Class to get the TreatAs value of.
+ *  clsidNew [I] The class the clsidOld should be treated as.
+ *
+ * RETURNS
+ *  Success: S_OK.
+ *  Failure: HRESULT code.
+ *
+ * SEE ALSO
+ *  CoSetTreatAsClass
+ */
+HRESULT WINAPI CoGetTreatAsClass(REFCLSID clsidOld, LPCLSID clsidNew)
+{
+    struct class_reg_cache_entry *entry;
+    unsigned int generation;
+    BOOL use_cache;
+    HRESULT res;
+
+    TRACE("(%s,%p)\n", debugstr_guid(clsidOld), clsidNew);
+
+    EnterCriticalSection(&csClassRegCache);
+    use_cache = class_reg_cache_validate();
+    if (use_cache && (entry = class_reg_cache_find(clsidOld)) && entry->treatas_valid)
+    {
+        *clsidNew = entry->treatas;
+        res = entry->treatas_hr;
+        LeaveCriticalSection(&csClassRegCache);
+        return res;
+    }
+    generation = class_reg_cache_generation;
+    LeaveCriticalSection(&csClassRegCache);
+
+    res = read_treat_as_class(clsidOld, clsidNew);
+    if (!use_cache) return res;
+
+    EnterCriticalSection(&csClassRegCache);
+    if (generation == class_reg_cache_generation && (entry = class_reg_cache_get(clsidOld)))
+    {
+        entry->treatas = *clsidNew;
+        entry->treatas_hr = res;
+        entry->treatas_valid = TRUE;
+    }
+    LeaveCriticalSection(&csClassRegCache);
+    return res;
+}
+
 /******************************************************************************
  *		CoGetCurrentProcess	[OLE32.@]
  *
@@ -5013,31 +5304,22 @@ HRESULT WINAPI CoGetDefaultContext(APTTYPE type, REFIID riid, LPVOID *ppv)
 
 HRESULT Handler_DllGetClassObject(REFCLSID rclsid, REFIID riid, LPVOID *ppv)
 {
-    static const WCHAR wszInprocHandler32[] = {'I','n','p','r','o','c','H','a','n','d','l','e','r','3','2',0};
-    HKEY hkey;
+    struct class_reg_data regdata;
     HRESULT hres;
 
-    hres = COM_OpenKeyForCLSID(rclsid, wszInprocHandler32, KEY_READ, &hkey);
+    hres = get_class_reg_data(rclsid, TRUE, &regdata);
     if (SUCCEEDED(hres))
     {
-        struct class_reg_data regdata;
         WCHAR dllpath[MAX_PATH+1];
 
-        regdata.u.hkey = hkey;
-        regdata.hkey = TRUE;
-
         if (COM_RegReadPath(&regdata, dllpath, ARRAYSIZE(dllpath)) == ERROR_SUCCESS)
         {
             static const WCHAR wszOle32[] = {'o','l','e','3','2','.','d','l','l',0};
             if (!strcmpiW(dllpath, wszOle32))
-            {
-                RegCloseKey(hkey);
                 return HandlerCF_Create(rclsid, riid, ppv);
-            }
         }
         else
             WARN("not creating object for inproc handler path %s\n", debugstr_w(dllpath));
-        RegCloseKey(hkey);
     }
 
     return CLASS_E_CLASSNOTAVAILABLE;
@@ -5061,6 +5343,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID reserved)
         UnregisterClassW( wszAptWinClass, hProxyDll );
         RPC_UnregisterAllChannelHooks();
         COMPOBJ_DllList_Free();
+        class_reg_cache_free();
         DeleteCriticalSection(&csRegisteredClassList);
         DeleteCriticalSection(&csApartment);
 	break;
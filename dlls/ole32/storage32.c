@@ -358,6 +358,253 @@ static ULONGLONG StorageImpl_GetBigBlockOffset(StorageImpl* This, ULONG index)
     return (ULONGLONG)(index+1) * This->bigBlockSize;
 }
 
+/************************************************************************
+** Sector cache
+**
+** All reads and writes of a StorageImpl go through a cache of whole file
+** sectors, so the header, the depots and the data of every block chain
+** share it. Misses on consecutive sectors grow a read-ahead window, and
+** dirty sectors are written back in runs of adjacent sectors when the
+** storage is flushed or the cache needs room.
+*/
+
+static inline struct list *StorageImpl_SectorBucket(StorageImpl *This, ULONG sector)
+{
+    return &This->sectorHash[sector % SECTOR_CACHE_HASH_SIZE];
+}
+
+static SectorCacheEntry *StorageImpl_LookupSector(StorageImpl *This, ULONG sector)
+{
+    SectorCacheEntry *entry;
+
+    LIST_FOR_EACH_ENTRY(entry, StorageImpl_SectorBucket(This, sector), SectorCacheEntry, hash_entry)
+        if (entry->sector == sector) return entry;
+
+    return NULL;
+}
+
+static SectorCacheEntry *StorageImpl_FindSector(StorageImpl *This, ULONG sector)
+{
+    SectorCacheEntry *entry = StorageImpl_LookupSector(This, sector);
+
+    if (entry)
+    {
+        list_remove(&entry->entry);
+        list_add_head(&This->sectorLRU, &entry->entry);
+    }
+
+    return entry;
+}
+
+static void StorageImpl_FreeSector(StorageImpl *This, SectorCacheEntry *entry)
+{
+    list_remove(&entry->entry);
+    list_remove(&entry->hash_entry);
+    if (entry->dirty) This->dirtySectorCount--;
+    This->sectorCount--;
+    HeapFree(GetProcessHeap(), 0, entry);
+}
+
+static int sector_compare(const void *a, const void *b)
+{
+    const SectorCacheEntry *x = *(SectorCacheEntry* const*)a;
+    const SectorCacheEntry *y = *(SectorCacheEntry* const*)b;
+
+    if (x->sector < y->sector) return -1;
+    return x->sector > y->sector;
+}
+
+static HRESULT StorageImpl_WriteBackSectors(StorageImpl *This)
+{
+    SectorCacheEntry **dirty, *entry;
+    ULONG count = 0, run_max = 1, i, j, k;
+    BYTE *buffer;
+    HRESULT hr = S_OK;
+
+    if (!This->dirtySectorCount) return S_OK;
+
+    dirty = HeapAlloc(GetProcessHeap(), 0, This->dirtySectorCount * sizeof(*dirty));
+    if (!dirty) return E_OUTOFMEMORY;
+
+    LIST_FOR_EACH_ENTRY(entry, &This->sectorLRU, SectorCacheEntry, entry)
+        if (entry->dirty) dirty[count++] = entry;
+
+    qsort(dirty, count, sizeof(*dirty), sector_compare);
+
+    if ((buffer = HeapAlloc(GetProcessHeap(), 0, SECTOR_CACHE_IO_SIZE)))
+        run_max = SECTOR_CACHE_IO_SIZE / This->sectorSize;
+
+    TRACE("writing back %u sectors\n", count);
+
+    for (i = 0; SUCCEEDED(hr) && i < count; i = j)
+    {
+        ULARGE_INTEGER offset;
+        const BYTE *data;
+        ULONG size, written = 0;
+
+        /* gather a run of adjacent sectors into a single write */
+        for (j = i + 1; j < count && j - i < run_max; j++)
+            if (dirty[j]->sector != dirty[j-1]->sector + 1) break;
+
+        size = (j - i) * This->sectorSize;
+        if (j - i == 1)
+            data = dirty[i]->data;
+        else
+        {
+            for (k = i; k < j; k++)
+                memcpy(buffer + (k - i) * This->sectorSize, dirty[k]->data, This->sectorSize);
+            data = buffer;
+        }
+
+        offset.QuadPart = (ULONGLONG)dirty[i]->sector * This->sectorSize;
+        hr = ILockBytes_WriteAt(This->lockBytes, offset, data, size, &written);
+        if (SUCCEEDED(hr) && written != size)
+            hr = STG_E_WRITEFAULT;
+
+        if (SUCCEEDED(hr))
+        {
+            for (k = i; k < j; k++)
+                dirty[k]->dirty = FALSE;
+            This->dirtySectorCount -= j - i;
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, buffer);
+    HeapFree(GetProcessHeap(), 0, dirty);
+    return hr;
+}
+
+/* Returns a new, unfilled sector entry, evicting the least recently used one if needed. */
+static SectorCacheEntry *StorageImpl_AllocSector(StorageImpl *This, ULONG sector)
+{
+    SectorCacheEntry *entry;
+
+    if (This->sectorCount >= This->sectorCacheMax)
+    {
+        entry = LIST_ENTRY(list_tail(&This->sectorLRU), SectorCacheEntry, entry);
+        if (entry->dirty && FAILED(StorageImpl_WriteBackSectors(This)))
+            return NULL;
+
+        list_remove(&entry->entry);
+        list_remove(&entry->hash_entry);
+        This->sectorCount--;
+    }
+    else if (!(entry = HeapAlloc(GetProcessHeap(), 0,
+                                 FIELD_OFFSET(SectorCacheEntry, data[This->sectorSize]))))
+        return NULL;
+
+    entry->sector = sector;
+    entry->dirty = FALSE;
+    list_add_head(&This->sectorLRU, &entry->entry);
+    list_add_head(StorageImpl_SectorBucket(This, sector), &entry->hash_entry);
+    This->sectorCount++;
+
+    return entry;
+}
+
+/* Reads a sector that is not cached, and the ones after it if the previous
+ * misses were sequential. Returns NULL if the sector can't be cached, for
+ * example because it is not complete. */
+static SectorCacheEntry *StorageImpl_LoadSector(StorageImpl *This, ULONG sector)
+{
+    SectorCacheEntry *entry, *result = NULL;
+    ULONG lock_sector = RANGELOCK_FIRST / This->sectorSize;
+    ULARGE_INTEGER offset;
+    ULONG count, read = 0, i;
+    HRESULT hr;
+
+    if (sector == This->nextSequentialSector)
+        This->readAheadCount = min(This->readAheadCount * 2, SECTOR_CACHE_IO_SIZE / This->sectorSize);
+    else
+        This->readAheadCount = 1;
+
+    count = This->readAheadCount;
+
+    /* only complete sectors are cached, and reading past the end of the
+     * file fails, so stop at the last complete one */
+    if ((ULONGLONG)sector >= This->fileSize / This->sectorSize)
+        return NULL;
+    count = min(count, This->fileSize / This->sectorSize - sector);
+
+    /* don't read into the range locks of a big file ahead of time */
+    if (sector < lock_sector && sector + count > lock_sector)
+        count = lock_sector - sector;
+
+    /* sectors in the range may get evicted while the others are added,
+     * so the file has to be up to date for all of them */
+    for (i = 1; i < count; i++)
+    {
+        if ((entry = StorageImpl_LookupSector(This, sector + i)) && entry->dirty)
+        {
+            if (FAILED(StorageImpl_WriteBackSectors(This))) count = 1;
+            break;
+        }
+    }
+
+    offset.QuadPart = (ULONGLONG)sector * This->sectorSize;
+    hr = ILockBytes_ReadAt(This->lockBytes, offset, This->readAheadBuffer, count * This->sectorSize, &read);
+    if (FAILED(hr))
+    {
+        /* let the caller read the sector itself so that it gets the error */
+        WARN("failed to read sectors %u-%u, hr %#x\n", sector, sector + count - 1, hr);
+        This->nextSequentialSector = 0xFFFFFFFF;
+        This->readAheadCount = 1;
+        return NULL;
+    }
+
+    This->nextSequentialSector = sector + count;
+
+    for (i = 0; i < read / This->sectorSize; i++)
+    {
+        /* a cached sector may be more recent than the file */
+        if (i && StorageImpl_LookupSector(This, sector + i)) continue;
+
+        if (!(entry = StorageImpl_AllocSector(This, sector + i))) break;
+        memcpy(entry->data, This->readAheadBuffer + i * This->sectorSize, This->sectorSize);
+        if (!i) result = entry;
+    }
+
+    return result;
+}
+
+static void StorageImpl_DiscardSectors(StorageImpl *This)
+{
+    SectorCacheEntry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &This->sectorLRU, SectorCacheEntry, entry)
+        StorageImpl_FreeSector(This, entry);
+}
+
+/* Enables the cache once the sector size is known. */
+static void StorageImpl_EnableSectorCache(StorageImpl *This)
+{
+    STATSTG statstg;
+
+    if (!This->readAheadBuffer &&
+        !(This->readAheadBuffer = HeapAlloc(GetProcessHeap(), 0, SECTOR_CACHE_IO_SIZE)))
+        return;
+
+    if (FAILED(ILockBytes_Stat(This->lockBytes, &statstg, STATFLAG_NONAME)))
+        return;
+
+    This->fileSize = statstg.cbSize.QuadPart;
+    This->sectorSize = This->bigBlockSize;
+    This->sectorCacheMax = SECTOR_CACHE_SIZE / This->sectorSize;
+    This->nextSequentialSector = 0xFFFFFFFF;
+    This->readAheadCount = 1;
+}
+
+static void StorageImpl_DisableSectorCache(StorageImpl *This)
+{
+    if (!This->sectorSize) return;
+
+    if (FAILED(StorageImpl_WriteBackSectors(This)))
+        WARN("failed to write back cached sectors\n");
+
+    StorageImpl_DiscardSectors(This);
+    This->sectorSize = 0;
+}
+
 /************************************************************************
 ** Storage32BaseImpl implementation
 */
@@ -367,7 +614,41 @@ static HRESULT StorageImpl_ReadAt(StorageImpl* This,
   ULONG          size,
   ULONG*         bytesRead)
 {
-    return ILockBytes_ReadAt(This->lockBytes,offset,buffer,size,bytesRead);
+    SectorCacheEntry *entry;
+    BYTE *dst = buffer;
+    ULONG total = 0;
+    HRESULT hr = S_OK;
+
+    if (!This->sectorSize)
+        return ILockBytes_ReadAt(This->lockBytes,offset,buffer,size,bytesRead);
+
+    while (size)
+    {
+        ULONG sector = offset.QuadPart / This->sectorSize;
+        ULONG offset_in_sector = offset.QuadPart % This->sectorSize;
+        ULONG count = min(size, This->sectorSize - offset_in_sector);
+
+        if ((entry = StorageImpl_FindSector(This, sector)) ||
+            (entry = StorageImpl_LoadSector(This, sector)))
+            memcpy(dst, entry->data + offset_in_sector, count);
+        else
+        {
+            ULONG read = 0;
+
+            /* the end of the file or an error, read it as is */
+            hr = ILockBytes_ReadAt(This->lockBytes, offset, dst, count, &read);
+            total += read;
+            if (FAILED(hr) || read < count) break;
+        }
+
+        if (entry) total += count;
+        dst += count;
+        offset.QuadPart += count;
+        size -= count;
+    }
+
+    if (bytesRead) *bytesRead = total;
+    return hr;
 }
 
 static HRESULT StorageImpl_WriteAt(StorageImpl* This,
@@ -376,7 +657,75 @@ static HRESULT StorageImpl_WriteAt(StorageImpl* This,
   const ULONG    size,
   ULONG*         bytesWritten)
 {
-    return ILockBytes_WriteAt(This->lockBytes,offset,buffer,size,bytesWritten);
+    SectorCacheEntry *entry;
+    const BYTE *src = buffer;
+    ULONG left = size, total = 0;
+    HRESULT hr = S_OK;
+
+    if (!This->sectorSize)
+        return ILockBytes_WriteAt(This->lockBytes,offset,buffer,size,bytesWritten);
+
+    while (left)
+    {
+        ULONG sector = offset.QuadPart / This->sectorSize;
+        ULONG offset_in_sector = offset.QuadPart % This->sectorSize;
+        ULONG count = min(left, This->sectorSize - offset_in_sector);
+
+        /* complete sectors inside the file are written back later, so the
+         * file size never depends on the contents of the cache */
+        if (!(entry = StorageImpl_FindSector(This, sector)) &&
+            count == This->sectorSize && offset.QuadPart + count <= This->fileSize)
+            entry = StorageImpl_AllocSector(This, sector);
+
+        if (entry)
+        {
+            memcpy(entry->data + offset_in_sector, src, count);
+            if (!entry->dirty)
+            {
+                entry->dirty = TRUE;
+                This->dirtySectorCount++;
+            }
+            total += count;
+        }
+        else
+        {
+            ULONG written = 0;
+
+            hr = ILockBytes_WriteAt(This->lockBytes, offset, src, count, &written);
+            total += written;
+            This->fileSize = max(This->fileSize, offset.QuadPart + written);
+            if (FAILED(hr) || written < count) break;
+        }
+
+        src += count;
+        offset.QuadPart += count;
+        left -= count;
+    }
+
+    if (bytesWritten) *bytesWritten = total;
+    return hr;
+}
+
+static HRESULT StorageImpl_SetSize(StorageImpl* This, ULARGE_INTEGER size)
+{
+    HRESULT hr;
+
+    if (This->sectorSize && size.QuadPart < This->fileSize)
+    {
+        SectorCacheEntry *entry, *next;
+
+        hr = StorageImpl_WriteBackSectors(This);
+        if (FAILED(hr)) return hr;
+
+        LIST_FOR_EACH_ENTRY_SAFE(entry, next, &This->sectorLRU, SectorCacheEntry, entry)
+            if ((ULONGLONG)(entry->sector + 1) * This->sectorSize > size.QuadPart)
+                StorageImpl_FreeSector(This, entry);
+    }
+
+    hr = ILockBytes_SetSize(This->lockBytes, size);
+    if (SUCCEEDED(hr)) This->fileSize = size.QuadPart;
+
+    return hr;
 }
 
 /************************************************************************
@@ -2676,7 +3025,11 @@ static HRESULT StorageImpl_GetTransactionSig(StorageBaseImpl *base,
 
     offset.u.HighPart = 0;
     offset.u.LowPart = OFFSET_TRANSACTIONSIG;
-    hr = StorageImpl_ReadAt(This, offset, data, 4, &bytes_read);
+
+    /* Bypass the sector cache, it can't know about other writers. */
+    hr = StorageImpl_WriteBackSectors(This);
+    if (SUCCEEDED(hr))
+      hr = ILockBytes_ReadAt(This->lockBytes, offset, data, 4, &bytes_read);
 
     if (SUCCEEDED(hr))
     {
@@ -3021,6 +3374,9 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
   DirRef      currentEntryRef;
   BlockChainStream *blockChainStream;
 
+  /* The sector size may change and anything cached may be stale. */
+  StorageImpl_DisableSectorCache(This);
+
   if (create)
   {
     ULARGE_INTEGER size;
@@ -3028,7 +3384,7 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
 
     /* Discard any existing data. */
     size.QuadPart = 0;
-    ILockBytes_SetSize(This->lockBytes, size);
+    StorageImpl_SetSize(This, size);
 
     /*
      * Initialize all header variables:
@@ -3060,7 +3416,7 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
      */
     size.u.HighPart = 0;
     size.u.LowPart  = This->bigBlockSize * 3;
-    ILockBytes_SetSize(This->lockBytes, size);
+    StorageImpl_SetSize(This, size);
 
     /*
      * Initialize the big block depot
@@ -3083,6 +3439,8 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
     }
   }
 
+  StorageImpl_EnableSectorCache(This);
+
   /*
    * There is no block depot cached yet.
    */
@@ -3241,6 +3599,7 @@ static HRESULT StorageImpl_Construct(
 {
   StorageImpl* This;
   HRESULT     hr = S_OK;
+  int         i;
 
   if ( FAILED( validateSTGM(openFlags) ))
     return STG_E_INVALIDFLAG;
@@ -3253,6 +3612,10 @@ static HRESULT StorageImpl_Construct(
 
   list_init(&This->base.strmHead);
 
+  list_init(&This->sectorLRU);
+  for (i=0; i<SECTOR_CACHE_HASH_SIZE; i++)
+    list_init(&This->sectorHash[i]);
+
   list_init(&This->base.storageHead);
 
   This->base.IStorage_iface.lpVtbl = &Storage32Impl_Vtbl;
@@ -3333,6 +3696,9 @@ static void StorageImpl_Destroy(StorageBaseImpl* iface)
   for (i=0; i<BLOCKCHAIN_CACHE_SIZE; i++)
     BlockChainStream_Destroy(This->blockChainCache[i]);
 
+  StorageImpl_DisableSectorCache(This);
+  HeapFree(GetProcessHeap(), 0, This->readAheadBuffer);
+
   for (i=0; i<sizeof(This->locked_bytes)/sizeof(This->locked_bytes[0]); i++)
   {
     ULARGE_INTEGER offset, cb;
@@ -3368,6 +3734,9 @@ static HRESULT StorageImpl_Flush(StorageBaseImpl *storage)
     if (This->blockChainCache[i])
       hr = BlockChainStream_Flush(This->blockChainCache[i]);
 
+  if (SUCCEEDED(hr))
+    hr = StorageImpl_WriteBackSectors(This);
+
   if (SUCCEEDED(hr))
     hr = ILockBytes_Flush(This->lockBytes);
 
@@ -3512,7 +3881,7 @@ static ULONG StorageImpl_GetNextFreeBigBlock(
   ILockBytes_Stat(This->lockBytes, &statstg, STATFLAG_NONAME);
 
   if (neededSize.QuadPart > statstg.cbSize.QuadPart)
-    ILockBytes_SetSize(This->lockBytes, neededSize);
+    StorageImpl_SetSize(This, neededSize);
 
   This->prevFreeBlock = freeBlock;
 
@@ -364,6 +364,27 @@ void StorageBaseImpl_RemoveStream(StorageBaseImpl * stg, StgStreamImpl * strm) D
 /* Number of BlockChainStream objects to cache in a StorageImpl */
 #define BLOCKCHAIN_CACHE_SIZE 4
 
+/* Number of bytes of file sectors to cache in a StorageImpl */
+#define SECTOR_CACHE_SIZE 0x100000
+
+/* Largest single read-ahead or write-back request, in bytes */
+#define SECTOR_CACHE_IO_SIZE 0x10000
+
+#define SECTOR_CACHE_HASH_SIZE 256
+
+/*
+ * A cached sector of the file. Sector 0 holds the header, sector n holds
+ * big block n-1. Only complete sectors are cached.
+ */
+typedef struct SectorCacheEntry
+{
+  struct list entry;      /* in the LRU list */
+  struct list hash_entry; /* in the hash bucket */
+  ULONG sector;
+  BOOL  dirty;
+  BYTE  data[1];
+} SectorCacheEntry;
+
 /****************************************************************************
  * Storage32Impl definitions.
  *
@@ -416,6 +437,18 @@ struct StorageImpl
   ILockBytes* lockBytes;
 
   ULONG locked_bytes[8];
+
+  /* Cache of file sectors shared by all block chains, disabled while sectorSize is 0 */
+  ULONG sectorSize;
+  ULONG sectorCount;
+  ULONG sectorCacheMax;
+  ULONG dirtySectorCount;
+  struct list sectorLRU;
+  struct list sectorHash[SECTOR_CACHE_HASH_SIZE];
+  ULONG nextSequentialSector;
+  ULONG readAheadCount;
+  ULONGLONG fileSize;
+  BYTE *readAheadBuffer;
 };
 
 HRESULT StorageImpl_ReadRawDirEntry(
@@ -31,6 +31,7 @@
 #include "objbase.h"
 #include "shlguid.h"
 #include "urlmon.h" /* for CLSID_FileProtocol */
+#include "comcat.h" /* for CLSID_StdComponentCategoriesMgr */
 #include "dde.h"
 
 #include "ctxtcall.h"
@@ -2018,6 +2019,68 @@ exit:
     RegCloseKey(clsidkey);
 }
 
+static void test_class_registration_changes(void)
+{
+    static const CLSID CLSID_reg_test = {0xdeadbeef,0xdead,0xbeef,{0xde,0xad,0xbe,0xef,0x00,0x00,0x00,0x01}};
+    static const char reg_testA[] = "CLSID\\{DEADBEEF-DEAD-BEEF-DEAD-BEEF00000001}";
+    IUnknown *unk;
+    HKEY hkey, inproc;
+    DWORD start, i;
+    HRESULT hr;
+    LONG res;
+
+    pCoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+
+    hr = CoGetClassObject(&CLSID_reg_test, CLSCTX_INPROC_SERVER, NULL, &IID_IClassFactory, (void **)&unk);
+    ok(hr == REGDB_E_CLASSNOTREG, "got 0x%08x\n", hr);
+
+    res = RegCreateKeyExA(HKEY_CLASSES_ROOT, reg_testA, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &hkey, NULL);
+    if (res == ERROR_ACCESS_DENIED)
+    {
+        skip("Not authorized to modify the Classes key\n");
+        CoUninitialize();
+        return;
+    }
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+
+    res = RegCreateKeyExA(hkey, "InprocServer32", 0, NULL, 0, KEY_ALL_ACCESS, NULL, &inproc, NULL);
+    ok(!res, "RegCreateKeyEx returned %d\n", res);
+
+    /* no dll path yet */
+    hr = CoGetClassObject(&CLSID_reg_test, CLSCTX_INPROC_SERVER, NULL, &IID_IClassFactory, (void **)&unk);
+    ok(hr == REGDB_E_CLASSNOTREG, "got 0x%08x\n", hr);
+
+    /* setting a value of a subkey has to be noticed right away */
+    res = RegSetValueExA(inproc, NULL, 0, REG_SZ, (const BYTE *)"ole32.dll", sizeof("ole32.dll"));
+    ok(!res, "RegSetValueEx returned %d\n", res);
+
+    hr = CoGetClassObject(&CLSID_reg_test, CLSCTX_INPROC_SERVER, NULL, &IID_IClassFactory, (void **)&unk);
+    ok(hr == CLASS_E_CLASSNOTAVAILABLE, "got 0x%08x\n", hr);
+
+    RegCloseKey(inproc);
+    res = RegDeleteKeyA(hkey, "InprocServer32");
+    ok(!res, "RegDeleteKey returned %d\n", res);
+    RegCloseKey(hkey);
+    res = RegDeleteKeyA(HKEY_CLASSES_ROOT, reg_testA);
+    ok(!res, "RegDeleteKey returned %d\n", res);
+
+    hr = CoGetClassObject(&CLSID_reg_test, CLSCTX_INPROC_SERVER, NULL, &IID_IClassFactory, (void **)&unk);
+    ok(hr == REGDB_E_CLASSNOTREG, "got 0x%08x\n", hr);
+
+    /* repeated lookups of the same class */
+    start = GetTickCount();
+    for (i = 0; i < 1000; i++)
+    {
+        hr = CoCreateInstance(&CLSID_StdComponentCategoriesMgr, NULL, CLSCTX_INPROC_SERVER, &IID_IUnknown, (void **)&unk);
+        if (hr != S_OK) break;
+        IUnknown_Release(unk);
+    }
+    ok(hr == S_OK, "CoCreateInstance failed: %08x\n", hr);
+    trace("%u CoCreateInstance calls took %u ms\n", i, GetTickCount() - start);
+
+    CoUninitialize();
+}
+
 static void test_CoInitializeEx(void)
 {
     HRESULT hr;
@@ -2342,6 +2405,7 @@ START_TEST(compobj)
     test_CoGetCallContext();
     test_CoGetContextToken();
     test_TreatAsClass();
+    test_class_registration_changes();
     test_CoInitializeEx();
     test_OleRegGetMiscStatus();
     test_CoCreateGuid();
@@ -3642,6 +3642,114 @@ static void test_overwrite(void)
     DeleteFileA(filenameA);
 }
 
+static void fill_test_data(BYTE *buffer, ULONG size, ULONG pos, BYTE seed)
+{
+    ULONG i;
+
+    for (i = 0; i < size; i++)
+        buffer[i] = (BYTE)(((pos + i) * 7) ^ ((pos + i) >> 9) ^ seed);
+}
+
+static void test_large_streams(void)
+{
+    static const WCHAR stmnames[2][5] = {{'S','t','m','A',0}, {'S','t','m','B',0}};
+    static const ULONG stream_size = 0x400000, chunk_size = 0x1000;
+    IStorage *stg = NULL;
+    IStream *stm[2] = {NULL, NULL};
+    BYTE *buffer, *expected;
+    LARGE_INTEGER pos;
+    DWORD start, elapsed;
+    ULONG offset, count;
+    HRESULT r;
+    int i;
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, chunk_size);
+    expected = HeapAlloc(GetProcessHeap(), 0, chunk_size);
+
+    DeleteFileA(filenameA);
+
+    r = StgCreateDocfile(filename, STGM_CREATE | STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, &stg);
+    ok(r == S_OK, "StgCreateDocfile failed, hr %08x\n", r);
+    if (r != S_OK) goto done;
+
+    for (i = 0; i < 2; i++)
+    {
+        r = IStorage_CreateStream(stg, stmnames[i], STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &stm[i]);
+        ok(r == S_OK, "IStorage_CreateStream failed, hr %08x\n", r);
+    }
+
+    /* interleave the writes so that the block chains are fragmented */
+    start = GetTickCount();
+    for (offset = 0; offset < stream_size; offset += chunk_size)
+    {
+        for (i = 0; i < 2; i++)
+        {
+            fill_test_data(buffer, chunk_size, offset, i);
+            r = IStream_Write(stm[i], buffer, chunk_size, &count);
+            if (r != S_OK || count != chunk_size) break;
+        }
+        if (i < 2) break;
+    }
+    ok(r == S_OK, "IStream_Write failed, hr %08x\n", r);
+    ok(offset == stream_size, "wrote %u bytes\n", offset);
+
+    for (i = 0; i < 2; i++)
+        IStream_Release(stm[i]);
+    IStorage_Release(stg);
+    elapsed = GetTickCount() - start;
+    trace("wrote 2x%u KB in %u ms\n", stream_size / 1024, elapsed);
+
+    r = StgOpenStorage(filename, NULL, STGM_SHARE_DENY_WRITE | STGM_READ, NULL, 0, &stg);
+    ok(r == S_OK, "StgOpenStorage failed, hr %08x\n", r);
+    if (r != S_OK) goto done;
+
+    for (i = 0; i < 2; i++)
+    {
+        r = IStorage_OpenStream(stg, stmnames[i], NULL, STGM_SHARE_EXCLUSIVE | STGM_READ, 0, &stm[i]);
+        ok(r == S_OK, "IStorage_OpenStream failed, hr %08x\n", r);
+    }
+
+    /* read each stream sequentially */
+    start = GetTickCount();
+    for (i = 0; i < 2; i++)
+    {
+        for (offset = 0; offset < stream_size; offset += count)
+        {
+            r = IStream_Read(stm[i], buffer, chunk_size, &count);
+            if (r != S_OK || count != chunk_size) break;
+            fill_test_data(expected, chunk_size, offset, i);
+            if (memcmp(buffer, expected, chunk_size)) break;
+        }
+        ok(offset == stream_size, "stream %d: data mismatch at %u, hr %08x\n", i, offset, r);
+    }
+    elapsed = GetTickCount() - start;
+    trace("read 2x%u KB in %u ms\n", stream_size / 1024, elapsed);
+
+    /* small reads at scattered offsets */
+    start = GetTickCount();
+    for (offset = 0; offset < stream_size; offset += 0x10000 + 0x123)
+    {
+        pos.QuadPart = offset;
+        r = IStream_Seek(stm[1], pos, STREAM_SEEK_SET, NULL);
+        ok(r == S_OK, "IStream_Seek failed, hr %08x\n", r);
+        r = IStream_Read(stm[1], buffer, 16, &count);
+        ok(r == S_OK && count == 16, "IStream_Read failed, hr %08x, count %u\n", r, count);
+        fill_test_data(expected, 16, offset, 1);
+        if (memcmp(buffer, expected, 16)) break;
+    }
+    ok(offset >= stream_size, "data mismatch at %u\n", offset);
+    trace("scattered reads took %u ms\n", GetTickCount() - start);
+
+    for (i = 0; i < 2; i++)
+        if (stm[i]) IStream_Release(stm[i]);
+    IStorage_Release(stg);
+
+done:
+    DeleteFileA(filenameA);
+    HeapFree(GetProcessHeap(), 0, buffer);
+    HeapFree(GetProcessHeap(), 0, expected);
+}
+
 START_TEST(storage32)
 {
     CHAR temp[MAX_PATH];
@@ -3690,4 +3798,5 @@ START_TEST(storage32)
     test_locking();
     test_transacted_shared();
     test_overwrite();
+    test_large_streams();
 }
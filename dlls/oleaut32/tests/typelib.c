@@ -32,6 +32,7 @@
 #include "oleauto.h"
 #include "ocidl.h"
 #include "shlwapi.h"
+#include "psapi.h"
 #include "tmarshal.h"
 
 #include "test_reg.h"
@@ -76,6 +77,7 @@ static BOOL   (WINAPI *pDeactivateActCtx)(DWORD,ULONG_PTR);
 static VOID   (WINAPI *pReleaseActCtx)(HANDLE);
 static BOOL   (WINAPI *pIsWow64Process)(HANDLE,LPBOOL);
 static LONG   (WINAPI *pRegDeleteKeyExW)(HKEY,LPCWSTR,REGSAM,DWORD);
+static BOOL   (WINAPI *pK32GetProcessMemoryInfo)(HANDLE,PPROCESS_MEMORY_COUNTERS,DWORD);
 
 static const WCHAR wszStdOle2[] = {'s','t','d','o','l','e','2','.','t','l','b',0};
 static WCHAR wszGUID[] = {'G','U','I','D',0};
@@ -176,6 +178,7 @@ static void init_function_pointers(void)
     pDeactivateActCtx = (void *)GetProcAddress(hk32, "DeactivateActCtx");
     pReleaseActCtx = (void *)GetProcAddress(hk32, "ReleaseActCtx");
     pIsWow64Process = (void *)GetProcAddress(hk32, "IsWow64Process");
+    pK32GetProcessMemoryInfo = (void *)GetProcAddress(hk32, "K32GetProcessMemoryInfo");
     pRegDeleteKeyExW = (void*)GetProcAddress(hadv, "RegDeleteKeyExW");
 }
 
@@ -4376,6 +4379,106 @@ static void test_LoadTypeLib(void)
     ok(hres == TYPE_E_CANTLOADLIBRARY, "LoadTypeLib returned: %08x, expected TYPE_E_CANTLOADLIBRARY\n", hres);
 }
 
+static void test_LoadTypeLib_perf(void)
+{
+    PROCESS_MEMORY_COUNTERS before, after;
+    LARGE_INTEGER freq, start, end;
+    ITypeLib *tl;
+    HRESULT hres;
+    int i;
+
+    if (!pK32GetProcessMemoryInfo)
+        memset(&before, 0, sizeof(before));
+    else
+        pK32GetProcessMemoryInfo(GetCurrentProcess(), &before, sizeof(before));
+
+    /* the library is freed on the last release, so every iteration loads it again */
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 100; i++)
+    {
+        hres = LoadTypeLib(wszStdOle2, &tl);
+        ok(hres == S_OK, "LoadTypeLib returned %08x\n", hres);
+        if (FAILED(hres)) return;
+        ITypeLib_Release(tl);
+    }
+    QueryPerformanceCounter(&end);
+
+    hres = LoadTypeLib(wszStdOle2, &tl);
+    ok(hres == S_OK, "LoadTypeLib returned %08x\n", hres);
+    if (pK32GetProcessMemoryInfo)
+    {
+        pK32GetProcessMemoryInfo(GetCurrentProcess(), &after, sizeof(after));
+        trace("LoadTypeLib: %u us per load, working set grew by %ld KiB\n",
+              (UINT)((end.QuadPart - start.QuadPart) * 10000 / freq.QuadPart),
+              ((LONG_PTR)after.WorkingSetSize - (LONG_PTR)before.WorkingSetSize) / 1024);
+    }
+    else
+        trace("LoadTypeLib: %u us per load\n",
+              (UINT)((end.QuadPart - start.QuadPart) * 10000 / freq.QuadPart));
+    ITypeLib_Release(tl);
+}
+
+static void test_dual_members(void)
+{
+    static WCHAR testW[] = {'t','e','s','t',0};
+    ITypeInfo *typeinfo, *dual_info, *other;
+    LPOLESTR name = testW;
+    WCHAR filename[MAX_PATH];
+    const char *filenameA;
+    FUNCDESC *funcdesc;
+    ITypeLib *typelib;
+    TYPEATTR *attr;
+    MEMBERID memid;
+    HRESULT hr;
+
+    filenameA = create_test_typelib(3);
+    MultiByteToWideChar(CP_ACP, 0, filenameA, -1, filename, MAX_PATH);
+
+    hr = LoadTypeLib(filename, &typelib);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = ITypeLib_GetTypeInfoOfGuid(typelib, &IID_Iole_dual_from_disp, &typeinfo);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    /* ask for the other half of the dual interface before touching any member */
+    hr = ITypeInfo_GetRefTypeInfo(typeinfo, -1, &dual_info);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = ITypeInfo_GetTypeAttr(dual_info, &attr);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(attr->typekind == TKIND_INTERFACE, "got kind %d\n", attr->typekind);
+    ok(attr->cFuncs == 1, "got %d functions\n", attr->cFuncs);
+    ITypeInfo_ReleaseTypeAttr(dual_info, attr);
+
+    hr = ITypeInfo_GetIDsOfNames(dual_info, &name, 1, &memid);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = ITypeInfo_GetFuncDesc(dual_info, 0, &funcdesc);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(funcdesc->memid == memid, "got memid %x, expected %x\n", funcdesc->memid, memid);
+    ITypeInfo_ReleaseFuncDesc(dual_info, funcdesc);
+    ITypeInfo_Release(dual_info);
+
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, &name, 1, &memid);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = ITypeInfo_GetFuncDesc(typeinfo, 0, &funcdesc);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ITypeInfo_ReleaseFuncDesc(typeinfo, funcdesc);
+
+    /* the other type infos must still be readable from the image */
+    hr = ITypeLib_GetTypeInfoOfGuid(typelib, &IID_IInvokeTest, &other);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = ITypeInfo_GetFuncDesc(other, 0, &funcdesc);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(funcdesc->memid == DISPID_VALUE, "got memid %x\n", funcdesc->memid);
+    ITypeInfo_ReleaseFuncDesc(other, funcdesc);
+    ITypeInfo_Release(other);
+
+    ITypeInfo_Release(typeinfo);
+    ITypeLib_Release(typelib);
+    DeleteFileA(filenameA);
+}
+
 static void test_SetVarHelpContext(void)
 {
     static OLECHAR nameW[] = {'n','a','m','e',0};
@@ -4592,6 +4695,140 @@ static void test_SetFuncAndParamNames(void)
     DeleteFileA(filenameA);
 }
 
+static void test_member_lookup(void)
+{
+    static OLECHAR nameW[] = {'n','a','m','e',0};
+    static OLECHAR propW[] = {'p','r','o','p',0};
+    static OLECHAR addedW[] = {'a','d','d','e','d',0};
+    static OLECHAR func17W[] = {'F','U','N','C','1','7',0};
+    static OLECHAR unknownW[] = {'u','n','k','n','o','w','n',0};
+    static const WCHAR func5W[] = {'f','u','n','c','5',0};
+    WCHAR buf[16];
+    OLECHAR *names[1];
+    ICreateTypeLib2 *ctl;
+    ICreateTypeInfo *cti;
+    ITypeInfo *ti, *bound_ti;
+    ITypeComp *tcomp;
+    FUNCDESC funcdesc;
+    ELEMDESC edesc;
+    DESCKIND desckind;
+    BINDPTR bindptr;
+    MEMBERID memid;
+    BSTR bstr;
+    UINT count, i;
+    HRESULT hr;
+
+    hr = CreateTypeLib2(SYS_WIN32, nameW, &ctl);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = ICreateTypeLib2_CreateTypeInfo(ctl, nameW, TKIND_DISPATCH, &cti);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    memset(&funcdesc, 0, sizeof(funcdesc));
+    funcdesc.funckind = FUNC_DISPATCH;
+    funcdesc.callconv = CC_STDCALL;
+    funcdesc.invkind = INVOKE_FUNC;
+    funcdesc.elemdescFunc.tdesc.vt = VT_VOID;
+
+    /* enough members for lookups to go through the hash index */
+    for(i = 0; i < 24; i++) {
+        static const WCHAR fmtW[] = {'f','u','n','c','%','u',0};
+
+        funcdesc.memid = 0x100 + i;
+        hr = ICreateTypeInfo_AddFuncDesc(cti, i, &funcdesc);
+        ok(hr == S_OK, "got %08x\n", hr);
+
+        wsprintfW(buf, fmtW, i);
+        names[0] = buf;
+        hr = ICreateTypeInfo_SetFuncAndParamNames(cti, i, names, 1);
+        ok(hr == S_OK, "got %08x\n", hr);
+    }
+
+    hr = ICreateTypeInfo_QueryInterface(cti, &IID_ITypeInfo, (void**)&ti);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    names[0] = func17W;
+    memid = 0xdeadbeef;
+    hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(memid == 0x117, "got memid %x\n", memid);
+
+    names[0] = unknownW;
+    hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+    ok(hr == DISP_E_UNKNOWNNAME, "got %08x\n", hr);
+
+    count = 0;
+    hr = ITypeInfo_GetNames(ti, 0x105, &bstr, 1, &count);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(count == 1, "got %u\n", count);
+    ok(!lstrcmpW(bstr, func5W), "got %s\n", wine_dbgstr_w(bstr));
+    SysFreeString(bstr);
+
+    /* members added after a lookup are found as well */
+    funcdesc.memid = 0x200;
+    hr = ICreateTypeInfo_AddFuncDesc(cti, 24, &funcdesc);
+    ok(hr == S_OK, "got %08x\n", hr);
+    names[0] = addedW;
+    hr = ICreateTypeInfo_SetFuncAndParamNames(cti, 24, names, 1);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    memid = 0xdeadbeef;
+    hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(memid == 0x200, "got memid %x\n", memid);
+
+    /* property accessors share both memid and name */
+    memset(&edesc, 0, sizeof(edesc));
+    edesc.tdesc.vt = VT_BSTR;
+    U(edesc).idldesc.wIDLFlags = IDLFLAG_FIN;
+
+    funcdesc.memid = 0x300;
+    funcdesc.invkind = INVOKE_PROPERTYPUT;
+    funcdesc.cParams = 1;
+    funcdesc.lprgelemdescParam = &edesc;
+    hr = ICreateTypeInfo_AddFuncDesc(cti, 25, &funcdesc);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    funcdesc.invkind = INVOKE_PROPERTYGET;
+    funcdesc.cParams = 0;
+    funcdesc.lprgelemdescParam = NULL;
+    hr = ICreateTypeInfo_AddFuncDesc(cti, 26, &funcdesc);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    names[0] = propW;
+    hr = ICreateTypeInfo_SetFuncAndParamNames(cti, 25, names, 1);
+    ok(hr == S_OK, "got %08x\n", hr);
+    hr = ICreateTypeInfo_SetFuncAndParamNames(cti, 26, names, 1);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = ITypeInfo_GetTypeComp(ti, &tcomp);
+    ok(hr == S_OK, "got %08x\n", hr);
+
+    hr = ITypeComp_Bind(tcomp, propW, 0, INVOKE_PROPERTYGET, &bound_ti, &desckind, &bindptr);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(desckind == DESCKIND_FUNCDESC, "got desckind %d\n", desckind);
+    ok(bindptr.lpfuncdesc->memid == 0x300, "got memid %x\n", bindptr.lpfuncdesc->memid);
+    ok(bindptr.lpfuncdesc->invkind == INVOKE_PROPERTYGET, "got invkind %d\n", bindptr.lpfuncdesc->invkind);
+    ITypeInfo_ReleaseFuncDesc(bound_ti, bindptr.lpfuncdesc);
+    ITypeInfo_Release(bound_ti);
+
+    hr = ITypeComp_Bind(tcomp, propW, 0, INVOKE_PROPERTYPUT, &bound_ti, &desckind, &bindptr);
+    ok(hr == S_OK, "got %08x\n", hr);
+    ok(desckind == DESCKIND_FUNCDESC, "got desckind %d\n", desckind);
+    ok(bindptr.lpfuncdesc->invkind == INVOKE_PROPERTYPUT, "got invkind %d\n", bindptr.lpfuncdesc->invkind);
+    ITypeInfo_ReleaseFuncDesc(bound_ti, bindptr.lpfuncdesc);
+    ITypeInfo_Release(bound_ti);
+
+    hr = ITypeComp_Bind(tcomp, func17W, 0, INVOKE_PROPERTYGET, &bound_ti, &desckind, &bindptr);
+    ok(hr == TYPE_E_TYPEMISMATCH, "got %08x\n", hr);
+    ok(desckind == DESCKIND_NONE, "got desckind %d\n", desckind);
+
+    ITypeComp_Release(tcomp);
+    ITypeInfo_Release(ti);
+    ICreateTypeInfo_Release(cti);
+    ICreateTypeLib2_Release(ctl);
+}
+
 static void test_SetDocString(void)
 {
     static OLECHAR nameW[] = {'n','a','m','e',0};
@@ -5626,6 +5863,7 @@ START_TEST(typelib)
     test_inheritance();
     test_SetVarHelpContext();
     test_SetFuncAndParamNames();
+    test_member_lookup();
     test_SetDocString();
     test_FindName();
 
@@ -5639,6 +5877,8 @@ START_TEST(typelib)
     test_register_typelib(FALSE);
     test_create_typelibs();
     test_LoadTypeLib();
+    test_LoadTypeLib_perf();
+    test_dual_members();
     test_TypeInfo2_GetContainingTypeLib();
     test_LoadRegTypeLib();
     test_GetLibAttr();
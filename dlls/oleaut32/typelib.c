@@ -1083,6 +1083,19 @@ typedef struct tagTLBString {
     struct list entry;
 } TLBString;
 
+/* what is kept of an MSFT image until all type infos have read their members */
+typedef struct tagTLBImage
+{
+    IUnknown *file;         /* keeps the mapping alive */
+    void *mapping;
+    unsigned int length;
+    MSFT_SegDir segdir;
+    TLBString **names;      /* name table entries by offset / 4 */
+    TLBString **strings;    /* string table entries by offset / 4 */
+    TLBGuid **guids;        /* guid table entries by offset / sizeof(MSFT_GuidEntry) */
+    LONG pending;           /* type infos with unread members, plus one while loading */
+} TLBImage;
+
 /* internal ITypeLib data */
 typedef struct tagITypeLibImpl
 {
@@ -1121,6 +1134,7 @@ typedef struct tagITypeLibImpl
 				   typelibs */
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
+    TLBImage *image;            /* MSFT image data, while members are unread */
 
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
@@ -1154,7 +1168,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1201,6 +1215,7 @@ typedef struct tagTLBFuncDesc
     const TLBString *HelpString;
     const TLBString *Entry;            /* if IS_INTRESOURCE true, it's numeric; if -1 it isn't present */
     struct list custdata_list;
+    VARTYPE *param_vts;     /* variant types of the parameters, cached by Invoke */
 } TLBFuncDesc;
 
 /* internal Variable data */
@@ -1232,6 +1247,8 @@ typedef struct tagITypeInfoImpl
     LONG ref;
     BOOL not_attached_to_typelib;
     BOOL needs_layout;
+    LONG members_pending;       /* funcdescs and vardescs not read from the image yet */
+    int memoffset;              /* offset of the member data in the image */
 
     TLBGuid *guid;
     LCID lcid;
@@ -1270,6 +1287,9 @@ typedef struct tagITypeInfoImpl
     /* variables  */
     TLBVarDesc *vardescs;
 
+    /* hash index of funcdescs and vardescs, built on first lookup */
+    struct tagTLBMemberIndex *member_index;
+
     /* Implemented Interfaces  */
     TLBImplType *impltypes;
 
@@ -1303,6 +1323,7 @@ static const ICreateTypeInfo2Vtbl CreateTypeInfo2Vtbl;
 
 static ITypeInfoImpl* ITypeInfoImpl_Constructor(void);
 static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This);
+static void TLB_load_members(ITypeInfoImpl *This);
 
 typedef struct tagTLBContext
 {
@@ -1581,9 +1602,12 @@ static void dump_TypeInfo(const ITypeInfoImpl * pty)
     TRACE("wTypeFlags: 0x%04x\n", pty->wTypeFlags);
     TRACE("parent tlb:%p index in TLB:%u\n",pty->pTypeLib, pty->index);
     if (pty->typekind == TKIND_MODULE) TRACE("dllname:%s\n", debugstr_w(TLB_get_bstr(pty->DllName)));
-    if (TRACE_ON(ole))
-        dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
-    dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    if (!pty->members_pending)
+    {
+        if (TRACE_ON(ole))
+            dump_TLBFuncDesc(pty->funcdescs, pty->cFuncs);
+        dump_TLBVarDesc(pty->vardescs, pty->cVars);
+    }
     dump_TLBImplType(pty->impltypes, pty->cImplTypes);
 }
 
@@ -1714,39 +1738,244 @@ static BSTR TLB_MultiByteToBSTR(const char *ptr)
     return ret;
 }
 
-static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid(TLBFuncDesc *funcdescs,
-        UINT n, MEMBERID memid)
+/* Member lookups by MEMBERID and by name go through per-typeinfo hash
+ * tables once a type has enough members to make that worthwhile. Each table
+ * chains the members of a bucket in declaration order, so that lookups find
+ * the same member a linear scan would. */
+#define TLB_INDEX_NONE (~0u)
+#define TLB_INDEX_MIN_MEMBERS 16
+
+typedef struct tagTLBMemberIndex
 {
-    while(n){
-        if(funcdescs->funcdesc.memid == memid)
-            return funcdescs;
-        ++funcdescs;
-        --n;
+    UINT mask;              /* number of buckets - 1 */
+    UINT cFuncs;            /* member counts the index was built for */
+    UINT cVars;
+    UINT *func_memid;       /* bucket heads */
+    UINT *func_name;
+    UINT *var_memid;
+    UINT *var_name;
+    UINT *func_memid_next;  /* chain links, one per member */
+    UINT *func_name_next;
+    UINT *var_memid_next;
+    UINT *var_name_next;
+    UINT data[1];
+} TLBMemberIndex;
+
+static inline UINT TLB_hash_memid(MEMBERID memid)
+{
+    UINT hash = memid;
+
+    hash = (hash ^ (hash >> 16)) * 0x45d9f3b;
+    return hash ^ (hash >> 16);
+}
+
+static UINT TLB_hash_name(const OLECHAR *name)
+{
+    UINT hash = 2166136261u;
+
+    while(*name)
+        hash = (hash ^ tolowerW(*name++)) * 16777619u;
+    return hash;
+}
+
+static inline void TLB_index_insert(UINT *heads, UINT *next, UINT mask, UINT hash, UINT i)
+{
+    next[i] = heads[hash & mask];
+    heads[hash & mask] = i;
+}
+
+static TLBMemberIndex *TLB_build_member_index(const ITypeInfoImpl *This)
+{
+    TLBMemberIndex *index;
+    UINT size = 4, i;
+
+    while(size < This->cFuncs || size < This->cVars)
+        size <<= 1;
+
+    index = heap_alloc(FIELD_OFFSET(TLBMemberIndex, data[4 * size + 2 * This->cFuncs + 2 * This->cVars]));
+    if(!index)
+        return NULL;
+
+    index->mask = size - 1;
+    index->cFuncs = This->cFuncs;
+    index->cVars = This->cVars;
+    index->func_memid = index->data;
+    index->func_name = index->func_memid + size;
+    index->var_memid = index->func_name + size;
+    index->var_name = index->var_memid + size;
+    index->func_memid_next = index->var_name + size;
+    index->func_name_next = index->func_memid_next + This->cFuncs;
+    index->var_memid_next = index->func_name_next + This->cFuncs;
+    index->var_name_next = index->var_memid_next + This->cVars;
+    memset(index->data, 0xff, 4 * size * sizeof(UINT));
+
+    /* insert backwards, so the chains end up in declaration order */
+    for(i = This->cFuncs; i--;){
+        const TLBFuncDesc *func = &This->funcdescs[i];
+
+        TLB_index_insert(index->func_memid, index->func_memid_next, index->mask,
+                TLB_hash_memid(func->funcdesc.memid), i);
+        if(func->Name)
+            TLB_index_insert(index->func_name, index->func_name_next, index->mask,
+                    TLB_hash_name(func->Name->str), i);
+    }
+
+    for(i = This->cVars; i--;){
+        const TLBVarDesc *var = &This->vardescs[i];
+
+        TLB_index_insert(index->var_memid, index->var_memid_next, index->mask,
+                TLB_hash_memid(var->vardesc.memid), i);
+        if(var->Name)
+            TLB_index_insert(index->var_name, index->var_name_next, index->mask,
+                    TLB_hash_name(var->Name->str), i);
+    }
+
+    return index;
+}
+
+/* Returns NULL if the members should be scanned linearly instead. */
+static const TLBMemberIndex *TLB_get_member_index(ITypeInfoImpl *This)
+{
+    TLBMemberIndex *index = This->member_index;
+
+    if(This->cFuncs + This->cVars < TLB_INDEX_MIN_MEMBERS)
+        return NULL;
+
+    if(!index){
+        if(!(index = TLB_build_member_index(This)))
+            return NULL;
+        if(InterlockedCompareExchangePointer((void**)&This->member_index, index, NULL)){
+            heap_free(index);
+            index = This->member_index;
+        }
+    }
+
+    if(index->cFuncs != This->cFuncs || index->cVars != This->cVars)
+        return NULL;
+    return index;
+}
+
+/* Must be called whenever members are added or their memids or names change. */
+static void TLB_invalidate_member_index(ITypeInfoImpl *This)
+{
+    heap_free(This->member_index);
+    This->member_index = NULL;
+}
+
+/* Returns the first funcdesc with the given memid following prev, or the
+ * first one at all if prev is NULL. */
+static TLBFuncDesc *TLB_next_funcdesc_by_memberid(ITypeInfoImpl *This,
+        const TLBFuncDesc *prev, MEMBERID memid)
+{
+    const TLBMemberIndex *index;
+    UINT i;
+
+    TLB_load_members(This);
+    index = TLB_get_member_index(This);
+
+    if(!index){
+        for(i = prev ? prev - This->funcdescs + 1 : 0; i < This->cFuncs; ++i)
+            if(This->funcdescs[i].funcdesc.memid == memid)
+                return &This->funcdescs[i];
+        return NULL;
     }
+
+    i = prev ? index->func_memid_next[prev - This->funcdescs]
+        : index->func_memid[TLB_hash_memid(memid) & index->mask];
+    for(; i != TLB_INDEX_NONE; i = index->func_memid_next[i])
+        if(This->funcdescs[i].funcdesc.memid == memid)
+            return &This->funcdescs[i];
     return NULL;
 }
 
-static inline TLBVarDesc *TLB_get_vardesc_by_memberid(TLBVarDesc *vardescs,
-        UINT n, MEMBERID memid)
+static inline TLBFuncDesc *TLB_get_funcdesc(ITypeInfoImpl *This, UINT index)
 {
-    while(n){
-        if(vardescs->vardesc.memid == memid)
-            return vardescs;
-        ++vardescs;
-        --n;
+    TLB_load_members(This);
+    return &This->funcdescs[index];
+}
+
+static inline TLBVarDesc *TLB_get_vardesc(ITypeInfoImpl *This, UINT index)
+{
+    TLB_load_members(This);
+    return &This->vardescs[index];
+}
+
+static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid(ITypeInfoImpl *This, MEMBERID memid)
+{
+    return TLB_next_funcdesc_by_memberid(This, NULL, memid);
+}
+
+/* Same as TLB_next_funcdesc_by_memberid, matching names case-insensitively. */
+static TLBFuncDesc *TLB_next_funcdesc_by_name(ITypeInfoImpl *This,
+        const TLBFuncDesc *prev, const OLECHAR *name)
+{
+    const TLBMemberIndex *index;
+    UINT i;
+
+    TLB_load_members(This);
+    index = name ? TLB_get_member_index(This) : NULL;
+
+    if(!index){
+        for(i = prev ? prev - This->funcdescs + 1 : 0; i < This->cFuncs; ++i)
+            if(!lstrcmpiW(TLB_get_bstr(This->funcdescs[i].Name), name))
+                return &This->funcdescs[i];
+        return NULL;
     }
+
+    i = prev ? index->func_name_next[prev - This->funcdescs]
+        : index->func_name[TLB_hash_name(name) & index->mask];
+    for(; i != TLB_INDEX_NONE; i = index->func_name_next[i])
+        if(!lstrcmpiW(TLB_get_bstr(This->funcdescs[i].Name), name))
+            return &This->funcdescs[i];
     return NULL;
 }
 
-static inline TLBVarDesc *TLB_get_vardesc_by_name(TLBVarDesc *vardescs,
-        UINT n, const OLECHAR *name)
+static inline TLBFuncDesc *TLB_get_funcdesc_by_name(ITypeInfoImpl *This, const OLECHAR *name)
 {
-    while(n){
-        if(!lstrcmpiW(TLB_get_bstr(vardescs->Name), name))
-            return vardescs;
-        ++vardescs;
-        --n;
+    return TLB_next_funcdesc_by_name(This, NULL, name);
+}
+
+static TLBVarDesc *TLB_get_vardesc_by_memberid(ITypeInfoImpl *This, MEMBERID memid)
+{
+    const TLBMemberIndex *index;
+    UINT i;
+
+    TLB_load_members(This);
+    index = TLB_get_member_index(This);
+
+    if(!index){
+        for(i = 0; i < This->cVars; ++i)
+            if(This->vardescs[i].vardesc.memid == memid)
+                return &This->vardescs[i];
+        return NULL;
     }
+
+    for(i = index->var_memid[TLB_hash_memid(memid) & index->mask]; i != TLB_INDEX_NONE;
+            i = index->var_memid_next[i])
+        if(This->vardescs[i].vardesc.memid == memid)
+            return &This->vardescs[i];
+    return NULL;
+}
+
+static TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *This, const OLECHAR *name)
+{
+    const TLBMemberIndex *index;
+    UINT i;
+
+    TLB_load_members(This);
+    index = name ? TLB_get_member_index(This) : NULL;
+
+    if(!index){
+        for(i = 0; i < This->cVars; ++i)
+            if(!lstrcmpiW(TLB_get_bstr(This->vardescs[i].Name), name))
+                return &This->vardescs[i];
+        return NULL;
+    }
+
+    for(i = index->var_name[TLB_hash_name(name) & index->mask]; i != TLB_INDEX_NONE;
+            i = index->var_name_next[i])
+        if(!lstrcmpiW(TLB_get_bstr(This->vardescs[i].Name), name))
+            return &This->vardescs[i];
     return NULL;
 }
 
@@ -2104,10 +2333,15 @@ static DWORD MSFT_ReadLEWords(void *buffer,  DWORD count, TLBContext *pcx,
 
 static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
 {
+    TLBImage *image = pcx->pLibInfo->image;
     TLBGuid *guid;
     MSFT_GuidEntry entry;
     int offs = 0;
 
+    image->guids = heap_alloc_zero((pcx->pTblDir->pGuidTab.length / sizeof(MSFT_GuidEntry) + 1) * sizeof(*image->guids));
+    if (!image->guids)
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pGuidTab.offset);
     while (1) {
         if (offs >= pcx->pTblDir->pGuidTab.length)
@@ -2122,6 +2356,7 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
         guid->hreftype = entry.hreftype;
 
         list_add_tail(&pcx->pLibInfo->guid_list, &guid->entry);
+        image->guids[offs / sizeof(MSFT_GuidEntry)] = guid;
 
         offs += sizeof(MSFT_GuidEntry);
     }
@@ -2131,14 +2366,14 @@ static TLBGuid *MSFT_ReadGuid( int offset, TLBContext *pcx)
 {
     TLBGuid *ret;
 
-    LIST_FOR_EACH_ENTRY(ret, &pcx->pLibInfo->guid_list, TLBGuid, entry){
-        if(ret->offset == offset){
-            TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
-            return ret;
-        }
-    }
+    if (!pcx->pLibInfo->image->guids || offset < 0 || offset >= pcx->pTblDir->pGuidTab.length ||
+            offset % sizeof(MSFT_GuidEntry))
+        return NULL;
 
-    return NULL;
+    ret = pcx->pLibInfo->image->guids[offset / sizeof(MSFT_GuidEntry)];
+    if (ret)
+        TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
+    return ret;
 }
 
 static HREFTYPE MSFT_ReadHreftype( TLBContext *pcx, int offset )
@@ -2159,11 +2394,16 @@ static HREFTYPE MSFT_ReadHreftype( TLBContext *pcx, int offset )
 
 static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
 {
+    TLBImage *image = pcx->pLibInfo->image;
     char *string;
     MSFT_NameIntro intro;
     INT16 len_piece;
     int offs = 0, lengthInChars;
 
+    image->names = heap_alloc_zero((pcx->pTblDir->pNametab.length / 4 + 1) * sizeof(*image->names));
+    if (!image->names)
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pNametab.offset);
     while (1) {
         TLBString *tlbstr;
@@ -2199,6 +2439,7 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
         heap_free(string);
 
         list_add_tail(&pcx->pLibInfo->name_list, &tlbstr->entry);
+        image->names[offs / 4] = tlbstr;
 
         offs += len_piece;
     }
@@ -2208,28 +2449,26 @@ static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
 {
     TLBString *tlbstr;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
-        }
-    }
+    if (!pcx->pLibInfo->image->names || offset < 0 || offset >= pcx->pTblDir->pNametab.length || offset % 4)
+        return NULL;
 
-    return NULL;
+    tlbstr = pcx->pLibInfo->image->names[offset / 4];
+    if (tlbstr)
+        TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
+    return tlbstr;
 }
 
 static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
 {
     TLBString *tlbstr;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
-        }
-    }
+    if (!pcx->pLibInfo->image->strings || offset < 0 || offset >= pcx->pTblDir->pStringtab.length || offset % 4)
+        return NULL;
 
-    return NULL;
+    tlbstr = pcx->pLibInfo->image->strings[offset / 4];
+    if (tlbstr)
+        TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
+    return tlbstr;
 }
 
 /*
@@ -2736,16 +2975,13 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->cFuncs,
-		    ptiRet->cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->cFuncs,
-		   ptiRet->cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are read on first use, see TLB_load_members */
+    ptiRet->memoffset = tiBase.memoffset;
+    if(ptiRet->cFuncs > 0 || ptiRet->cVars > 0)
+    {
+        ptiRet->members_pending = TRUE;
+        pLibInfo->image->pending++;
+    }
     if(ptiRet->cImplTypes >0 ) {
         switch(ptiRet->typekind)
         {
@@ -2784,12 +3020,80 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
     return ptiRet;
 }
 
+static CRITICAL_SECTION members_section;
+static CRITICAL_SECTION_DEBUG members_section_debug =
+{
+    0, 0, &members_section,
+    { &members_section_debug.ProcessLocksList, &members_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": members_section") }
+};
+static CRITICAL_SECTION members_section = { &members_section_debug, -1, 0, 0, 0, 0 };
+
+static void TLB_free_image(TLBImage *image)
+{
+    if (image->file)
+        IUnknown_Release(image->file);
+    heap_free(image->names);
+    heap_free(image->strings);
+    heap_free(image->guids);
+    heap_free(image);
+}
+
+/* Once nothing is left to read, the image and the lookup tables go away. */
+static void TLB_release_image(ITypeLibImpl *lib)
+{
+    if (!--lib->image->pending)
+    {
+        TLB_free_image(lib->image);
+        lib->image = NULL;
+    }
+}
+
+/* MSFT type infos leave their functions and variables in the image until
+ * something asks for them; most type infos of a large library are never
+ * looked at by a given client. */
+static void TLB_load_members(ITypeInfoImpl *This)
+{
+    ITypeLibImpl *lib = This->pTypeLib;
+    TLBContext cx;
+
+    if (!This->members_pending)
+        return;
+
+    EnterCriticalSection(&members_section);
+    if (This->members_pending)
+    {
+        TRACE_(typelib)("reading members of %s\n", debugstr_w(TLB_get_bstr(This->Name)));
+
+        cx.oStart = 0;
+        cx.pos = 0;
+        cx.mapping = lib->image->mapping;
+        cx.length = lib->image->length;
+        cx.pTblDir = &lib->image->segdir;
+        cx.pLibInfo = lib;
+
+        if (This->cFuncs > 0)
+            MSFT_DoFuncs(&cx, This, This->cFuncs, This->cVars, This->memoffset, &This->funcdescs);
+        if (This->cVars > 0)
+            MSFT_DoVars(&cx, This, This->cFuncs, This->cVars, This->memoffset, &This->vardescs);
+
+        InterlockedExchange(&This->members_pending, FALSE);
+        TLB_release_image(lib);
+    }
+    LeaveCriticalSection(&members_section);
+}
+
 static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
 {
+    TLBImage *image = pcx->pLibInfo->image;
     char *string;
     INT16 len_str, len_piece;
     int offs = 0, lengthInChars;
 
+    image->strings = heap_alloc_zero((pcx->pTblDir->pStringtab.length / 4 + 1) * sizeof(*image->strings));
+    if (!image->strings)
+        return E_OUTOFMEMORY;
+
     MSFT_Seek(pcx, pcx->pTblDir->pStringtab.offset);
     while (1) {
         TLBString *tlbstr;
@@ -2824,6 +3128,7 @@ static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
         heap_free(string);
 
         list_add_tail(&pcx->pLibInfo->string_list, &tlbstr->entry);
+        image->strings[offs / 4] = tlbstr;
 
         offs += len_piece;
     }
@@ -3399,7 +3704,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3470,7 +3775,7 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *
  * loading an MSFT typelib from an in-memory image
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file)
 {
     TLBContext cx;
     LONG lPSegDir;
@@ -3484,6 +3789,16 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     pTypeLibImpl = TypeLibImpl_Constructor();
     if (!pTypeLibImpl) return NULL;
 
+    pTypeLibImpl->image = heap_alloc_zero(sizeof(TLBImage));
+    if (!pTypeLibImpl->image)
+    {
+        heap_free(pTypeLibImpl);
+        return NULL;
+    }
+    pTypeLibImpl->image->mapping = pLib;
+    pTypeLibImpl->image->length = dwTLBLength;
+    pTypeLibImpl->image->pending = 1;
+
     /* get pointer to beginning of typelib data */
     cx.pos = 0;
     cx.oStart=0;
@@ -3497,6 +3812,8 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     TRACE_(typelib)("\tmagic1=0x%08x ,magic2=0x%08x\n",tlbHeader.magic1,tlbHeader.magic2 );
     if (tlbHeader.magic1 != MSFT_SIGNATURE) {
 	FIXME("Header type magic 0x%08x not supported.\n",tlbHeader.magic1);
+	TLB_free_image(pTypeLibImpl->image);
+	heap_free(pTypeLibImpl);
 	return NULL;
     }
     TRACE_(typelib)("\tdispatchpos = 0x%x\n", tlbHeader.dispatchpos);
@@ -3509,12 +3826,14 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     /* now read the segment directory */
     TRACE("read segment directory (at %d)\n",lPSegDir);
     MSFT_ReadLEDWords(&tlbSegDir, sizeof(tlbSegDir), &cx, lPSegDir);
-    cx.pTblDir = &tlbSegDir;
+    pTypeLibImpl->image->segdir = tlbSegDir;
+    cx.pTblDir = &pTypeLibImpl->image->segdir;
 
     /* just check two entries */
     if ( tlbSegDir.pTypeInfoTab.res0c != 0x0F || tlbSegDir.pImpInfo.res0c != 0x0F)
     {
         ERR("cannot find the table directory, ptr=0x%x\n",lPSegDir);
+	TLB_free_image(pTypeLibImpl->image);
 	heap_free(pTypeLibImpl);
 	return NULL;
     }
@@ -3682,6 +4001,14 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
     }
 #endif
 
+    /* keep the image around for the members that are still to be read */
+    if (pTypeLibImpl->image->pending > 1)
+    {
+        pTypeLibImpl->image->file = file;
+        IUnknown_AddRef(file);
+    }
+    TLB_release_image(pTypeLibImpl);
+
     TRACE("(%p)\n", pTypeLibImpl);
     return &pTypeLibImpl->ITypeLib2_iface;
 }
@@ -4773,6 +5100,9 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
       }
       TRACE(" destroying ITypeLib(%p)\n",This);
 
+      if (This->image)
+          TLB_free_image(This->image);
+
       LIST_FOR_EACH_ENTRY_SAFE(tlbstr, tlbstr_next, &This->string_list, TLBString, entry) {
           list_remove(&tlbstr->entry);
           SysFreeString(tlbstr->str);
@@ -5074,6 +5404,7 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5133,6 +5464,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
             goto ITypeLib2_fnFindName_exit;
         }
 
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
 
@@ -5142,7 +5474,7 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
             }
         }
 
-        var = TLB_get_vardesc_by_name(pTInfo->vardescs, pTInfo->cVars, name);
+        var = TLB_get_vardesc_by_name(pTInfo, name);
         if (var) {
             memid[count] = var->vardesc.memid;
             goto ITypeLib2_fnFindName_exit;
@@ -5588,7 +5920,11 @@ static HRESULT WINAPI ITypeInfo_fnQueryInterface(
         *ppvObject = This;
     else if(IsEqualIID(riid, &IID_ICreateTypeInfo) ||
              IsEqualIID(riid, &IID_ICreateTypeInfo2))
+    {
+        /* ICreateTypeInfo2 methods access the members directly */
+        TLB_load_members(This);
         *ppvObject = &This->ICreateTypeInfo2_iface;
+    }
 
     if(*ppvObject){
         ITypeInfo2_AddRef(iface);
@@ -5620,6 +5956,10 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
+    /* nothing was allocated for members that were never read */
+    if (This->members_pending)
+        This->cFuncs = This->cVars = 0;
+
     for (i = 0; i < This->cFuncs; ++i)
     {
         int j;
@@ -5633,9 +5973,11 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
         }
         heap_free(pFInfo->funcdesc.lprgelemdescParam);
         heap_free(pFInfo->pParamDesc);
+        heap_free(pFInfo->param_vts);
         TLB_FreeCustData(&pFInfo->custdata_list);
     }
     heap_free(This->funcdescs);
+    heap_free(This->member_index);
 
     for(i = 0; i < This->cVars; ++i)
     {
@@ -5677,7 +6019,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release(&This->pTypeLib->ITypeLib2_iface);
         if (not_attached_to_typelib)
+        {
+            heap_free(This->member_index);
             heap_free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -5926,7 +6271,7 @@ HRESULT ITypeInfoImpl_GetInternalFuncDesc( ITypeInfo *iface, UINT index, const F
     if (index >= This->cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
-    *ppFuncDesc = &This->funcdescs[index].funcdesc;
+    *ppFuncDesc = &TLB_get_funcdesc(This, index)->funcdesc;
     return S_OK;
 }
 
@@ -6115,7 +6460,7 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
         LPVARDESC  *ppVarDesc)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc = &This->vardescs[index];
+    const TLBVarDesc *pVDesc = TLB_get_vardesc(This, index);
 
     TRACE("(%p) index %d\n", This, index);
 
@@ -6148,7 +6493,7 @@ static HRESULT WINAPI ITypeInfo_fnGetNames( ITypeInfo2 *iface, MEMBERID memid,
 
     *pcNames = 0;
 
-    pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
+    pFDesc = TLB_get_funcdesc_by_memberid(This, memid);
     if(pFDesc)
     {
         if(!cMaxNames || !pFDesc->Name)
@@ -6166,7 +6511,7 @@ static HRESULT WINAPI ITypeInfo_fnGetNames( ITypeInfo2 *iface, MEMBERID memid,
         return S_OK;
     }
 
-    pVDesc = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
+    pVDesc = TLB_get_vardesc_by_memberid(This, memid);
     if(pVDesc)
     {
       *rgBstrNames=SysAllocString(TLB_get_bstr(pVDesc->Name));
@@ -6296,9 +6641,10 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
 
     TRACE("(%p) Name %s cNames %d\n", This, debugstr_w(*rgszNames),
             cNames);
@@ -6307,25 +6653,23 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->cFuncs; ++fdc) {
+    pFDesc = TLB_get_funcdesc_by_name(This, *rgszNames);
+    if(pFDesc) {
         int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
-        }
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
+        return ret;
     }
-    pVDesc = TLB_get_vardesc_by_name(This->vardescs, This->cVars, *rgszNames);
+    pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
     if(pVDesc){
         if(cNames)
             *pMemId = pVDesc->vardesc.memid;
@@ -6881,6 +7225,39 @@ static inline BOOL func_restricted( const FUNCDESC *desc )
 #define INVBUF_GET_ARG_TYPE_ARRAY(buffer, params) \
     ((VARTYPE *)((char *)(buffer) + (sizeof(VARIANTARG) + sizeof(VARIANTARG) + sizeof(VARIANTARG *)) * (params)))
 
+/* The parameter types of a function never change once it is laid out, so
+ * resolve them once and reuse the result for later invocations. */
+static HRESULT get_param_vts(ITypeInfoImpl *This, TLBFuncDesc *func, VARTYPE *vts)
+{
+    const FUNCDESC *func_desc = &func->funcdesc;
+    VARTYPE *cached = func->param_vts;
+    HRESULT hres;
+    int i;
+
+    if (cached)
+    {
+        memcpy(vts, cached, func_desc->cParams * sizeof(*vts));
+        return S_OK;
+    }
+
+    for (i = 0; i < func_desc->cParams; i++)
+    {
+        hres = typedescvt_to_variantvt((ITypeInfo *)&This->ITypeInfo2_iface,
+                &func_desc->lprgelemdescParam[i].tdesc, &vts[i]);
+        if (FAILED(hres))
+            return hres;
+    }
+
+    if (func_desc->cParams && (cached = heap_alloc(func_desc->cParams * sizeof(*cached))))
+    {
+        memcpy(cached, vts, func_desc->cParams * sizeof(*cached));
+        if (InterlockedCompareExchangePointer((void **)&func->param_vts, cached, NULL))
+            heap_free(cached);
+    }
+
+    return S_OK;
+}
+
 static HRESULT WINAPI ITypeInfo_fnInvoke(
     ITypeInfo2 *iface,
     VOID  *pIUnk,
@@ -6896,8 +7273,7 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
     unsigned int var_index;
     TYPEKIND type_kind;
     HRESULT hres;
-    const TLBFuncDesc *pFuncInfo;
-    UINT fdc;
+    TLBFuncDesc *pFuncInfo;
 
     TRACE("(%p)(%p,id=%d,flags=0x%08x,%p,%p,%p,%p)\n",
       This,pIUnk,memid,wFlags,pDispParams,pVarResult,pExcepInfo,pArgErr
@@ -6923,15 +7299,14 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
-    for (fdc = 0; fdc < This->cFuncs; ++fdc){
-        pFuncInfo = &This->funcdescs[fdc];
-        if ((memid == pFuncInfo->funcdesc.memid) &&
-            (wFlags & pFuncInfo->funcdesc.invkind) &&
+    for (pFuncInfo = TLB_get_funcdesc_by_memberid(This, memid); pFuncInfo;
+         pFuncInfo = TLB_next_funcdesc_by_memberid(This, pFuncInfo, memid)){
+        if ((wFlags & pFuncInfo->funcdesc.invkind) &&
             !func_restricted( &pFuncInfo->funcdesc ))
             break;
     }
 
-    if (fdc < This->cFuncs) {
+    if (pFuncInfo) {
         const FUNCDESC *func_desc = &pFuncInfo->funcdesc;
 
         if (TRACE_ON(ole))
@@ -6972,13 +7347,9 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
                 goto func_fail;
             }
 
-            for (i = 0; i < func_desc->cParams; i++)
-            {
-                TYPEDESC *tdesc = &func_desc->lprgelemdescParam[i].tdesc;
-                hres = typedescvt_to_variantvt((ITypeInfo *)iface, tdesc, &rgvt[i]);
-                if (FAILED(hres))
-                    goto func_fail;
-            }
+            hres = get_param_vts(This, pFuncInfo, rgvt);
+            if (FAILED(hres))
+                goto func_fail;
 
             TRACE("changing args\n");
             for (i = 0; i < func_desc->cParams; i++)
@@ -7433,7 +7804,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
             *pBstrHelpFile=SysAllocString(TLB_get_bstr(This->pTypeLib->HelpFile));
         return S_OK;
     }else {/* for a member */
-        pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
+        pFDesc = TLB_get_funcdesc_by_memberid(This, memid);
         if(pFDesc){
             if(pBstrName)
               *pBstrName = SysAllocString(TLB_get_bstr(pFDesc->Name));
@@ -7445,7 +7816,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDocumentation( ITypeInfo2 *iface,
               *pBstrHelpFile = SysAllocString(TLB_get_bstr(This->pTypeLib->HelpFile));
             return S_OK;
         }
-        pVDesc = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
+        pVDesc = TLB_get_vardesc_by_memberid(This, memid);
         if(pVDesc){
             if(pBstrName)
               *pBstrName = SysAllocString(TLB_get_bstr(pVDesc->Name));
@@ -7499,7 +7870,7 @@ static HRESULT WINAPI ITypeInfo_fnGetDllEntry( ITypeInfo2 *iface, MEMBERID memid
     if (This->typekind != TKIND_MODULE)
         return TYPE_E_BADMODULEKIND;
 
-    pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
+    pFDesc = TLB_get_funcdesc_by_memberid(This, memid);
     if(pFDesc){
 	    dump_TypeInfo(This);
 	    if (TRACE_ON(ole))
@@ -7624,8 +7995,12 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
         */
         pTypeInfoImpl = ITypeInfoImpl_Constructor();
 
+        /* the copy shares the members, so they have to be read first */
+        TLB_load_members(This);
+
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
+        pTypeInfoImpl->member_index = NULL;
         list_init(&pTypeInfoImpl->custdata_list);
 
         if (This->typekind == TKIND_INTERFACE)
@@ -7977,6 +8352,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     UINT fdc;
     HRESULT result;
 
+    TLB_load_members(This);
     for (fdc = 0; fdc < This->cFuncs; ++fdc){
         const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
         if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
@@ -8007,7 +8383,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarIndexOfMemId( ITypeInfo2 * iface,
 
     TRACE("%p %d %p\n", iface, memid, pVarIndex);
 
-    pVarInfo = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
+    pVarInfo = TLB_get_vardesc_by_memberid(This, memid);
     if(!pVarInfo)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8055,7 +8431,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc = TLB_get_funcdesc(This, index);
 
     TRACE("%p %u %s %p\n", This, index, debugstr_guid(guid), pVarVal);
 
@@ -8085,7 +8461,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetParamCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc = TLB_get_funcdesc(This, indexFunc);
 
     TRACE("%p %u %u %s %p\n", This, indexFunc, indexParam,
             debugstr_guid(guid), pVarVal);
@@ -8118,7 +8494,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBVarDesc *pVDesc = &This->vardescs[index];
+    TLBVarDesc *pVDesc = TLB_get_vardesc(This, index);
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), pVarVal);
 
@@ -8200,7 +8576,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetDocumentation2(
                 SysAllocString(TLB_get_bstr(This->pTypeLib->HelpStringDll));/* FIXME */
         return S_OK;
     }else {/* for a member */
-        pFDesc = TLB_get_funcdesc_by_memberid(This->funcdescs, This->cFuncs, memid);
+        pFDesc = TLB_get_funcdesc_by_memberid(This, memid);
         if(pFDesc){
             if(pbstrHelpString)
                 *pbstrHelpString=SysAllocString(TLB_get_bstr(pFDesc->HelpString));
@@ -8211,7 +8587,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetDocumentation2(
                     SysAllocString(TLB_get_bstr(This->pTypeLib->HelpStringDll));/* FIXME */
             return S_OK;
         }
-        pVDesc = TLB_get_vardesc_by_memberid(This->vardescs, This->cVars, memid);
+        pVDesc = TLB_get_vardesc_by_memberid(This, memid);
         if(pVDesc){
             if(pbstrHelpString)
                 *pbstrHelpString=SysAllocString(TLB_get_bstr(pVDesc->HelpString));
@@ -8253,7 +8629,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllFuncCustData(
 	CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[index];
+    TLBFuncDesc *pFDesc = TLB_get_funcdesc(This, index);
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
@@ -8272,7 +8648,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllParamCustData( ITypeInfo2 * iface,
     UINT indexFunc, UINT indexParam, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBFuncDesc *pFDesc = &This->funcdescs[indexFunc];
+    TLBFuncDesc *pFDesc = TLB_get_funcdesc(This, indexFunc);
 
     TRACE("%p %u %u %p\n", This, indexFunc, indexParam, pCustData);
 
@@ -8294,7 +8670,7 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllVarCustData( ITypeInfo2 * iface,
     UINT index, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBVarDesc * pVDesc = &This->vardescs[index];
+    TLBVarDesc * pVDesc = TLB_get_vardesc(This, index);
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
@@ -8526,7 +8902,6 @@ static HRESULT WINAPI ITypeComp_fnBind(
     const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     HRESULT hr = DISP_E_MEMBERNOTFOUND;
-    UINT fdc;
 
     TRACE("(%p)->(%s, %x, 0x%x, %p, %p, %p)\n", This, debugstr_w(szName), lHash, wFlags, ppTInfo, pDescKind, pBindPtr);
 
@@ -8534,18 +8909,16 @@ static HRESULT WINAPI ITypeComp_fnBind(
     pBindPtr->lpfuncdesc = NULL;
     *ppTInfo = NULL;
 
-    for(fdc = 0; fdc < This->cFuncs; ++fdc){
-        pFDesc = &This->funcdescs[fdc];
-        if (!lstrcmpiW(TLB_get_bstr(pFDesc->Name), szName)) {
-            if (!wFlags || (pFDesc->funcdesc.invkind & wFlags))
-                break;
-            else
-                /* name found, but wrong flags */
-                hr = TYPE_E_TYPEMISMATCH;
-        }
+    for(pFDesc = TLB_get_funcdesc_by_name(This, szName); pFDesc;
+            pFDesc = TLB_next_funcdesc_by_name(This, pFDesc, szName)){
+        if (!wFlags || (pFDesc->funcdesc.invkind & wFlags))
+            break;
+        else
+            /* name found, but wrong flags */
+            hr = TYPE_E_TYPEMISMATCH;
     }
 
-    if (fdc < This->cFuncs)
+    if (pFDesc)
     {
         HRESULT hr = TLB_AllocAndInitFuncDesc(
             &pFDesc->funcdesc,
@@ -8558,7 +8931,7 @@ static HRESULT WINAPI ITypeComp_fnBind(
         ITypeInfo_AddRef(*ppTInfo);
         return S_OK;
     } else {
-        pVDesc = TLB_get_vardesc_by_name(This->vardescs, This->cVars, szName);
+        pVDesc = TLB_get_vardesc_by_name(This, szName);
         if(pVDesc){
             HRESULT hr = TLB_AllocAndInitVarDesc(&pVDesc->vardesc, &pBindPtr->lpvardesc);
             if (FAILED(hr))
@@ -9908,6 +10281,9 @@ static HRESULT WINAPI ICreateTypeLib2_fnSaveAllChanges(ICreateTypeLib2 *iface)
 
     TRACE("%p\n", This);
 
+    for(i = 0; i < This->TypeInfoCount; ++i)
+        TLB_load_members(This->typeinfos[i]);
+
     for(i = 0; i < This->TypeInfoCount; ++i)
         if(This->typeinfos[i]->needs_layout)
             ICreateTypeInfo2_LayOut(&This->typeinfos[i]->ICreateTypeInfo2_iface);
@@ -10515,6 +10891,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
 
     ++This->cFuncs;
 
+    TLB_invalidate_member_index(This);
     This->needs_layout = TRUE;
 
     return S_OK;
@@ -10685,6 +11062,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
 
     ++This->cVars;
 
+    TLB_invalidate_member_index(This);
     This->needs_layout = TRUE;
 
     return S_OK;
@@ -10730,6 +11108,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         par_desc->Name = TLB_append_str(&This->pTypeLib->name_list, *(names + i));
     }
 
+    TLB_invalidate_member_index(This);
     return S_OK;
 }
 
@@ -10747,6 +11126,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
         return TYPE_E_ELEMENTNOTFOUND;
 
     This->vardescs[index].Name = TLB_append_str(&This->pTypeLib->name_list, name);
+    TLB_invalidate_member_index(This);
     return S_OK;
 }
 
@@ -11016,6 +11396,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnLayOut(ICreateTypeInfo2 *iface)
         }
     }
 
+    TLB_invalidate_member_index(This);
+
     ITypeInfo_Release(tinfo);
     return hres;
 }
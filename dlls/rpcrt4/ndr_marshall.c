@@ -1817,6 +1817,90 @@ void WINAPI NdrSimpleStructFree(PMIDL_STUB_MESSAGE pStubMsg,
     EmbeddedPointerFree(pStubMsg, pMemory, pFormat+4);
 }
 
+/***********************************************************************
+ *           get_flat_element_size
+ *
+ * Checks whether the member list of a complex array element has identical
+ * memory and wire representations, i.e. it only contains base types whose
+ * memory size matches their wire size and embedded simple structures, with
+ * no padding in between. Returns the element size, or 0 if the element has
+ * to be processed member by member. The alignment that both the memory and
+ * the buffer need for the bulk copy to be equivalent is returned in
+ * *alignment.
+ */
+static ULONG get_flat_element_size(PFORMAT_STRING pFormat, unsigned char *alignment)
+{
+  PFORMAT_STRING desc;
+  ULONG size = 0, align = 1, n;
+
+  while (*pFormat != RPC_FC_END) {
+    switch (*pFormat) {
+    case RPC_FC_BYTE:
+    case RPC_FC_CHAR:
+    case RPC_FC_SMALL:
+    case RPC_FC_USMALL:
+      size += 1;
+      break;
+    case RPC_FC_WCHAR:
+    case RPC_FC_SHORT:
+    case RPC_FC_USHORT:
+      size += 2;
+      break;
+    case RPC_FC_LONG:
+    case RPC_FC_ULONG:
+    case RPC_FC_ENUM32:
+    case RPC_FC_FLOAT:
+      size += 4;
+      break;
+#ifndef _WIN64
+    case RPC_FC_INT3264:
+    case RPC_FC_UINT3264:
+      size += 4;
+      break;
+#endif
+    case RPC_FC_HYPER:
+    case RPC_FC_DOUBLE:
+      size += 8;
+      break;
+    case RPC_FC_ALIGNM2:
+    case RPC_FC_ALIGNM4:
+    case RPC_FC_ALIGNM8:
+      n = (*pFormat == RPC_FC_ALIGNM2) ? 2 : (*pFormat == RPC_FC_ALIGNM4) ? 4 : 8;
+      /* the memory would be padded, but not the buffer */
+      if (size & (n - 1)) return 0;
+      if (n > align) align = n;
+      break;
+    case RPC_FC_PAD:
+      break;
+    case RPC_FC_EMBEDDED_COMPLEX:
+      if (pFormat[1]) return 0;
+      desc = pFormat + 2 + *(const SHORT*)(pFormat + 2);
+      if (*desc != RPC_FC_STRUCT) return 0;
+      n = desc[1] + 1;
+      /* the buffer would be padded, but not the memory */
+      if (size & (n - 1)) return 0;
+      if (n > align) align = n;
+      size += *(const WORD*)(desc + 2);
+      pFormat += 4;
+      continue;
+    default:
+      return 0;
+    }
+    pFormat++;
+  }
+
+  if (!size || (size & (align - 1))) return 0;
+  *alignment = align;
+  return size;
+}
+
+static inline BOOL is_flat_copy_aligned(PMIDL_STUB_MESSAGE pStubMsg,
+                                        const unsigned char *pMemory,
+                                        unsigned char alignment)
+{
+  return !(((ULONG_PTR)pMemory | (ULONG_PTR)pStubMsg->Buffer) & (alignment - 1));
+}
+
 /* Array helpers */
 
 static inline void array_compute_and_size_conformance(
@@ -1931,6 +2015,13 @@ static inline void array_buffer_size(
 
     align_length(&pStubMsg->BufferLength, alignment);
 
+    esize = get_flat_element_size(pFormat, &alignment);
+    if (esize && !(pStubMsg->BufferLength & (alignment - 1)))
+    {
+      safe_buffer_length_increment(pStubMsg, safe_multiply(esize, pStubMsg->ActualCount));
+      break;
+    }
+
     size = pStubMsg->ActualCount;
     for (i = 0; i < size; i++)
       pMemory = ComplexBufferSize(pStubMsg, pMemory, pFormat, NULL);
@@ -2058,6 +2149,14 @@ static inline void array_write_variance_and_marshall(
 
     align_pointer_clear(&pStubMsg->Buffer, alignment);
 
+    esize = get_flat_element_size(pFormat, &alignment);
+    if (esize && is_flat_copy_aligned(pStubMsg, pMemory, alignment))
+    {
+      /* memory and wire layouts are the same, copy the whole array at once */
+      safe_copy_to_buffer(pStubMsg, pMemory, safe_multiply(esize, pStubMsg->ActualCount));
+      break;
+    }
+
     size = pStubMsg->ActualCount;
     for (i = 0; i < size; i++)
       pMemory = ComplexMarshall(pStubMsg, pMemory, pFormat, NULL);
@@ -2263,6 +2362,15 @@ static inline ULONG array_read_variance_and_unmarshall(
 
     pMemory = *ppMemory;
     count = pStubMsg->ActualCount;
+
+    if (get_flat_element_size(pFormat, &alignment) == esize && esize &&
+        is_flat_copy_aligned(pStubMsg, pMemory, alignment))
+    {
+      /* memory and wire layouts are the same, copy the whole array at once */
+      safe_copy_from_buffer(pStubMsg, pMemory, safe_multiply(esize, count));
+      return pStubMsg->Buffer - saved_buffer;
+    }
+
     for (i = 0; i < count; i++)
         pMemory = ComplexUnmarshall(pStubMsg, pMemory, pFormat, NULL, fMustAlloc);
     return pStubMsg->Buffer - saved_buffer;
@@ -2363,8 +2471,14 @@ static inline void array_memory_size(
     memsize = safe_multiply(pStubMsg->MaxCount, esize);
 
     count = pStubMsg->ActualCount;
-    for (i = 0; i < count; i++)
+    if (get_flat_element_size(pFormat, &alignment) == esize && esize &&
+        is_flat_copy_aligned(pStubMsg, NULL, alignment))
+      safe_buffer_increment(pStubMsg, safe_multiply(count, esize));
+    else
+    {
+      for (i = 0; i < count; i++)
         ComplexStructMemorySize(pStubMsg, pFormat, NULL);
+    }
 
     pStubMsg->MemorySize = SavedMemorySize + memsize;
     break;
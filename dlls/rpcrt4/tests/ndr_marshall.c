@@ -2077,6 +2077,154 @@ cleanup:
     HeapFree(GetProcessHeap(), 0, memsrc.array);
 }
 
+struct flat_elem
+{
+    LONG l;
+    SHORT s1, s2;
+};
+
+struct padded_elem
+{
+    SHORT s;
+    LONG l;
+};
+
+#define FLAT_ARRAY_COUNT 4096
+
+static void marshall_complex_array(const unsigned char *fmtstr, void *memsrc, ULONG memsize,
+                                   ULONG wiresize, DWORD iterations, const char *name)
+{
+    RPC_MESSAGE RpcMessage;
+    MIDL_STUB_MESSAGE StubMsg;
+    MIDL_STUB_DESC StubDesc;
+    unsigned char *mem, *mem2;
+    DWORD i, start, elapsed_marshall = 0, elapsed_unmarshall = 0;
+    void *ptr;
+
+    StubDesc = Object_StubDesc;
+    StubDesc.pFormatTypes = fmtstr;
+
+    NdrClientInitializeNew(&RpcMessage, &StubMsg, &StubDesc, 0);
+
+    StubMsg.BufferLength = 0;
+    NdrComplexArrayBufferSize(&StubMsg, memsrc, fmtstr);
+    ok(StubMsg.BufferLength == wiresize, "%s: length %u, expected %u\n", name, StubMsg.BufferLength, wiresize);
+
+    StubMsg.RpcMsg->Buffer = StubMsg.BufferStart = StubMsg.Buffer = HeapAlloc(GetProcessHeap(), 0, StubMsg.BufferLength);
+    StubMsg.BufferEnd = StubMsg.BufferStart + StubMsg.BufferLength;
+
+    mem = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, memsize);
+
+    for (i = 0; i < iterations; i++)
+    {
+        StubMsg.Buffer = StubMsg.BufferStart;
+        start = GetTickCount();
+        ptr = NdrComplexArrayMarshall(&StubMsg, memsrc, fmtstr);
+        elapsed_marshall += GetTickCount() - start;
+        ok(ptr == NULL, "%s: ret %p\n", name, ptr);
+        ok(StubMsg.Buffer == StubMsg.BufferStart + wiresize, "%s: marshalled %u bytes, expected %u\n",
+           name, (ULONG)(StubMsg.Buffer - StubMsg.BufferStart), wiresize);
+
+        StubMsg.Buffer = StubMsg.BufferStart;
+        mem2 = mem;
+        start = GetTickCount();
+        ptr = NdrComplexArrayUnmarshall(&StubMsg, &mem2, fmtstr, 0);
+        elapsed_unmarshall += GetTickCount() - start;
+        ok(ptr == NULL, "%s: ret %p\n", name, ptr);
+        ok(mem2 == mem, "%s: memory was reallocated\n", name);
+        ok(StubMsg.Buffer == StubMsg.BufferStart + wiresize, "%s: unmarshalled %u bytes, expected %u\n",
+           name, (ULONG)(StubMsg.Buffer - StubMsg.BufferStart), wiresize);
+    }
+    ok(!memcmp(mem, memsrc, memsize), "%s: array wasn't unmarshalled correctly\n", name);
+
+    StubMsg.Buffer = StubMsg.BufferStart;
+    StubMsg.MemorySize = 0;
+    i = NdrComplexArrayMemorySize(&StubMsg, fmtstr);
+    ok(i == memsize, "%s: memory size %u, expected %u\n", name, i, memsize);
+    ok(StubMsg.Buffer == StubMsg.BufferStart + wiresize, "%s: sized %u bytes, expected %u\n",
+       name, (ULONG)(StubMsg.Buffer - StubMsg.BufferStart), wiresize);
+
+    trace("%s: %u x %u bytes, marshall %u ms, unmarshall %u ms\n", name, iterations, memsize,
+          elapsed_marshall, elapsed_unmarshall);
+
+    HeapFree(GetProcessHeap(), 0, mem);
+    HeapFree(GetProcessHeap(), 0, StubMsg.RpcMsg->Buffer);
+}
+
+static void test_flat_complex_array(void)
+{
+    struct flat_elem *flat;
+    struct padded_elem *padded;
+    unsigned char *buf;
+    DWORD i;
+
+    static const unsigned char fmtstr_flat_array[] =
+    {
+        0x21,                       /* FC_BOGUS_ARRAY */
+        0x3,                        /* 3 */
+        NdrFcShort(FLAT_ARRAY_COUNT),
+        NdrFcLong(0xffffffff),      /* no conformance */
+        NdrFcLong(0xffffffff),      /* no variance */
+        0x8,                        /* FC_LONG */
+        0x6,                        /* FC_SHORT */
+        0x6,                        /* FC_SHORT */
+        0x5b,                       /* FC_END */
+    };
+    static const unsigned char fmtstr_padded_array[] =
+    {
+        0x21,                       /* FC_BOGUS_ARRAY */
+        0x3,                        /* 3 */
+        NdrFcShort(FLAT_ARRAY_COUNT),
+        NdrFcLong(0xffffffff),      /* no conformance */
+        NdrFcLong(0xffffffff),      /* no variance */
+        0x6,                        /* FC_SHORT */
+        0x39,                       /* FC_ALIGNM4 */
+        0x8,                        /* FC_LONG */
+        0x5b,                       /* FC_END */
+    };
+
+    flat = HeapAlloc(GetProcessHeap(), 0, FLAT_ARRAY_COUNT * sizeof(*flat));
+    padded = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, FLAT_ARRAY_COUNT * sizeof(*padded));
+    for (i = 0; i < FLAT_ARRAY_COUNT; i++)
+    {
+        flat[i].l = i * 0x10001;
+        flat[i].s1 = i;
+        flat[i].s2 = ~i;
+        padded[i].s = i;
+        padded[i].l = ~i;
+    }
+
+    /* elements without padding go to the wire unchanged */
+    marshall_complex_array(fmtstr_flat_array, flat, FLAT_ARRAY_COUNT * sizeof(*flat),
+                           FLAT_ARRAY_COUNT * sizeof(*flat), 100, "flat");
+
+    /* the memory padding is not marshalled */
+    marshall_complex_array(fmtstr_padded_array, padded, FLAT_ARRAY_COUNT * sizeof(*padded),
+                           FLAT_ARRAY_COUNT * 6, 100, "padded");
+
+    /* check the wire layout of the padded elements */
+    {
+        RPC_MESSAGE RpcMessage;
+        MIDL_STUB_MESSAGE StubMsg;
+        MIDL_STUB_DESC StubDesc = Object_StubDesc;
+
+        StubDesc.pFormatTypes = fmtstr_padded_array;
+        NdrClientInitializeNew(&RpcMessage, &StubMsg, &StubDesc, 0);
+        StubMsg.BufferLength = FLAT_ARRAY_COUNT * 6;
+        StubMsg.RpcMsg->Buffer = StubMsg.BufferStart = StubMsg.Buffer = HeapAlloc(GetProcessHeap(), 0, StubMsg.BufferLength);
+        StubMsg.BufferEnd = StubMsg.BufferStart + StubMsg.BufferLength;
+        NdrComplexArrayMarshall(&StubMsg, (unsigned char *)padded, fmtstr_padded_array);
+
+        buf = StubMsg.BufferStart + 6;
+        ok(*(SHORT *)buf == 1, "got %d\n", *(SHORT *)buf);
+        ok(*(LONG *)(buf + 2) == ~1, "got %d\n", *(LONG *)(buf + 2));
+        HeapFree(GetProcessHeap(), 0, StubMsg.RpcMsg->Buffer);
+    }
+
+    HeapFree(GetProcessHeap(), 0, flat);
+    HeapFree(GetProcessHeap(), 0, padded);
+}
+
 static void test_ndr_buffer(void)
 {
     static unsigned char ncalrpc[] = "ncalrpc";
@@ -2422,6 +2570,7 @@ START_TEST( ndr_marshall )
     test_nonconformant_string();
     test_conf_complex_struct();
     test_conf_complex_array();
+    test_flat_complex_array();
     test_ndr_buffer();
     test_NdrMapCommAndFaultStatus();
     test_NdrGetUserMarshalInfo();
@@ -1503,6 +1503,22 @@ void __cdecl s_authinfo_test(unsigned int protseq, int secure)
     }
 }
 
+static void
+latency_test(const char *protseq)
+{
+  static const int count = 1000;
+  DWORD start, elapsed;
+  int i, failures = 0;
+
+  start = GetTickCount();
+  for (i = 0; i < count; i++)
+    if (square(i) != i * i) failures++;
+  elapsed = GetTickCount() - start;
+
+  ok(!failures, "%d calls failed\n", failures);
+  trace("%s: %d round trips in %u ms\n", protseq, count, elapsed);
+}
+
 static void
 run_tests(void)
 {
@@ -1553,6 +1569,7 @@ client(const char *test)
 
     run_tests();
     authinfo_test(RPC_PROTSEQ_TCP, 0);
+    latency_test("ncacn_ip_tcp");
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
@@ -1575,6 +1592,7 @@ client(const char *test)
 
     run_tests(); /* can cause RPC_X_BAD_STUB_DATA exception */
     authinfo_test(RPC_PROTSEQ_LRPC, 0);
+    latency_test("ncalrpc");
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IServer_IfHandle), "RpcBindingFree\n");
@@ -1597,6 +1615,7 @@ client(const char *test)
 
     run_tests();
     authinfo_test(RPC_PROTSEQ_NMP, 0);
+    latency_test("ncacn_np");
     stop();
 
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
@@ -19,30 +19,499 @@
 
 #include "config.h"
 #include <stdarg.h>
+#include <math.h>
 
 #include "windef.h"
 #include "winbase.h"
 #include "ole2.h"
+#include "olectl.h"
 #include "dispex.h"
 #include "scrrun.h"
 #include "scrrun_private.h"
 
 #include "wine/debug.h"
+#include "wine/list.h"
+#include "wine/unicode.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(scrrun);
 
+#define DICT_HASH_MOD 1201
+#define DICT_MIN_BUCKETS 16
+
+typedef enum
+{
+    KEY_EMPTY,
+    KEY_NULL,
+    KEY_NUMBER,
+    KEY_STRING,
+    KEY_OBJECT
+} key_type;
+
+struct dictkey
+{
+    key_type type;
+    union
+    {
+        double num;
+        struct
+        {
+            const WCHAR *ptr;
+            UINT len;
+        } str;
+        IUnknown *obj;
+    } u;
+    DWORD hash;
+};
+
+struct keyitem_pair
+{
+    struct list entry;
+    struct list bucket;
+    struct dictkey dictkey;
+    VARIANT key;
+    VARIANT item;
+};
+
 typedef struct
 {
     IDictionary IDictionary_iface;
 
     LONG ref;
+
+    CompareMethod method;
+    LONG count;
+    struct list pairs;
+    struct list *buckets;
+    DWORD buckets_size;
+    struct list notifier;
 } dictionary;
 
+struct dictionary_enum
+{
+    IEnumVARIANT IEnumVARIANT_iface;
+    LONG ref;
+
+    dictionary *dict;
+    struct list *cur;
+    struct list notify;
+};
+
 static inline dictionary *impl_from_IDictionary(IDictionary *iface)
 {
     return CONTAINING_RECORD(iface, dictionary, IDictionary_iface);
 }
 
+static inline struct dictionary_enum *impl_from_IEnumVARIANT(IEnumVARIANT *iface)
+{
+    return CONTAINING_RECORD(iface, struct dictionary_enum, IEnumVARIANT_iface);
+}
+
+static inline BOOL is_text_compare(const dictionary *dict)
+{
+    return dict->method != BinaryCompare;
+}
+
+/* Spreads the hash over all bits, the bucket index is taken from the low bits. */
+static inline DWORD mix_hash(DWORD hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+static DWORD get_str_hash(const dictionary *dict, const WCHAR *str, UINT len)
+{
+    DWORD hash = 0x811c9dc5;
+    UINT i;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ (is_text_compare(dict) ? tolowerW(str[i]) : str[i])) * 0x01000193;
+
+    return mix_hash(hash);
+}
+
+static inline DWORD get_ptr_hash(const void *ptr)
+{
+    ULONG_PTR val = (ULONG_PTR)ptr;
+    return mix_hash((DWORD)val ^ (DWORD)(val >> 16 >> 16));
+}
+
+/* Fills dictkey for given key. Numeric keys of all types compare equal if they have the same value. */
+static HRESULT get_dictkey(const dictionary *dict, VARIANT *key, struct dictkey *ret)
+{
+    VARIANT num;
+    HRESULT hr;
+
+    if (V_VT(key) == (VT_VARIANT|VT_BYREF))
+        key = V_VARIANTREF(key);
+
+    switch (V_VT(key))
+    {
+    case VT_EMPTY:
+        ret->type = KEY_EMPTY;
+        ret->hash = 0;
+        return S_OK;
+    case VT_NULL:
+        ret->type = KEY_NULL;
+        ret->hash = 1;
+        return S_OK;
+    case VT_BSTR:
+    case VT_BSTR|VT_BYREF:
+        ret->type = KEY_STRING;
+        ret->u.str.ptr = V_VT(key) == VT_BSTR ? V_BSTR(key) : *V_BSTRREF(key);
+        ret->u.str.len = SysStringLen((BSTR)ret->u.str.ptr);
+        ret->hash = get_str_hash(dict, ret->u.str.ptr, ret->u.str.len);
+        return S_OK;
+    case VT_UNKNOWN:
+    case VT_DISPATCH:
+        ret->type = KEY_OBJECT;
+        ret->u.obj = V_UNKNOWN(key);
+        ret->hash = get_ptr_hash(ret->u.obj);
+        return S_OK;
+    case VT_UNKNOWN|VT_BYREF:
+    case VT_DISPATCH|VT_BYREF:
+        ret->type = KEY_OBJECT;
+        ret->u.obj = *V_UNKNOWNREF(key);
+        ret->hash = get_ptr_hash(ret->u.obj);
+        return S_OK;
+    default:
+        if (V_VT(key) & VT_ARRAY)
+            return CTL_E_ILLEGALFUNCTIONCALL;
+
+        V_VT(&num) = VT_EMPTY;
+        hr = VariantChangeType(&num, key, 0, VT_R8);
+        if (FAILED(hr))
+        {
+            WARN("unsupported key type %s\n", debugstr_vt(V_VT(key)));
+            return CTL_E_ILLEGALFUNCTIONCALL;
+        }
+
+        ret->type = KEY_NUMBER;
+        /* make sure that 0.0 and -0.0 hash the same */
+        ret->u.num = V_R8(&num) == 0.0 ? 0.0 : V_R8(&num);
+        ret->hash = mix_hash(((DWORD*)&ret->u.num)[0] ^ ((DWORD*)&ret->u.num)[1]);
+        return S_OK;
+    }
+}
+
+static BOOL is_matching_key(const dictionary *dict, const struct dictkey *key1, const struct dictkey *key2)
+{
+    if (key1->hash != key2->hash || key1->type != key2->type)
+        return FALSE;
+
+    switch (key1->type)
+    {
+    case KEY_NUMBER:
+        return key1->u.num == key2->u.num;
+    case KEY_STRING:
+        if (key1->u.str.len != key2->u.str.len)
+            return FALSE;
+        if (is_text_compare(dict))
+            return !memicmpW(key1->u.str.ptr, key2->u.str.ptr, key1->u.str.len);
+        return !memcmp(key1->u.str.ptr, key2->u.str.ptr, key1->u.str.len*sizeof(WCHAR));
+    case KEY_OBJECT:
+        return key1->u.obj == key2->u.obj;
+    default:
+        return TRUE;
+    }
+}
+
+static inline struct list *get_bucket(const dictionary *dict, DWORD hash)
+{
+    return dict->buckets + (hash & (dict->buckets_size - 1));
+}
+
+static struct keyitem_pair *get_keyitem_pair(dictionary *dict, const struct dictkey *key)
+{
+    struct keyitem_pair *pair;
+
+    if (!dict->count)
+        return NULL;
+
+    LIST_FOR_EACH_ENTRY(pair, get_bucket(dict, key->hash), struct keyitem_pair, bucket)
+    {
+        if (is_matching_key(dict, &pair->dictkey, key))
+            return pair;
+    }
+
+    return NULL;
+}
+
+static BOOL resize_buckets(dictionary *dict, DWORD size)
+{
+    struct keyitem_pair *pair;
+    struct list *buckets;
+    DWORD i;
+
+    buckets = heap_alloc(size * sizeof(*buckets));
+    if (!buckets)
+        return FALSE;
+
+    for (i = 0; i < size; i++)
+        list_init(buckets + i);
+
+    heap_free(dict->buckets);
+    dict->buckets = buckets;
+    dict->buckets_size = size;
+
+    LIST_FOR_EACH_ENTRY(pair, &dict->pairs, struct keyitem_pair, entry)
+        list_add_tail(get_bucket(dict, pair->dictkey.hash), &pair->bucket);
+
+    return TRUE;
+}
+
+/* Stores a copy of the key in the pair and fills its dictkey, so that string keys point to the owned copy. */
+static HRESULT set_pair_key(dictionary *dict, struct keyitem_pair *pair, VARIANT *key)
+{
+    HRESULT hr;
+
+    VariantInit(&pair->key);
+    hr = VariantCopyInd(&pair->key, key);
+    if (FAILED(hr))
+        return hr;
+
+    hr = get_dictkey(dict, &pair->key, &pair->dictkey);
+    if (FAILED(hr))
+        VariantClear(&pair->key);
+    return hr;
+}
+
+static HRESULT add_keyitem_pair(dictionary *dict, VARIANT *key, VARIANT *item, struct keyitem_pair **ret)
+{
+    struct keyitem_pair *pair;
+    HRESULT hr;
+
+    if (dict->count >= dict->buckets_size &&
+        !resize_buckets(dict, dict->buckets_size ? dict->buckets_size * 2 : DICT_MIN_BUCKETS))
+        return E_OUTOFMEMORY;
+
+    pair = heap_alloc(sizeof(*pair));
+    if (!pair)
+        return E_OUTOFMEMORY;
+
+    hr = set_pair_key(dict, pair, key);
+    if (FAILED(hr))
+    {
+        heap_free(pair);
+        return hr;
+    }
+
+    VariantInit(&pair->item);
+    hr = VariantCopyInd(&pair->item, item);
+    if (FAILED(hr))
+    {
+        VariantClear(&pair->key);
+        heap_free(pair);
+        return hr;
+    }
+
+    list_add_tail(&dict->pairs, &pair->entry);
+    list_add_tail(get_bucket(dict, pair->dictkey.hash), &pair->bucket);
+    dict->count++;
+
+    if (ret)
+        *ret = pair;
+    return S_OK;
+}
+
+static void free_keyitem_pair(struct keyitem_pair *pair)
+{
+    VariantClear(&pair->key);
+    VariantClear(&pair->item);
+    heap_free(pair);
+}
+
+/* Moves enumerators pointing to the removed pair to the next one, or to the end if pair is NULL. */
+static void notify_remove_pair(dictionary *dict, struct list *pair)
+{
+    struct dictionary_enum *denum;
+
+    LIST_FOR_EACH_ENTRY(denum, &dict->notifier, struct dictionary_enum, notify)
+    {
+        if (!pair)
+            denum->cur = NULL;
+        else if (denum->cur == pair)
+            denum->cur = list_next(&dict->pairs, pair);
+    }
+}
+
+static void remove_keyitem_pair(dictionary *dict, struct keyitem_pair *pair)
+{
+    notify_remove_pair(dict, &pair->entry);
+    list_remove(&pair->entry);
+    list_remove(&pair->bucket);
+    dict->count--;
+    free_keyitem_pair(pair);
+}
+
+static void remove_all_pairs(dictionary *dict)
+{
+    struct keyitem_pair *pair, *next;
+
+    notify_remove_pair(dict, NULL);
+
+    LIST_FOR_EACH_ENTRY_SAFE(pair, next, &dict->pairs, struct keyitem_pair, entry)
+        free_keyitem_pair(pair);
+
+    list_init(&dict->pairs);
+    heap_free(dict->buckets);
+    dict->buckets = NULL;
+    dict->buckets_size = 0;
+    dict->count = 0;
+}
+
+static HRESULT WINAPI dict_enum_QueryInterface(IEnumVARIANT *iface, REFIID riid, void **obj)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+
+    TRACE("(%p)->(%s %p)\n", This, debugstr_guid(riid), obj);
+
+    if (IsEqualIID(riid, &IID_IEnumVARIANT) || IsEqualIID(riid, &IID_IUnknown))
+    {
+        *obj = iface;
+        IEnumVARIANT_AddRef(iface);
+        return S_OK;
+    }
+
+    WARN("interface not supported %s\n", debugstr_guid(riid));
+    *obj = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI dict_enum_AddRef(IEnumVARIANT *iface)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+    ULONG ref = InterlockedIncrement(&This->ref);
+    TRACE("(%p)->(%u)\n", This, ref);
+    return ref;
+}
+
+static ULONG WINAPI dict_enum_Release(IEnumVARIANT *iface)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+    ULONG ref = InterlockedDecrement(&This->ref);
+
+    TRACE("(%p)->(%u)\n", This, ref);
+
+    if (!ref)
+    {
+        list_remove(&This->notify);
+        IDictionary_Release(&This->dict->IDictionary_iface);
+        heap_free(This);
+    }
+
+    return ref;
+}
+
+static HRESULT WINAPI dict_enum_Next(IEnumVARIANT *iface, ULONG count, VARIANT *keys, ULONG *fetched)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+    struct keyitem_pair *pair;
+    ULONG i = 0;
+    HRESULT hr;
+
+    TRACE("(%p)->(%u %p %p)\n", This, count, keys, fetched);
+
+    if (fetched)
+        *fetched = 0;
+
+    if (!count)
+        return S_OK;
+
+    while (This->cur && i < count)
+    {
+        pair = LIST_ENTRY(This->cur, struct keyitem_pair, entry);
+        VariantInit(&keys[i]);
+        hr = VariantCopy(&keys[i], &pair->key);
+        if (FAILED(hr))
+        {
+            while (i)
+                VariantClear(&keys[--i]);
+            return hr;
+        }
+        This->cur = list_next(&This->dict->pairs, This->cur);
+        i++;
+    }
+
+    if (fetched)
+        *fetched = i;
+
+    return i < count ? S_FALSE : S_OK;
+}
+
+static HRESULT WINAPI dict_enum_Skip(IEnumVARIANT *iface, ULONG count)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+
+    TRACE("(%p)->(%u)\n", This, count);
+
+    if (!count)
+        return S_OK;
+
+    while (This->cur && count)
+    {
+        This->cur = list_next(&This->dict->pairs, This->cur);
+        count--;
+    }
+
+    return count ? S_FALSE : S_OK;
+}
+
+static HRESULT WINAPI dict_enum_Reset(IEnumVARIANT *iface)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+
+    TRACE("(%p)\n", This);
+
+    This->cur = list_head(&This->dict->pairs);
+    return S_OK;
+}
+
+static HRESULT create_dict_enum(dictionary*,struct list*,IUnknown**);
+
+static HRESULT WINAPI dict_enum_Clone(IEnumVARIANT *iface, IEnumVARIANT **cloned)
+{
+    struct dictionary_enum *This = impl_from_IEnumVARIANT(iface);
+
+    TRACE("(%p)->(%p)\n", This, cloned);
+
+    return create_dict_enum(This->dict, This->cur, (IUnknown**)cloned);
+}
+
+static const IEnumVARIANTVtbl dictenumvtbl = {
+    dict_enum_QueryInterface,
+    dict_enum_AddRef,
+    dict_enum_Release,
+    dict_enum_Next,
+    dict_enum_Skip,
+    dict_enum_Reset,
+    dict_enum_Clone
+};
+
+static HRESULT create_dict_enum(dictionary *dict, struct list *cur, IUnknown **ret)
+{
+    struct dictionary_enum *This;
+
+    *ret = NULL;
+
+    This = heap_alloc(sizeof(*This));
+    if (!This)
+        return E_OUTOFMEMORY;
+
+    This->IEnumVARIANT_iface.lpVtbl = &dictenumvtbl;
+    This->ref = 1;
+    This->cur = cur;
+    This->dict = dict;
+    IDictionary_AddRef(&dict->IDictionary_iface);
+    list_add_tail(&dict->notifier, &This->notify);
+
+    *ret = (IUnknown*)&This->IEnumVARIANT_iface;
+    return S_OK;
+}
+
 static HRESULT WINAPI dictionary_QueryInterface(IDictionary *iface, REFIID riid, void **obj)
 {
     dictionary *This = impl_from_IDictionary(iface);
@@ -94,8 +563,10 @@ static ULONG WINAPI dictionary_Release(IDictionary *iface)
     TRACE("(%p)\n", This);
 
     ref = InterlockedDecrement(&This->ref);
-    if(ref == 0)
+    if(ref == 0) {
+        remove_all_pairs(This);
         heap_free(This);
+    }
 
     return ref;
 }
@@ -163,139 +634,355 @@ static HRESULT WINAPI dictionary_putref_Item(IDictionary *iface, VARIANT *Key, V
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->(%p %p)\n", This, Key, pRetItem);
+    TRACE("(%p)->(%s %s)\n", This, debugstr_variant(Key), debugstr_variant(pRetItem));
 
-    return E_NOTIMPL;
+    return IDictionary_put_Item(iface, Key, pRetItem);
 }
 
 static HRESULT WINAPI dictionary_put_Item(IDictionary *iface, VARIANT *Key, VARIANT *pRetItem)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct keyitem_pair *pair;
+    struct dictkey key;
+    VARIANT item;
+    HRESULT hr;
+
+    TRACE("(%p)->(%s %s)\n", This, debugstr_variant(Key), debugstr_variant(pRetItem));
+
+    hr = get_dictkey(This, Key, &key);
+    if (FAILED(hr))
+        return hr;
+
+    pair = get_keyitem_pair(This, &key);
+    if (!pair)
+        return add_keyitem_pair(This, Key, pRetItem, NULL);
 
-    FIXME("(%p)->(%p %p)\n", This, Key, pRetItem);
+    VariantInit(&item);
+    hr = VariantCopyInd(&item, pRetItem);
+    if (FAILED(hr))
+        return hr;
 
-    return E_NOTIMPL;
+    VariantClear(&pair->item);
+    pair->item = item;
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary_get_Item(IDictionary *iface, VARIANT *Key, VARIANT *pRetItem)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct keyitem_pair *pair;
+    struct dictkey key;
+    HRESULT hr;
+
+    TRACE("(%p)->(%s %p)\n", This, debugstr_variant(Key), pRetItem);
+
+    hr = get_dictkey(This, Key, &key);
+    if (FAILED(hr))
+        return hr;
 
-    FIXME("(%p)->(%p %p)\n", This, Key, pRetItem );
+    VariantInit(pRetItem);
 
-    return E_NOTIMPL;
+    /* Reading a missing key adds it with an empty item. */
+    pair = get_keyitem_pair(This, &key);
+    if (!pair)
+        return add_keyitem_pair(This, Key, pRetItem, NULL);
+
+    return VariantCopy(pRetItem, &pair->item);
 }
 
 static HRESULT WINAPI dictionary_Add(IDictionary *iface, VARIANT *Key, VARIANT *Item)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct dictkey key;
+    HRESULT hr;
+
+    TRACE("(%p)->(%s %s)\n", This, debugstr_variant(Key), debugstr_variant(Item));
 
-    FIXME("(%p)->(%p %p)\n", This, Key, Item);
+    hr = get_dictkey(This, Key, &key);
+    if (FAILED(hr))
+        return hr;
 
-    return E_NOTIMPL;
+    if (get_keyitem_pair(This, &key))
+        return CTL_E_KEY_ALREADY_EXISTS;
+
+    return add_keyitem_pair(This, Key, Item, NULL);
 }
 
 static HRESULT WINAPI dictionary_get_Count(IDictionary *iface, LONG *pCount)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->(%p)\n", This, pCount);
-
-    *pCount = 0;
+    TRACE("(%p)->(%p)\n", This, pCount);
 
+    *pCount = This->count;
     return S_OK;
 }
 
 static HRESULT WINAPI dictionary_Exists(IDictionary *iface, VARIANT *Key, VARIANT_BOOL *pExists)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct dictkey key;
+    HRESULT hr;
+
+    TRACE("(%p)->(%s %p)\n", This, debugstr_variant(Key), pExists);
 
-    FIXME("(%p)->(%p %p)\n", This, Key, pExists);
+    if (!pExists)
+        return CTL_E_ILLEGALFUNCTIONCALL;
 
-    return E_NOTIMPL;
+    hr = get_dictkey(This, Key, &key);
+    if (FAILED(hr))
+        return hr;
+
+    *pExists = get_keyitem_pair(This, &key) ? VARIANT_TRUE : VARIANT_FALSE;
+    return S_OK;
+}
+
+static HRESULT create_pairs_array(dictionary *dict, BOOL keys, VARIANT *ret)
+{
+    struct keyitem_pair *pair;
+    SAFEARRAYBOUND bound;
+    SAFEARRAY *sa;
+    VARIANT *v;
+    HRESULT hr;
+
+    bound.lLbound = 0;
+    bound.cElements = dict->count;
+    sa = SafeArrayCreate(VT_VARIANT, 1, &bound);
+    if (!sa)
+        return E_OUTOFMEMORY;
+
+    hr = SafeArrayAccessData(sa, (void**)&v);
+    if (FAILED(hr))
+    {
+        SafeArrayDestroy(sa);
+        return hr;
+    }
+
+    LIST_FOR_EACH_ENTRY(pair, &dict->pairs, struct keyitem_pair, entry)
+    {
+        hr = VariantCopy(v++, keys ? &pair->key : &pair->item);
+        if (FAILED(hr))
+            break;
+    }
+
+    SafeArrayUnaccessData(sa);
+    if (FAILED(hr))
+    {
+        SafeArrayDestroy(sa);
+        return hr;
+    }
+
+    V_VT(ret) = VT_ARRAY|VT_VARIANT;
+    V_ARRAY(ret) = sa;
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary_Items(IDictionary *iface, VARIANT *pItemsArray)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->(%p)\n", This, pItemsArray);
+    TRACE("(%p)->(%p)\n", This, pItemsArray);
 
-    return E_NOTIMPL;
+    if (!pItemsArray)
+        return S_OK;
+
+    return create_pairs_array(This, FALSE, pItemsArray);
 }
 
 static HRESULT WINAPI dictionary_put_Key(IDictionary *iface, VARIANT *Key, VARIANT *rhs)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct keyitem_pair *pair, *existing;
+    struct dictkey key, old_dictkey;
+    VARIANT old_key;
+    HRESULT hr;
 
-    FIXME("(%p)->(%p %p)\n", This, Key, rhs);
+    TRACE("(%p)->(%s %s)\n", This, debugstr_variant(Key), debugstr_variant(rhs));
+
+    hr = get_dictkey(This, Key, &key);
+    if (FAILED(hr))
+        return hr;
+
+    pair = get_keyitem_pair(This, &key);
+    if (!pair)
+        return CTL_E_ELEMENT_NOT_FOUND;
+
+    hr = get_dictkey(This, rhs, &key);
+    if (FAILED(hr))
+        return hr;
+
+    existing = get_keyitem_pair(This, &key);
+    if (existing && existing != pair)
+        return CTL_E_KEY_ALREADY_EXISTS;
+
+    old_key = pair->key;
+    old_dictkey = pair->dictkey;
+    hr = set_pair_key(This, pair, rhs);
+    if (FAILED(hr))
+    {
+        pair->key = old_key;
+        pair->dictkey = old_dictkey;
+        return hr;
+    }
 
-    return E_NOTIMPL;
+    VariantClear(&old_key);
+    list_remove(&pair->bucket);
+    list_add_tail(get_bucket(This, pair->dictkey.hash), &pair->bucket);
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary_Keys(IDictionary *iface, VARIANT *pKeysArray)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->(%p)\n", This, pKeysArray);
+    TRACE("(%p)->(%p)\n", This, pKeysArray);
+
+    if (!pKeysArray)
+        return S_OK;
 
-    return E_NOTIMPL;
+    return create_pairs_array(This, TRUE, pKeysArray);
 }
 
 static HRESULT WINAPI dictionary_Remove(IDictionary *iface, VARIANT *Key)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct keyitem_pair *pair;
+    struct dictkey key;
+    HRESULT hr;
+
+    TRACE("(%p)->(%s)\n", This, debugstr_variant(Key));
 
-    FIXME("(%p)->(%p)\n", This, Key);
+    hr = get_dictkey(This, Key, &key);
+    if (FAILED(hr))
+        return hr;
 
-    return E_NOTIMPL;
+    pair = get_keyitem_pair(This, &key);
+    if (!pair)
+        return CTL_E_ELEMENT_NOT_FOUND;
+
+    remove_keyitem_pair(This, pair);
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary_RemoveAll(IDictionary *iface)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->()\n", This);
+    TRACE("(%p)\n", This);
 
-    return E_NOTIMPL;
+    remove_all_pairs(This);
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary_put_CompareMode(IDictionary *iface, CompareMethod pcomp)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->()\n", This);
+    TRACE("(%p)->(%d)\n", This, pcomp);
 
-    return E_NOTIMPL;
+    if (This->count)
+        return CTL_E_ILLEGALFUNCTIONCALL;
+
+    This->method = pcomp;
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary_get_CompareMode(IDictionary *iface, CompareMethod *pcomp)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->(%p)\n", This, pcomp);
+    TRACE("(%p)->(%p)\n", This, pcomp);
 
-    return E_NOTIMPL;
+    *pcomp = This->method;
+    return S_OK;
 }
 
 static HRESULT WINAPI dictionary__NewEnum(IDictionary *iface, IUnknown **ppunk)
 {
     dictionary *This = impl_from_IDictionary(iface);
 
-    FIXME("(%p)->(%p)\n", This, ppunk);
+    TRACE("(%p)->(%p)\n", This, ppunk);
+
+    if (!ppunk)
+        return E_POINTER;
 
-    return E_NOTIMPL;
+    return create_dict_enum(This, list_head(&This->pairs), ppunk);
+}
+
+/* HashVal values are compatible with native, they are not used for the lookups. */
+static DWORD get_str_hashval(const dictionary *dict, const WCHAR *str, UINT len)
+{
+    DWORD hash = 0;
+    UINT i;
+
+    for (i = 0; i < len; i++)
+        hash += (hash << 4) + (is_text_compare(dict) ? tolowerW(str[i]) : str[i]);
+
+    return hash % DICT_HASH_MOD;
+}
+
+static HRESULT get_flt_hashval(FLOAT flt, LONG *hash)
+{
+    if (isinf(flt))
+    {
+        *hash = 0;
+        return S_OK;
+    }
+
+    if (!isnan(flt))
+    {
+        *hash = *(DWORD*)&flt % DICT_HASH_MOD;
+        return S_OK;
+    }
+
+    *hash = ~0u;
+    return CTL_E_ILLEGALFUNCTIONCALL;
 }
 
 static HRESULT WINAPI dictionary_get_HashVal(IDictionary *iface, VARIANT *Key, VARIANT *HashVal)
 {
     dictionary *This = impl_from_IDictionary(iface);
+    struct dictkey key;
+    VARIANT num;
+    HRESULT hr;
 
-    FIXME("(%p)->(%p %p)\n", This, Key, HashVal);
+    TRACE("(%p)->(%s %p)\n", This, debugstr_variant(Key), HashVal);
 
-    return E_NOTIMPL;
-}
+    if (V_VT(Key) == (VT_VARIANT|VT_BYREF))
+        Key = V_VARIANTREF(Key);
 
+    V_VT(HashVal) = VT_I4;
+    switch (V_VT(Key) & ~VT_BYREF)
+    {
+    case VT_EMPTY:
+    case VT_NULL:
+        V_I4(HashVal) = 0;
+        return S_OK;
+    case VT_BSTR:
+    case VT_UNKNOWN:
+    case VT_DISPATCH:
+        get_dictkey(This, Key, &key);
+        if (key.type == KEY_STRING)
+            V_I4(HashVal) = get_str_hashval(This, key.u.str.ptr, key.u.str.len);
+        else
+            V_I4(HashVal) = PtrToUlong(key.u.obj) % DICT_HASH_MOD;
+        return S_OK;
+    case VT_I2:
+    case VT_I4:
+    case VT_R4:
+    case VT_R8:
+    case VT_DATE:
+        V_VT(&num) = VT_EMPTY;
+        hr = VariantChangeType(&num, Key, 0, VT_R8);
+        if (FAILED(hr))
+            return hr;
+        return get_flt_hashval(V_R8(&num), &V_I4(HashVal));
+    default:
+        FIXME("unhandled key type %s\n", debugstr_vt(V_VT(Key)));
+        V_I4(HashVal) = ~0u;
+        return CTL_E_ILLEGALFUNCTIONCALL;
+    }
+}
 
 static const struct IDictionaryVtbl dictionary_vtbl =
 {
@@ -336,6 +1023,12 @@ HRESULT WINAPI Dictionary_CreateInstance(IClassFactory *factory,IUnknown *outer,
 
     This->IDictionary_iface.lpVtbl = &dictionary_vtbl;
     This->ref = 1;
+    This->method = BinaryCompare;
+    This->count = 0;
+    list_init(&This->pairs);
+    This->buckets = NULL;
+    This->buckets_size = 0;
+    list_init(&This->notifier);
 
     *obj = &This->IDictionary_iface;
 
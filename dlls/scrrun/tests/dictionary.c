@@ -26,6 +26,7 @@
 
 #include "wine/test.h"
 
+#include "olectl.h"
 #include "scrrun.h"
 
 static void test_interfaces(void)
@@ -66,37 +67,265 @@ static void test_interfaces(void)
     V_VT(&value) = VT_BSTR;
     V_BSTR(&value) = SysAllocString(key_add_value);
     hr = IDictionary_Add(dict, &key, &value);
-    todo_wine ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
+    ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
     VariantClear(&value);
 
     exists = VARIANT_FALSE;
     hr = IDictionary_Exists(dict, &key, &exists);
-    todo_wine ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
-    todo_wine ok(exists == VARIANT_TRUE, "Expected TRUE but got FALSE.\n");
+    ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
+    ok(exists == VARIANT_TRUE, "Expected TRUE but got FALSE.\n");
     VariantClear(&key);
 
     exists = VARIANT_TRUE;
     V_VT(&key) = VT_BSTR;
     V_BSTR(&key) = SysAllocString(key_non_exist);
     hr = IDictionary_Exists(dict, &key, &exists);
-    todo_wine ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
-    todo_wine ok(exists == VARIANT_FALSE, "Expected FALSE but got TRUE.\n");
+    ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
+    ok(exists == VARIANT_FALSE, "Expected FALSE but got TRUE.\n");
     VariantClear(&key);
 
     hr = IDictionary_get_Count(dict, &count);
     ok(hr == S_OK, "got 0x%08x, expected 0x%08x\n", hr, S_OK);
-    todo_wine ok(count == 1, "got %d, expected 1\n", count);
+    ok(count == 1, "got %d, expected 1\n", count);
 
     IDictionary_Release(dict);
     IDispatch_Release(disp);
 }
 
+static void test_comparemode(void)
+{
+    CompareMethod method;
+    IDictionary *dict;
+    VARIANT key, item;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_Dictionary, NULL, CLSCTX_INPROC_SERVER|CLSCTX_INPROC_HANDLER,
+            &IID_IDictionary, (void**)&dict);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    method = 10;
+    hr = IDictionary_get_CompareMode(dict, &method);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(method == BinaryCompare, "got %d\n", method);
+
+    hr = IDictionary_put_CompareMode(dict, TextCompare);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    method = 10;
+    hr = IDictionary_get_CompareMode(dict, &method);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(method == TextCompare, "got %d\n", method);
+
+    V_VT(&key) = VT_I2;
+    V_I2(&key) = 0;
+    VariantInit(&item);
+    hr = IDictionary_Add(dict, &key, &item);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    /* can't change mode of a non-empty dictionary */
+    hr = IDictionary_put_CompareMode(dict, BinaryCompare);
+    ok(hr == CTL_E_ILLEGALFUNCTIONCALL, "got 0x%08x\n", hr);
+
+    hr = IDictionary_RemoveAll(dict);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    hr = IDictionary_put_CompareMode(dict, BinaryCompare);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    IDictionary_Release(dict);
+}
+
+static void test_keys(void)
+{
+    static const WCHAR lowerW[] = {'k','e','y',0};
+    static const WCHAR upperW[] = {'K','E','Y',0};
+    VARIANT key, key2, item, keys, *data;
+    VARIANT_BOOL exists;
+    IDictionary *dict;
+    LONG count, i;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_Dictionary, NULL, CLSCTX_INPROC_SERVER|CLSCTX_INPROC_HANDLER,
+            &IID_IDictionary, (void**)&dict);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    /* numeric keys of different types are equal if their values are */
+    V_VT(&key) = VT_I2;
+    V_I2(&key) = 1;
+    V_VT(&item) = VT_I4;
+    V_I4(&item) = 10;
+    hr = IDictionary_Add(dict, &key, &item);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    V_VT(&key) = VT_R8;
+    V_R8(&key) = 1.0;
+    hr = IDictionary_Add(dict, &key, &item);
+    ok(hr == CTL_E_KEY_ALREADY_EXISTS, "got 0x%08x\n", hr);
+
+    V_VT(&key) = VT_BSTR;
+    V_BSTR(&key) = SysAllocString(lowerW);
+    hr = IDictionary_Add(dict, &key, &item);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    V_VT(&key2) = VT_BSTR;
+    V_BSTR(&key2) = SysAllocString(upperW);
+    exists = VARIANT_TRUE;
+    hr = IDictionary_Exists(dict, &key2, &exists);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(exists == VARIANT_FALSE, "got %x\n", exists);
+
+    /* reading a missing item adds it */
+    V_VT(&item) = VT_I4;
+    hr = IDictionary_get_Item(dict, &key2, &item);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_VT(&item) == VT_EMPTY, "got %d\n", V_VT(&item));
+
+    count = 0;
+    hr = IDictionary_get_Count(dict, &count);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(count == 3, "got %d\n", count);
+
+    hr = IDictionary_Remove(dict, &key);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    hr = IDictionary_Remove(dict, &key);
+    ok(hr == CTL_E_ELEMENT_NOT_FOUND, "got 0x%08x\n", hr);
+
+    hr = IDictionary_put_Key(dict, &key2, &key);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    /* keys are returned in insertion order */
+    VariantInit(&keys);
+    hr = IDictionary_Keys(dict, &keys);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_VT(&keys) == (VT_ARRAY|VT_VARIANT), "got %d\n", V_VT(&keys));
+    hr = SafeArrayGetUBound(V_ARRAY(&keys), 1, &i);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(i == 1, "got %d\n", i);
+    hr = SafeArrayAccessData(V_ARRAY(&keys), (void**)&data);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_VT(data) == VT_I2 && V_I2(data) == 1, "got %d\n", V_VT(data));
+    ok(V_VT(data+1) == VT_BSTR && !lstrcmpW(V_BSTR(data+1), lowerW), "got %d\n", V_VT(data+1));
+    SafeArrayUnaccessData(V_ARRAY(&keys));
+    VariantClear(&keys);
+
+    VariantClear(&key);
+    VariantClear(&key2);
+    IDictionary_Release(dict);
+}
+
+static void test_hash_value(void)
+{
+    static const WCHAR aW[] = {'a',0};
+    static const WCHAR AW[] = {'A',0};
+    VARIANT key, hash;
+    IDictionary *dict;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_Dictionary, NULL, CLSCTX_INPROC_SERVER|CLSCTX_INPROC_HANDLER,
+            &IID_IDictionary, (void**)&dict);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    V_VT(&key) = VT_BSTR;
+    V_BSTR(&key) = SysAllocString(AW);
+    VariantInit(&hash);
+    hr = IDictionary_get_HashVal(dict, &key, &hash);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_VT(&hash) == VT_I4, "got %d\n", V_VT(&hash));
+    ok(V_I4(&hash) == 65, "got %d\n", V_I4(&hash));
+
+    hr = IDictionary_put_CompareMode(dict, TextCompare);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    hr = IDictionary_get_HashVal(dict, &key, &hash);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_I4(&hash) == 97, "got %d\n", V_I4(&hash));
+    VariantClear(&key);
+
+    V_VT(&key) = VT_BSTR;
+    V_BSTR(&key) = SysAllocString(aW);
+    hr = IDictionary_get_HashVal(dict, &key, &hash);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_I4(&hash) == 97, "got %d\n", V_I4(&hash));
+    VariantClear(&key);
+
+    V_VT(&key) = VT_EMPTY;
+    hr = IDictionary_get_HashVal(dict, &key, &hash);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_I4(&hash) == 0, "got %d\n", V_I4(&hash));
+
+    IDictionary_Release(dict);
+}
+
+static void test_enum(void)
+{
+    IEnumVARIANT *enumvar;
+    VARIANT key, item, v;
+    IDictionary *dict;
+    IUnknown *unk;
+    ULONG fetched;
+    HRESULT hr;
+    int i;
+
+    hr = CoCreateInstance(&CLSID_Dictionary, NULL, CLSCTX_INPROC_SERVER|CLSCTX_INPROC_HANDLER,
+            &IID_IDictionary, (void**)&dict);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    VariantInit(&item);
+    V_VT(&key) = VT_I4;
+    for (i = 0; i < 3; i++)
+    {
+        V_I4(&key) = i;
+        hr = IDictionary_Add(dict, &key, &item);
+        ok(hr == S_OK, "got 0x%08x\n", hr);
+    }
+
+    hr = IDictionary__NewEnum(dict, &unk);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IUnknown_QueryInterface(unk, &IID_IEnumVARIANT, (void**)&enumvar);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    IUnknown_Release(unk);
+
+    fetched = 0;
+    VariantInit(&v);
+    hr = IEnumVARIANT_Next(enumvar, 1, &v, &fetched);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(fetched == 1, "got %u\n", fetched);
+    ok(V_VT(&v) == VT_I4 && V_I4(&v) == 0, "got %d\n", V_VT(&v));
+
+    /* removing the next key moves the enumerator forward */
+    V_I4(&key) = 1;
+    hr = IDictionary_Remove(dict, &key);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    hr = IEnumVARIANT_Next(enumvar, 1, &v, &fetched);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_VT(&v) == VT_I4 && V_I4(&v) == 2, "got %d\n", V_I4(&v));
+
+    hr = IEnumVARIANT_Next(enumvar, 1, &v, &fetched);
+    ok(hr == S_FALSE, "got 0x%08x\n", hr);
+    ok(fetched == 0, "got %u\n", fetched);
+
+    hr = IEnumVARIANT_Reset(enumvar);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IEnumVARIANT_Skip(enumvar, 2);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = IEnumVARIANT_Skip(enumvar, 1);
+    ok(hr == S_FALSE, "got 0x%08x\n", hr);
+
+    IEnumVARIANT_Release(enumvar);
+    IDictionary_Release(dict);
+}
+
 START_TEST(dictionary)
 {
     CoInitialize(NULL);
 
     test_interfaces();
-
+    test_comparemode();
+    test_keys();
+    test_hash_value();
+    test_enum();
 
     CoUninitialize();
 }
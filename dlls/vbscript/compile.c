@@ -921,12 +921,97 @@ static HRESULT compile_select_statement(compile_ctx_t *ctx, select_statement_t *
     return S_OK;
 }
 
+/*
+ * Function locals are numbered by slots: arguments come first, followed by variables in order of
+ * their declaration. The function name is never bound, since assigning to it sets the return value.
+ */
+static BOOL lookup_local_slot(compile_ctx_t *ctx, function_t *func, const WCHAR *name, unsigned *ret)
+{
+    dim_decl_t *dim_decl;
+    unsigned i;
+
+    if(func->type == FUNC_GLOBAL || !strcmpiW(func->name, name))
+        return FALSE;
+
+    for(i = 0; i < func->arg_cnt; i++) {
+        if(!strcmpiW(func->args[i].name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    for(dim_decl = ctx->dim_decls; dim_decl; dim_decl = dim_decl->next, i++) {
+        if(!strcmpiW(dim_decl->name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/* Returns TRUE for expressions like 'identifier & expr1 & expr2'. */
+static BOOL is_append_expression(expression_t *expr, const WCHAR *identifier)
+{
+    member_expression_t *member_expr;
+
+    if(expr->type != EXPR_CONCAT)
+        return FALSE;
+
+    do {
+        expr = ((binary_expression_t*)expr)->left;
+    }while(expr->type == EXPR_CONCAT);
+
+    if(expr->type != EXPR_MEMBER)
+        return FALSE;
+
+    member_expr = (member_expression_t*)expr;
+    return !member_expr->obj_expr && !member_expr->args && !strcmpiW(member_expr->identifier, identifier);
+}
+
+/* Compiles all operands of an append expression except the first one, concatenating them together. */
+static HRESULT compile_append_operands(compile_ctx_t *ctx, binary_expression_t *expr)
+{
+    HRESULT hres;
+
+    if(expr->left->type != EXPR_CONCAT)
+        return compile_expression(ctx, expr->right);
+
+    hres = compile_append_operands(ctx, (binary_expression_t*)expr->left);
+    if(FAILED(hres))
+        return hres;
+
+    hres = compile_expression(ctx, expr->right);
+    if(FAILED(hres))
+        return hres;
+
+    return push_instr(ctx, OP_concat) ? S_OK : E_OUTOFMEMORY;
+}
+
 static HRESULT compile_assignment(compile_ctx_t *ctx, member_expression_t *member_expr, expression_t *value_expr, BOOL is_set)
 {
-    unsigned args_cnt;
+    unsigned args_cnt, slot;
     vbsop_t op;
     HRESULT hres;
 
+    /* Repeated 'str = str & expr' on a local variable may grow the string in place. */
+    if(!is_set && !member_expr->obj_expr && !member_expr->args
+       && is_append_expression(value_expr, member_expr->identifier)
+       && lookup_local_slot(ctx, ctx->func, member_expr->identifier, &slot)) {
+        hres = compile_append_operands(ctx, (binary_expression_t*)value_expr);
+        if(FAILED(hres))
+            return hres;
+
+        hres = push_instr_uint(ctx, OP_append_local, slot);
+        if(FAILED(hres))
+            return hres;
+
+        if(!emit_catch(ctx, 0))
+            return E_OUTOFMEMORY;
+
+        return S_OK;
+    }
+
     if(member_expr->obj_expr) {
         hres = compile_expression(ctx, member_expr->obj_expr);
         if(FAILED(hres))
@@ -1302,6 +1387,50 @@ static void resolve_labels(compile_ctx_t *ctx, unsigned off)
     ctx->labels_cnt = 0;
 }
 
+/* Binds references to function arguments and variables to their slots. */
+static void resolve_locals(compile_ctx_t *ctx, function_t *func)
+{
+    instr_t *instr;
+    unsigned slot;
+
+    for(instr = ctx->code->instrs+func->code_off; instr < ctx->code->instrs+ctx->instr_cnt; instr++) {
+        switch(instr->op) {
+        case OP_icall:
+            if(lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_assign_ident:
+            if(lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_assign_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_set_ident:
+            if(lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_set_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_incc:
+            if(lookup_local_slot(ctx, func, instr->arg1.bstr, &slot)) {
+                instr->op = OP_incc_local;
+                instr->arg1.uint = slot;
+            }
+            break;
+        case OP_step:
+            if(lookup_local_slot(ctx, func, instr->arg2.bstr, &slot)) {
+                instr->op = OP_step_local;
+                instr->arg2.uint = slot;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 static HRESULT fill_array_desc(compile_ctx_t *ctx, dim_decl_t *dim_decl, array_desc_t *array_desc)
 {
     unsigned dim_cnt = 0, i;
@@ -1377,6 +1506,9 @@ static HRESULT compile_func(compile_ctx_t *ctx, statement_t *stat, function_t *f
 
     resolve_labels(ctx, func->code_off);
 
+    if(func->type != FUNC_GLOBAL)
+        resolve_locals(ctx, func);
+
     if(func->var_cnt) {
         dim_decl_t *dim_decl;
 
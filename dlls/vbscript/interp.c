@@ -26,6 +26,11 @@ WINE_DEFAULT_DEBUG_CHANNEL(vbscript);
 
 static DISPID propput_dispid = DISPID_PROPERTYPUT;
 
+typedef struct {
+    BSTR str;
+    unsigned size;
+} strbuf_t;
+
 typedef struct {
     vbscode_t *code;
     instr_t *instr;
@@ -37,6 +42,7 @@ typedef struct {
     VARIANT *args;
     VARIANT *vars;
     SAFEARRAY **arrays;
+    strbuf_t *strbufs;
 
     dynamic_var_t *dynamic_vars;
     heap_pool_t heap;
@@ -80,6 +86,31 @@ typedef struct {
     BOOL owned;
 } variant_val_t;
 
+static inline VARIANT *get_local(exec_ctx_t *ctx, unsigned slot)
+{
+    assert(slot < ctx->func->arg_cnt + ctx->func->var_cnt);
+    return slot < ctx->func->arg_cnt ? ctx->args+slot : ctx->vars+slot-ctx->func->arg_cnt;
+}
+
+static inline const WCHAR *get_local_name(exec_ctx_t *ctx, unsigned slot)
+{
+    return slot < ctx->func->arg_cnt ? ctx->func->args[slot].name : ctx->func->vars[slot-ctx->func->arg_cnt].name;
+}
+
+/* Called whenever a reference to the variable may be taken, so its string may not be grown in place anymore. */
+static inline void release_strbuf(exec_ctx_t *ctx, unsigned slot)
+{
+    if(ctx->strbufs)
+        ctx->strbufs[slot].str = NULL;
+}
+
+static void local_ref(exec_ctx_t *ctx, unsigned slot, ref_t *ref)
+{
+    release_strbuf(ctx, slot);
+    ref->type = REF_VAR;
+    ref->u.v = get_local(ctx, slot);
+}
+
 static BOOL lookup_dynamic_vars(dynamic_var_t *var, const WCHAR *name, ref_t *ref)
 {
     while(var) {
@@ -115,16 +146,14 @@ static HRESULT lookup_identifier(exec_ctx_t *ctx, BSTR name, vbdisp_invoke_type_
 
     for(i=0; i < ctx->func->var_cnt; i++) {
         if(!strcmpiW(ctx->func->vars[i].name, name)) {
-            ref->type = REF_VAR;
-            ref->u.v = ctx->vars+i;
+            local_ref(ctx, ctx->func->arg_cnt+i, ref);
             return TRUE;
         }
     }
 
     for(i=0; i < ctx->func->arg_cnt; i++) {
         if(!strcmpiW(ctx->func->args[i].name, name)) {
-            ref->type = REF_VAR;
-            ref->u.v = ctx->args+i;
+            local_ref(ctx, i, ref);
             return S_OK;
         }
     }
@@ -536,19 +565,12 @@ static HRESULT array_access(exec_ctx_t *ctx, SAFEARRAY *array, DISPPARAMS *dp, V
     return S_OK;
 }
 
-static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
+static HRESULT call_ref(exec_ctx_t *ctx, ref_t *ref, const WCHAR *identifier, unsigned arg_cnt, VARIANT *res)
 {
-    BSTR identifier = ctx->instr->arg1.bstr;
-    const unsigned arg_cnt = ctx->instr->arg2.uint;
     DISPPARAMS dp;
-    ref_t ref;
     HRESULT hres;
 
-    hres = lookup_identifier(ctx, identifier, VBDISP_CALLGET, &ref);
-    if(FAILED(hres))
-        return hres;
-
-    switch(ref.type) {
+    switch(ref->type) {
     case REF_VAR:
     case REF_CONST: {
         VARIANT *v;
@@ -558,17 +580,17 @@ static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
             return E_NOTIMPL;
         }
 
-        v = V_VT(ref.u.v) == (VT_VARIANT|VT_BYREF) ? V_VARIANTREF(ref.u.v) : ref.u.v;
+        v = V_VT(ref->u.v) == (VT_VARIANT|VT_BYREF) ? V_VARIANTREF(ref->u.v) : ref->u.v;
 
         if(arg_cnt) {
             SAFEARRAY *array = NULL;
 
             switch(V_VT(v)) {
             case VT_ARRAY|VT_BYREF|VT_VARIANT:
-                array = *V_ARRAYREF(ref.u.v);
+                array = *V_ARRAYREF(ref->u.v);
                 break;
             case VT_ARRAY|VT_VARIANT:
-                array = V_ARRAY(ref.u.v);
+                array = V_ARRAY(ref->u.v);
                 break;
             case VT_DISPATCH:
                 vbstack_to_dp(ctx, arg_cnt, FALSE, &dp);
@@ -596,13 +618,13 @@ static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
     }
     case REF_DISP:
         vbstack_to_dp(ctx, arg_cnt, FALSE, &dp);
-        hres = disp_call(ctx->script, ref.u.d.disp, ref.u.d.id, &dp, res);
+        hres = disp_call(ctx->script, ref->u.d.disp, ref->u.d.id, &dp, res);
         if(FAILED(hres))
             return hres;
         break;
     case REF_FUNC:
         vbstack_to_dp(ctx, arg_cnt, FALSE, &dp);
-        hres = exec_script(ctx->script, ref.u.f, NULL, &dp, res);
+        hres = exec_script(ctx->script, ref->u.f, NULL, &dp, res);
         if(FAILED(hres))
             return hres;
         break;
@@ -613,9 +635,9 @@ static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
         }
 
         if(res) {
-            IDispatch_AddRef(ref.u.obj);
+            IDispatch_AddRef(ref->u.obj);
             V_VT(res) = VT_DISPATCH;
-            V_DISPATCH(res) = ref.u.obj;
+            V_DISPATCH(res) = ref->u.obj;
         }
         break;
     case REF_NONE:
@@ -637,6 +659,19 @@ static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
     return S_OK;
 }
 
+static HRESULT do_icall(exec_ctx_t *ctx, VARIANT *res)
+{
+    BSTR identifier = ctx->instr->arg1.bstr;
+    ref_t ref;
+    HRESULT hres;
+
+    hres = lookup_identifier(ctx, identifier, VBDISP_CALLGET, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    return call_ref(ctx, &ref, identifier, ctx->instr->arg2.uint, res);
+}
+
 static HRESULT interp_icall(exec_ctx_t *ctx)
 {
     VARIANT v;
@@ -657,6 +692,23 @@ static HRESULT interp_icallv(exec_ctx_t *ctx)
     return do_icall(ctx, NULL);
 }
 
+static HRESULT interp_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg1.uint;
+    VARIANT v;
+    ref_t ref;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(get_local_name(ctx, slot)));
+
+    local_ref(ctx, slot, &ref);
+    hres = call_ref(ctx, &ref, get_local_name(ctx, slot), ctx->instr->arg2.uint, &v);
+    if(FAILED(hres))
+        return hres;
+
+    return stack_push(ctx, &v);
+}
+
 static HRESULT do_mcall(exec_ctx_t *ctx, VARIANT *res)
 {
     const BSTR identifier = ctx->instr->arg1.bstr;
@@ -709,18 +761,13 @@ static HRESULT interp_mcallv(exec_ctx_t *ctx)
     return do_mcall(ctx, NULL);
 }
 
-static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, DISPPARAMS *dp)
+static HRESULT assign_ref(exec_ctx_t *ctx, ref_t *ref, const WCHAR *name, DISPPARAMS *dp)
 {
-    ref_t ref;
     HRESULT hres;
 
-    hres = lookup_identifier(ctx, name, VBDISP_LET, &ref);
-    if(FAILED(hres))
-        return hres;
-
-    switch(ref.type) {
+    switch(ref->type) {
     case REF_VAR: {
-        VARIANT *v = ref.u.v;
+        VARIANT *v = ref->u.v;
 
         if(V_VT(v) == (VT_VARIANT|VT_BYREF))
             v = V_VARIANTREF(v);
@@ -762,7 +809,7 @@ static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, DISPPARAMS *dp)
         break;
     }
     case REF_DISP:
-        hres = disp_propput(ctx->script, ref.u.d.disp, ref.u.d.id, dp);
+        hres = disp_propput(ctx->script, ref->u.d.disp, ref->u.d.id, dp);
         break;
     case REF_FUNC:
         FIXME("functions not implemented\n");
@@ -791,6 +838,18 @@ static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, DISPPARAMS *dp)
     return hres;
 }
 
+static HRESULT assign_ident(exec_ctx_t *ctx, BSTR name, DISPPARAMS *dp)
+{
+    ref_t ref;
+    HRESULT hres;
+
+    hres = lookup_identifier(ctx, name, VBDISP_LET, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    return assign_ref(ctx, &ref, name, dp);
+}
+
 static HRESULT interp_assign_ident(exec_ctx_t *ctx)
 {
     const BSTR arg = ctx->instr->arg1.bstr;
@@ -840,6 +899,63 @@ static HRESULT interp_set_ident(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT assign_local(exec_ctx_t *ctx, unsigned slot, unsigned arg_cnt)
+{
+    DISPPARAMS dp;
+    ref_t ref;
+    HRESULT hres;
+
+    hres = stack_assume_val(ctx, arg_cnt);
+    if(FAILED(hres))
+        return hres;
+
+    vbstack_to_dp(ctx, arg_cnt, TRUE, &dp);
+    local_ref(ctx, slot, &ref);
+    hres = assign_ref(ctx, &ref, get_local_name(ctx, slot), &dp);
+    if(FAILED(hres))
+        return hres;
+
+    stack_popn(ctx, arg_cnt+1);
+    return S_OK;
+}
+
+static HRESULT interp_assign_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg1.uint;
+
+    TRACE("%s\n", debugstr_w(get_local_name(ctx, slot)));
+
+    return assign_local(ctx, slot, ctx->instr->arg2.uint);
+}
+
+static HRESULT interp_set_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg1.uint;
+    DISPPARAMS dp;
+    ref_t ref;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(get_local_name(ctx, slot)));
+
+    if(ctx->instr->arg2.uint) {
+        FIXME("arguments not supported\n");
+        return E_NOTIMPL;
+    }
+
+    hres = stack_assume_disp(ctx, 0, NULL);
+    if(FAILED(hres))
+        return hres;
+
+    vbstack_to_dp(ctx, 0, TRUE, &dp);
+    local_ref(ctx, slot, &ref);
+    hres = assign_ref(ctx, &ref, get_local_name(ctx, slot), &dp);
+    if(FAILED(hres))
+        return hres;
+
+    stack_popn(ctx, 1);
+    return S_OK;
+}
+
 static HRESULT interp_assign_member(exec_ctx_t *ctx)
 {
     BSTR identifier = ctx->instr->arg1.bstr;
@@ -1060,15 +1176,16 @@ static HRESULT interp_dim(exec_ctx_t *ctx)
     return S_OK;
 }
 
-static HRESULT interp_step(exec_ctx_t *ctx)
+static HRESULT do_step(exec_ctx_t *ctx, ref_t *ref, const WCHAR *ident)
 {
-    const BSTR ident = ctx->instr->arg2.bstr;
     BOOL gteq_zero;
     VARIANT zero;
-    ref_t ref;
     HRESULT hres;
 
-    TRACE("%s\n", debugstr_w(ident));
+    if(ref->type != REF_VAR) {
+        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
+        return E_FAIL;
+    }
 
     V_VT(&zero) = VT_I2;
     V_I2(&zero) = 0;
@@ -1078,16 +1195,7 @@ static HRESULT interp_step(exec_ctx_t *ctx)
 
     gteq_zero = hres == VARCMP_GT || hres == VARCMP_EQ;
 
-    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
-    if(FAILED(hres))
-        return hres;
-
-    if(ref.type != REF_VAR) {
-        FIXME("%s is not REF_VAR\n", debugstr_w(ident));
-        return E_FAIL;
-    }
-
-    hres = VarCmp(ref.u.v, stack_top(ctx, 1), ctx->script->lcid, 0);
+    hres = VarCmp(ref->u.v, stack_top(ctx, 1), ctx->script->lcid, 0);
     if(FAILED(hres))
         return hres;
 
@@ -1100,6 +1208,32 @@ static HRESULT interp_step(exec_ctx_t *ctx)
     return S_OK;
 }
 
+static HRESULT interp_step(exec_ctx_t *ctx)
+{
+    const BSTR ident = ctx->instr->arg2.bstr;
+    ref_t ref;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(ident));
+
+    hres = lookup_identifier(ctx, ident, VBDISP_ANY, &ref);
+    if(FAILED(hres))
+        return hres;
+
+    return do_step(ctx, &ref, ident);
+}
+
+static HRESULT interp_step_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg2.uint;
+    ref_t ref;
+
+    TRACE("%s\n", debugstr_w(get_local_name(ctx, slot)));
+
+    local_ref(ctx, slot, &ref);
+    return do_step(ctx, &ref, get_local_name(ctx, slot));
+}
+
 static HRESULT interp_newenum(exec_ctx_t *ctx)
 {
     variant_val_t v;
@@ -1776,6 +1910,102 @@ static HRESULT interp_concat(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+/*
+ * BSTR keeps its length in bytes in the DWORD preceding the string. Strings grown by append_bstr
+ * may have more memory allocated than their length says, so that repeated appends to the same
+ * variable don't need to copy the whole string every time.
+ */
+static inline void set_bstr_len(BSTR str, unsigned len)
+{
+    ((DWORD*)str)[-1] = len*sizeof(WCHAR);
+    str[len] = 0;
+}
+
+static HRESULT append_bstr(exec_ctx_t *ctx, unsigned slot, BSTR str)
+{
+    VARIANT *v = get_local(ctx, slot);
+    unsigned len, append_len;
+    strbuf_t *buf;
+
+    len = SysStringLen(V_BSTR(v));
+    append_len = SysStringLen(str);
+    if(!append_len)
+        return S_OK;
+
+    if(!ctx->strbufs) {
+        ctx->strbufs = heap_alloc_zero((ctx->func->arg_cnt+ctx->func->var_cnt) * sizeof(*ctx->strbufs));
+        if(!ctx->strbufs)
+            return E_OUTOFMEMORY;
+    }
+
+    buf = ctx->strbufs + slot;
+    if(buf->str == V_BSTR(v) && len + append_len <= buf->size) {
+        memcpy(V_BSTR(v)+len, str, append_len*sizeof(WCHAR));
+    }else {
+        unsigned size = len + append_len;
+        BSTR new_str;
+
+        /* Allocate the exact size on the first append, grow geometrically after that. */
+        if(buf->str == V_BSTR(v) && size < buf->size*2)
+            size = buf->size*2;
+
+        new_str = SysAllocStringLen(NULL, size);
+        if(!new_str)
+            return E_OUTOFMEMORY;
+
+        memcpy(new_str, V_BSTR(v), len*sizeof(WCHAR));
+        memcpy(new_str+len, str, append_len*sizeof(WCHAR));
+        SysFreeString(V_BSTR(v));
+        V_BSTR(v) = buf->str = new_str;
+        buf->size = size;
+    }
+
+    set_bstr_len(V_BSTR(v), len + append_len);
+    return S_OK;
+}
+
+static HRESULT interp_append_local(exec_ctx_t *ctx)
+{
+    const unsigned slot = ctx->instr->arg1.uint;
+    VARIANT *v = get_local(ctx, slot), *r = stack_top(ctx, 0);
+    VARIANT ref, val;
+    HRESULT hres;
+
+    TRACE("%s\n", debugstr_w(get_local_name(ctx, slot)));
+
+    if(V_VT(r) == (VT_BYREF|VT_VARIANT))
+        r = V_VARIANTREF(r);
+
+    if(V_VT(v) == VT_BSTR && V_VT(r) == VT_BSTR) {
+        hres = append_bstr(ctx, slot, V_BSTR(r));
+        if(FAILED(hres))
+            return hres;
+
+        stack_popn(ctx, 1);
+        return S_OK;
+    }
+
+    /* Otherwise do exactly what concat followed by assign_local would do. */
+    release_strbuf(ctx, slot);
+    V_VT(&ref) = VT_BYREF|VT_VARIANT;
+    V_VARIANTREF(&ref) = V_VT(v) == (VT_BYREF|VT_VARIANT) ? V_VARIANTREF(v) : v;
+
+    val = *stack_pop(ctx);
+    stack_push(ctx, &ref); /* can't fail, there is space for the popped value */
+    hres = stack_push(ctx, &val);
+    if(FAILED(hres)) {
+        VariantClear(&val);
+        stack_popn(ctx, 1);
+        return hres;
+    }
+
+    hres = interp_concat(ctx);
+    if(FAILED(hres))
+        return hres;
+
+    return assign_local(ctx, slot, 0);
+}
+
 static HRESULT interp_add(exec_ctx_t *ctx)
 {
     variant_val_t r, l;
@@ -1962,10 +2192,28 @@ static HRESULT interp_neg(exec_ctx_t *ctx)
     return stack_push(ctx, &v);
 }
 
+static HRESULT do_incc(exec_ctx_t *ctx, ref_t *ref)
+{
+    VARIANT v;
+    HRESULT hres;
+
+    if(ref->type != REF_VAR) {
+        FIXME("ref.type is not REF_VAR\n");
+        return E_FAIL;
+    }
+
+    hres = VarAdd(stack_top(ctx, 0), ref->u.v, &v);
+    if(FAILED(hres))
+        return hres;
+
+    VariantClear(ref->u.v);
+    *ref->u.v = v;
+    return S_OK;
+}
+
 static HRESULT interp_incc(exec_ctx_t *ctx)
 {
     const BSTR ident = ctx->instr->arg1.bstr;
-    VARIANT v;
     ref_t ref;
     HRESULT hres;
 
@@ -1975,18 +2223,17 @@ static HRESULT interp_incc(exec_ctx_t *ctx)
     if(FAILED(hres))
         return hres;
 
-    if(ref.type != REF_VAR) {
-        FIXME("ref.type is not REF_VAR\n");
-        return E_FAIL;
-    }
+    return do_incc(ctx, &ref);
+}
 
-    hres = VarAdd(stack_top(ctx, 0), ref.u.v, &v);
-    if(FAILED(hres))
-        return hres;
+static HRESULT interp_incc_local(exec_ctx_t *ctx)
+{
+    ref_t ref;
 
-    VariantClear(ref.u.v);
-    *ref.u.v = v;
-    return S_OK;
+    TRACE("\n");
+
+    local_ref(ctx, ctx->instr->arg1.uint, &ref);
+    return do_incc(ctx, &ref);
 }
 
 static HRESULT interp_catch(exec_ctx_t *ctx)
@@ -2044,6 +2291,7 @@ static void release_exec(exec_ctx_t *ctx)
     }
 
     heap_pool_free(&ctx->heap);
+    heap_free(ctx->strbufs);
     heap_free(ctx->args);
     heap_free(ctx->vars);
     heap_free(ctx->stack);
@@ -36,12 +36,16 @@ WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 #define WINED3D_BUFFER_DISCARD      0x10    /* A DISCARD lock has occurred since the last preload. */
 #define WINED3D_BUFFER_SYNC         0x20    /* There has been at least one synchronized map since the last preload. */
 #define WINED3D_BUFFER_APPLESYNC    0x40    /* Using sync as in GL_APPLE_flush_buffer_range. */
+#define WINED3D_BUFFER_PERSISTENT   0x80    /* Sub-allocating from a persistently mapped ring. */
 
 #define VB_MAXDECLCHANGES     100     /* After that number of decl changes we stop converting */
 #define VB_RESETDECLCHANGE    1000    /* Reset the decl changecount after that number of draws */
 #define VB_MAXFULLCONVERSIONS 5       /* Number of full conversions before we stop converting */
 #define VB_RESETFULLCONVS     20      /* Reset full conversion counts after that number of draws */
 
+#define WINED3D_BUFFER_RING_MIN_SIZE    (1024 * 1024)       /* Minimum size of a buffer ring */
+#define WINED3D_BUFFER_RING_MAX_SIZE    (16 * 1024 * 1024)  /* Don't use a ring if it would get larger than this */
+
 static void buffer_invalidate_bo_range(struct wined3d_buffer *buffer, UINT offset, UINT size)
 {
     if (!offset && !size)
@@ -101,20 +105,148 @@ static BOOL buffer_is_fully_dirty(const struct wined3d_buffer *buffer)
 }
 
 /* Context activation is done by the caller */
-static void delete_gl_buffer(struct wined3d_buffer *This, const struct wined3d_gl_info *gl_info)
+void buffer_destroy_buffer_object(struct wined3d_buffer *This, const struct wined3d_gl_info *gl_info)
 {
+    unsigned int i;
+
     if(!This->buffer_object) return;
 
     GL_EXTCALL(glDeleteBuffers(1, &This->buffer_object));
     checkGLcall("glDeleteBuffers");
     This->buffer_object = 0;
 
+    /* The ring fences are owned by the ring, buffer->query just points to
+     * the current one. */
+    if (This->flags & WINED3D_BUFFER_PERSISTENT)
+        This->query = NULL;
+    for (i = 0; i < WINED3D_BUFFER_RING_SEGMENTS; ++i)
+    {
+        if (This->ring_queries[i])
+        {
+            wined3d_event_query_destroy(This->ring_queries[i]);
+            This->ring_queries[i] = NULL;
+        }
+    }
+    This->ring_ptr = NULL;
+    This->ring_offset = 0;
+
     if(This->query)
     {
         wined3d_event_query_destroy(This->query);
         This->query = NULL;
     }
-    This->flags &= ~WINED3D_BUFFER_APPLESYNC;
+    This->flags &= ~(WINED3D_BUFFER_APPLESYNC | WINED3D_BUFFER_PERSISTENT);
+}
+
+static BOOL buffer_use_ring(const struct wined3d_buffer *buffer, const struct wined3d_gl_info *gl_info)
+{
+    if (!(buffer->resource.usage & WINED3DUSAGE_DYNAMIC)
+            || !gl_info->supported[ARB_BUFFER_STORAGE] || !gl_info->supported[ARB_SYNC])
+        return FALSE;
+
+    /* Constant buffers are bound without an offset, only vertex and index
+     * buffers can be sub-allocated. */
+    if (buffer->buffer_type_hint != GL_ELEMENT_ARRAY_BUFFER_ARB
+            && buffer->resource.format->id != WINED3DFMT_VERTEXDATA)
+        return FALSE;
+
+    return buffer->resource.size <= WINED3D_BUFFER_RING_MAX_SIZE / WINED3D_BUFFER_RING_SEGMENTS;
+}
+
+/* Dynamic vertex and index buffers are backed by a persistently mapped
+ * buffer object that holds several copies of the buffer. A DISCARD map moves
+ * on to the next copy instead of waiting for the GPU or relying on the
+ * driver to orphan the storage. The ring is split into
+ * WINED3D_BUFFER_RING_SEGMENTS segments with one fence each. Draws re-issue
+ * the fence of the current segment through buffer->query, and entering a
+ * segment waits for the draws that used it on the previous pass.
+ *
+ * The caller provides a context and binds the buffer. */
+static BOOL buffer_create_ring(struct wined3d_buffer *buffer, const struct wined3d_gl_info *gl_info)
+{
+    static const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT
+            | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    unsigned int i, count;
+    GLenum error;
+
+    buffer->ring_stride = (buffer->resource.size + RESOURCE_ALIGNMENT - 1) & ~(RESOURCE_ALIGNMENT - 1);
+    count = max(WINED3D_BUFFER_RING_MIN_SIZE / buffer->ring_stride, WINED3D_BUFFER_RING_SEGMENTS);
+    count = (count + WINED3D_BUFFER_RING_SEGMENTS - 1) & ~(WINED3D_BUFFER_RING_SEGMENTS - 1);
+    buffer->ring_segment_size = count / WINED3D_BUFFER_RING_SEGMENTS * buffer->ring_stride;
+    buffer->ring_size = count * buffer->ring_stride;
+    buffer->ring_offset = 0;
+
+    TRACE("Creating a %u byte ring with %u copies for buffer %p.\n", buffer->ring_size, count, buffer);
+
+    GL_EXTCALL(glBufferStorage(buffer->buffer_type_hint, buffer->ring_size, NULL, flags));
+    error = gl_info->gl_ops.gl.p_glGetError();
+    if (error != GL_NO_ERROR)
+    {
+        ERR("glBufferStorage failed with error %s (%#x)\n", debug_glerror(error), error);
+        return FALSE;
+    }
+
+    buffer->ring_ptr = GL_EXTCALL(glMapBufferRange(buffer->buffer_type_hint, 0, buffer->ring_size, flags));
+    checkGLcall("glMapBufferRange");
+    if (!buffer->ring_ptr || ((DWORD_PTR)buffer->ring_ptr) & (RESOURCE_ALIGNMENT - 1))
+    {
+        WARN("Failed to map the buffer ring, pointer %p.\n", buffer->ring_ptr);
+        return FALSE;
+    }
+
+    for (i = 0; i < WINED3D_BUFFER_RING_SEGMENTS; ++i)
+    {
+        if (!(buffer->ring_queries[i] = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*buffer->ring_queries[i]))))
+        {
+            ERR("Failed to allocate event query memory.\n");
+            return FALSE;
+        }
+    }
+
+    if (buffer->resource.heap_memory)
+        memcpy(buffer->ring_ptr, buffer->resource.heap_memory, buffer->resource.size);
+
+    buffer->query = buffer->ring_queries[0];
+    buffer->flags |= WINED3D_BUFFER_PERSISTENT;
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static void buffer_sync_ring(struct wined3d_buffer *buffer, struct wined3d_context *context, DWORD flags)
+{
+    struct wined3d_device *device = buffer->resource.device;
+    enum wined3d_event_query_result ret;
+    unsigned int segment;
+
+    if (flags & WINED3D_MAP_DISCARD)
+    {
+        segment = buffer->ring_offset / buffer->ring_segment_size;
+        buffer->ring_offset += buffer->ring_stride;
+        if (buffer->ring_offset >= buffer->ring_size)
+            buffer->ring_offset = 0;
+
+        /* The stream sources have to pick up the new offset. Index buffer
+         * offsets are read on each draw. */
+        if (buffer->resource.bind_count && buffer->buffer_type_hint != GL_ELEMENT_ARRAY_BUFFER_ARB)
+            device_invalidate_state(device, STATE_STREAMSRC);
+
+        if (buffer->ring_offset / buffer->ring_segment_size == segment)
+            return;
+        buffer->query = buffer->ring_queries[buffer->ring_offset / buffer->ring_segment_size];
+    }
+    else if (flags & WINED3D_MAP_NOOVERWRITE)
+    {
+        return;
+    }
+
+    TRACE("Synchronizing buffer %p, ring offset %u.\n", buffer, buffer->ring_offset);
+    ret = wined3d_event_query_finish(buffer->query, device);
+    if (ret != WINED3D_EVENT_QUERY_OK && ret != WINED3D_EVENT_QUERY_NOT_STARTED)
+    {
+        ERR("wined3d_event_query_finish returned %u, falling back to glFinish.\n", ret);
+        context->gl_info->gl_ops.gl.p_glFinish();
+    }
 }
 
 /* Context activation is done by the caller. */
@@ -158,38 +290,46 @@ static void buffer_create_buffer_object(struct wined3d_buffer *This, struct wine
         goto fail;
     }
 
-    if (This->resource.usage & WINED3DUSAGE_DYNAMIC)
+    if (buffer_use_ring(This, gl_info))
     {
-        TRACE("Buffer has WINED3DUSAGE_DYNAMIC set.\n");
-        gl_usage = GL_STREAM_DRAW_ARB;
-
-        if(gl_info->supported[APPLE_FLUSH_BUFFER_RANGE])
+        if (!buffer_create_ring(This, gl_info))
+            goto fail;
+    }
+    else
+    {
+        if (This->resource.usage & WINED3DUSAGE_DYNAMIC)
         {
-            GL_EXTCALL(glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_FLUSHING_UNMAP_APPLE, GL_FALSE));
-            checkGLcall("glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_FLUSHING_UNMAP_APPLE, GL_FALSE)");
-            This->flags |= WINED3D_BUFFER_FLUSH;
+            TRACE("Buffer has WINED3DUSAGE_DYNAMIC set.\n");
+            gl_usage = GL_STREAM_DRAW_ARB;
+
+            if(gl_info->supported[APPLE_FLUSH_BUFFER_RANGE])
+            {
+                GL_EXTCALL(glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_FLUSHING_UNMAP_APPLE, GL_FALSE));
+                checkGLcall("glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_FLUSHING_UNMAP_APPLE, GL_FALSE)");
+                This->flags |= WINED3D_BUFFER_FLUSH;
 
-            GL_EXTCALL(glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_SERIALIZED_MODIFY_APPLE, GL_FALSE));
-            checkGLcall("glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_SERIALIZED_MODIFY_APPLE, GL_FALSE)");
-            This->flags |= WINED3D_BUFFER_APPLESYNC;
+                GL_EXTCALL(glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_SERIALIZED_MODIFY_APPLE, GL_FALSE));
+                checkGLcall("glBufferParameteriAPPLE(This->buffer_type_hint, GL_BUFFER_SERIALIZED_MODIFY_APPLE, GL_FALSE)");
+                This->flags |= WINED3D_BUFFER_APPLESYNC;
+            }
+            /* No setup is needed here for GL_ARB_map_buffer_range */
         }
-        /* No setup is needed here for GL_ARB_map_buffer_range */
-    }
 
-    /* Reserve memory for the buffer. The amount of data won't change
-     * so we are safe with calling glBufferData once and
-     * calling glBufferSubData on updates. Upload the actual data in case
-     * we're not double buffering, so we can release the heap mem afterwards
-     */
-    GL_EXTCALL(glBufferData(This->buffer_type_hint, This->resource.size, This->resource.heap_memory, gl_usage));
-    error = gl_info->gl_ops.gl.p_glGetError();
-    if (error != GL_NO_ERROR)
-    {
-        ERR("glBufferData failed with error %s (%#x)\n", debug_glerror(error), error);
-        goto fail;
-    }
+        /* Reserve memory for the buffer. The amount of data won't change
+         * so we are safe with calling glBufferData once and
+         * calling glBufferSubData on updates. Upload the actual data in case
+         * we're not double buffering, so we can release the heap mem afterwards
+         */
+        GL_EXTCALL(glBufferData(This->buffer_type_hint, This->resource.size, This->resource.heap_memory, gl_usage));
+        error = gl_info->gl_ops.gl.p_glGetError();
+        if (error != GL_NO_ERROR)
+        {
+            ERR("glBufferData failed with error %s (%#x)\n", debug_glerror(error), error);
+            goto fail;
+        }
 
-    This->buffer_object_usage = gl_usage;
+        This->buffer_object_usage = gl_usage;
+    }
 
     if (This->flags & WINED3D_BUFFER_DOUBLEBUFFER)
         buffer_invalidate_bo_range(This, 0, 0);
@@ -201,7 +341,7 @@ static void buffer_create_buffer_object(struct wined3d_buffer *This, struct wine
 fail:
     /* Clean up all vbo init, but continue because we can work without a vbo :-) */
     ERR("Failed to create a vertex buffer object. Continuing, but performance issues may occur\n");
-    delete_gl_buffer(This, gl_info);
+    buffer_destroy_buffer_object(This, gl_info);
     buffer_clear_dirty_areas(This);
 }
 
@@ -472,7 +612,7 @@ void buffer_get_memory(struct wined3d_buffer *buffer, struct wined3d_context *co
     }
     else
     {
-        data->addr = NULL;
+        data->addr = (BYTE *)(ULONG_PTR)buffer->ring_offset;
     }
 }
 
@@ -497,11 +637,18 @@ BYTE *buffer_get_sysmem(struct wined3d_buffer *This, struct wined3d_context *con
     if (!wined3d_resource_allocate_sysmem(&This->resource))
         ERR("Failed to allocate system memory.\n");
 
-    if (This->buffer_type_hint == GL_ELEMENT_ARRAY_BUFFER_ARB)
-        context_invalidate_state(context, STATE_INDEXBUFFER);
+    if (This->flags & WINED3D_BUFFER_PERSISTENT)
+    {
+        memcpy(This->resource.heap_memory, This->ring_ptr + This->ring_offset, This->resource.size);
+    }
+    else
+    {
+        if (This->buffer_type_hint == GL_ELEMENT_ARRAY_BUFFER_ARB)
+            context_invalidate_state(context, STATE_INDEXBUFFER);
 
-    GL_EXTCALL(glBindBuffer(This->buffer_type_hint, This->buffer_object));
-    GL_EXTCALL(glGetBufferSubData(This->buffer_type_hint, 0, This->resource.size, This->resource.heap_memory));
+        GL_EXTCALL(glBindBuffer(This->buffer_type_hint, This->buffer_object));
+        GL_EXTCALL(glGetBufferSubData(This->buffer_type_hint, 0, This->resource.size, This->resource.heap_memory));
+    }
     This->flags |= WINED3D_BUFFER_DOUBLEBUFFER;
 
     return This->resource.heap_memory;
@@ -527,7 +674,7 @@ static void buffer_unload(struct wined3d_resource *resource)
             buffer->flags &= ~WINED3D_BUFFER_DOUBLEBUFFER;
         }
 
-        delete_gl_buffer(buffer, context->gl_info);
+        buffer_destroy_buffer_object(buffer, context->gl_info);
         buffer->flags |= WINED3D_BUFFER_CREATEBO; /* Recreate the buffer object next load */
         buffer_clear_dirty_areas(buffer);
 
@@ -555,7 +702,7 @@ ULONG CDECL wined3d_buffer_decref(struct wined3d_buffer *buffer)
         if (buffer->buffer_object)
         {
             context = context_acquire(buffer->resource.device, NULL);
-            delete_gl_buffer(buffer, context->gl_info);
+            buffer_destroy_buffer_object(buffer, context->gl_info);
             context_release(context);
 
             HeapFree(GetProcessHeap(), 0, buffer->conversion_map);
@@ -646,6 +793,30 @@ drop_query:
     This->flags &= ~WINED3D_BUFFER_APPLESYNC;
 }
 
+/* Context activation is done by the caller. */
+static void buffer_ring_upload(struct wined3d_buffer *buffer, struct wined3d_context *context, DWORD flags)
+{
+    DWORD syncflags = 0;
+    UINT start, len;
+
+    if (flags & WINED3D_BUFFER_DISCARD)
+        syncflags |= WINED3D_MAP_DISCARD;
+    else if (!(flags & WINED3D_BUFFER_SYNC))
+        syncflags |= WINED3D_MAP_NOOVERWRITE;
+    buffer_sync_ring(buffer, context, syncflags);
+
+    while (buffer->modified_areas)
+    {
+        buffer->modified_areas--;
+        start = buffer->maps[buffer->modified_areas].offset;
+        len = buffer->maps[buffer->modified_areas].size;
+
+        memcpy(buffer->ring_ptr + buffer->ring_offset + start, (BYTE *)buffer->resource.heap_memory + start, len);
+        wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOADS, 1);
+        wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOAD_BYTES, len);
+    }
+}
+
 /* The caller provides a GL context */
 static void buffer_direct_upload(struct wined3d_buffer *This, const struct wined3d_gl_info *gl_info, DWORD flags)
 {
@@ -695,6 +866,8 @@ static void buffer_direct_upload(struct wined3d_buffer *This, const struct wined
         len = This->maps[This->modified_areas].size;
 
         memcpy(map + start, (BYTE *)This->resource.heap_memory + start, len);
+        wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOADS, 1);
+        wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOAD_BYTES, len);
 
         if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
         {
@@ -863,7 +1036,10 @@ void buffer_internal_preload(struct wined3d_buffer *buffer, struct wined3d_conte
             return;
         }
 
-        buffer_direct_upload(buffer, context->gl_info, flags);
+        if (buffer->flags & WINED3D_BUFFER_PERSISTENT)
+            buffer_ring_upload(buffer, context, flags);
+        else
+            buffer_direct_upload(buffer, context->gl_info, flags);
 
         return;
     }
@@ -917,6 +1093,8 @@ void buffer_internal_preload(struct wined3d_buffer *buffer, struct wined3d_conte
         checkGLcall("glBindBuffer");
         GL_EXTCALL(glBufferSubData(buffer->buffer_type_hint, start, len, data + start));
         checkGLcall("glBufferSubData");
+        wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOADS, 1);
+        wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOAD_BYTES, len);
     }
 
     HeapFree(GetProcessHeap(), 0, data);
@@ -944,6 +1122,8 @@ HRESULT CDECL wined3d_buffer_map(struct wined3d_buffer *buffer, UINT offset, UIN
 
     TRACE("buffer %p, offset %u, size %u, data %p, flags %#x\n", buffer, offset, size, data, flags);
 
+    buffer->resource.device->cs->ops->finish(buffer->resource.device->cs);
+
     flags = wined3d_resource_sanitize_map_flags(&buffer->resource, flags);
     /* Filter redundant WINED3D_MAP_DISCARD maps. The 3DMark2001 multitexture
      * fill rate test seems to depend on this. When we map a buffer with
@@ -966,7 +1146,22 @@ HRESULT CDECL wined3d_buffer_map(struct wined3d_buffer *buffer, UINT offset, UIN
         else if (!(flags & WINED3D_MAP_READONLY))
             buffer_invalidate_bo_range(buffer, offset, size);
 
-        if (!(buffer->flags & WINED3D_BUFFER_DOUBLEBUFFER))
+        if (!(buffer->flags & WINED3D_BUFFER_DOUBLEBUFFER) && (buffer->flags & WINED3D_BUFFER_PERSISTENT))
+        {
+            if (count == 1)
+            {
+                struct wined3d_context *context;
+
+                context = context_acquire(buffer->resource.device, NULL);
+                /* Nothing has been drawn from the current copy since the
+                 * last DISCARD map if the flag is still set. */
+                buffer_sync_ring(buffer, context, buffer->flags & WINED3D_BUFFER_DISCARD
+                        ? WINED3D_MAP_NOOVERWRITE : flags);
+                context_release(context);
+            }
+            buffer->map_ptr = buffer->ring_ptr + buffer->ring_offset;
+        }
+        else if (!(buffer->flags & WINED3D_BUFFER_DOUBLEBUFFER))
         {
             if (count == 1)
             {
@@ -984,6 +1179,17 @@ HRESULT CDECL wined3d_buffer_map(struct wined3d_buffer *buffer, UINT offset, UIN
                 if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
                 {
                     GLbitfield mapflags = wined3d_resource_gl_map_flags(flags);
+
+                    /* Some drivers wait for the GPU on GL_MAP_INVALIDATE_BUFFER_BIT
+                     * instead of reallocating the storage. Orphan it explicitly. */
+                    if ((flags & WINED3D_MAP_DISCARD) && (buffer->resource.usage & WINED3DUSAGE_DYNAMIC))
+                    {
+                        GL_EXTCALL(glBufferData(buffer->buffer_type_hint, buffer->resource.size,
+                                NULL, buffer->buffer_object_usage));
+                        checkGLcall("glBufferData");
+                        mapflags &= ~GL_MAP_INVALIDATE_BUFFER_BIT;
+                        mapflags |= GL_MAP_UNSYNCHRONIZED_BIT;
+                    }
                     buffer->map_ptr = GL_EXTCALL(glMapBufferRange(buffer->buffer_type_hint,
                             0, buffer->resource.size, mapflags));
                     checkGLcall("glMapBufferRange");
@@ -1067,7 +1273,19 @@ void CDECL wined3d_buffer_unmap(struct wined3d_buffer *buffer)
         return;
     }
 
-    if (!(buffer->flags & WINED3D_BUFFER_DOUBLEBUFFER) && buffer->buffer_object)
+    if (!(buffer->flags & WINED3D_BUFFER_DOUBLEBUFFER) && (buffer->flags & WINED3D_BUFFER_PERSISTENT))
+    {
+        /* The ring is mapped coherently, there is nothing to flush. */
+        for (i = 0; i < buffer->modified_areas; ++i)
+        {
+            wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOADS, 1);
+            wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOAD_BYTES, buffer->maps[i].size);
+        }
+
+        buffer_clear_dirty_areas(buffer);
+        buffer->map_ptr = NULL;
+    }
+    else if (!(buffer->flags & WINED3D_BUFFER_DOUBLEBUFFER) && buffer->buffer_object)
     {
         struct wined3d_device *device = buffer->resource.device;
         const struct wined3d_gl_info *gl_info;
@@ -1080,6 +1298,12 @@ void CDECL wined3d_buffer_unmap(struct wined3d_buffer *buffer)
             context_invalidate_state(context, STATE_INDEXBUFFER);
         GL_EXTCALL(glBindBuffer(buffer->buffer_type_hint, buffer->buffer_object));
 
+        for (i = 0; i < buffer->modified_areas; ++i)
+        {
+            wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOADS, 1);
+            wined3d_perf_count(WINED3D_PERF_BUFFER_UPLOAD_BYTES, buffer->maps[i].size);
+        }
+
         if (gl_info->supported[ARB_MAP_BUFFER_RANGE])
         {
             for (i = 0; i < buffer->modified_areas; ++i)
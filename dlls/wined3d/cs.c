@@ -18,11 +18,19 @@
 
 #include "config.h"
 #include "wine/port.h"
+
+#include <assert.h>
+#include <stdio.h>
+
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 
 #define WINED3D_INITIAL_CS_SIZE 4096
+#define WINED3D_CS_QUEUE_SIZE   0x100000 /* must be a power of two */
+#define WINED3D_CS_SPIN_COUNT   10000
+#define WINED3D_CS_MAX_PACKET_SIZE (WINED3D_CS_QUEUE_SIZE / 2)
+#define WINED3D_CS_MAX_CLEAR_RECTS 1024 /* larger clears are split */
 
 enum wined3d_cs_op
 {
@@ -50,7 +58,17 @@ enum wined3d_cs_op
     WINED3D_CS_OP_SET_TRANSFORM,
     WINED3D_CS_OP_SET_CLIP_PLANE,
     WINED3D_CS_OP_SET_MATERIAL,
+    WINED3D_CS_OP_SET_LIGHT_ENABLE,
+    WINED3D_CS_OP_PUSH_CONSTANTS,
     WINED3D_CS_OP_RESET_STATE,
+    WINED3D_CS_OP_NOP,
+    WINED3D_CS_OP_STOP,
+};
+
+struct wined3d_cs_packet
+{
+    size_t size;
+    BYTE data[1];
 };
 
 struct wined3d_cs_present
@@ -58,26 +76,30 @@ struct wined3d_cs_present
     enum wined3d_cs_op opcode;
     HWND dst_window_override;
     struct wined3d_swapchain *swapchain;
-    const RECT *src_rect;
-    const RECT *dst_rect;
-    const RGNDATA *dirty_region;
+    RECT src_rect;
+    RECT dst_rect;
+    BOOL has_src_rect;
+    BOOL has_dst_rect;
     DWORD flags;
 };
 
 struct wined3d_cs_clear
 {
     enum wined3d_cs_op opcode;
-    DWORD rect_count;
-    const RECT *rects;
     DWORD flags;
-    const struct wined3d_color *color;
+    struct wined3d_color color;
     float depth;
     DWORD stencil;
+    DWORD rect_count;
+    RECT rects[1];
 };
 
 struct wined3d_cs_draw
 {
     enum wined3d_cs_op opcode;
+    GLenum primitive_type;
+    INT base_vertex_idx;
+    INT load_base_vertex_idx;
     UINT start_idx;
     UINT index_count;
     UINT start_instance;
@@ -95,13 +117,13 @@ struct wined3d_cs_set_predication
 struct wined3d_cs_set_viewport
 {
     enum wined3d_cs_op opcode;
-    const struct wined3d_viewport *viewport;
+    struct wined3d_viewport viewport;
 };
 
 struct wined3d_cs_set_scissor_rect
 {
     enum wined3d_cs_op opcode;
-    const RECT *rect;
+    RECT rect;
 };
 
 struct wined3d_cs_set_rendertarget_view
@@ -220,20 +242,36 @@ struct wined3d_cs_set_transform
 {
     enum wined3d_cs_op opcode;
     enum wined3d_transform_state state;
-    const struct wined3d_matrix *matrix;
+    struct wined3d_matrix matrix;
 };
 
 struct wined3d_cs_set_clip_plane
 {
     enum wined3d_cs_op opcode;
     UINT plane_idx;
-    const struct wined3d_vec4 *plane;
+    struct wined3d_vec4 plane;
 };
 
 struct wined3d_cs_set_material
 {
     enum wined3d_cs_op opcode;
-    const struct wined3d_material *material;
+    struct wined3d_material material;
+};
+
+struct wined3d_cs_set_light_enable
+{
+    enum wined3d_cs_op opcode;
+    UINT gl_idx;
+    const struct wined3d_light_info *light;
+};
+
+struct wined3d_cs_push_constants
+{
+    enum wined3d_cs_op opcode;
+    enum wined3d_cs_push_constants_type type;
+    UINT start_idx;
+    UINT count;
+    BYTE constants[1];
 };
 
 struct wined3d_cs_reset_state
@@ -241,6 +279,140 @@ struct wined3d_cs_reset_state
     enum wined3d_cs_op opcode;
 };
 
+struct wined3d_cs_nop
+{
+    enum wined3d_cs_op opcode;
+};
+
+struct wined3d_cs_stop
+{
+    enum wined3d_cs_op opcode;
+};
+
+static const char * const wined3d_perf_counter_names[] =
+{
+    /* WINED3D_PERF_DRAWS                   */ "draws",
+    /* WINED3D_PERF_CLEARS                  */ "clears",
+    /* WINED3D_PERF_STATE_CHANGES           */ "state changes",
+    /* WINED3D_PERF_STATE_APPLICATIONS      */ "state applications",
+    /* WINED3D_PERF_BUFFER_UPLOADS          */ "buffer uploads",
+    /* WINED3D_PERF_BUFFER_UPLOAD_BYTES     */ "buffer upload bytes",
+    /* WINED3D_PERF_SURFACE_UPLOADS         */ "surface uploads",
+    /* WINED3D_PERF_SURFACE_LOADS           */ "surface loads",
+    /* WINED3D_PERF_SHADER_COMPILES         */ "shader compiles",
+    /* WINED3D_PERF_PROGRAM_LINKS           */ "program links",
+    /* WINED3D_PERF_GL_CALLS                */ "GL calls",
+};
+
+#define WINED3D_PERF_LOG_INTERVAL 1000 /* ms */
+
+static struct
+{
+    struct wined3d_perf_stats stats;
+    struct wined3d_perf_stats *shared;
+    BOOL shared_failed;
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER frame_start;
+    LARGE_INTEGER log_start;
+    ULONG64 log_frame_count;
+    ULONG64 log_total[WINED3D_PERF_COUNTER_COUNT];
+} wined3d_perf;
+
+static struct wined3d_perf_stats *wined3d_perf_get_shared_block(void)
+{
+    char name[64];
+    HANDLE mapping;
+
+    if (wined3d_perf.shared || wined3d_perf.shared_failed)
+        return wined3d_perf.shared;
+
+    sprintf(name, WINED3D_PERF_STATS_NAME, GetCurrentProcessId());
+    /* The mapping is intentionally leaked, it has to live as long as the process. */
+    if (!(mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+            0, sizeof(*wined3d_perf.shared), name))
+            || !(wined3d_perf.shared = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0)))
+    {
+        ERR("Failed to create performance statistics block %s, error %u.\n", debugstr_a(name), GetLastError());
+        if (mapping)
+            CloseHandle(mapping);
+        wined3d_perf.shared_failed = TRUE;
+        return NULL;
+    }
+
+    TRACE("Publishing performance statistics as %s.\n", debugstr_a(name));
+    return wined3d_perf.shared;
+}
+
+static void wined3d_perf_log(const LARGE_INTEGER *now)
+{
+    ULONG64 frames = wined3d_perf.stats.frame_count - wined3d_perf.log_frame_count;
+    char line[1024], *ptr = line;
+    double elapsed;
+    unsigned int i;
+
+    elapsed = (double)(now->QuadPart - wined3d_perf.log_start.QuadPart) / wined3d_perf.frequency.QuadPart;
+    ptr += sprintf(ptr, "%.1f fps, per frame:", frames / elapsed);
+    for (i = 0; i < WINED3D_PERF_COUNTER_COUNT; ++i)
+    {
+        ptr += sprintf(ptr, "%s %s %s", i ? "," : "", wine_dbgstr_longlong((wined3d_perf.stats.total[i]
+                - wined3d_perf.log_total[i]) / frames), wined3d_perf_counter_names[i]);
+        wined3d_perf.log_total[i] = wined3d_perf.stats.total[i];
+    }
+    MESSAGE("wined3d: %s.\n", line);
+
+    wined3d_perf.log_frame_count = wined3d_perf.stats.frame_count;
+    wined3d_perf.log_start = *now;
+}
+
+/* Aggregates the counters of the frame that just ended. */
+static void wined3d_perf_end_frame(void)
+{
+    struct wined3d_perf_stats *shared;
+    LARGE_INTEGER now;
+    unsigned int i;
+    LONG count;
+
+    if (!wined3d_settings.perf_stats)
+        return;
+
+    QueryPerformanceCounter(&now);
+    if (!wined3d_perf.frequency.QuadPart)
+    {
+        QueryPerformanceFrequency(&wined3d_perf.frequency);
+        wined3d_perf.stats.version = WINED3D_PERF_STATS_VERSION;
+        wined3d_perf.stats.counter_count = WINED3D_PERF_COUNTER_COUNT;
+        wined3d_perf.frame_start = wined3d_perf.log_start = now;
+    }
+
+    for (i = 0; i < WINED3D_PERF_COUNTER_COUNT; ++i)
+    {
+        count = InterlockedExchange(&wined3d_perf_counters[i], 0);
+        wined3d_perf.stats.last_frame[i] = (ULONG)count;
+        wined3d_perf.stats.total[i] += (ULONG)count;
+    }
+    wined3d_perf.stats.frame_time_us = (now.QuadPart - wined3d_perf.frame_start.QuadPart)
+            * 1000000 / wined3d_perf.frequency.QuadPart;
+    ++wined3d_perf.stats.frame_count;
+    wined3d_perf.frame_start = now;
+
+    if ((wined3d_settings.perf_stats & WINED3D_PERF_STATS_SHM) && (shared = wined3d_perf_get_shared_block()))
+    {
+        wined3d_perf.stats.sequence = shared->sequence + 1;
+        InterlockedExchange(&shared->sequence, wined3d_perf.stats.sequence);
+        memcpy((BYTE *)shared + FIELD_OFFSET(struct wined3d_perf_stats, frame_time_us),
+                (BYTE *)&wined3d_perf.stats + FIELD_OFFSET(struct wined3d_perf_stats, frame_time_us),
+                sizeof(*shared) - FIELD_OFFSET(struct wined3d_perf_stats, frame_time_us));
+        shared->version = wined3d_perf.stats.version;
+        shared->counter_count = wined3d_perf.stats.counter_count;
+        InterlockedExchange(&shared->sequence, wined3d_perf.stats.sequence + 1);
+    }
+
+    if ((wined3d_settings.perf_stats & WINED3D_PERF_STATS_LOG)
+            && (now.QuadPart - wined3d_perf.log_start.QuadPart) * 1000
+            >= WINED3D_PERF_LOG_INTERVAL * wined3d_perf.frequency.QuadPart)
+        wined3d_perf_log(&now);
+}
+
 static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_present *op = data;
@@ -249,8 +421,10 @@ static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
     swapchain = op->swapchain;
     wined3d_swapchain_set_window(swapchain, op->dst_window_override);
 
-    swapchain->swapchain_ops->swapchain_present(swapchain,
-            op->src_rect, op->dst_rect, op->dirty_region, op->flags);
+    swapchain->swapchain_ops->swapchain_present(swapchain, op->has_src_rect ? &op->src_rect : NULL,
+            op->has_dst_rect ? &op->dst_rect : NULL, NULL, op->flags);
+
+    wined3d_perf_end_frame();
 }
 
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain,
@@ -263,9 +437,10 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
     op->opcode = WINED3D_CS_OP_PRESENT;
     op->dst_window_override = dst_window_override;
     op->swapchain = swapchain;
-    op->src_rect = src_rect;
-    op->dst_rect = dst_rect;
-    op->dirty_region = dirty_region;
+    if ((op->has_src_rect = !!src_rect))
+        op->src_rect = *src_rect;
+    if ((op->has_dst_rect = !!dst_rect))
+        op->dst_rect = *dst_rect;
     op->flags = flags;
 
     cs->ops->submit(cs);
@@ -277,45 +452,78 @@ static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
     struct wined3d_device *device;
     RECT draw_rect;
 
+    wined3d_perf_count(WINED3D_PERF_CLEARS, 1);
     device = cs->device;
-    wined3d_get_draw_rect(&device->state, &draw_rect);
+    wined3d_get_draw_rect(&cs->state, &draw_rect);
     device_clear_render_targets(device, device->adapter->gl_info.limits.buffers,
-            &device->fb, op->rect_count, op->rects, &draw_rect, op->flags,
-            op->color, op->depth, op->stencil);
+            &cs->fb, op->rect_count, op->rect_count ? op->rects : NULL, &draw_rect, op->flags,
+            &op->color, op->depth, op->stencil);
 }
 
 void wined3d_cs_emit_clear(struct wined3d_cs *cs, DWORD rect_count, const RECT *rects,
         DWORD flags, const struct wined3d_color *color, float depth, DWORD stencil)
 {
     struct wined3d_cs_clear *op;
+    DWORD count;
 
-    op = cs->ops->require_space(cs, sizeof(*op));
-    op->opcode = WINED3D_CS_OP_CLEAR;
-    op->rect_count = rect_count;
-    op->rects = rects;
-    op->flags = flags;
-    op->color = color;
-    op->depth = depth;
-    op->stencil = stencil;
-
-    cs->ops->submit(cs);
+    /* Clearing the rects in several batches gives the same result, and keeps
+     * the packets within the command stream limits. */
+    do
+    {
+        count = min(rect_count, WINED3D_CS_MAX_CLEAR_RECTS);
+        op = cs->ops->require_space(cs, FIELD_OFFSET(struct wined3d_cs_clear, rects[count]));
+        op->opcode = WINED3D_CS_OP_CLEAR;
+        op->flags = flags;
+        op->color = *color;
+        op->depth = depth;
+        op->stencil = stencil;
+        op->rect_count = count;
+        if (count)
+            memcpy(op->rects, rects, count * sizeof(*rects));
+
+        cs->ops->submit(cs);
+        rects += count;
+        rect_count -= count;
+    } while (rect_count);
 }
 
 static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_draw *op = data;
+    struct wined3d_state *state = &cs->state;
 
-    draw_primitive(cs->device, op->start_idx, op->index_count,
+    wined3d_perf_count(WINED3D_PERF_DRAWS, 1);
+
+    if (op->primitive_type != state->gl_primitive_type)
+    {
+        if (op->primitive_type == GL_POINTS || state->gl_primitive_type == GL_POINTS)
+            device_invalidate_state(cs->device, STATE_POINT_SIZE_ENABLE);
+        state->gl_primitive_type = op->primitive_type;
+    }
+    if (op->load_base_vertex_idx != state->load_base_vertex_index)
+    {
+        state->load_base_vertex_index = op->load_base_vertex_idx;
+        device_invalidate_state(cs->device, STATE_BASEVERTEXINDEX);
+    }
+    state->base_vertex_index = op->base_vertex_idx;
+
+    draw_primitive(cs->device, state, op->start_idx, op->index_count,
             op->start_instance, op->instance_count, op->indexed);
 }
 
+/* The draw parameters that aren't set through their own ops are taken from
+ * the device state when the draw is queued. */
 void wined3d_cs_emit_draw(struct wined3d_cs *cs, UINT start_idx, UINT index_count,
         UINT start_instance, UINT instance_count, BOOL indexed)
 {
+    const struct wined3d_state *state = &cs->device->state;
     struct wined3d_cs_draw *op;
 
     op = cs->ops->require_space(cs, sizeof(*op));
     op->opcode = WINED3D_CS_OP_DRAW;
+    op->primitive_type = state->gl_primitive_type;
+    op->base_vertex_idx = state->base_vertex_index;
+    op->load_base_vertex_idx = state->load_base_vertex_index;
     op->start_idx = start_idx;
     op->index_count = index_count;
     op->start_instance = start_instance;
@@ -349,7 +557,7 @@ static void wined3d_cs_exec_set_viewport(struct wined3d_cs *cs, const void *data
 {
     const struct wined3d_cs_set_viewport *op = data;
 
-    cs->state.viewport = *op->viewport;
+    cs->state.viewport = op->viewport;
     device_invalidate_state(cs->device, STATE_VIEWPORT);
 }
 
@@ -359,7 +567,7 @@ void wined3d_cs_emit_set_viewport(struct wined3d_cs *cs, const struct wined3d_vi
 
     op = cs->ops->require_space(cs, sizeof(*op));
     op->opcode = WINED3D_CS_OP_SET_VIEWPORT;
-    op->viewport = viewport;
+    op->viewport = *viewport;
 
     cs->ops->submit(cs);
 }
@@ -368,7 +576,7 @@ static void wined3d_cs_exec_set_scissor_rect(struct wined3d_cs *cs, const void *
 {
     const struct wined3d_cs_set_scissor_rect *op = data;
 
-    cs->state.scissor_rect = *op->rect;
+    cs->state.scissor_rect = op->rect;
     device_invalidate_state(cs->device, STATE_SCISSORRECT);
 }
 
@@ -378,7 +586,7 @@ void wined3d_cs_emit_set_scissor_rect(struct wined3d_cs *cs, const RECT *rect)
 
     op = cs->ops->require_space(cs, sizeof(*op));
     op->opcode = WINED3D_CS_OP_SET_SCISSOR_RECT;
-    op->rect = rect;
+    op->rect = *rect;
 
     cs->ops->submit(cs);
 }
@@ -832,7 +1040,7 @@ static void wined3d_cs_exec_set_transform(struct wined3d_cs *cs, const void *dat
 {
     const struct wined3d_cs_set_transform *op = data;
 
-    cs->state.transforms[op->state] = *op->matrix;
+    cs->state.transforms[op->state] = op->matrix;
     if (op->state < WINED3D_TS_WORLD_MATRIX(cs->device->adapter->gl_info.limits.blends))
         device_invalidate_state(cs->device, STATE_TRANSFORM(op->state));
 }
@@ -845,7 +1053,7 @@ void wined3d_cs_emit_set_transform(struct wined3d_cs *cs, enum wined3d_transform
     op = cs->ops->require_space(cs, sizeof(*op));
     op->opcode = WINED3D_CS_OP_SET_TRANSFORM;
     op->state = state;
-    op->matrix = matrix;
+    op->matrix = *matrix;
 
     cs->ops->submit(cs);
 }
@@ -854,7 +1062,7 @@ static void wined3d_cs_exec_set_clip_plane(struct wined3d_cs *cs, const void *da
 {
     const struct wined3d_cs_set_clip_plane *op = data;
 
-    cs->state.clip_planes[op->plane_idx] = *op->plane;
+    cs->state.clip_planes[op->plane_idx] = op->plane;
     device_invalidate_state(cs->device, STATE_CLIPPLANE(op->plane_idx));
 }
 
@@ -865,7 +1073,7 @@ void wined3d_cs_emit_set_clip_plane(struct wined3d_cs *cs, UINT plane_idx, const
     op = cs->ops->require_space(cs, sizeof(*op));
     op->opcode = WINED3D_CS_OP_SET_CLIP_PLANE;
     op->plane_idx = plane_idx;
-    op->plane = plane;
+    op->plane = *plane;
 
     cs->ops->submit(cs);
 }
@@ -874,7 +1082,7 @@ static void wined3d_cs_exec_set_material(struct wined3d_cs *cs, const void *data
 {
     const struct wined3d_cs_set_material *op = data;
 
-    cs->state.material = *op->material;
+    cs->state.material = op->material;
     device_invalidate_state(cs->device, STATE_MATERIAL);
 }
 
@@ -884,7 +1092,91 @@ void wined3d_cs_emit_set_material(struct wined3d_cs *cs, const struct wined3d_ma
 
     op = cs->ops->require_space(cs, sizeof(*op));
     op->opcode = WINED3D_CS_OP_SET_MATERIAL;
-    op->material = material;
+    op->material = *material;
+
+    cs->ops->submit(cs);
+}
+
+static void wined3d_cs_exec_set_light_enable(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_set_light_enable *op = data;
+
+    /* The light parameters are only changed once the command stream is idle. */
+    cs->state.lights[op->gl_idx] = op->light;
+    device_invalidate_state(cs->device, STATE_LIGHT_TYPE);
+    device_invalidate_state(cs->device, STATE_ACTIVELIGHT(op->gl_idx));
+}
+
+void wined3d_cs_emit_set_light_enable(struct wined3d_cs *cs, UINT gl_idx, const struct wined3d_light_info *light)
+{
+    struct wined3d_cs_set_light_enable *op;
+
+    op = cs->ops->require_space(cs, sizeof(*op));
+    op->opcode = WINED3D_CS_OP_SET_LIGHT_ENABLE;
+    op->gl_idx = gl_idx;
+    op->light = light;
+
+    cs->ops->submit(cs);
+}
+
+static const struct
+{
+    size_t offset;
+    size_t size;
+    DWORD mask;
+}
+wined3d_cs_push_constant_info[] =
+{
+    /* WINED3D_PUSH_CONSTANTS_VS_F */
+    {FIELD_OFFSET(struct wined3d_state, vs_consts_f), sizeof(float) * 4, WINED3D_SHADER_CONST_VS_F},
+    /* WINED3D_PUSH_CONSTANTS_PS_F */
+    {FIELD_OFFSET(struct wined3d_state, ps_consts_f), sizeof(float) * 4, WINED3D_SHADER_CONST_PS_F},
+    /* WINED3D_PUSH_CONSTANTS_VS_I */
+    {FIELD_OFFSET(struct wined3d_state, vs_consts_i), sizeof(INT) * 4,   WINED3D_SHADER_CONST_VS_I},
+    /* WINED3D_PUSH_CONSTANTS_PS_I */
+    {FIELD_OFFSET(struct wined3d_state, ps_consts_i), sizeof(INT) * 4,   WINED3D_SHADER_CONST_PS_I},
+    /* WINED3D_PUSH_CONSTANTS_VS_B */
+    {FIELD_OFFSET(struct wined3d_state, vs_consts_b), sizeof(BOOL),      WINED3D_SHADER_CONST_VS_B},
+    /* WINED3D_PUSH_CONSTANTS_PS_B */
+    {FIELD_OFFSET(struct wined3d_state, ps_consts_b), sizeof(BOOL),      WINED3D_SHADER_CONST_PS_B},
+};
+
+static void wined3d_cs_exec_push_constants(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_push_constants *op = data;
+    struct wined3d_device *device = cs->device;
+    size_t size = wined3d_cs_push_constant_info[op->type].size;
+    BYTE *dst = (BYTE *)&cs->state + wined3d_cs_push_constant_info[op->type].offset;
+    unsigned int i;
+
+    /* The float constants are allocated separately. */
+    if (op->type == WINED3D_PUSH_CONSTANTS_VS_F || op->type == WINED3D_PUSH_CONSTANTS_PS_F)
+        dst = *(BYTE **)dst;
+    memcpy(dst + op->start_idx * size, op->constants, op->count * size);
+
+    if (op->type == WINED3D_PUSH_CONSTANTS_VS_F)
+        device->shader_backend->shader_update_float_vertex_constants(device, op->start_idx, op->count);
+    else if (op->type == WINED3D_PUSH_CONSTANTS_PS_F)
+        device->shader_backend->shader_update_float_pixel_constants(device, op->start_idx, op->count);
+    else
+    {
+        for (i = 0; i < device->context_count; ++i)
+            device->contexts[i]->constant_update_mask |= wined3d_cs_push_constant_info[op->type].mask;
+    }
+}
+
+void wined3d_cs_emit_push_constants(struct wined3d_cs *cs, enum wined3d_cs_push_constants_type type,
+        UINT start_idx, UINT count, const void *constants)
+{
+    struct wined3d_cs_push_constants *op;
+    size_t size = count * wined3d_cs_push_constant_info[type].size;
+
+    op = cs->ops->require_space(cs, FIELD_OFFSET(struct wined3d_cs_push_constants, constants[size]));
+    op->opcode = WINED3D_CS_OP_PUSH_CONSTANTS;
+    op->type = type;
+    op->start_idx = start_idx;
+    op->count = count;
+    memcpy(op->constants, constants, size);
 
     cs->ops->submit(cs);
 }
@@ -911,6 +1203,15 @@ void wined3d_cs_emit_reset_state(struct wined3d_cs *cs)
     cs->ops->submit(cs);
 }
 
+static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
+{
+}
+
+static void wined3d_cs_exec_stop(struct wined3d_cs *cs, const void *data)
+{
+    cs->thread_stop = TRUE;
+}
+
 static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void *data) =
 {
     /* WINED3D_CS_OP_PRESENT                    */ wined3d_cs_exec_present,
@@ -937,7 +1238,11 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_SET_TRANSFORM              */ wined3d_cs_exec_set_transform,
     /* WINED3D_CS_OP_SET_CLIP_PLANE             */ wined3d_cs_exec_set_clip_plane,
     /* WINED3D_CS_OP_SET_MATERIAL               */ wined3d_cs_exec_set_material,
+    /* WINED3D_CS_OP_SET_LIGHT_ENABLE           */ wined3d_cs_exec_set_light_enable,
+    /* WINED3D_CS_OP_PUSH_CONSTANTS             */ wined3d_cs_exec_push_constants,
     /* WINED3D_CS_OP_RESET_STATE                */ wined3d_cs_exec_reset_state,
+    /* WINED3D_CS_OP_NOP                        */ wined3d_cs_exec_nop,
+    /* WINED3D_CS_OP_STOP                       */ wined3d_cs_exec_stop,
 };
 
 static void *wined3d_cs_st_require_space(struct wined3d_cs *cs, size_t size)
@@ -961,15 +1266,197 @@ static void wined3d_cs_st_submit(struct wined3d_cs *cs)
 {
     enum wined3d_cs_op opcode = *(const enum wined3d_cs_op *)cs->data;
 
+    if (opcode >= WINED3D_CS_OP_SET_PREDICATION)
+        wined3d_perf_count(WINED3D_PERF_STATE_CHANGES, 1);
     wined3d_cs_op_handlers[opcode](cs, cs->data);
 }
 
+static void wined3d_cs_st_finish(struct wined3d_cs *cs)
+{
+}
+
 static const struct wined3d_cs_ops wined3d_cs_st_ops =
 {
     wined3d_cs_st_require_space,
     wined3d_cs_st_submit,
+    wined3d_cs_st_finish,
+};
+
+/* The multithreaded command stream uses a single producer, single consumer
+ * ring buffer. The application thread writes packets at "queue_head", and
+ * the command stream thread executes them from "queue_tail". Both are
+ * free-running counters; only their low bits are used as queue offsets. */
+static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs)
+{
+    return *(volatile const LONG *)&cs->queue_tail == *(volatile const LONG *)&cs->queue_head;
+}
+
+static void wined3d_cs_mt_wait_space(struct wined3d_cs *cs, size_t size)
+{
+    while (WINED3D_CS_QUEUE_SIZE - (ULONG)(cs->queue_head - *(volatile LONG *)&cs->queue_tail) < size)
+        Sleep(0);
+}
+
+static void wined3d_cs_mt_publish(struct wined3d_cs *cs, size_t size)
+{
+    InterlockedExchange(&cs->queue_head, cs->queue_head + size);
+    if (cs->waiting_for_work)
+        SetEvent(cs->work_event);
+}
+
+static void *wined3d_cs_mt_require_space(struct wined3d_cs *cs, size_t size)
+{
+    size_t packet_size = (FIELD_OFFSET(struct wined3d_cs_packet, data[size]) + 15) & ~15;
+    ULONG offset = cs->queue_head & (WINED3D_CS_QUEUE_SIZE - 1);
+    size_t remaining = WINED3D_CS_QUEUE_SIZE - offset;
+    struct wined3d_cs_packet *packet;
+
+    /* Callers split their ops so that they always fit. */
+    assert(packet_size <= WINED3D_CS_MAX_PACKET_SIZE);
+
+    /* Packets are contiguous, pad the end of the queue if this one doesn't fit. */
+    if (remaining < packet_size)
+    {
+        wined3d_cs_mt_wait_space(cs, remaining);
+        packet = (struct wined3d_cs_packet *)&cs->queue[offset];
+        packet->size = remaining;
+        ((struct wined3d_cs_nop *)packet->data)->opcode = WINED3D_CS_OP_NOP;
+        wined3d_cs_mt_publish(cs, remaining);
+        offset = 0;
+    }
+
+    wined3d_cs_mt_wait_space(cs, packet_size);
+    packet = (struct wined3d_cs_packet *)&cs->queue[offset];
+    packet->size = packet_size;
+    cs->pending_size = packet_size;
+
+    return packet->data;
+}
+
+static void wined3d_cs_mt_submit(struct wined3d_cs *cs)
+{
+    wined3d_cs_mt_publish(cs, cs->pending_size);
+}
+
+static void wined3d_cs_mt_finish(struct wined3d_cs *cs)
+{
+    unsigned int spin_count = 0;
+
+    /* Ops executed by the command stream thread may end up here as well. */
+    if (cs->thread_id == GetCurrentThreadId())
+        return;
+
+    while (!wined3d_cs_queue_is_empty(cs))
+    {
+        if (++spin_count < WINED3D_CS_SPIN_COUNT)
+            continue;
+
+        InterlockedExchange(&cs->waiting_for_idle, TRUE);
+        if (!wined3d_cs_queue_is_empty(cs))
+            WaitForSingleObject(cs->idle_event, INFINITE);
+        InterlockedExchange(&cs->waiting_for_idle, FALSE);
+    }
+}
+
+static const struct wined3d_cs_ops wined3d_cs_mt_ops =
+{
+    wined3d_cs_mt_require_space,
+    wined3d_cs_mt_submit,
+    wined3d_cs_mt_finish,
 };
 
+static void wined3d_cs_mt_wait_work(struct wined3d_cs *cs)
+{
+    unsigned int spin_count;
+
+    for (spin_count = 0; spin_count < WINED3D_CS_SPIN_COUNT; ++spin_count)
+    {
+        if (!wined3d_cs_queue_is_empty(cs))
+            return;
+    }
+
+    InterlockedExchange(&cs->waiting_for_work, TRUE);
+    if (wined3d_cs_queue_is_empty(cs))
+        WaitForSingleObject(cs->work_event, INFINITE);
+    InterlockedExchange(&cs->waiting_for_work, FALSE);
+}
+
+static DWORD WINAPI wined3d_cs_run(void *thread_param)
+{
+    struct wined3d_cs *cs = thread_param;
+    const struct wined3d_cs_packet *packet;
+    enum wined3d_cs_op opcode;
+    ULONG tail;
+
+    TRACE("Started.\n");
+
+    while (!cs->thread_stop)
+    {
+        if (wined3d_cs_queue_is_empty(cs))
+        {
+            wined3d_cs_mt_wait_work(cs);
+            continue;
+        }
+
+        tail = cs->queue_tail;
+        packet = (const struct wined3d_cs_packet *)&cs->queue[tail & (WINED3D_CS_QUEUE_SIZE - 1)];
+        opcode = *(const enum wined3d_cs_op *)packet->data;
+        if (opcode >= WINED3D_CS_OP_SET_PREDICATION && opcode < WINED3D_CS_OP_NOP)
+            wined3d_perf_count(WINED3D_PERF_STATE_CHANGES, 1);
+        wined3d_cs_op_handlers[opcode](cs, packet->data);
+
+        InterlockedExchange(&cs->queue_tail, tail + packet->size);
+        if (cs->waiting_for_idle && wined3d_cs_queue_is_empty(cs))
+            SetEvent(cs->idle_event);
+    }
+
+    /* Release the GL context this thread may have made current. */
+    context_set_current(NULL);
+
+    TRACE("Stopped.\n");
+    return 0;
+}
+
+static BOOL wined3d_cs_mt_init(struct wined3d_cs *cs)
+{
+    if (!(cs->queue = HeapAlloc(GetProcessHeap(), 0, WINED3D_CS_QUEUE_SIZE)))
+        return FALSE;
+    if (!(cs->work_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        goto fail;
+    if (!(cs->idle_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        goto fail;
+    if (!(cs->thread = CreateThread(NULL, 0, wined3d_cs_run, cs, 0, &cs->thread_id)))
+        goto fail;
+
+    cs->ops = &wined3d_cs_mt_ops;
+    return TRUE;
+
+fail:
+    if (cs->idle_event)
+        CloseHandle(cs->idle_event);
+    if (cs->work_event)
+        CloseHandle(cs->work_event);
+    HeapFree(GetProcessHeap(), 0, cs->queue);
+    cs->idle_event = cs->work_event = NULL;
+    cs->queue = NULL;
+    return FALSE;
+}
+
+static void wined3d_cs_mt_cleanup(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_stop *op;
+
+    op = cs->ops->require_space(cs, sizeof(*op));
+    op->opcode = WINED3D_CS_OP_STOP;
+    cs->ops->submit(cs);
+
+    WaitForSingleObject(cs->thread, INFINITE);
+    CloseHandle(cs->thread);
+    CloseHandle(cs->idle_event);
+    CloseHandle(cs->work_event);
+    HeapFree(GetProcessHeap(), 0, cs->queue);
+}
+
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
 {
     const struct wined3d_gl_info *gl_info = &device->adapter->gl_info;
@@ -1003,11 +1490,16 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         return NULL;
     }
 
+    if (wined3d_settings.cs_multithreaded && !wined3d_cs_mt_init(cs))
+        WARN("Failed to start the command stream thread, using the single-threaded command stream.\n");
+
     return cs;
 }
 
 void wined3d_cs_destroy(struct wined3d_cs *cs)
 {
+    if (cs->thread)
+        wined3d_cs_mt_cleanup(cs);
     state_cleanup(&cs->state);
     HeapFree(GetProcessHeap(), 0, cs->fb.render_targets);
     HeapFree(GetProcessHeap(), 0, cs->data);
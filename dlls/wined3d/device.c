@@ -1661,6 +1661,8 @@ HRESULT CDECL wined3d_device_set_light_enable(struct wined3d_device *device, UIN
             }
 
             device->update_state->lights[light_info->glIndex] = NULL;
+            if (!device->recording)
+                wined3d_cs_emit_set_light_enable(device->cs, light_info->glIndex, NULL);
             light_info->glIndex = -1;
         }
         else
@@ -1707,6 +1709,7 @@ HRESULT CDECL wined3d_device_set_light_enable(struct wined3d_device *device, UIN
             {
                 device_invalidate_state(device, STATE_LIGHT_TYPE);
                 device_invalidate_state(device, STATE_ACTIVELIGHT(i));
+                wined3d_cs_emit_set_light_enable(device->cs, i, light_info);
             }
         }
     }
@@ -2248,16 +2251,6 @@ struct wined3d_sampler * CDECL wined3d_device_get_vs_sampler(const struct wined3
     return device->state.sampler[WINED3D_SHADER_TYPE_VERTEX][idx];
 }
 
-static void device_invalidate_shader_constants(const struct wined3d_device *device, DWORD mask)
-{
-    UINT i;
-
-    for (i = 0; i < device->context_count; ++i)
-    {
-        device->contexts[i]->constant_update_mask |= mask;
-    }
-}
-
 HRESULT CDECL wined3d_device_set_vs_consts_b(struct wined3d_device *device,
         UINT start_register, const BOOL *constants, UINT bool_count)
 {
@@ -2281,7 +2274,7 @@ HRESULT CDECL wined3d_device_set_vs_consts_b(struct wined3d_device *device,
     }
     else
     {
-        device_invalidate_shader_constants(device, WINED3D_SHADER_CONST_VS_B);
+        wined3d_cs_emit_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_VS_B, start_register, count, constants);
     }
 
     return WINED3D_OK;
@@ -2328,7 +2321,7 @@ HRESULT CDECL wined3d_device_set_vs_consts_i(struct wined3d_device *device,
     }
     else
     {
-        device_invalidate_shader_constants(device, WINED3D_SHADER_CONST_VS_I);
+        wined3d_cs_emit_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_VS_I, start_register, count, constants);
     }
 
     return WINED3D_OK;
@@ -2379,7 +2372,8 @@ HRESULT CDECL wined3d_device_set_vs_consts_f(struct wined3d_device *device,
         memset(device->recording->changed.vertexShaderConstantsF + start_register, 1,
                 sizeof(*device->recording->changed.vertexShaderConstantsF) * vector4f_count);
     else
-        device->shader_backend->shader_update_float_vertex_constants(device, start_register, vector4f_count);
+        wined3d_cs_emit_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_VS_F,
+                start_register, vector4f_count, constants);
 
 
     return WINED3D_OK;
@@ -2515,7 +2509,7 @@ HRESULT CDECL wined3d_device_set_ps_consts_b(struct wined3d_device *device,
     }
     else
     {
-        device_invalidate_shader_constants(device, WINED3D_SHADER_CONST_PS_B);
+        wined3d_cs_emit_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_PS_B, start_register, count, constants);
     }
 
     return WINED3D_OK;
@@ -2562,7 +2556,7 @@ HRESULT CDECL wined3d_device_set_ps_consts_i(struct wined3d_device *device,
     }
     else
     {
-        device_invalidate_shader_constants(device, WINED3D_SHADER_CONST_PS_I);
+        wined3d_cs_emit_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_PS_I, start_register, count, constants);
     }
 
     return WINED3D_OK;
@@ -2614,7 +2608,8 @@ HRESULT CDECL wined3d_device_set_ps_consts_f(struct wined3d_device *device,
         memset(device->recording->changed.pixelShaderConstantsF + start_register, 1,
                 sizeof(*device->recording->changed.pixelShaderConstantsF) * vector4f_count);
     else
-        device->shader_backend->shader_update_float_pixel_constants(device, start_register, vector4f_count);
+        wined3d_cs_emit_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_PS_F,
+                start_register, vector4f_count, constants);
 
     return WINED3D_OK;
 }
@@ -3035,11 +3030,7 @@ HRESULT CDECL wined3d_device_process_vertices(struct wined3d_device *device,
         buffer = state->streams[e->stream_idx].buffer;
         e->data.buffer_object = 0;
         e->data.addr += (ULONG_PTR)buffer_get_sysmem(buffer, context);
-        if (buffer->buffer_object)
-        {
-            GL_EXTCALL(glDeleteBuffers(1, &buffer->buffer_object));
-            buffer->buffer_object = 0;
-        }
+        buffer_destroy_buffer_object(buffer, gl_info);
         if (e->data.addr)
             e->data.addr += e->stride * src_start_idx;
     }
@@ -3383,17 +3374,12 @@ struct wined3d_query * CDECL wined3d_device_get_predication(struct wined3d_devic
 void CDECL wined3d_device_set_primitive_type(struct wined3d_device *device,
         enum wined3d_primitive_type primitive_type)
 {
-    GLenum gl_primitive_type, prev;
-
     TRACE("device %p, primitive_type %s\n", device, debug_d3dprimitivetype(primitive_type));
 
-    gl_primitive_type = gl_primitive_type_from_d3d(primitive_type);
-    prev = device->update_state->gl_primitive_type;
-    device->update_state->gl_primitive_type = gl_primitive_type;
+    /* The command stream picks the primitive type up with the next draw. */
+    device->update_state->gl_primitive_type = gl_primitive_type_from_d3d(primitive_type);
     if (device->recording)
         device->recording->changed.primitive_type = TRUE;
-    else if (gl_primitive_type != prev && (gl_primitive_type == GL_POINTS || prev == GL_POINTS))
-        device_invalidate_state(device, STATE_POINT_SIZE_ENABLE);
 }
 
 void CDECL wined3d_device_get_primitive_type(const struct wined3d_device *device,
@@ -3416,11 +3402,7 @@ HRESULT CDECL wined3d_device_draw_primitive(struct wined3d_device *device, UINT
         return WINED3DERR_INVALIDCALL;
     }
 
-    if (device->state.load_base_vertex_index)
-    {
-        device->state.load_base_vertex_index = 0;
-        device_invalidate_state(device, STATE_BASEVERTEXINDEX);
-    }
+    device->state.load_base_vertex_index = 0;
 
     wined3d_cs_emit_draw(device->cs, start_vertex, vertex_count, 0, 0, FALSE);
 
@@ -3449,12 +3431,8 @@ HRESULT CDECL wined3d_device_draw_indexed_primitive(struct wined3d_device *devic
         return WINED3DERR_INVALIDCALL;
     }
 
-    if (!gl_info->supported[ARB_DRAW_ELEMENTS_BASE_VERTEX] &&
-        device->state.load_base_vertex_index != device->state.base_vertex_index)
-    {
+    if (!gl_info->supported[ARB_DRAW_ELEMENTS_BASE_VERTEX])
         device->state.load_base_vertex_index = device->state.base_vertex_index;
-        device_invalidate_state(device, STATE_BASEVERTEXINDEX);
-    }
 
     wined3d_cs_emit_draw(device->cs, start_idx, index_count, 0, 0, TRUE);
 
@@ -4972,6 +4950,9 @@ void device_invalidate_state(const struct wined3d_device *device, DWORD state)
     BYTE shift;
     UINT i;
 
+    /* The command stream thread may be invalidating states as well. */
+    device->cs->ops->finish(device->cs);
+
     for (i = 0; i < device->context_count; ++i)
     {
         context = device->contexts[i];
@@ -89,6 +89,51 @@ struct constant_heap
     unsigned int size;
 };
 
+#define WINED3D_GLSL_CACHE_MAGIC    0x43534757 /* "WGSC" */
+#define WINED3D_GLSL_CACHE_VERSION  1
+
+/* On-disk program cache file layout. The header is followed by the GLSL
+ * source of all attached shaders and then by the program binary. */
+struct glsl_program_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    ULONGLONG key;
+    DWORD binary_format;
+    DWORD source_size;
+    DWORD binary_size;
+};
+
+struct glsl_program_cache_entry
+{
+    struct list entry;
+    ULONGLONG key;
+    DWORD size;
+};
+
+struct glsl_program_cache
+{
+    BOOL enabled;
+    BOOL driver_checked;
+    ULONGLONG driver_key;
+    const char *path;
+    ULONGLONG size;
+    ULONGLONG max_size;
+    struct list lru;
+
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int rejects;
+    unsigned int stores;
+    unsigned int evictions;
+};
+
+struct glsl_program_source
+{
+    char *data;
+    SIZE_T size;
+};
+
 /* GLSL shader private data */
 struct shader_glsl_priv {
     struct wined3d_shader_buffer shader_buffer;
@@ -105,6 +150,8 @@ struct shader_glsl_priv {
     struct wine_rb_tree ffp_vertex_shaders;
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
+
+    struct glsl_program_cache program_cache;
 };
 
 struct glsl_vs_program
@@ -334,6 +381,7 @@ static void print_glsl_info_log(const struct wined3d_gl_info *gl_info, GLuint id
 static void shader_glsl_compile(const struct wined3d_gl_info *gl_info, GLuint shader, const char *src)
 {
     TRACE("Compiling shader object %u.\n", shader);
+    wined3d_perf_count(WINED3D_PERF_SHADER_COMPILES, 1);
     GL_EXTCALL(glShaderSource(shader, 1, &src, NULL));
     checkGLcall("glShaderSource");
     GL_EXTCALL(glCompileShader(shader));
@@ -413,6 +461,470 @@ static void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLu
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+static BOOL shader_glsl_program_cache_supported(const struct wined3d_gl_info *gl_info)
+{
+    return wined3d_settings.shader_cache_path && gl_info->supported[ARB_GET_PROGRAM_BINARY];
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_compile_deferred(const struct wined3d_gl_info *gl_info, GLuint shader, const char *src)
+{
+    /* When the program cache is in use, compilation is postponed until the
+     * shader is actually needed to link a program that isn't in the cache. */
+    if (!shader_glsl_program_cache_supported(gl_info))
+    {
+        shader_glsl_compile(gl_info, shader, src);
+        return;
+    }
+
+    TRACE("Setting source for shader object %u, deferring compilation.\n", shader);
+    GL_EXTCALL(glShaderSource(shader, 1, &src, NULL));
+    checkGLcall("glShaderSource");
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_compile_pending(const struct wined3d_gl_info *gl_info, GLuint shader)
+{
+    GLint compiled;
+
+    GL_EXTCALL(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+    if (compiled)
+        return;
+
+    TRACE("Compiling deferred shader object %u.\n", shader);
+    wined3d_perf_count(WINED3D_PERF_SHADER_COMPILES, 1);
+    GL_EXTCALL(glCompileShader(shader));
+    checkGLcall("glCompileShader");
+    print_glsl_info_log(gl_info, shader, FALSE);
+}
+
+static ULONGLONG shader_glsl_hash(ULONGLONG hash, const void *data, SIZE_T size)
+{
+    const BYTE *ptr = data;
+    SIZE_T i;
+
+    /* 64-bit FNV-1a. */
+    for (i = 0; i < size; ++i)
+    {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+static void shader_glsl_program_cache_get_filename(const struct glsl_program_cache *cache,
+        ULONGLONG key, const char *ext, char *filename, unsigned int size)
+{
+    snprintf(filename, size, "%s\\%08x%08x.%s", cache->path,
+            (unsigned int)(key >> 32), (unsigned int)key, ext);
+}
+
+static struct glsl_program_cache_entry *shader_glsl_program_cache_find(struct glsl_program_cache *cache,
+        ULONGLONG key)
+{
+    struct glsl_program_cache_entry *entry;
+
+    LIST_FOR_EACH_ENTRY(entry, &cache->lru, struct glsl_program_cache_entry, entry)
+    {
+        if (entry->key == key)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static void shader_glsl_program_cache_remove(struct glsl_program_cache *cache,
+        struct glsl_program_cache_entry *entry)
+{
+    char filename[MAX_PATH];
+
+    shader_glsl_program_cache_get_filename(cache, entry->key, "bin", filename, sizeof(filename));
+    DeleteFileA(filename);
+
+    cache->size -= entry->size;
+    list_remove(&entry->entry);
+    HeapFree(GetProcessHeap(), 0, entry);
+}
+
+static void shader_glsl_program_cache_evict(struct glsl_program_cache *cache)
+{
+    struct glsl_program_cache_entry *entry;
+    struct list *tail;
+
+    while (cache->size > cache->max_size && (tail = list_tail(&cache->lru)))
+    {
+        entry = LIST_ENTRY(tail, struct glsl_program_cache_entry, entry);
+        TRACE("Evicting program %s, %u bytes.\n", wine_dbgstr_longlong(entry->key), entry->size);
+        shader_glsl_program_cache_remove(cache, entry);
+        ++cache->evictions;
+    }
+}
+
+static int shader_glsl_program_cache_compare_files(const void *a, const void *b)
+{
+    const WIN32_FIND_DATAA *f = a, *g = b;
+
+    /* Most recently used first. */
+    return -CompareFileTime(&f->ftLastWriteTime, &g->ftLastWriteTime);
+}
+
+static void shader_glsl_program_cache_init(struct glsl_program_cache *cache)
+{
+    struct glsl_program_cache_entry *entry;
+    unsigned int count = 0, capacity = 16, i;
+    WIN32_FIND_DATAA *files, *new_files;
+    char pattern[MAX_PATH];
+    DWORD key_high, key_low;
+    HANDLE handle;
+
+    list_init(&cache->lru);
+    if (!(cache->path = wined3d_settings.shader_cache_path))
+        return;
+
+    if (!CreateDirectoryA(cache->path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        WARN("Failed to create shader cache directory %s, error %u.\n",
+                debugstr_a(cache->path), GetLastError());
+        return;
+    }
+    cache->max_size = (ULONGLONG)wined3d_settings.shader_cache_size * 1024 * 1024;
+    cache->enabled = TRUE;
+
+    if (!(files = HeapAlloc(GetProcessHeap(), 0, capacity * sizeof(*files))))
+        return;
+
+    snprintf(pattern, sizeof(pattern), "%s\\*.bin", cache->path);
+    if ((handle = FindFirstFileA(pattern, &files[0])) != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if (++count < capacity)
+                continue;
+            if (!(new_files = HeapReAlloc(GetProcessHeap(), 0, files, capacity * 2 * sizeof(*files))))
+                break;
+            files = new_files;
+            capacity *= 2;
+        } while (FindNextFileA(handle, &files[count]));
+        FindClose(handle);
+    }
+
+    /* Rebuild the LRU list from the file modification times, which are
+     * updated whenever a cached program is used. */
+    qsort(files, count, sizeof(*files), shader_glsl_program_cache_compare_files);
+    for (i = 0; i < count; ++i)
+    {
+        if (sscanf(files[i].cFileName, "%08x%08x.bin", &key_high, &key_low) != 2)
+            continue;
+        if (!(entry = HeapAlloc(GetProcessHeap(), 0, sizeof(*entry))))
+            break;
+        entry->key = ((ULONGLONG)key_high << 32) | key_low;
+        entry->size = files[i].nFileSizeLow;
+        list_add_tail(&cache->lru, &entry->entry);
+        cache->size += entry->size;
+    }
+    HeapFree(GetProcessHeap(), 0, files);
+
+    TRACE("Found %u cached programs, %s bytes in %s.\n", count,
+            wine_dbgstr_longlong(cache->size), debugstr_a(cache->path));
+    shader_glsl_program_cache_evict(cache);
+}
+
+static void shader_glsl_program_cache_cleanup(struct glsl_program_cache *cache)
+{
+    struct glsl_program_cache_entry *entry, *next;
+
+    if (cache->enabled)
+        TRACE("Program cache: %u hits, %u misses, %u rejected, %u stored, %u evicted.\n",
+                cache->hits, cache->misses, cache->rejects, cache->stores, cache->evictions);
+
+    LIST_FOR_EACH_ENTRY_SAFE(entry, next, &cache->lru, struct glsl_program_cache_entry, entry)
+    {
+        HeapFree(GetProcessHeap(), 0, entry);
+    }
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_program_cache_check_driver(struct glsl_program_cache *cache,
+        const struct wined3d_gl_info *gl_info)
+{
+    static const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION_ARB};
+    const char *str;
+    GLint formats;
+    ULONGLONG key;
+    unsigned int i;
+
+    if (cache->driver_checked)
+        return cache->enabled;
+    cache->driver_checked = TRUE;
+
+    gl_info->gl_ops.gl.p_glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (!formats)
+    {
+        WARN("No program binary formats supported, disabling the program cache.\n");
+        cache->enabled = FALSE;
+        return FALSE;
+    }
+
+    /* Program binaries are only valid for the driver that created them. */
+    key = 0xcbf29ce484222325ull;
+    for (i = 0; i < sizeof(names) / sizeof(*names); ++i)
+    {
+        if ((str = (const char *)gl_info->gl_ops.gl.p_glGetString(names[i])))
+            key = shader_glsl_hash(key, str, strlen(str) + 1);
+    }
+    cache->driver_key = key;
+    TRACE("Driver key %s.\n", wine_dbgstr_longlong(key));
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_get_program_source(const struct wined3d_gl_info *gl_info,
+        const GLuint *shader_ids, unsigned int shader_count, struct glsl_program_source *source)
+{
+    GLint length, total = 0;
+    unsigned int i;
+    char *ptr;
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        if (!shader_ids[i])
+            continue;
+        GL_EXTCALL(glGetShaderiv(shader_ids[i], GL_SHADER_SOURCE_LENGTH, &length));
+        total += length;
+    }
+
+    if (!total || !(source->data = HeapAlloc(GetProcessHeap(), 0, total)))
+        return FALSE;
+
+    for (i = 0, ptr = source->data; i < shader_count; ++i)
+    {
+        if (!shader_ids[i])
+            continue;
+        GL_EXTCALL(glGetShaderSource(shader_ids[i], total - (ptr - source->data), &length, ptr));
+        ptr += length + 1;
+    }
+    checkGLcall("get program source");
+    source->size = ptr - source->data;
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_program_cache_load(struct glsl_program_cache *cache,
+        const struct wined3d_gl_info *gl_info, GLuint program_id, ULONGLONG key,
+        const struct glsl_program_source *source)
+{
+    struct glsl_program_cache_header header;
+    struct glsl_program_cache_entry *entry;
+    char filename[MAX_PATH];
+    BOOL ret = FALSE;
+    FILETIME now;
+    HANDLE file;
+    BYTE *data;
+    DWORD size;
+    GLint tmp;
+
+    if (!(entry = shader_glsl_program_cache_find(cache, key)))
+    {
+        ++cache->misses;
+        return FALSE;
+    }
+
+    shader_glsl_program_cache_get_filename(cache, key, "bin", filename, sizeof(filename));
+    file = CreateFileA(filename, GENERIC_READ | FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        shader_glsl_program_cache_remove(cache, entry);
+        ++cache->misses;
+        return FALSE;
+    }
+
+    /* The stored GLSL source has to match exactly, a key collision must never
+     * result in the wrong program being used. */
+    if (!ReadFile(file, &header, sizeof(header), &size, NULL) || size != sizeof(header)
+            || header.magic != WINED3D_GLSL_CACHE_MAGIC || header.version != WINED3D_GLSL_CACHE_VERSION
+            || header.key != key || header.source_size != source->size || !header.binary_size)
+    {
+        CloseHandle(file);
+        ++cache->misses;
+        return FALSE;
+    }
+
+    if (!(data = HeapAlloc(GetProcessHeap(), 0, header.source_size + header.binary_size)))
+    {
+        CloseHandle(file);
+        ++cache->misses;
+        return FALSE;
+    }
+
+    if (ReadFile(file, data, header.source_size + header.binary_size, &size, NULL)
+            && size == header.source_size + header.binary_size
+            && !memcmp(data, source->data, source->size))
+    {
+        GL_EXTCALL(glProgramBinary(program_id, header.binary_format,
+                data + header.source_size, header.binary_size));
+        GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &tmp));
+        checkGLcall("glProgramBinary");
+        if (!(ret = !!tmp))
+        {
+            /* Typically after a driver update that kept the version string. */
+            TRACE("Driver rejected cached program %s.\n", wine_dbgstr_longlong(key));
+            ++cache->rejects;
+        }
+    }
+
+    if (ret)
+    {
+        GetSystemTimeAsFileTime(&now);
+        SetFileTime(file, NULL, NULL, &now);
+    }
+    CloseHandle(file);
+    HeapFree(GetProcessHeap(), 0, data);
+
+    if (!ret)
+    {
+        shader_glsl_program_cache_remove(cache, entry);
+        ++cache->misses;
+        return FALSE;
+    }
+
+    TRACE("Loaded program %u from cache entry %s.\n", program_id, wine_dbgstr_longlong(key));
+    list_remove(&entry->entry);
+    list_add_head(&cache->lru, &entry->entry);
+    ++cache->hits;
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_program_cache_store(struct glsl_program_cache *cache,
+        const struct wined3d_gl_info *gl_info, GLuint program_id, ULONGLONG key,
+        const struct glsl_program_source *source)
+{
+    struct glsl_program_cache_header *header;
+    struct glsl_program_cache_entry *entry;
+    char filename[MAX_PATH], tmp_filename[MAX_PATH];
+    GLint length, status;
+    GLenum format;
+    DWORD size;
+    HANDLE file;
+    BOOL ret;
+
+    GL_EXTCALL(glGetProgramiv(program_id, GL_LINK_STATUS, &status));
+    GL_EXTCALL(glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (!status || length <= 0)
+        return;
+
+    size = sizeof(*header) + source->size + length;
+    if (!(header = HeapAlloc(GetProcessHeap(), 0, size)))
+        return;
+
+    GL_EXTCALL(glGetProgramBinary(program_id, length, &length, &format,
+            (BYTE *)(header + 1) + source->size));
+    checkGLcall("glGetProgramBinary");
+
+    header->magic = WINED3D_GLSL_CACHE_MAGIC;
+    header->version = WINED3D_GLSL_CACHE_VERSION;
+    header->key = key;
+    header->binary_format = format;
+    header->source_size = source->size;
+    header->binary_size = length;
+    memcpy(header + 1, source->data, source->size);
+    size = sizeof(*header) + source->size + length;
+
+    /* Write to a temporary file first, so that other processes sharing the
+     * cache never see a partially written entry. */
+    shader_glsl_program_cache_get_filename(cache, key, "bin", filename, sizeof(filename));
+    shader_glsl_program_cache_get_filename(cache, key, "tmp", tmp_filename, sizeof(tmp_filename));
+    file = CreateFileA(tmp_filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create %s, error %u.\n", debugstr_a(tmp_filename), GetLastError());
+        HeapFree(GetProcessHeap(), 0, header);
+        return;
+    }
+    ret = WriteFile(file, header, size, &size, NULL);
+    CloseHandle(file);
+    HeapFree(GetProcessHeap(), 0, header);
+
+    if (!ret || !MoveFileExA(tmp_filename, filename, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write %s, error %u.\n", debugstr_a(filename), GetLastError());
+        DeleteFileA(tmp_filename);
+        return;
+    }
+
+    if ((entry = shader_glsl_program_cache_find(cache, key)))
+    {
+        cache->size -= entry->size;
+        list_remove(&entry->entry);
+    }
+    else if (!(entry = HeapAlloc(GetProcessHeap(), 0, sizeof(*entry))))
+    {
+        return;
+    }
+    entry->key = key;
+    entry->size = size;
+    list_add_head(&cache->lru, &entry->entry);
+    cache->size += size;
+    ++cache->stores;
+
+    TRACE("Stored program %u as cache entry %s, %u bytes.\n", program_id, wine_dbgstr_longlong(key), size);
+    shader_glsl_program_cache_evict(cache);
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_link_program(const struct wined3d_gl_info *gl_info, struct glsl_program_cache *cache,
+        GLuint program_id, const GLuint *shader_ids, unsigned int shader_count,
+        const DWORD *params, unsigned int param_count)
+{
+    struct glsl_program_source source = {NULL, 0};
+    ULONGLONG key = 0;
+    unsigned int i;
+
+    if (cache->enabled && shader_glsl_program_cache_check_driver(cache, gl_info)
+            && shader_glsl_get_program_source(gl_info, shader_ids, shader_count, &source))
+    {
+        /* The generated GLSL is a function of the shader bytecode and the
+         * compile arguments, so together with the driver identity and the
+         * link-time parameters it identifies the program. */
+        key = shader_glsl_hash(cache->driver_key, source.data, source.size);
+        key = shader_glsl_hash(key, params, param_count * sizeof(*params));
+
+        if (shader_glsl_program_cache_load(cache, gl_info, program_id, key, &source))
+        {
+            HeapFree(GetProcessHeap(), 0, source.data);
+            return;
+        }
+    }
+
+    if (shader_glsl_program_cache_supported(gl_info))
+    {
+        for (i = 0; i < shader_count; ++i)
+        {
+            if (shader_ids[i])
+                shader_glsl_compile_pending(gl_info, shader_ids[i]);
+        }
+    }
+
+    if (source.data)
+        GL_EXTCALL(glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+
+    TRACE("Linking GLSL shader program %u.\n", program_id);
+    wined3d_perf_count(WINED3D_PERF_PROGRAM_LINKS, 1);
+    GL_EXTCALL(glLinkProgram(program_id));
+    shader_glsl_validate_link(gl_info, program_id);
+
+    if (source.data)
+    {
+        shader_glsl_program_cache_store(cache, gl_info, program_id, key, &source);
+        HeapFree(GetProcessHeap(), 0, source.data);
+    }
+}
+
 /* Context activation is done by the caller. */
 static void shader_glsl_load_samplers(const struct wined3d_gl_info *gl_info,
         const DWORD *tex_unit_map, GLuint program_id)
@@ -950,10 +1462,10 @@ static void shader_generate_glsl_declarations(const struct wined3d_context *cont
         const struct wined3d_shader_reg_maps *reg_maps, const struct shader_glsl_ctx_priv *ctx_priv)
 {
     const struct wined3d_shader_version *version = &reg_maps->shader_version;
-    const struct wined3d_state *state = &shader->device->state;
+    const struct wined3d_state *state = &shader->device->cs->state;
     const struct ps_compile_args *ps_args = ctx_priv->cur_ps_args;
     const struct wined3d_gl_info *gl_info = context->gl_info;
-    const struct wined3d_fb_state *fb = &shader->device->fb;
+    const struct wined3d_fb_state *fb = &shader->device->cs->fb;
     unsigned int i, extra_constants_needed = 0;
     const struct wined3d_shader_lconst *lconst;
     const char *prefix;
@@ -4441,7 +4953,7 @@ static GLuint generate_param_reorder_function(struct wined3d_shader_buffer *buff
 
     ret = GL_EXTCALL(glCreateShader(GL_VERTEX_SHADER));
     checkGLcall("glCreateShader(GL_VERTEX_SHADER)");
-    shader_glsl_compile(gl_info, ret, buffer->buffer);
+    shader_glsl_compile_deferred(gl_info, ret, buffer->buffer);
 
     return ret;
 }
@@ -4544,7 +5056,7 @@ static GLuint shader_glsl_generate_pshader(const struct wined3d_context *context
     shader_addline(buffer, "}\n");
 
     TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_glsl_compile_deferred(gl_info, shader_id, buffer->buffer);
 
     return shader_id;
 }
@@ -4618,7 +5130,7 @@ static GLuint shader_glsl_generate_vshader(const struct wined3d_context *context
     shader_addline(buffer, "}\n");
 
     TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_glsl_compile_deferred(gl_info, shader_id, buffer->buffer);
 
     return shader_id;
 }
@@ -4652,7 +5164,7 @@ static GLuint shader_glsl_generate_geometry_shader(const struct wined3d_context
     shader_addline(buffer, "}\n");
 
     TRACE("Compiling shader object %u.\n", shader_id);
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_glsl_compile_deferred(gl_info, shader_id, buffer->buffer);
 
     return shader_id;
 }
@@ -5074,7 +5586,7 @@ static GLuint shader_glsl_generate_ffp_vertex_shader(struct wined3d_shader_buffe
     shader_addline(buffer, "}\n");
 
     shader_obj = GL_EXTCALL(glCreateShader(GL_VERTEX_SHADER));
-    shader_glsl_compile(gl_info, shader_obj, buffer->buffer);
+    shader_glsl_compile_deferred(gl_info, shader_obj, buffer->buffer);
 
     return shader_obj;
 }
@@ -5675,7 +6187,7 @@ static GLuint shader_glsl_generate_ffp_fragment_shader(struct wined3d_shader_buf
     shader_addline(buffer, "}\n");
 
     shader_id = GL_EXTCALL(glCreateShader(GL_FRAGMENT_SHADER));
-    shader_glsl_compile(gl_info, shader_id, buffer->buffer);
+    shader_glsl_compile_deferred(gl_info, shader_id, buffer->buffer);
     return shader_id;
 }
 
@@ -5830,6 +6342,8 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     struct wined3d_shader *pshader = NULL;
     GLuint program_id = 0;
     GLuint reorder_shader_id = 0;
+    GLuint shader_ids[4];
+    DWORD link_params[4];
     unsigned int i;
     GLuint vs_id = 0;
     GLuint gs_id = 0;
@@ -6003,9 +6517,16 @@ static void set_glsl_shader_program(const struct wined3d_context *context, const
     }
 
     /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    shader_ids[0] = vs_id;
+    shader_ids[1] = reorder_shader_id;
+    shader_ids[2] = gs_id;
+    shader_ids[3] = ps_id;
+    link_params[0] = vshader ? vshader->reg_maps.input_registers : 0;
+    link_params[1] = gshader ? gshader->u.gs.input_type : 0;
+    link_params[2] = gshader ? gshader->u.gs.output_type : 0;
+    link_params[3] = gshader ? gshader->u.gs.vertices_out : 0;
+    shader_glsl_link_program(gl_info, &priv->program_cache, program_id,
+            shader_ids, ARRAY_SIZE(shader_ids), link_params, ARRAY_SIZE(link_params));
 
     shader_glsl_init_vs_uniform_locations(gl_info, program_id, &entry->vs,
             vshader ? min(vshader->limits->constant_float, gl_info->limits.glsl_vs_float_constants) : 0);
@@ -6573,6 +7094,10 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     priv->fragment_pipe = fragment_pipe;
     fragment_pipe->get_caps(gl_info, &fragment_caps);
     priv->ffp_proj_control = fragment_caps.wined3d_caps & WINED3D_FRAGMENT_CAP_PROJ_CONTROL;
+    if (gl_info->supported[ARB_GET_PROGRAM_BINARY])
+        shader_glsl_program_cache_init(&priv->program_cache);
+    else
+        list_init(&priv->program_cache.lru);
 
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
@@ -6610,6 +7135,7 @@ static void shader_glsl_free(struct wined3d_device *device)
         }
     }
 
+    shader_glsl_program_cache_cleanup(&priv->program_cache);
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
@@ -278,6 +278,8 @@ HRESULT CDECL wined3d_query_get_data(struct wined3d_query *query,
     TRACE("query %p, data %p, data_size %u, flags %#x.\n",
             query, data, data_size, flags);
 
+    query->device->cs->ops->finish(query->device->cs);
+
     return query->query_ops->query_get_data(query, data, data_size, flags);
 }
 
@@ -292,6 +294,8 @@ HRESULT CDECL wined3d_query_issue(struct wined3d_query *query, DWORD flags)
 {
     TRACE("query %p, flags %#x.\n", query, flags);
 
+    query->device->cs->ops->finish(query->device->cs);
+
     return query->query_ops->query_issue(query, flags);
 }
 
@@ -30,6 +30,10 @@
 #include "wine/port.h"
 #include "wined3d_private.h"
 
+#ifdef WINED3D_SSE2_CONVERSION
+#include <emmintrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(d3d_surface);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d);
@@ -1479,6 +1483,8 @@ void wined3d_surface_upload_data(struct wined3d_surface *surface, const struct w
             surface, gl_info, debug_d3dformat(format->id), wine_dbgstr_rect(src_rect), src_pitch,
             wine_dbgstr_point(dst_point), srgb, data->buffer_object, data->addr);
 
+    wined3d_perf_count(WINED3D_PERF_SURFACE_UPLOADS, 1);
+
     if (surface->resource.map_count)
     {
         WARN("Uploading a surface that is currently mapped, setting WINED3D_TEXTURE_PIN_SYSMEM.\n");
@@ -1852,6 +1858,7 @@ void surface_load(struct wined3d_surface *surface, BOOL srgb)
         return;
     }
 
+    wined3d_perf_count(WINED3D_PERF_SURFACE_LOADS, 1);
     surface_load_location(surface, location);
     surface_evict_sysmem(surface);
 }
@@ -2266,6 +2273,134 @@ static void convert_r32_float_r16_float(const BYTE *src, BYTE *dst,
     }
 }
 
+#ifdef WINED3D_SSE2_CONVERSION
+/* Stores 8 pixels given as 16-bit channel values in the 0-255 range. */
+static inline void WINED3D_SSE2_FUNC store_x8r8g8b8_sse2(DWORD *dst, __m128i r, __m128i g, __m128i b)
+{
+    const __m128i alpha = _mm_set1_epi16(0xff00);
+    __m128i bg, ra;
+
+    bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    ra = _mm_or_si128(r, alpha);
+    _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(bg, ra));
+}
+
+static unsigned int WINED3D_SSE2_FUNC convert_r5g6b5_x8r8g8b8_row_sse2(const WORD *src,
+        DWORD *dst, unsigned int width)
+{
+    const __m128i mask5 = _mm_set1_epi16(0x1f), mask6 = _mm_set1_epi16(0x3f);
+    const __m128i mul5 = _mm_set1_epi16(527), mul6 = _mm_set1_epi16(259);
+    const __m128i bias5 = _mm_set1_epi16(23), bias6 = _mm_set1_epi16(33);
+    __m128i pixel, r, g, b;
+    unsigned int x;
+
+    for (x = 0; x + 8 <= width; x += 8)
+    {
+        pixel = _mm_loadu_si128((const __m128i *)(src + x));
+        r = _mm_srli_epi16(pixel, 11);
+        g = _mm_and_si128(_mm_srli_epi16(pixel, 5), mask6);
+        b = _mm_and_si128(pixel, mask5);
+
+        /* These produce exactly the convert_5to8 and convert_6to8 table values. */
+        r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(r, mul5), bias5), 6);
+        g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(g, mul6), bias6), 6);
+        b = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(b, mul5), bias5), 6);
+
+        store_x8r8g8b8_sse2(dst + x, r, g, b);
+    }
+
+    return x;
+}
+
+static unsigned int WINED3D_SSE2_FUNC convert_a8r8g8b8_x8r8g8b8_row_sse2(const DWORD *src,
+        DWORD *dst, unsigned int width)
+{
+    const __m128i alpha = _mm_set1_epi32(0xff000000);
+    unsigned int x;
+
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        _mm_storeu_si128((__m128i *)(dst + x),
+                _mm_or_si128(_mm_loadu_si128((const __m128i *)(src + x)), alpha));
+    }
+
+    return x;
+}
+
+static inline __m128i WINED3D_SSE2_FUNC yuv_channel_sse2(__m128i c298_lo, __m128i c298_hi,
+        __m128i a, __m128i b, __m128i coeffs)
+{
+    const __m128i round = _mm_set1_epi32(128), max = _mm_set1_epi16(255);
+    __m128i lo, hi;
+
+    lo = _mm_add_epi32(_mm_add_epi32(c298_lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), coeffs)), round);
+    hi = _mm_add_epi32(_mm_add_epi32(c298_hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), coeffs)), round);
+    lo = _mm_srai_epi32(lo, 8);
+    hi = _mm_srai_epi32(hi, 8);
+
+    return _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128()), max);
+}
+
+/* Converts 8 YUY2 pixels to 16-bit channel values in the 0-255 range, using
+ * the same formulas as the C code in convert_yuy2_x8r8g8b8(). */
+static inline void WINED3D_SSE2_FUNC convert_yuy2_rgb_sse2(const BYTE *src,
+        __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128i zero = _mm_setzero_si128(), low_byte = _mm_set1_epi16(0x00ff);
+    const __m128i c_coeff = _mm_set1_epi32(298), r_coeff = _mm_set1_epi32(409), b_coeff = _mm_set1_epi32(516);
+    const __m128i g_coeffs = _mm_set_epi16(-208, -100, -208, -100, -208, -100, -208, -100);
+    __m128i pixels, c, uv, d, e, c298_lo, c298_hi;
+
+    pixels = _mm_loadu_si128((const __m128i *)src);
+    c = _mm_sub_epi16(_mm_and_si128(pixels, low_byte), _mm_set1_epi16(16));
+    uv = _mm_sub_epi16(_mm_srli_epi16(pixels, 8), _mm_set1_epi16(128));
+
+    /* U and V are shared by each pair of pixels. */
+    d = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+    e = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+
+    c298_lo = _mm_madd_epi16(_mm_unpacklo_epi16(c, zero), c_coeff);
+    c298_hi = _mm_madd_epi16(_mm_unpackhi_epi16(c, zero), c_coeff);
+
+    *r = yuv_channel_sse2(c298_lo, c298_hi, e, zero, r_coeff);
+    *g = yuv_channel_sse2(c298_lo, c298_hi, d, e, g_coeffs);
+    *b = yuv_channel_sse2(c298_lo, c298_hi, d, zero, b_coeff);
+}
+
+static unsigned int WINED3D_SSE2_FUNC convert_yuy2_x8r8g8b8_row_sse2(const BYTE *src,
+        DWORD *dst, unsigned int width)
+{
+    __m128i r, g, b;
+    unsigned int x;
+
+    for (x = 0; x + 8 <= width; x += 8)
+    {
+        convert_yuy2_rgb_sse2(src + 2 * x, &r, &g, &b);
+        store_x8r8g8b8_sse2(dst + x, r, g, b);
+    }
+
+    return x;
+}
+
+static unsigned int WINED3D_SSE2_FUNC convert_yuy2_r5g6b5_row_sse2(const BYTE *src,
+        WORD *dst, unsigned int width)
+{
+    __m128i r, g, b, pixel;
+    unsigned int x;
+
+    for (x = 0; x + 8 <= width; x += 8)
+    {
+        convert_yuy2_rgb_sse2(src + 2 * x, &r, &g, &b);
+        pixel = _mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(r, 3), 11),
+                _mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(g, 2), 5), _mm_srli_epi16(b, 3)));
+        _mm_storeu_si128((__m128i *)(dst + x), pixel);
+    }
+
+    return x;
+}
+#endif
+
 static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
         DWORD pitch_in, DWORD pitch_out, unsigned int w, unsigned int h)
 {
@@ -2295,7 +2430,13 @@ static void convert_r5g6b5_x8r8g8b8(const BYTE *src, BYTE *dst,
     {
         const WORD *src_line = (const WORD *)(src + y * pitch_in);
         DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
-        for (x = 0; x < w; ++x)
+
+        x = 0;
+#ifdef WINED3D_SSE2_CONVERSION
+        if (wined3d_cpu_has_sse2())
+            x = convert_r5g6b5_x8r8g8b8_row_sse2(src_line, dst_line, w);
+#endif
+        for (; x < w; ++x)
         {
             WORD pixel = src_line[x];
             dst_line[x] = 0xff000000
@@ -2320,7 +2461,12 @@ static void convert_a8r8g8b8_x8r8g8b8(const BYTE *src, BYTE *dst,
         const DWORD *src_line = (const DWORD *)(src + y * pitch_in);
         DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
 
-        for (x = 0; x < w; ++x)
+        x = 0;
+#ifdef WINED3D_SSE2_CONVERSION
+        if (wined3d_cpu_has_sse2())
+            x = convert_a8r8g8b8_x8r8g8b8_row_sse2(src_line, dst_line, w);
+#endif
+        for (; x < w; ++x)
         {
             dst_line[x] = 0xff000000 | (src_line[x] & 0xffffff);
         }
@@ -2344,7 +2490,16 @@ static void convert_yuy2_x8r8g8b8(const BYTE *src, BYTE *dst,
     {
         const BYTE *src_line = src + y * pitch_in;
         DWORD *dst_line = (DWORD *)(dst + y * pitch_out);
-        for (x = 0; x < w; ++x)
+
+        x = 0;
+#ifdef WINED3D_SSE2_CONVERSION
+        if (wined3d_cpu_has_sse2())
+        {
+            x = convert_yuy2_x8r8g8b8_row_sse2(src_line, dst_line, w);
+            src_line += 2 * x;
+        }
+#endif
+        for (; x < w; ++x)
         {
             /* YUV to RGB conversion formulas from http://en.wikipedia.org/wiki/YUV:
              *     C = Y - 16; D = U - 128; E = V - 128;
@@ -2386,7 +2541,16 @@ static void convert_yuy2_r5g6b5(const BYTE *src, BYTE *dst,
     {
         const BYTE *src_line = src + y * pitch_in;
         WORD *dst_line = (WORD *)(dst + y * pitch_out);
-        for (x = 0; x < w; ++x)
+
+        x = 0;
+#ifdef WINED3D_SSE2_CONVERSION
+        if (wined3d_cpu_has_sse2())
+        {
+            x = convert_yuy2_r5g6b5_row_sse2(src_line, dst_line, w);
+            src_line += 2 * x;
+        }
+#endif
+        for (; x < w; ++x)
         {
             /* YUV to RGB conversion formulas from http://en.wikipedia.org/wiki/YUV:
              *     C = Y - 16; D = U - 128; E = V - 128;
@@ -2431,6 +2595,23 @@ static const struct d3dfmt_converter_desc converters[] =
     {WINED3DFMT_YUY2,           WINED3DFMT_B5G6R5_UNORM,    convert_yuy2_r5g6b5},
 };
 
+struct surface_convert_ctx
+{
+    const struct d3dfmt_converter_desc *conv;
+    const BYTE *src;
+    BYTE *dst;
+    DWORD pitch_in, pitch_out;
+    unsigned int width;
+};
+
+static void surface_convert_rows(void *ctx, unsigned int row, unsigned int row_count)
+{
+    const struct surface_convert_ctx *c = ctx;
+
+    c->conv->convert(c->src + row * c->pitch_in, c->dst + row * c->pitch_out,
+            c->pitch_in, c->pitch_out, c->width, row_count);
+}
+
 static inline const struct d3dfmt_converter_desc *find_converter(enum wined3d_format_id from,
         enum wined3d_format_id to)
 {
@@ -2450,6 +2631,7 @@ static struct wined3d_texture *surface_convert_format(struct wined3d_surface *so
     struct wined3d_map_desc src_map, dst_map;
     const struct d3dfmt_converter_desc *conv;
     struct wined3d_texture *ret = NULL;
+    struct surface_convert_ctx ctx;
     struct wined3d_resource_desc desc;
     struct wined3d_surface *dst;
 
@@ -2492,8 +2674,13 @@ static struct wined3d_texture *surface_convert_format(struct wined3d_surface *so
         return NULL;
     }
 
-    conv->convert(src_map.data, dst_map.data, src_map.row_pitch, dst_map.row_pitch,
-            source->resource.width, source->resource.height);
+    ctx.conv = conv;
+    ctx.src = src_map.data;
+    ctx.dst = dst_map.data;
+    ctx.pitch_in = src_map.row_pitch;
+    ctx.pitch_out = dst_map.row_pitch;
+    ctx.width = source->resource.width;
+    wined3d_process_rows(surface_convert_rows, &ctx, source->resource.height, dst_map.row_pitch);
 
     wined3d_surface_unmap(dst);
     wined3d_surface_unmap(source);
@@ -2592,6 +2779,8 @@ HRESULT CDECL wined3d_surface_map(struct wined3d_surface *surface,
     TRACE("surface %p, map_desc %p, rect %s, flags %#x.\n",
             surface, map_desc, wine_dbgstr_rect(rect), flags);
 
+    device->cs->ops->finish(device->cs);
+
     if (surface->resource.map_count)
     {
         WARN("Surface is already mapped.\n");
@@ -2725,6 +2914,8 @@ HRESULT CDECL wined3d_surface_getdc(struct wined3d_surface *surface, HDC *dc)
 
     TRACE("surface %p, dc %p.\n", surface, dc);
 
+    surface->resource.device->cs->ops->finish(surface->resource.device->cs);
+
     /* Give more detailed info for ddraw. */
     if (surface->flags & SFLAG_DCINUSE)
         return WINEDDERR_DCALREADYCREATED;
@@ -4225,7 +4416,7 @@ static HRESULT surface_load_texture(struct wined3d_surface *surface,
             context_release(context);
             return E_OUTOFMEMORY;
         }
-        format.convert(data.addr, mem, src_pitch, src_pitch * height,
+        wined3d_format_convert(&format, data.addr, mem, src_pitch, src_pitch * height,
                 dst_pitch, dst_pitch * height, width, height, 1);
         src_pitch = dst_pitch;
         data.addr = mem;
@@ -31,6 +31,10 @@
 
 #include "wined3d_private.h"
 
+#ifdef WINED3D_SSE2_CONVERSION
+#include <emmintrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 
 struct wined3d_format_channels
@@ -262,6 +266,131 @@ struct wined3d_format_texture_info
             UINT dst_row_pitch, UINT dst_slice_pitch, UINT width, UINT height, UINT depth);
 };
 
+BOOL wined3d_cpu_has_sse2(void)
+{
+    static int sse2 = -1;
+
+    if (sse2 == -1)
+        sse2 = IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE);
+    return sse2;
+}
+
+/* Conversions below this size aren't worth the thread pool round trip. */
+#define WINED3D_PARALLEL_ROWS_THRESHOLD (1024 * 1024)
+#define WINED3D_MAX_ROW_BANDS           8
+
+struct wined3d_row_band
+{
+    void (*func)(void *ctx, unsigned int row, unsigned int row_count);
+    void *ctx;
+    unsigned int row;
+    unsigned int row_count;
+    LONG *pending;
+    HANDLE done;
+};
+
+static DWORD CALLBACK wined3d_row_band_proc(void *arg)
+{
+    struct wined3d_row_band *band = arg;
+
+    band->func(band->ctx, band->row, band->row_count);
+    if (!InterlockedDecrement(band->pending))
+        SetEvent(band->done);
+
+    return 0;
+}
+
+/* Rows have to be independent of each other, they may be processed in
+ * parallel on the thread pool. Returns when all rows have been processed. */
+void wined3d_process_rows(void (*func)(void *ctx, unsigned int row, unsigned int row_count),
+        void *ctx, unsigned int row_count, SIZE_T row_size)
+{
+    struct wined3d_row_band bands[WINED3D_MAX_ROW_BANDS];
+    static unsigned int cpu_count;
+    unsigned int band_count, i;
+    SYSTEM_INFO system_info;
+    LONG pending;
+    HANDLE done;
+
+    if (!cpu_count)
+    {
+        GetSystemInfo(&system_info);
+        cpu_count = max(system_info.dwNumberOfProcessors, 1);
+    }
+
+    band_count = min(min(cpu_count, WINED3D_MAX_ROW_BANDS), row_count);
+    if (band_count < 2 || row_count * row_size < WINED3D_PARALLEL_ROWS_THRESHOLD
+            || !(done = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        func(ctx, 0, row_count);
+        return;
+    }
+
+    TRACE("Processing %u rows in %u bands.\n", row_count, band_count);
+
+    pending = band_count;
+    for (i = 0; i < band_count; ++i)
+    {
+        bands[i].func = func;
+        bands[i].ctx = ctx;
+        bands[i].row = row_count * i / band_count;
+        bands[i].row_count = row_count * (i + 1) / band_count - bands[i].row;
+        bands[i].pending = &pending;
+        bands[i].done = done;
+    }
+
+    for (i = 1; i < band_count; ++i)
+    {
+        if (!QueueUserWorkItem(wined3d_row_band_proc, &bands[i], WT_EXECUTEDEFAULT))
+            wined3d_row_band_proc(&bands[i]);
+    }
+    wined3d_row_band_proc(&bands[0]);
+
+    WaitForSingleObject(done, INFINITE);
+    CloseHandle(done);
+}
+
+#ifdef WINED3D_SSE2_CONVERSION
+static unsigned int WINED3D_SSE2_FUNC convert_l4a4_unorm_row_sse2(const BYTE *src, BYTE *dst, unsigned int width)
+{
+    const __m128i l_mask = _mm_set1_epi8(0x0f), a_mask = _mm_set1_epi8(0xf0);
+    __m128i color, l, a;
+    unsigned int x;
+
+    for (x = 0; x + 16 <= width; x += 16)
+    {
+        color = _mm_loadu_si128((const __m128i *)(src + x));
+        /* The mask keeps the 16-bit shift from crossing into the next byte. */
+        l = _mm_slli_epi16(_mm_and_si128(color, l_mask), 4);
+        a = _mm_and_si128(color, a_mask);
+        _mm_storeu_si128((__m128i *)(dst + 2 * x), _mm_unpacklo_epi8(l, a));
+        _mm_storeu_si128((__m128i *)(dst + 2 * x + 16), _mm_unpackhi_epi8(l, a));
+    }
+
+    return x;
+}
+
+static unsigned int WINED3D_SSE2_FUNC convert_r8g8b8a8_snorm_row_sse2(const DWORD *src, BYTE *dst, unsigned int width)
+{
+    const __m128i bias = _mm_set1_epi8(0x80), ga_mask = _mm_set1_epi32(0xff00ff00);
+    const __m128i r_mask = _mm_set1_epi32(0x000000ff), b_mask = _mm_set1_epi32(0x00ff0000);
+    __m128i color;
+    unsigned int x;
+
+    for (x = 0; x + 4 <= width; x += 4)
+    {
+        /* Adding 128 modulo 256 flips the top bit; then swap U and W. */
+        color = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + x)), bias);
+        color = _mm_or_si128(_mm_and_si128(color, ga_mask),
+                _mm_or_si128(_mm_slli_epi32(_mm_and_si128(color, r_mask), 16),
+                _mm_srli_epi32(_mm_and_si128(color, b_mask), 16)));
+        _mm_storeu_si128((__m128i *)(dst + 4 * x), color);
+    }
+
+    return x;
+}
+#endif
+
 static void convert_l4a4_unorm(const BYTE *src, BYTE *dst, UINT src_row_pitch, UINT src_slice_pitch,
         UINT dst_row_pitch, UINT dst_slice_pitch, UINT width, UINT height, UINT depth)
 {
@@ -279,7 +408,16 @@ static void convert_l4a4_unorm(const BYTE *src, BYTE *dst, UINT src_row_pitch, U
         {
             Source = src + z * src_slice_pitch + y * src_row_pitch;
             Dest = dst + z * dst_slice_pitch + y * dst_row_pitch;
-            for (x = 0; x < width; x++ )
+            x = 0;
+#ifdef WINED3D_SSE2_CONVERSION
+            if (wined3d_cpu_has_sse2())
+            {
+                x = convert_l4a4_unorm_row_sse2(Source, Dest, width);
+                Source += x;
+                Dest += 2 * x;
+            }
+#endif
+            for (; x < width; x++ )
             {
                 unsigned char color = (*Source++);
                 /* A */ Dest[1] = (color & 0xf0) << 0;
@@ -455,7 +593,16 @@ static void convert_r8g8b8a8_snorm(const BYTE *src, BYTE *dst, UINT src_row_pitc
         {
             Source = (const DWORD *)(src + z * src_slice_pitch + y * src_row_pitch);
             Dest = dst + z * dst_slice_pitch + y * dst_row_pitch;
-            for (x = 0; x < width; x++ )
+            x = 0;
+#ifdef WINED3D_SSE2_CONVERSION
+            if (wined3d_cpu_has_sse2())
+            {
+                x = convert_r8g8b8a8_snorm_row_sse2(Source, Dest, width);
+                Source += x;
+                Dest += 4 * x;
+            }
+#endif
+            for (; x < width; x++ )
             {
                 LONG color = (*Source++);
                 /* B */ Dest[0] = ((color >> 16) & 0xff) + 128; /* W */
@@ -2239,6 +2386,54 @@ const struct wined3d_format *wined3d_get_format(const struct wined3d_gl_info *gl
     return &gl_info->formats[idx];
 }
 
+struct wined3d_format_convert_ctx
+{
+    const struct wined3d_format *format;
+    const BYTE *src;
+    BYTE *dst;
+    UINT src_row_pitch, src_slice_pitch;
+    UINT dst_row_pitch, dst_slice_pitch;
+    UINT width, height, depth;
+};
+
+static void wined3d_format_convert_rows(void *ctx, unsigned int row, unsigned int row_count)
+{
+    const struct wined3d_format_convert_ctx *c = ctx;
+
+    /* Volumes are split by slices, everything else by rows. */
+    if (c->depth > 1)
+        c->format->convert(c->src + row * c->src_slice_pitch, c->dst + row * c->dst_slice_pitch,
+                c->src_row_pitch, c->src_slice_pitch, c->dst_row_pitch, c->dst_slice_pitch,
+                c->width, c->height, row_count);
+    else
+        c->format->convert(c->src + row * c->src_row_pitch, c->dst + row * c->dst_row_pitch,
+                c->src_row_pitch, c->src_slice_pitch, c->dst_row_pitch, c->dst_slice_pitch,
+                c->width, row_count, 1);
+}
+
+void wined3d_format_convert(const struct wined3d_format *format, const BYTE *src, BYTE *dst,
+        UINT src_row_pitch, UINT src_slice_pitch, UINT dst_row_pitch, UINT dst_slice_pitch,
+        UINT width, UINT height, UINT depth)
+{
+    struct wined3d_format_convert_ctx ctx;
+
+    ctx.format = format;
+    ctx.src = src;
+    ctx.dst = dst;
+    ctx.src_row_pitch = src_row_pitch;
+    ctx.src_slice_pitch = src_slice_pitch;
+    ctx.dst_row_pitch = dst_row_pitch;
+    ctx.dst_slice_pitch = dst_slice_pitch;
+    ctx.width = width;
+    ctx.height = height;
+    ctx.depth = depth;
+
+    if (depth > 1)
+        wined3d_process_rows(wined3d_format_convert_rows, &ctx, depth, dst_slice_pitch);
+    else
+        wined3d_process_rows(wined3d_format_convert_rows, &ctx, height, dst_row_pitch);
+}
+
 UINT wined3d_format_calculate_pitch(const struct wined3d_format *format, UINT width)
 {
     /* For block based formats, pitch means the amount of bytes to the next
@@ -41,6 +41,10 @@ ULONG CDECL wined3d_rendertarget_view_decref(struct wined3d_rendertarget_view *v
 
     if (!refcount)
     {
+        struct wined3d_cs *cs = view->resource->device->cs;
+
+        /* Make sure the command stream is done with the view. */
+        cs->ops->finish(cs);
         /* Call wined3d_object_destroyed() before releasing the resource,
          * since releasing the resource may end up destroying the parent. */
         view->parent_ops->wined3d_object_destroyed(view->parent);
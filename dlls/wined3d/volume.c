@@ -98,7 +98,7 @@ void wined3d_volume_upload_data(struct wined3d_volume *volume, const struct wine
         wined3d_volume_get_pitch(volume, &src_row_pitch, &src_slice_pitch);
 
         converted_mem = HeapAlloc(GetProcessHeap(), 0, dst_slice_pitch * depth);
-        format->convert(data->addr, converted_mem, src_row_pitch, src_slice_pitch,
+        wined3d_format_convert(format, data->addr, converted_mem, src_row_pitch, src_slice_pitch,
                 dst_row_pitch, dst_slice_pitch, width, height, depth);
         mem = converted_mem;
     }
@@ -551,6 +551,8 @@ HRESULT CDECL wined3d_volume_map(struct wined3d_volume *volume,
     TRACE("volume %p, map_desc %p, box %p, flags %#x.\n",
             volume, map_desc, box, flags);
 
+    device->cs->ops->finish(device->cs);
+
     map_desc->data = NULL;
     if (!(volume->resource.access_flags & WINED3D_RESOURCE_ACCESS_CPU))
     {
@@ -85,8 +85,14 @@ struct wined3d_settings wined3d_settings =
     ~0U,            /* No GS shader model limit by default. */
     ~0U,            /* No PS shader model limit by default. */
     FALSE,          /* 3D support enabled by default. */
+    FALSE,          /* Single-threaded command stream by default. */
+    NULL,           /* No shader cache by default. */
+    128,            /* 128 MiB shader cache size limit. */
+    0,              /* No performance statistics by default. */
 };
 
+LONG wined3d_perf_counters[WINED3D_PERF_COUNTER_COUNT];
+
 struct wined3d * CDECL wined3d_create(DWORD flags)
 {
     struct wined3d *object;
@@ -304,11 +310,39 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             TRACE("Disabling 3D support.\n");
             wined3d_settings.no_3d = TRUE;
         }
+        if (!get_config_key(hkey, appkey, "CSMT", buffer, size)
+                && !strcmp(buffer, "enabled"))
+        {
+            TRACE("Enabling the multithreaded command stream.\n");
+            wined3d_settings.cs_multithreaded = TRUE;
+        }
+        if (!get_config_key(hkey, appkey, "ShaderCachePath", buffer, size))
+        {
+            size_t len = strlen(buffer) + 1;
+
+            TRACE("Using shader cache directory %s.\n", debugstr_a(buffer));
+            wined3d_settings.shader_cache_path = HeapAlloc(GetProcessHeap(), 0, len);
+            if (!wined3d_settings.shader_cache_path) ERR("Failed to allocate shader cache path memory.\n");
+            else memcpy(wined3d_settings.shader_cache_path, buffer, len);
+        }
+        if (!get_config_key_dword(hkey, appkey, "ShaderCacheSize", &wined3d_settings.shader_cache_size))
+            TRACE("Limiting the shader cache to %u MiB.\n", wined3d_settings.shader_cache_size);
     }
 
     if (appkey) RegCloseKey( appkey );
     if (hkey) RegCloseKey( hkey );
 
+    /* Statistics are meant to be enabled for a single run, so they are
+     * selected through the environment rather than the registry. */
+    if (GetEnvironmentVariableA("WINED3D_PERF_STATS", buffer, size) && buffer[0])
+    {
+        if (strstr(buffer, "log"))
+            wined3d_settings.perf_stats |= WINED3D_PERF_STATS_LOG;
+        if (strstr(buffer, "shm"))
+            wined3d_settings.perf_stats |= WINED3D_PERF_STATS_SHM;
+        TRACE("Performance statistics %#x.\n", wined3d_settings.perf_stats);
+    }
+
     return TRUE;
 }
 
@@ -336,6 +370,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     HeapFree(GetProcessHeap(), 0, wndproc_table.entries);
 
     HeapFree(GetProcessHeap(), 0, wined3d_settings.logo);
+    HeapFree(GetProcessHeap(), 0, wined3d_settings.shader_cache_path);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_wndproc_cs);
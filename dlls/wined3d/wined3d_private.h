@@ -278,8 +278,15 @@ struct wined3d_settings
     unsigned int max_sm_gs;
     unsigned int max_sm_ps;
     BOOL no_3d;
+    BOOL cs_multithreaded;
+    char *shader_cache_path;
+    unsigned int shader_cache_size;
+    unsigned int perf_stats;
 };
 
+#define WINED3D_PERF_STATS_LOG      0x00000001
+#define WINED3D_PERF_STATS_SHM      0x00000002
+
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
 
 enum wined3d_shader_resource_type
@@ -872,7 +879,22 @@ extern const struct wined3d_shader_backend_ops glsl_shader_backend DECLSPEC_HIDD
 extern const struct wined3d_shader_backend_ops arb_program_shader_backend DECLSPEC_HIDDEN;
 extern const struct wined3d_shader_backend_ops none_shader_backend DECLSPEC_HIDDEN;
 
+extern LONG wined3d_perf_counters[WINED3D_PERF_COUNTER_COUNT] DECLSPEC_HIDDEN;
+
+/* The counters are updated from both the application and the command stream threads. */
+static inline void wined3d_perf_count(enum wined3d_perf_counter counter, LONG count)
+{
+    if (wined3d_settings.perf_stats)
+        InterlockedExchangeAdd(&wined3d_perf_counters[counter], count);
+}
+
+/* Counting every GL call has a cost even when the statistics are disabled,
+ * so it has to be enabled at build time with WINED3D_PERF_COUNT_GL_CALLS. */
+#ifdef WINED3D_PERF_COUNT_GL_CALLS
+#define GL_EXTCALL(f) (wined3d_perf_count(WINED3D_PERF_GL_CALLS, 1), gl_info->gl_ops.ext.p_##f)
+#else
 #define GL_EXTCALL(f) (gl_info->gl_ops.ext.p_##f)
+#endif
 
 #define D3DCOLOR_B_R(dw) (((dw) >> 16) & 0xff)
 #define D3DCOLOR_B_G(dw) (((dw) >>  8) & 0xff)
@@ -990,8 +1012,8 @@ struct wined3d_stream_info
     WORD use_map; /* MAX_ATTRIBS, 16 */
 };
 
-void draw_primitive(struct wined3d_device *device, UINT start_idx, UINT index_count,
-        UINT start_instance, UINT instance_count, BOOL indexed) DECLSPEC_HIDDEN;
+void draw_primitive(struct wined3d_device *device, const struct wined3d_state *state, UINT start_idx,
+        UINT index_count, UINT start_instance, UINT instance_count, BOOL indexed) DECLSPEC_HIDDEN;
 DWORD get_flexible_vertex_size(DWORD d3dvtVertexType) DECLSPEC_HIDDEN;
 
 #define eps 1e-8f
@@ -1361,7 +1383,8 @@ void context_alloc_occlusion_query(struct wined3d_context *context,
 void context_apply_blit_state(struct wined3d_context *context, const struct wined3d_device *device) DECLSPEC_HIDDEN;
 BOOL context_apply_clear_state(struct wined3d_context *context, const struct wined3d_device *device,
         UINT rt_count, const struct wined3d_fb_state *fb) DECLSPEC_HIDDEN;
-BOOL context_apply_draw_state(struct wined3d_context *context, struct wined3d_device *device) DECLSPEC_HIDDEN;
+BOOL context_apply_draw_state(struct wined3d_context *context, struct wined3d_device *device,
+        const struct wined3d_state *state) DECLSPEC_HIDDEN;
 void context_apply_fbo_state_blit(struct wined3d_context *context, GLenum target,
         struct wined3d_surface *render_target, struct wined3d_surface *depth_stencil, DWORD location) DECLSPEC_HIDDEN;
 void context_active_texture(struct wined3d_context *context, const struct wined3d_gl_info *gl_info,
@@ -2514,10 +2537,21 @@ HRESULT state_init(struct wined3d_state *state, struct wined3d_fb_state *fb,
         DWORD flags) DECLSPEC_HIDDEN;
 void state_unbind_resources(struct wined3d_state *state) DECLSPEC_HIDDEN;
 
+enum wined3d_cs_push_constants_type
+{
+    WINED3D_PUSH_CONSTANTS_VS_F,
+    WINED3D_PUSH_CONSTANTS_PS_F,
+    WINED3D_PUSH_CONSTANTS_VS_I,
+    WINED3D_PUSH_CONSTANTS_PS_I,
+    WINED3D_PUSH_CONSTANTS_VS_B,
+    WINED3D_PUSH_CONSTANTS_PS_B,
+};
+
 struct wined3d_cs_ops
 {
     void *(*require_space)(struct wined3d_cs *cs, size_t size);
     void (*submit)(struct wined3d_cs *cs);
+    void (*finish)(struct wined3d_cs *cs);
 };
 
 struct wined3d_cs
@@ -2529,6 +2563,19 @@ struct wined3d_cs
 
     size_t data_size;
     void *data;
+
+    /* Multithreaded command stream. */
+    BYTE *queue;
+    LONG queue_head;
+    LONG queue_tail;
+    size_t pending_size;
+    HANDLE thread;
+    DWORD thread_id;
+    BOOL thread_stop;
+    HANDLE work_event;
+    HANDLE idle_event;
+    LONG waiting_for_work;
+    LONG waiting_for_idle;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device) DECLSPEC_HIDDEN;
@@ -2541,6 +2588,8 @@ void wined3d_cs_emit_draw(struct wined3d_cs *cs, UINT start_idx, UINT index_coun
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain,
         const RECT *src_rect, const RECT *dst_rect, HWND dst_window_override,
         const RGNDATA *dirty_region, DWORD flags) DECLSPEC_HIDDEN;
+void wined3d_cs_emit_push_constants(struct wined3d_cs *cs, enum wined3d_cs_push_constants_type type,
+        UINT start_idx, UINT count, const void *constants) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_reset_state(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_clip_plane(struct wined3d_cs *cs, UINT plane_idx,
         const struct wined3d_vec4 *plane) DECLSPEC_HIDDEN;
@@ -2550,6 +2599,8 @@ void wined3d_cs_emit_set_depth_stencil_view(struct wined3d_cs *cs,
         struct wined3d_rendertarget_view *view) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_index_buffer(struct wined3d_cs *cs, struct wined3d_buffer *buffer,
         enum wined3d_format_id format_id) DECLSPEC_HIDDEN;
+void wined3d_cs_emit_set_light_enable(struct wined3d_cs *cs, UINT gl_idx,
+        const struct wined3d_light_info *light) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_material(struct wined3d_cs *cs, const struct wined3d_material *material) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_predication(struct wined3d_cs *cs,
         struct wined3d_query *predicate, BOOL value) DECLSPEC_HIDDEN;
@@ -2625,6 +2676,8 @@ struct wined3d_map_range
     UINT size;
 };
 
+#define WINED3D_BUFFER_RING_SEGMENTS    4
+
 struct wined3d_buffer
 {
     struct wined3d_resource resource;
@@ -2641,6 +2694,11 @@ struct wined3d_buffer
     ULONG maps_size, modified_areas;
     struct wined3d_event_query *query;
 
+    /* Persistently mapped ring of buffer copies, see buffer_sync_ring(). */
+    BYTE *ring_ptr;
+    UINT ring_size, ring_stride, ring_segment_size, ring_offset;
+    struct wined3d_event_query *ring_queries[WINED3D_BUFFER_RING_SEGMENTS];
+
     /* conversion stuff */
     UINT decl_change_count, full_conversion_count;
     UINT draw_count;
@@ -2657,6 +2715,8 @@ static inline struct wined3d_buffer *buffer_from_resource(struct wined3d_resourc
 void buffer_get_memory(struct wined3d_buffer *buffer, struct wined3d_context *context,
         struct wined3d_bo_address *data) DECLSPEC_HIDDEN;
 BYTE *buffer_get_sysmem(struct wined3d_buffer *This, struct wined3d_context *context) DECLSPEC_HIDDEN;
+void buffer_destroy_buffer_object(struct wined3d_buffer *buffer,
+        const struct wined3d_gl_info *gl_info) DECLSPEC_HIDDEN;
 void buffer_internal_preload(struct wined3d_buffer *buffer, struct wined3d_context *context,
         const struct wined3d_state *state) DECLSPEC_HIDDEN;
 void buffer_mark_used(struct wined3d_buffer *buffer) DECLSPEC_HIDDEN;
@@ -3154,6 +3214,20 @@ DWORD wined3d_format_convert_from_float(const struct wined3d_surface *surface,
         const struct wined3d_color *color) DECLSPEC_HIDDEN;
 const struct wined3d_color_key_conversion * wined3d_format_get_color_key_conversion(
         const struct wined3d_texture *texture, BOOL need_alpha_ck) DECLSPEC_HIDDEN;
+void wined3d_format_convert(const struct wined3d_format *format, const BYTE *src, BYTE *dst,
+        UINT src_row_pitch, UINT src_slice_pitch, UINT dst_row_pitch, UINT dst_slice_pitch,
+        UINT width, UINT height, UINT depth) DECLSPEC_HIDDEN;
+void wined3d_process_rows(void (*func)(void *ctx, unsigned int row, unsigned int row_count),
+        void *ctx, unsigned int row_count, SIZE_T row_size) DECLSPEC_HIDDEN;
+BOOL wined3d_cpu_has_sse2(void) DECLSPEC_HIDDEN;
+
+/* SSE2 versions of the CPU format converters are built with the target
+ * attribute, so that they can be selected at runtime on i386 as well. */
+#if defined(__x86_64__) || (defined(__i386__) && defined(__GNUC__) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define WINED3D_SSE2_CONVERSION
+#define WINED3D_SSE2_FUNC __attribute__((target("sse2")))
+#endif
 
 static inline BOOL use_vs(const struct wined3d_state *state)
 {
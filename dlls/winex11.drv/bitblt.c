@@ -51,6 +51,7 @@
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(bitblt);
+WINE_DECLARE_DEBUG_CHANNEL(fps);
 
 
 #define DST 0   /* Destination drawable */
@@ -1556,6 +1557,9 @@ DWORD get_pixmap_image( Pixmap pixmap, int width, int height, const XVisualInfo
 }
 
 
+#define MAX_DAMAGE_RECTS  16  /* merge damage rectangles beyond that */
+#define FLUSH_INTERVAL    16  /* minimum time between two uploads of a surface, in ms */
+
 struct x11drv_window_surface
 {
     struct window_surface header;
@@ -1563,6 +1567,11 @@ struct x11drv_window_surface
     GC                    gc;
     XImage               *image;
     RECT                  bounds;
+    RECT                  damage[MAX_DAMAGE_RECTS];
+    int                   damage_count;
+    DWORD                 last_flush;
+    HANDLE                flush_timer;
+    BOOL                  flush_pending;
     BOOL                  byteswap;
     BOOL                  is_argb;
     COLORREF              color_key;
@@ -1622,7 +1631,7 @@ static void update_surface_region( struct x11drv_window_surface *surface )
     int x, y, start, width;
     HRGN rgn;
 
-    if (!shape_layered_windows) return;
+    if (!shape_layered_windows || !surface->window) return;
 
     if (!surface->is_argb && surface->color_key == CLR_INVALID)
     {
@@ -1810,6 +1819,166 @@ failed:
 }
 #endif /* HAVE_LIBXXSHM */
 
+static inline int get_rect_area( const RECT *rect )
+{
+    return (rect->right - rect->left) * (rect->bottom - rect->top);
+}
+
+/***********************************************************************
+ *           add_damage_rect
+ *
+ * Add a rectangle to the surface damage list. Rectangles that overlap an
+ * existing one without growing its area are merged into it; once the list
+ * is full, the rectangle is merged with the entry that grows the least.
+ */
+static void add_damage_rect( struct x11drv_window_surface *surface, const RECT *rect )
+{
+    RECT rc, tmp;
+    int i, cost, best = 0, best_cost = INT_MAX;
+
+    SetRect( &rc, 0, 0, surface->header.rect.right - surface->header.rect.left,
+             surface->header.rect.bottom - surface->header.rect.top );
+    if (!IntersectRect( &rc, &rc, rect )) return;
+
+    for (i = 0; i < surface->damage_count; i++)
+    {
+        UnionRect( &tmp, &surface->damage[i], &rc );
+        cost = get_rect_area( &tmp ) - get_rect_area( &surface->damage[i] ) - get_rect_area( &rc );
+        if (cost <= 0)
+        {
+            surface->damage[i] = tmp;
+            return;
+        }
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best = i;
+        }
+    }
+    if (surface->damage_count < MAX_DAMAGE_RECTS)
+        surface->damage[surface->damage_count++] = rc;
+    else
+        UnionRect( &surface->damage[best], &surface->damage[best], &rc );
+}
+
+/***********************************************************************
+ *           add_damage_bounds
+ *
+ * Move the bounds accumulated by the DIB engine to the damage list.
+ * Must be called with the surface lock held.
+ */
+static void add_damage_bounds( struct x11drv_window_surface *surface )
+{
+    if (surface->bounds.left >= surface->bounds.right) return;
+    add_damage_rect( surface, &surface->bounds );
+    reset_bounds( &surface->bounds );
+}
+
+/***********************************************************************
+ *           trace_upload_rate
+ */
+static void trace_upload_rate( UINT bytes )
+{
+    static LONG total_bytes, total_rects;
+    static DWORD prev_time;
+    DWORD time = GetTickCount();
+
+    InterlockedExchangeAdd( &total_bytes, bytes );
+    InterlockedIncrement( &total_rects );
+
+    /* every 1.5 seconds */
+    if (time - prev_time > 1500)
+    {
+        LONG count = InterlockedExchange( &total_rects, 0 );
+        LONG size = InterlockedExchange( &total_bytes, 0 );
+
+        if (prev_time)
+            TRACE_(fps)( "surfaces @ approx %.2f KB/s in %.2f rects/s\n",
+                         1000.0 / 1024 * size / (time - prev_time),
+                         1000.0 * count / (time - prev_time) );
+        prev_time = time;
+    }
+}
+
+/***********************************************************************
+ *           flush_damage
+ *
+ * Upload the damaged parts of the surface to the X server.
+ * Must be called with the surface lock held.
+ */
+static void flush_damage( struct x11drv_window_surface *surface )
+{
+    unsigned char *src = surface->bits;
+    unsigned char *dst = (unsigned char *)surface->image->data;
+    int i, width_bytes = surface->image->bytes_per_line;
+    const int *mapping = NULL;
+    const RECT *rect;
+
+    add_damage_bounds( surface );
+    surface->last_flush = GetTickCount();
+    if (!surface->window) surface->damage_count = 0;  /* the X window is gone */
+    if (!surface->damage_count) return;
+
+    if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
+
+    if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
+        mapping = X11DRV_PALETTE_PaletteToXPixel;
+
+    for (i = 0; i < surface->damage_count; i++)
+    {
+        rect = &surface->damage[i];
+
+        TRACE( "flushing %p %s bits %p\n", surface, wine_dbgstr_rect( rect ), surface->bits );
+
+        if (src != dst)
+            copy_image_byteswap( &surface->info, src + rect->top * width_bytes,
+                                 dst + rect->top * width_bytes, width_bytes, width_bytes,
+                                 rect->bottom - rect->top, surface->byteswap, mapping, ~0u );
+
+#ifdef HAVE_LIBXXSHM
+        if (surface->shminfo.shmid != -1)
+            XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                          rect->left, rect->top,
+                          surface->header.rect.left + rect->left,
+                          surface->header.rect.top + rect->top,
+                          rect->right - rect->left, rect->bottom - rect->top, False );
+        else
+#endif
+        XPutImage( gdi_display, surface->window, surface->gc, surface->image,
+                   rect->left, rect->top,
+                   surface->header.rect.left + rect->left,
+                   surface->header.rect.top + rect->top,
+                   rect->right - rect->left, rect->bottom - rect->top );
+
+        if (TRACE_ON(fps))
+            trace_upload_rate( (rect->right - rect->left) * (rect->bottom - rect->top) *
+                               surface->image->bits_per_pixel / 8 );
+    }
+    surface->damage_count = 0;
+}
+
+/***********************************************************************
+ *           flush_timer_proc
+ *
+ * Upload the damage left over by flushes that were coalesced. The timer
+ * holds a reference to the surface, released once it has run.
+ */
+static void CALLBACK flush_timer_proc( void *arg, BOOLEAN fired )
+{
+    struct x11drv_window_surface *surface = arg;
+    HANDLE timer;
+
+    surface->header.funcs->lock( &surface->header );
+    surface->flush_pending = FALSE;
+    flush_damage( surface );
+    timer = surface->flush_timer;
+    surface->flush_timer = 0;
+    surface->header.funcs->unlock( &surface->header );
+    XFlush( gdi_display );
+    DeleteTimerQueueTimer( NULL, timer, NULL );
+    window_surface_release( &surface->header );
+}
+
 /***********************************************************************
  *           x11drv_surface_lock
  */
@@ -1827,6 +1996,8 @@ static void x11drv_surface_unlock( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
 
+    /* keep the bounds of each drawing operation as a separate damage rect */
+    add_damage_bounds( surface );
     LeaveCriticalSection( &surface->crit );
 }
 
@@ -1888,57 +2059,31 @@ static void x11drv_surface_set_region( struct window_surface *window_surface, HR
 static void x11drv_surface_flush( struct window_surface *window_surface )
 {
     struct x11drv_window_surface *surface = get_x11_surface( window_surface );
-    unsigned char *src = surface->bits;
-    unsigned char *dst = (unsigned char *)surface->image->data;
-    struct bitblt_coords coords;
+    DWORD elapsed;
 
     window_surface->funcs->lock( window_surface );
-    coords.x = 0;
-    coords.y = 0;
-    coords.width  = surface->header.rect.right - surface->header.rect.left;
-    coords.height = surface->header.rect.bottom - surface->header.rect.top;
-    SetRect( &coords.visrect, 0, 0, coords.width, coords.height );
-    if (IntersectRect( &coords.visrect, &coords.visrect, &surface->bounds ))
+    add_damage_bounds( surface );
+    elapsed = GetTickCount() - surface->last_flush;
+    /* if a flush is pending, the timer will upload the new damage too */
+    if (surface->damage_count && !surface->flush_pending)
     {
-        TRACE( "flushing %p %dx%d bounds %s bits %p\n",
-               surface, coords.width, coords.height,
-               wine_dbgstr_rect( &surface->bounds ), surface->bits );
-
-        if (surface->is_argb || surface->color_key != CLR_INVALID) update_surface_region( surface );
-
-        if (src != dst)
+        /* a detached surface has nothing to upload, don't start a timer for it */
+        if (elapsed >= FLUSH_INTERVAL || !surface->window) flush_damage( surface );
+        else
         {
-            const int *mapping = NULL;
-            int width_bytes = surface->image->bytes_per_line;
-
-            if (surface->image->bits_per_pixel == 4 || surface->image->bits_per_pixel == 8)
-                mapping = X11DRV_PALETTE_PaletteToXPixel;
-
-            src += coords.visrect.top * width_bytes;
-            dst += coords.visrect.top * width_bytes;
-            copy_image_byteswap( &surface->info, src, dst, width_bytes, width_bytes,
-                                 coords.visrect.bottom - coords.visrect.top,
-                                 surface->byteswap, mapping, ~0u );
+            /* we've just uploaded a frame, coalesce with what is drawn until the next one */
+            window_surface_add_ref( window_surface );
+            surface->flush_pending = CreateTimerQueueTimer( &surface->flush_timer, NULL, flush_timer_proc,
+                                                            surface, FLUSH_INTERVAL - elapsed, 0,
+                                                            WT_EXECUTEINTIMERTHREAD | WT_EXECUTEONLYONCE );
+            if (!surface->flush_pending)
+            {
+                surface->flush_timer = 0;
+                window_surface_release( window_surface );  /* not the last reference, we got it from the caller */
+                flush_damage( surface );
+            }
         }
-
-#ifdef HAVE_LIBXXSHM
-        if (surface->shminfo.shmid != -1)
-            XShmPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                          coords.visrect.left, coords.visrect.top,
-                          surface->header.rect.left + coords.visrect.left,
-                          surface->header.rect.top + coords.visrect.top,
-                          coords.visrect.right - coords.visrect.left,
-                          coords.visrect.bottom - coords.visrect.top, False );
-        else
-#endif
-        XPutImage( gdi_display, surface->window, surface->gc, surface->image,
-                   coords.visrect.left, coords.visrect.top,
-                   surface->header.rect.left + coords.visrect.left,
-                   surface->header.rect.top + coords.visrect.top,
-                   coords.visrect.right - coords.visrect.left,
-                   coords.visrect.bottom - coords.visrect.top );
     }
-    reset_bounds( &surface->bounds );
     window_surface->funcs->unlock( window_surface );
 }
 
@@ -2069,6 +2214,40 @@ void set_surface_color_key( struct window_surface *window_surface, COLORREF colo
     window_surface->funcs->unlock( window_surface );
 }
 
+/***********************************************************************
+ *           detach_surface
+ *
+ * Stop uploading a surface to its X window, because the window is about
+ * to be destroyed or the surface is being replaced. The damage of coalesced
+ * flushes is uploaded first if the window is still there, and the pending
+ * flush timer is cancelled; the surface itself may live on in DCs that
+ * still reference it, but it never touches the window again.
+ */
+void detach_surface( struct window_surface *window_surface, BOOL flush )
+{
+    struct x11drv_window_surface *surface = get_x11_surface( window_surface );
+    HANDLE timer;
+
+    if (window_surface->funcs != &x11drv_surface_funcs) return;  /* we may get the null surface */
+
+    window_surface->funcs->lock( window_surface );
+    if (flush && surface->flush_pending) flush_damage( surface );
+    surface->window = 0;
+    timer = surface->flush_timer;
+    surface->flush_timer = 0;
+    window_surface->funcs->unlock( window_surface );
+
+    if (!timer) return;
+    /* wait for the callback if it is already running, it takes the surface lock */
+    DeleteTimerQueueTimer( NULL, timer, INVALID_HANDLE_VALUE );
+
+    window_surface->funcs->lock( window_surface );
+    if (!surface->flush_pending) timer = 0;  /* the callback ran and released its reference */
+    surface->flush_pending = FALSE;
+    window_surface->funcs->unlock( window_surface );
+    if (timer) window_surface_release( window_surface );  /* not the last reference, we got it from the caller */
+}
+
 /***********************************************************************
  *           expose_surface
  */
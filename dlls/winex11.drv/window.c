@@ -1509,6 +1509,7 @@ static void destroy_whole_window( struct x11drv_win_data *data, BOOL already_des
     TRACE( "win %p xwin %lx\n", data->hwnd, data->whole_window );
     XDeleteContext( data->display, data->whole_window, winContext );
     if (data->client_window) XDeleteContext( data->display, data->client_window, winContext );
+    if (data->surface) detach_surface( data->surface, !already_destroyed );
     if (!already_destroyed) XDestroyWindow( data->display, data->whole_window );
     if (data->colormap) XFreeColormap( data->display, data->colormap );
     data->whole_window = data->client_window = 0;
@@ -2229,7 +2230,11 @@ void CDECL X11DRV_WindowPosChanged( HWND hwnd, HWND insert_after, UINT swp_flags
     if (data->vis.visualid == default_visual.visualid)
     {
         if (surface) window_surface_add_ref( surface );
-        if (data->surface) window_surface_release( data->surface );
+        if (data->surface)
+        {
+            if (data->surface != surface) detach_surface( data->surface, TRUE );
+            window_surface_release( data->surface );
+        }
         data->surface = surface;
     }
 
@@ -2528,7 +2533,11 @@ BOOL CDECL X11DRV_UpdateLayeredWindow( HWND hwnd, const UPDATELAYEREDWINDOWINFO
     {
         data->surface = create_surface( data->whole_window, &data->vis, &rect,
                                         color_key, !data->embedded );
-        if (surface) window_surface_release( surface );
+        if (surface)
+        {
+            detach_surface( surface, TRUE );
+            window_surface_release( surface );
+        }
         surface = data->surface;
     }
     else set_surface_color_key( surface, color_key );
@@ -302,12 +302,14 @@ HRESULT WINAPI OleTranslateColor( OLE_COLOR clr, HPALETTE hpal,
 #define CTL_E_GETNOTSUPPORTEDATRUNTIME  STD_CTL_SCODE(393)
 #define CTL_E_GETNOTSUPPORTED           STD_CTL_SCODE(394)
 #define CTL_E_PROPERTYNOTFOUND          STD_CTL_SCODE(422)
+#define CTL_E_KEY_ALREADY_EXISTS        STD_CTL_SCODE(457)
 #define CTL_E_INVALIDCLIPBOARDFORMAT    STD_CTL_SCODE(460)
 #define CTL_E_INVALIDPICTURE            STD_CTL_SCODE(481)
 #define CTL_E_PRINTERERROR              STD_CTL_SCODE(482)
 #define CTL_E_CANTSAVEFILETOTEMP        STD_CTL_SCODE(735)
 #define CTL_E_SEARCHTEXTNOTFOUND        STD_CTL_SCODE(744)
 #define CTL_E_REPLACEMENTSTOOLONG       STD_CTL_SCODE(746)
+#define CTL_E_ELEMENT_NOT_FOUND         STD_CTL_SCODE(32811)
 
 #define CUSTOM_CTL_SCODE(n) MAKE_SCODE(SEVERITY_ERROR, FACILITY_CONTROL, n)
 #define CTL_E_CUSTOM_FIRST              CUSTOM_CTL_SCODE(600)
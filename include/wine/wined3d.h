@@ -794,6 +794,39 @@ enum wined3d_display_rotation
     WINED3D_DISPLAY_ROTATION_270            = 4,
 };
 
+enum wined3d_perf_counter
+{
+    WINED3D_PERF_DRAWS                      = 0,
+    WINED3D_PERF_CLEARS                     = 1,
+    WINED3D_PERF_STATE_CHANGES              = 2,
+    WINED3D_PERF_STATE_APPLICATIONS         = 3,
+    WINED3D_PERF_BUFFER_UPLOADS             = 4,
+    WINED3D_PERF_BUFFER_UPLOAD_BYTES        = 5,
+    WINED3D_PERF_SURFACE_UPLOADS            = 6,
+    WINED3D_PERF_SURFACE_LOADS              = 7,
+    WINED3D_PERF_SHADER_COMPILES            = 8,
+    WINED3D_PERF_PROGRAM_LINKS              = 9,
+    WINED3D_PERF_GL_CALLS                   = 10,
+    WINED3D_PERF_COUNTER_COUNT              = 11,
+};
+
+#define WINED3D_PERF_STATS_VERSION                              1
+#define WINED3D_PERF_STATS_NAME                                 "wined3d_perf_stats_%08x"
+
+/* Layout of the shared memory block published when WINED3D_PERF_STATS
+ * contains "shm". The block is named after the process id. The sequence
+ * number is odd while the block is being updated. */
+struct wined3d_perf_stats
+{
+    DWORD version;
+    DWORD counter_count;
+    volatile LONG sequence;
+    DWORD frame_time_us;
+    ULONG64 frame_count;
+    ULONG64 last_frame[WINED3D_PERF_COUNTER_COUNT];
+    ULONG64 total[WINED3D_PERF_COUNTER_COUNT];
+};
+
 #define WINED3DCOLORWRITEENABLE_RED                             (1 << 0)
 #define WINED3DCOLORWRITEENABLE_GREEN                           (1 << 1)
 #define WINED3DCOLORWRITEENABLE_BLUE                            (1 << 2)